@@ -0,0 +1,51 @@
+#include <kvs/GrayImage>
+#include <kvs/BitImage>
+#include <kvs/ValueArray>
+
+
+int main( int argc, char** argv )
+{
+    if ( argc == 1 )
+    {
+        kvsMessageError() << "Usage: % " << std::string( argv[0] ) << " <image file>" << std::endl;
+        return (false);
+    }
+
+    const std::string filename( argv[1] );
+    const kvs::GrayImage image( filename );
+    image.write( "output_source.bmp" );
+
+    // The filters are applied in-place, so that each filtered image is created
+    // from a deep copy of the source pixels.
+    kvs::GrayImage box( image.width(), image.height(), image.pixels().clone() );
+    box.boxBlur( 5 );
+    box.write( "output_box.bmp" );
+
+    kvs::GrayImage gaussian( image.width(), image.height(), image.pixels().clone() );
+    gaussian.gaussianBlur( 3.0 );
+    gaussian.write( "output_gaussian.bmp" );
+
+    kvs::GrayImage convolution( image.width(), image.height(), image.pixels().clone() );
+    convolution.convolve( kvs::ValueArray<kvs::Real32>{ 0.25f, 0.5f, 0.25f } );
+    convolution.write( "output_convolution.bmp" );
+
+    kvs::GrayImage sobel( image.width(), image.height(), image.pixels().clone() );
+    sobel.sobel();
+    sobel.write( "output_sobel.bmp" );
+
+    kvs::GrayImage erosion( image.width(), image.height(), image.pixels().clone() );
+    erosion.erode( 2 );
+    erosion.write( "output_erosion.bmp" );
+
+    kvs::GrayImage dilation( image.width(), image.height(), image.pixels().clone() );
+    dilation.dilate( 2 );
+    dilation.write( "output_dilation.bmp" );
+
+    // Opening of the binarized image.
+    kvs::BitImage opening( image, kvs::BitImage::PTile() );
+    opening.erode( 1 );
+    opening.dilate( 1 );
+    opening.write( "output_opening.bmp" );
+
+    return 0;
+}
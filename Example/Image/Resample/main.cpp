@@ -0,0 +1,115 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Example program for the separable image resampling.
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#include <kvs/ColorImage>
+#include <kvs/GrayImage>
+#include <kvs/ImageResampler>
+#include <kvs/ValueArray>
+#include <kvs/Indent>
+#include <kvs/Timer>
+#include <kvs/Message>
+#include <iostream>
+#include <string>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Measures the processing time of the image resizing.
+ *  @param  name [in] name of the method
+ *  @param  image [in] input image
+ *  @param  width [in] resized width
+ *  @param  height [in] resized height
+ *  @param  resize [in] resizing function
+ */
+/*===========================================================================*/
+template <typename Image, typename Resize>
+void Measure(
+    const std::string& name,
+    const Image& image,
+    const size_t width,
+    const size_t height,
+    Resize resize )
+{
+    const kvs::Indent indent(4);
+    Image resized = image;
+    kvs::Timer timer( kvs::Timer::Start );
+    resize( resized, width, height );
+    timer.stop();
+    std::cout << indent << name << ": " << timer.msec() << " [msec]" << std::endl;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Performance test of the resizing methods.
+ *  @param  image [in] input image
+ *  @param  ratio [in] scaling ratio
+ */
+/*===========================================================================*/
+template <typename Image>
+void PerfTest( const Image& image, const double ratio )
+{
+    const size_t width = static_cast<size_t>( image.width() * ratio );
+    const size_t height = static_cast<size_t>( image.height() * ratio );
+    std::cout << "Performance Test ("
+              << image.width() << "x" << image.height() << " -> "
+              << width << "x" << height << ")" << std::endl;
+
+    // Per-pixel interpolators (previous implementation).
+    Measure( "Nearest (interpolator)", image, width, height,
+             [] ( Image& i, size_t w, size_t h ) { i.resize( w, h, Image::Nearest() ); } );
+    Measure( "Bilinear (interpolator)", image, width, height,
+             [] ( Image& i, size_t w, size_t h ) { i.resize( w, h, Image::Bilinear() ); } );
+
+    // Separable resampling filters.
+    Measure( "Box (separable)", image, width, height,
+             [] ( Image& i, size_t w, size_t h ) { i.resize( w, h, kvs::ImageResampler::Box ); } );
+    Measure( "Bilinear (separable)", image, width, height,
+             [] ( Image& i, size_t w, size_t h ) { i.resize( w, h, kvs::ImageResampler::Bilinear ); } );
+    Measure( "Bicubic (separable)", image, width, height,
+             [] ( Image& i, size_t w, size_t h ) { i.resize( w, h, kvs::ImageResampler::Bicubic ); } );
+    Measure( "Lanczos3 (separable)", image, width, height,
+             [] ( Image& i, size_t w, size_t h ) { i.resize( w, h, kvs::ImageResampler::Lanczos3 ); } );
+}
+
+} // end of namespace
+
+
+int main( int argc, char** argv )
+{
+    // Input image (4096x4096 random image if the image file is not given).
+    kvs::ColorImage image;
+    if ( argc > 1 )
+    {
+        if ( !image.read( argv[1] ) )
+        {
+            kvsMessageError() << "Cannot read " << argv[1] << "." << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        const size_t size = 4096;
+        image.create( size, size, kvs::ValueArray<kvs::UInt8>::Random( size * size * 3 ) );
+    }
+
+    std::cout << "Color image" << std::endl;
+    ::PerfTest( image, 0.25 );
+    ::PerfTest( image, 1.5 );
+
+    std::cout << "Gray image" << std::endl;
+    const kvs::GrayImage gray( image );
+    ::PerfTest( gray, 0.25 );
+    ::PerfTest( gray, 1.5 );
+
+    image.resize( image.width() / 4, image.height() / 4, kvs::ImageResampler::Lanczos3 );
+    image.write( "output.bmp" );
+
+    return 0;
+}
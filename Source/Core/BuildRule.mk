@@ -131,6 +131,8 @@ $(OUTDIR)/./Image/HCLColor.o \
 $(OUTDIR)/./Image/HSLColor.o \
 $(OUTDIR)/./Image/HSVColor.o \
 $(OUTDIR)/./Image/ImageBase.o \
+$(OUTDIR)/./Image/ImageFilter.o \
+$(OUTDIR)/./Image/ImageResampler.o \
 $(OUTDIR)/./Image/LabColor.o \
 $(OUTDIR)/./Image/MshColor.o \
 $(OUTDIR)/./Image/RGBAColor.o \
@@ -143,6 +145,7 @@ $(OUTDIR)/./Matrix/Matrix.o \
 $(OUTDIR)/./Matrix/Matrix22.o \
 $(OUTDIR)/./Matrix/Matrix33.o \
 $(OUTDIR)/./Matrix/Matrix44.o \
+$(OUTDIR)/./Matrix/MatrixMultiplication.o \
 $(OUTDIR)/./Matrix/OrthogonalMatrix44.o \
 $(OUTDIR)/./Matrix/PerspectiveMatrix44.o \
 $(OUTDIR)/./Matrix/RotationMatrix33.o \
@@ -198,6 +201,7 @@ $(OUTDIR)/./Numeric/SVSolver.o \
 $(OUTDIR)/./Numeric/StudentTDistribution.o \
 $(OUTDIR)/./Numeric/Xorshift128.o \
 $(OUTDIR)/./OpenGL/BufferObject.o \
+$(OUTDIR)/./OpenGL/BufferUploadQueue.o \
 $(OUTDIR)/./OpenGL/FrameBuffer.o \
 $(OUTDIR)/./OpenGL/FrameBufferObject.o \
 $(OUTDIR)/./OpenGL/GL.o \
@@ -229,6 +233,7 @@ $(OUTDIR)/./Utility/Date.o \
 $(OUTDIR)/./Utility/Directory.o \
 $(OUTDIR)/./Utility/File.o \
 $(OUTDIR)/./Utility/Indent.o \
+$(OUTDIR)/./Utility/MappedFile.o \
 $(OUTDIR)/./Utility/MemoryTracer.o \
 $(OUTDIR)/./Utility/Message.o \
 $(OUTDIR)/./Utility/Program.o \
@@ -329,6 +334,7 @@ $(OUTDIR)/./Visualization/Mapper/StreamlineBase.o \
 $(OUTDIR)/./Visualization/Mapper/TetrahedralCell.o \
 $(OUTDIR)/./Visualization/Mapper/TransferFunction.o \
 $(OUTDIR)/./Visualization/Mapper/UniformGrid.o \
+$(OUTDIR)/./Visualization/Object/CompressedPointArray.o \
 $(OUTDIR)/./Visualization/Object/GeometryObjectBase.o \
 $(OUTDIR)/./Visualization/Object/ImageObject.o \
 $(OUTDIR)/./Visualization/Object/LineObject.o \
@@ -347,6 +353,7 @@ $(OUTDIR)/./Visualization/Renderer/ArrowGlyph.o \
 $(OUTDIR)/./Visualization/Renderer/Axis2D.o \
 $(OUTDIR)/./Visualization/Renderer/Axis2DMatrix.o \
 $(OUTDIR)/./Visualization/Renderer/Axis3D.o \
+$(OUTDIR)/./Visualization/Renderer/BatchedGeometryRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/Bounds.o \
 $(OUTDIR)/./Visualization/Renderer/CategoryAxis.o \
 $(OUTDIR)/./Visualization/Renderer/CurvedParallelCoordinatesRenderer.o \
@@ -359,6 +366,7 @@ $(OUTDIR)/./Visualization/Renderer/HeatmapRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/ImageRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/LineRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/LineRendererGLSL.o \
+$(OUTDIR)/./Visualization/Renderer/MaxReductionBuffer.o \
 $(OUTDIR)/./Visualization/Renderer/ParallelAxis.o \
 $(OUTDIR)/./Visualization/Renderer/ParallelCoordinatesRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/ParticleBasedRenderer.o \
@@ -391,9 +399,11 @@ $(OUTDIR)/./Visualization/Renderer/StochasticRenderingEngine.o \
 $(OUTDIR)/./Visualization/Renderer/StochasticTetrahedraRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/StochasticUniformGridRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/StylizedLineRenderer.o \
+$(OUTDIR)/./Visualization/Renderer/TableBuffer.o \
 $(OUTDIR)/./Visualization/Renderer/ValueAxis.o \
 $(OUTDIR)/./Visualization/Renderer/VolumeRayIntersector.o \
 $(OUTDIR)/./Visualization/Renderer/VolumeRendererBase.o \
+$(OUTDIR)/./Visualization/Renderer/WeightedBlendedBuffer.o \
 $(OUTDIR)/./Visualization/Viewer/ApplicationBase.o \
 $(OUTDIR)/./Visualization/Viewer/Background.o \
 $(OUTDIR)/./Visualization/Viewer/Camera.o \
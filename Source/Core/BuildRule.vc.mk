@@ -131,6 +131,8 @@ $(OUTDIR)\.\Image\HCLColor.obj \
 $(OUTDIR)\.\Image\HSLColor.obj \
 $(OUTDIR)\.\Image\HSVColor.obj \
 $(OUTDIR)\.\Image\ImageBase.obj \
+$(OUTDIR)\.\Image\ImageFilter.obj \
+$(OUTDIR)\.\Image\ImageResampler.obj \
 $(OUTDIR)\.\Image\LabColor.obj \
 $(OUTDIR)\.\Image\MshColor.obj \
 $(OUTDIR)\.\Image\RGBAColor.obj \
@@ -143,6 +145,7 @@ $(OUTDIR)\.\Matrix\Matrix.obj \
 $(OUTDIR)\.\Matrix\Matrix22.obj \
 $(OUTDIR)\.\Matrix\Matrix33.obj \
 $(OUTDIR)\.\Matrix\Matrix44.obj \
+$(OUTDIR)\.\Matrix\MatrixMultiplication.obj \
 $(OUTDIR)\.\Matrix\OrthogonalMatrix44.obj \
 $(OUTDIR)\.\Matrix\PerspectiveMatrix44.obj \
 $(OUTDIR)\.\Matrix\RotationMatrix33.obj \
@@ -198,6 +201,7 @@ $(OUTDIR)\.\Numeric\SVSolver.obj \
 $(OUTDIR)\.\Numeric\StudentTDistribution.obj \
 $(OUTDIR)\.\Numeric\Xorshift128.obj \
 $(OUTDIR)\.\OpenGL\BufferObject.obj \
+$(OUTDIR)\.\OpenGL\BufferUploadQueue.obj \
 $(OUTDIR)\.\OpenGL\FrameBuffer.obj \
 $(OUTDIR)\.\OpenGL\FrameBufferObject.obj \
 $(OUTDIR)\.\OpenGL\GL.obj \
@@ -229,6 +233,7 @@ $(OUTDIR)\.\Utility\Date.obj \
 $(OUTDIR)\.\Utility\Directory.obj \
 $(OUTDIR)\.\Utility\File.obj \
 $(OUTDIR)\.\Utility\Indent.obj \
+$(OUTDIR)\.\Utility\MappedFile.obj \
 $(OUTDIR)\.\Utility\MemoryTracer.obj \
 $(OUTDIR)\.\Utility\Message.obj \
 $(OUTDIR)\.\Utility\Program.obj \
@@ -329,6 +334,7 @@ $(OUTDIR)\.\Visualization\Mapper\StreamlineBase.obj \
 $(OUTDIR)\.\Visualization\Mapper\TetrahedralCell.obj \
 $(OUTDIR)\.\Visualization\Mapper\TransferFunction.obj \
 $(OUTDIR)\.\Visualization\Mapper\UniformGrid.obj \
+$(OUTDIR)\.\Visualization\Object\CompressedPointArray.obj \
 $(OUTDIR)\.\Visualization\Object\GeometryObjectBase.obj \
 $(OUTDIR)\.\Visualization\Object\ImageObject.obj \
 $(OUTDIR)\.\Visualization\Object\LineObject.obj \
@@ -347,6 +353,7 @@ $(OUTDIR)\.\Visualization\Renderer\ArrowGlyph.obj \
 $(OUTDIR)\.\Visualization\Renderer\Axis2D.obj \
 $(OUTDIR)\.\Visualization\Renderer\Axis2DMatrix.obj \
 $(OUTDIR)\.\Visualization\Renderer\Axis3D.obj \
+$(OUTDIR)\.\Visualization\Renderer\BatchedGeometryRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\Bounds.obj \
 $(OUTDIR)\.\Visualization\Renderer\CategoryAxis.obj \
 $(OUTDIR)\.\Visualization\Renderer\CurvedParallelCoordinatesRenderer.obj \
@@ -359,6 +366,7 @@ $(OUTDIR)\.\Visualization\Renderer\HeatmapRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\ImageRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\LineRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\LineRendererGLSL.obj \
+$(OUTDIR)\.\Visualization\Renderer\MaxReductionBuffer.obj \
 $(OUTDIR)\.\Visualization\Renderer\ParallelAxis.obj \
 $(OUTDIR)\.\Visualization\Renderer\ParallelCoordinatesRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\ParticleBasedRenderer.obj \
@@ -391,9 +399,11 @@ $(OUTDIR)\.\Visualization\Renderer\StochasticRenderingEngine.obj \
 $(OUTDIR)\.\Visualization\Renderer\StochasticTetrahedraRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\StochasticUniformGridRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\StylizedLineRenderer.obj \
+$(OUTDIR)\.\Visualization\Renderer\TableBuffer.obj \
 $(OUTDIR)\.\Visualization\Renderer\ValueAxis.obj \
 $(OUTDIR)\.\Visualization\Renderer\VolumeRayIntersector.obj \
 $(OUTDIR)\.\Visualization\Renderer\VolumeRendererBase.obj \
+$(OUTDIR)\.\Visualization\Renderer\WeightedBlendedBuffer.obj \
 $(OUTDIR)\.\Visualization\Viewer\ApplicationBase.obj \
 $(OUTDIR)\.\Visualization\Viewer\Background.obj \
 $(OUTDIR)\.\Visualization\Viewer\Camera.obj \
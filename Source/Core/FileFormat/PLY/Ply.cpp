@@ -15,6 +15,11 @@
 #include <kvs/IgnoreUnusedVariable>
 #include <kvs/File>
 #include <kvs/Assert>
+#include <kvs/Endian>
+#include <kvs/MappedFile>
+#include <kvs/OpenMP>
+#include <sstream>
+#include <vector>
 #include "Ply.h"
 #include "PlyFile.h"
 
@@ -79,6 +84,188 @@ kvs::ply::PlyProperty FaceProps[1] =
 
 } // end of namespace
 
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Property description in the PLY header.
+ */
+/*===========================================================================*/
+struct PropertyInfo
+{
+    std::string name; ///< property name
+    int type = 0; ///< value type (or item type for the list property)
+    int count_type = 0; ///< count type for the list property
+    bool is_list = false; ///< true if the property is a list
+    size_t offset = 0; ///< byte offset in the element
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Element description in the PLY header.
+ */
+/*===========================================================================*/
+struct ElementInfo
+{
+    std::string name; ///< element name
+    size_t count = 0; ///< number of elements
+    std::vector<PropertyInfo> properties; ///< properties
+
+    const PropertyInfo* find( const std::string& property_name ) const
+    {
+        for ( const auto& property : properties )
+        {
+            if ( property.name == property_name ) { return &property; }
+        }
+        return nullptr;
+    }
+};
+
+int TypeOf( const std::string& name )
+{
+    if ( name == "char" || name == "int8" ) { return PLY_CHAR; }
+    if ( name == "short" || name == "int16" ) { return PLY_SHORT; }
+    if ( name == "int" || name == "int32" ) { return PLY_INT; }
+    if ( name == "uchar" || name == "uint8" ) { return PLY_UCHAR; }
+    if ( name == "ushort" || name == "uint16" ) { return PLY_USHORT; }
+    if ( name == "uint" || name == "uint32" ) { return PLY_UINT; }
+    if ( name == "float" || name == "float32" ) { return PLY_FLOAT; }
+    if ( name == "double" || name == "float64" ) { return PLY_DOUBLE; }
+    return PLY_START_TYPE;
+}
+
+size_t SizeOf( const int type )
+{
+    switch ( type )
+    {
+    case PLY_CHAR: case PLY_UCHAR: return 1;
+    case PLY_SHORT: case PLY_USHORT: return 2;
+    case PLY_INT: case PLY_UINT: case PLY_FLOAT: return 4;
+    case PLY_DOUBLE: return 8;
+    default: return 0;
+    }
+}
+
+template <typename T>
+inline T Read( const unsigned char* p, const bool swap )
+{
+    T value;
+    std::memcpy( &value, p, sizeof(T) );
+    if ( swap ) { kvs::Endian::Swap( &value ); }
+    return value;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Decodes a binary value of the given type with the type conversion.
+ *  @param  p [in] pointer to the value
+ *  @param  type [in] value type
+ *  @param  swap [in] true if the byte order is swapped
+ *  @return decoded value
+ */
+/*===========================================================================*/
+template <typename T>
+inline T Decode( const unsigned char* p, const int type, const bool swap )
+{
+    switch ( type )
+    {
+    case PLY_CHAR: return static_cast<T>( Read<kvs::Int8>( p, false ) );
+    case PLY_UCHAR: return static_cast<T>( Read<kvs::UInt8>( p, false ) );
+    case PLY_SHORT: return static_cast<T>( Read<kvs::Int16>( p, swap ) );
+    case PLY_USHORT: return static_cast<T>( Read<kvs::UInt16>( p, swap ) );
+    case PLY_INT: return static_cast<T>( Read<kvs::Int32>( p, swap ) );
+    case PLY_UINT: return static_cast<T>( Read<kvs::UInt32>( p, swap ) );
+    case PLY_FLOAT: return static_cast<T>( Read<kvs::Real32>( p, swap ) );
+    case PLY_DOUBLE: return static_cast<T>( Read<kvs::Real64>( p, swap ) );
+    default: return T(0);
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the PLY header in the mapped file.
+ *  @param  data [in] pointer to the file data
+ *  @param  size [in] file size
+ *  @param  format [out] format name
+ *  @param  elements [out] element descriptions
+ *  @param  header_size [out] header size in bytes
+ *  @return true if the header is parsed successfully
+ */
+/*===========================================================================*/
+bool ParseHeader(
+    const unsigned char* data,
+    const size_t size,
+    std::string& format,
+    std::vector<ElementInfo>& elements,
+    size_t& header_size )
+{
+    size_t position = 0;
+    bool is_first_line = true;
+    while ( position < size )
+    {
+        const unsigned char* head = data + position;
+        const void* tail = std::memchr( head, '\n', size - position );
+        if ( !tail ) { return false; }
+
+        const size_t length = static_cast<const unsigned char*>( tail ) - head;
+        std::string line( reinterpret_cast<const char*>( head ), length );
+        if ( !line.empty() && line.back() == '\r' ) { line.pop_back(); }
+        position += length + 1;
+
+        std::istringstream stream( line );
+        std::string keyword;
+        stream >> keyword;
+        if ( is_first_line )
+        {
+            if ( keyword != "ply" ) { return false; }
+            is_first_line = false;
+        }
+        else if ( keyword == "format" )
+        {
+            stream >> format;
+        }
+        else if ( keyword == "element" )
+        {
+            ElementInfo element;
+            stream >> element.name >> element.count;
+            elements.push_back( element );
+        }
+        else if ( keyword == "property" )
+        {
+            if ( elements.empty() ) { return false; }
+            PropertyInfo property;
+            std::string type;
+            stream >> type;
+            if ( type == "list" )
+            {
+                std::string count_type, item_type;
+                stream >> count_type >> item_type;
+                property.is_list = true;
+                property.count_type = TypeOf( count_type );
+                property.type = TypeOf( item_type );
+                if ( property.count_type == PLY_START_TYPE ) { return false; }
+            }
+            else
+            {
+                property.type = TypeOf( type );
+            }
+            if ( property.type == PLY_START_TYPE ) { return false; }
+            stream >> property.name;
+            elements.back().properties.push_back( property );
+        }
+        else if ( keyword == "end_header" )
+        {
+            header_size = position;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // end of namespace
+
 namespace kvs
 {
 
@@ -222,6 +409,15 @@ bool Ply::read( const std::string& filename )
     BaseClass::setFilename( filename );
     BaseClass::setSuccess( true );
 
+    // Binary file with triangle faces is decoded directly from the mapped file.
+    if ( this->read_binary( filename ) )
+    {
+        this->calculate_min_max_coord();
+        if ( !m_has_normals ) this->calculate_normals();
+        if ( !m_has_connections ) m_nfaces = m_nverts / 3;
+        return true;
+    }
+
     // Read PLY file.
     kvs::ply::PlyFile* ply;
     int nelems;
@@ -488,6 +684,177 @@ bool Ply::write( const std::string& filename )
     return true;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Reads the binary PLY file via the memory mapping.
+ *  @param  filename [in] filename
+ *  @return true if the file is read by this method
+ *
+ *  The element offsets are computed from the header and the vertex and face
+ *  properties are decoded in parallel directly into the value arrays. This
+ *  method returns false without modifying the data for the files that cannot
+ *  be handled here (ascii format, faces other than triangles, list properties
+ *  in or preceding the vertex and face elements except for vertex_indices),
+ *  which are then read through the generic PLY reader.
+ */
+/*===========================================================================*/
+bool Ply::read_binary( const std::string& filename )
+{
+    kvs::MappedFile file;
+    if ( !file.open( filename ) ) { return false; }
+
+    std::string format;
+    std::vector<::ElementInfo> elements;
+    size_t header_size = 0;
+    if ( !::ParseHeader( file.data(), file.size(), format, elements, header_size ) ) { return false; }
+
+    bool is_big_endian = false;
+    if ( format == "binary_little_endian" ) { is_big_endian = false; }
+    else if ( format == "binary_big_endian" ) { is_big_endian = true; }
+    else { return false; }
+    const bool swap = ( is_big_endian != kvs::Endian::IsBig() );
+
+    // Compute the element offsets and strides. The face element is assumed to
+    // consist of triangles, which is verified in decoding.
+    const ::ElementInfo* vertex = nullptr;
+    const ::ElementInfo* face = nullptr;
+    size_t vertex_offset = 0, vertex_stride = 0;
+    size_t face_offset = 0, face_stride = 0;
+    size_t offset = header_size;
+    for ( auto& element : elements )
+    {
+        const bool is_vertex = ( element.name == "vertex" );
+        const bool is_face = ( element.name == "face" && element.find( "vertex_indices" ) );
+
+        size_t stride = 0;
+        for ( auto& property : element.properties )
+        {
+            property.offset = stride;
+            if ( !property.is_list )
+            {
+                stride += ::SizeOf( property.type );
+            }
+            else if ( is_face && property.name == "vertex_indices" )
+            {
+                stride += ::SizeOf( property.count_type ) + 3 * ::SizeOf( property.type );
+            }
+            else
+            {
+                // The vertex and face elements have to be fixed-size records,
+                // and the offsets of the elements after a variable-size one
+                // are unknown.
+                if ( is_vertex || is_face || !vertex || !face ) { return false; }
+                stride = 0;
+                break;
+            }
+        }
+
+        if ( is_vertex ) { vertex = &element; vertex_offset = offset; vertex_stride = stride; }
+        if ( is_face ) { face = &element; face_offset = offset; face_stride = stride; }
+        if ( stride == 0 && element.count > 0 ) { break; }
+        offset += element.count * stride;
+    }
+
+    if ( !vertex ) { return false; }
+    if ( vertex->count > 0 && vertex_stride == 0 ) { return false; }
+    if ( face && face->count > 0 && face_stride == 0 ) { return false; }
+    if ( vertex_offset + vertex->count * vertex_stride > file.size() ) { return false; }
+    if ( face && face_offset + face->count * face_stride > file.size() ) { return false; }
+
+    const ::PropertyInfo* x = vertex->find( "x" );
+    const ::PropertyInfo* y = vertex->find( "y" );
+    const ::PropertyInfo* z = vertex->find( "z" );
+    if ( !x || !y || !z ) { return false; }
+
+    const ::PropertyInfo* r = vertex->find( "red" );
+    const ::PropertyInfo* g = vertex->find( "green" );
+    const ::PropertyInfo* b = vertex->find( "blue" );
+    const bool has_colors = r && g && b;
+
+    const ::PropertyInfo* nx = vertex->find( "nx" );
+    const ::PropertyInfo* ny = vertex->find( "ny" );
+    const ::PropertyInfo* nz = vertex->find( "nz" );
+    const bool has_normals = nx && ny && nz;
+
+    // Decode the triangle connections.
+    kvs::ValueArray<kvs::UInt32> connections;
+    if ( face )
+    {
+        const ::PropertyInfo* indices = face->find( "vertex_indices" );
+        const size_t count_size = ::SizeOf( indices->count_type );
+        const size_t index_size = ::SizeOf( indices->type );
+        const long nfaces = static_cast<long>( face->count );
+        const unsigned char* head = file.data() + face_offset + indices->offset;
+
+        connections.allocate( face->count * 3 );
+        kvs::UInt32* pconnections = connections.data();
+        long ninvalids = 0;
+        KVS_OMP_PARALLEL_FOR( reduction(+:ninvalids) )
+        for ( long i = 0; i < nfaces; i++ )
+        {
+            const unsigned char* p = head + i * face_stride;
+            const int nverts = ::Decode<int>( p, indices->count_type, swap );
+            if ( nverts != 3 ) { ninvalids++; continue; }
+            p += count_size;
+            pconnections[ 3 * i + 0 ] = ::Decode<kvs::UInt32>( p, indices->type, swap );
+            pconnections[ 3 * i + 1 ] = ::Decode<kvs::UInt32>( p + index_size, indices->type, swap );
+            pconnections[ 3 * i + 2 ] = ::Decode<kvs::UInt32>( p + 2 * index_size, indices->type, swap );
+        }
+
+        // Faces other than triangles are read through the generic reader.
+        if ( ninvalids > 0 ) { return false; }
+    }
+
+    // Decode the vertex properties.
+    const long nverts = static_cast<long>( vertex->count );
+    const unsigned char* head = file.data() + vertex_offset;
+
+    kvs::ValueArray<kvs::Real32> coords( vertex->count * 3 );
+    kvs::ValueArray<kvs::UInt8> colors;
+    kvs::ValueArray<kvs::Real32> normals;
+    if ( has_colors ) { colors.allocate( vertex->count * 3 ); }
+    if ( has_normals ) { normals.allocate( vertex->count * 3 ); }
+
+    kvs::Real32* pcoords = coords.data();
+    kvs::UInt8* pcolors = colors.data();
+    kvs::Real32* pnormals = normals.data();
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nverts; i++ )
+    {
+        const unsigned char* p = head + i * vertex_stride;
+        pcoords[ 3 * i + 0 ] = ::Decode<kvs::Real32>( p + x->offset, x->type, swap );
+        pcoords[ 3 * i + 1 ] = ::Decode<kvs::Real32>( p + y->offset, y->type, swap );
+        pcoords[ 3 * i + 2 ] = ::Decode<kvs::Real32>( p + z->offset, z->type, swap );
+
+        if ( has_colors )
+        {
+            pcolors[ 3 * i + 0 ] = ::Decode<kvs::UInt8>( p + r->offset, r->type, swap );
+            pcolors[ 3 * i + 1 ] = ::Decode<kvs::UInt8>( p + g->offset, g->type, swap );
+            pcolors[ 3 * i + 2 ] = ::Decode<kvs::UInt8>( p + b->offset, b->type, swap );
+        }
+
+        if ( has_normals )
+        {
+            pnormals[ 3 * i + 0 ] = ::Decode<kvs::Real32>( p + nx->offset, nx->type, swap );
+            pnormals[ 3 * i + 1 ] = ::Decode<kvs::Real32>( p + ny->offset, ny->type, swap );
+            pnormals[ 3 * i + 2 ] = ::Decode<kvs::Real32>( p + nz->offset, nz->type, swap );
+        }
+    }
+
+    m_file_type = Ply::FileType( is_big_endian ? PLY_BINARY_BE : PLY_BINARY_LE );
+    m_nverts = vertex->count;
+    m_coords = coords;
+    m_has_colors = has_colors;
+    m_colors = colors;
+    m_has_normals = has_normals;
+    m_normals = normals;
+    m_has_connections = ( face != nullptr );
+    m_nfaces = face ? face->count : 0;
+    m_connections = connections;
+
+    return true;
+}
+
 void Ply::calculate_min_max_coord()
 {
     m_min_coord = kvs::Vector3f::Constant( std::numeric_limits<float>::max() );
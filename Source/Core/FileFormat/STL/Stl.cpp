@@ -6,8 +6,15 @@
 /*****************************************************************************/
 #include "Stl.h"
 #include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
 #include <kvs/File>
 #include <kvs/Assert>
+#include <kvs/Math>
+#include <kvs/Endian>
+#include <kvs/MappedFile>
+#include <kvs/OpenMP>
 
 
 namespace
@@ -39,6 +46,7 @@ bool IsAsciiType( FILE* ifs )
         if ( buffer[0] == '\n' ) continue;
 
         const char* head = strtok( buffer, ::Delimiter );
+        if ( !head ) return false;
         if ( !strcmp( head, "solid" ) ) break;
         else if ( !strcmp( head, "facet" ) ) return true;
         else return false;
@@ -59,6 +67,93 @@ bool IsAsciiType( FILE* ifs )
 
 } // end of namespace
 
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Sort key of the vertex for the welding.
+ */
+/*===========================================================================*/
+struct WeldKey
+{
+    kvs::UInt32 cell[3]; ///< cell index of the spatial hash (or bits of the coordinate)
+    kvs::UInt32 index; ///< vertex index in the triangle soup
+
+    bool operator <( const WeldKey& other ) const
+    {
+        if ( cell[0] != other.cell[0] ) return cell[0] < other.cell[0];
+        if ( cell[1] != other.cell[1] ) return cell[1] < other.cell[1];
+        if ( cell[2] != other.cell[2] ) return cell[2] < other.cell[2];
+        return index < other.index;
+    }
+
+    bool isSameCell( const WeldKey& other ) const
+    {
+        return cell[0] == other.cell[0] && cell[1] == other.cell[1] && cell[2] == other.cell[2];
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the cell index of the coordinate value.
+ *  @param  value [in] coordinate value
+ *  @param  inv_epsilon [in] inverse of the cell size (0 for the exact matching)
+ *  @return cell index
+ */
+/*===========================================================================*/
+inline kvs::UInt32 CellIndex( kvs::Real32 value, const double inv_epsilon )
+{
+    if ( inv_epsilon > 0.0 )
+    {
+        const double cell = std::floor( value * inv_epsilon );
+        const double limit = 2147483647.0;
+        return static_cast<kvs::UInt32>( static_cast<kvs::Int32>( kvs::Math::Clamp( cell, -limit, limit ) ) );
+    }
+
+    // -0 and +0 are regarded as the same value.
+    if ( value == 0.0f ) { value = 0.0f; }
+    kvs::UInt32 bits = 0;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+    return bits;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sorts the keys by sorting the chunks in parallel and merging them.
+ *  @param  keys [in/out] sort keys
+ */
+/*===========================================================================*/
+void ParallelSort( std::vector<WeldKey>& keys )
+{
+    const long nkeys = static_cast<long>( keys.size() );
+    const long nchunks = std::max( 1L, std::min<long>( kvs::OpenMP::GetMaxThreads(), nkeys / 4096 ) );
+    const long chunk_size = ( nkeys + nchunks - 1 ) / std::max( nchunks, 1L );
+
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nchunks; i++ )
+    {
+        const long begin = std::min( i * chunk_size, nkeys );
+        const long end = std::min( begin + chunk_size, nkeys );
+        std::sort( keys.begin() + begin, keys.begin() + end );
+    }
+
+    for ( long width = chunk_size; width < nkeys; width *= 2 )
+    {
+        const long npairs = ( nkeys + 2 * width - 1 ) / ( 2 * width );
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < npairs; i++ )
+        {
+            const long begin = i * 2 * width;
+            const long middle = std::min( begin + width, nkeys );
+            const long end = std::min( begin + 2 * width, nkeys );
+            std::inplace_merge( keys.begin() + begin, keys.begin() + middle, keys.begin() + end );
+        }
+    }
+}
+
+} // end of namespace
+
 namespace kvs
 {
 
@@ -120,6 +215,11 @@ void Stl::print( std::ostream& os, const kvs::Indent& indent ) const
     os << indent << "Filename : " << BaseClass::filename() << std::endl;
     os << indent << "File type : " << ::FileTypeToString[ m_file_type ] << std::endl;
     os << indent << "Number of triangles : " << m_normals.size() / 3;
+    if ( this->hasConnections() )
+    {
+        os << std::endl;
+        os << indent << "Number of vertices : " << m_coords.size() / 3;
+    }
 }
 
 /*===========================================================================*/
@@ -142,21 +242,23 @@ bool Stl::read( const std::string& filename )
         return false;
     }
 
+    m_connections.release();
+
     bool success = false;
     if ( ::IsAsciiType( ifs ) )
     {
         m_file_type = Stl::Ascii;
         success = this->read_ascii( ifs );
+        fclose( ifs );
     }
     else
     {
         m_file_type = Stl::Binary;
-        success = this->read_binary( ifs );
+        fclose( ifs );
+        success = this->read_binary( filename );
     }
     BaseClass::setSuccess( success );
 
-    fclose( ifs );
-
     return success;
 }
 
@@ -169,7 +271,23 @@ bool Stl::read( const std::string& filename )
 /*===========================================================================*/
 bool Stl::write( const std::string& filename )
 {
-    KVS_ASSERT( ( m_normals.size() / 3 ) == ( m_coords.size() / 9 ) );
+    // Welded vertices are expanded to the triangle soup.
+    kvs::ValueArray<kvs::Real32> coords = m_coords;
+    if ( this->hasConnections() )
+    {
+        const long nvertices = static_cast<long>( m_connections.size() );
+        coords.allocate( nvertices * 3 );
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < nvertices; i++ )
+        {
+            const kvs::UInt32 index = m_connections[i];
+            coords[ 3 * i + 0 ] = m_coords[ 3 * index + 0 ];
+            coords[ 3 * i + 1 ] = m_coords[ 3 * index + 1 ];
+            coords[ 3 * i + 2 ] = m_coords[ 3 * index + 2 ];
+        }
+    }
+
+    KVS_ASSERT( ( m_normals.size() / 3 ) == ( coords.size() / 9 ) );
 
     BaseClass::setFilename( filename );
     BaseClass::setSuccess( true );
@@ -185,11 +303,11 @@ bool Stl::write( const std::string& filename )
     bool success = false;
     if ( m_file_type == Stl::Ascii )
     {
-        success = this->write_ascii( ofs );
+        success = this->write_ascii( ofs, coords.data() );
     }
     else
     {
-        success = this->write_binary( ofs );
+        success = this->write_binary( ofs, coords.data() );
     }
     BaseClass::setSuccess( success );
 
@@ -198,6 +316,74 @@ bool Stl::write( const std::string& filename )
     return success;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Welds the vertices shared by the triangles.
+ *  @param  epsilon [in] cell size for the welding (0 for the exact matching)
+ *
+ *  The triangle soup is converted to the unique vertices and the connections.
+ *  The vertices are sorted by the cell index of the spatial hash in parallel,
+ *  and the vertices in the same cell are merged into the first one in the
+ *  file order. If epsilon is 0, only the identical coordinates are merged.
+ *  The per-triangle normal vectors are not changed.
+ */
+/*===========================================================================*/
+void Stl::weld( const kvs::Real32 epsilon )
+{
+    if ( this->hasConnections() ) { return; }
+
+    const long nvertices = static_cast<long>( m_coords.size() / 3 );
+    const double inv_epsilon = epsilon > 0.0f ? 1.0 / epsilon : 0.0;
+    const kvs::Real32* pcoords = m_coords.data();
+
+    // Sort the vertices by the cell index.
+    std::vector<::WeldKey> keys( nvertices );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nvertices; i++ )
+    {
+        keys[i].cell[0] = ::CellIndex( pcoords[ 3 * i + 0 ], inv_epsilon );
+        keys[i].cell[1] = ::CellIndex( pcoords[ 3 * i + 1 ], inv_epsilon );
+        keys[i].cell[2] = ::CellIndex( pcoords[ 3 * i + 2 ], inv_epsilon );
+        keys[i].index = static_cast<kvs::UInt32>( i );
+    }
+    ::ParallelSort( keys );
+
+    // Representative (first) vertex of each cell.
+    std::vector<kvs::UInt32> representatives( nvertices );
+    kvs::UInt32 representative = 0;
+    for ( long i = 0; i < nvertices; i++ )
+    {
+        if ( i == 0 || !keys[i].isSameCell( keys[i-1] ) ) { representative = keys[i].index; }
+        representatives[ keys[i].index ] = representative;
+    }
+
+    // New vertex IDs in the file order.
+    std::vector<kvs::UInt32> ids( nvertices );
+    kvs::UInt32 nwelded = 0;
+    for ( long i = 0; i < nvertices; i++ )
+    {
+        if ( representatives[i] == static_cast<kvs::UInt32>( i ) ) { ids[i] = nwelded++; }
+    }
+
+    kvs::ValueArray<kvs::Real32> coords( nwelded * 3 );
+    kvs::ValueArray<kvs::UInt32> connections( nvertices );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nvertices; i++ )
+    {
+        const kvs::UInt32 id = ids[ representatives[i] ];
+        connections[i] = id;
+        if ( representatives[i] == static_cast<kvs::UInt32>( i ) )
+        {
+            coords[ 3 * id + 0 ] = pcoords[ 3 * i + 0 ];
+            coords[ 3 * id + 1 ] = pcoords[ 3 * i + 1 ];
+            coords[ 3 * id + 2 ] = pcoords[ 3 * i + 2 ];
+        }
+    }
+
+    m_coords = coords;
+    m_connections = connections;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Check file type whether the ascii or the binary.
@@ -368,69 +554,59 @@ bool Stl::read_ascii( FILE* ifs )
 /*===========================================================================*/
 /**
  *  @brief  Reads the polygon data as binary format.
- *  @param  ifs [in] file pointer
+ *  @param  filename [in] filename
  *  @return true, if the reading process is done successfully
+ *
+ *  The file is memory-mapped and the 50-byte triangle records are decoded in
+ *  parallel.
  */
 /*===========================================================================*/
-bool Stl::read_binary( FILE* ifs )
+bool Stl::read_binary( const std::string& filename )
 {
-    // Go back file-pointer to head.
-    fseek( ifs, 0, SEEK_SET );
+    kvs::MappedFile file;
+    if ( !file.open( filename ) ) { return false; }
 
-    // Read header string (80bytes).
+    // Header string (80bytes) and number of triangles (4bytes).
     const size_t HeaderLength = 80;
-    char buffer[ HeaderLength ];
-    if ( fread( buffer, sizeof( char ), HeaderLength, ifs ) != HeaderLength )
+    if ( file.size() < HeaderLength + sizeof( kvs::UInt32 ) )
     {
-        kvsMessageError("Cannot read a header string (80byets).");
+        kvsMessageError("Cannot read a header string (80byets) and a number of triangles.");
         return false;
     }
 
-    // Read a number of triangles (4bytes).
+    // NOTE: The binary STL is stored in little endian.
+    const bool swap = kvs::Endian::IsBig();
     kvs::UInt32 ntriangles = 0;
-    if ( fread( &ntriangles, sizeof( kvs::UInt32 ), 1, ifs ) != 1 )
+    std::memcpy( &ntriangles, file.data() + HeaderLength, sizeof( kvs::UInt32 ) );
+    if ( swap ) { kvs::Endian::Swap( &ntriangles ); }
+
+    // Triangle record: normal vector (4x3=12bytes), coordinate values
+    // (4x9=36bytes) and unused block (2bytes).
+    const size_t RecordLength = 50;
+    const unsigned char* records = file.data() + HeaderLength + sizeof( kvs::UInt32 );
+    if ( file.size() - HeaderLength - sizeof( kvs::UInt32 ) < size_t( ntriangles ) * RecordLength )
     {
-        kvsMessageError("Cannot read a number of triangles.");
+        kvsMessageError("Cannot read %u triangles.", ntriangles );
         return false;
     }
 
-    // Memory allocation.
-    m_normals.allocate( ntriangles * 3 );
-    m_coords.allocate( ntriangles * 9 );
-
-    // Read trianbles.
+    // NOTE: The unused block is sometimes used for storing color infomartion,
+    // but we don't currently supported such color STL format.
+    m_normals.allocate( size_t( ntriangles ) * 3 );
+    m_coords.allocate( size_t( ntriangles ) * 9 );
     kvs::Real32* normals = m_normals.data();
     kvs::Real32* coords = m_coords.data();
-    kvs::UInt32 index3 = 0;
-    kvs::UInt32 index9 = 0;
-    for ( kvs::UInt32 i = 0; i < ntriangles; i++, index3 += 3, index9 += 9 )
+    const long nrecords = static_cast<long>( ntriangles );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nrecords; i++ )
     {
-        // Normal vector (4x3=12byets)
-        if ( fread( normals + index3, sizeof( kvs::Real32 ), 3, ifs ) != 3 )
+        const unsigned char* record = records + i * RecordLength;
+        std::memcpy( normals + 3 * i, record, sizeof( kvs::Real32 ) * 3 );
+        std::memcpy( coords + 9 * i, record + 12, sizeof( kvs::Real32 ) * 9 );
+        if ( swap )
         {
-            kvsMessageError("Cannot read a normal vector.");
-            m_normals.release();
-            return false;
-        }
-
-        // Coordinate value (4x3=12bytes)
-        if ( fread( coords + index9, sizeof( kvs::Real32 ), 9, ifs ) != 9 )
-        {
-            kvsMessageError("Cannot read a coordinate value.");
-            m_coords.release();
-            return false;
-        }
-
-        // Unused (2bytes)
-        // NOTE: This block is sometimes used for storing color infomartion,
-        // but we don't currently supported such color STL format.
-        char unused[2];
-        if ( fread( unused, sizeof( char ), 2, ifs ) != 2 )
-        {
-            kvsMessageError("Cannot read unused block (2bytes).");
-            m_normals.release();
-            m_coords.release();
-            return false;
+            kvs::Endian::Swap( normals + 3 * i, 3 );
+            kvs::Endian::Swap( coords + 9 * i, 9 );
         }
     }
 
@@ -440,11 +616,12 @@ bool Stl::read_binary( FILE* ifs )
 /*===========================================================================*/
 /**
  *  @brief  Writes the polygon data as ascii format.
- *  @param  ifs [in] file pointer
+ *  @param  ofs [in] file pointer
+ *  @param  coords [in] coordinate values of the triangle soup
  *  @return true, if the writting process is done successfully
  */
 /*===========================================================================*/
-bool Stl::write_ascii( FILE* ofs )
+bool Stl::write_ascii( FILE* ofs, const kvs::Real32* coords )
 {
     const char* header = "Generated by KVS";
     fprintf( ofs, "solid %s\n", header );
@@ -460,17 +637,17 @@ bool Stl::write_ascii( FILE* ofs )
                  m_normals[ index3 + 2 ] );
         fprintf( ofs, "outer loop\n" );
         fprintf( ofs, "vertex %f %f %f\n",
-                 m_coords[ index9 + 0 ],
-                 m_coords[ index9 + 1 ],
-                 m_coords[ index9 + 2 ] );
+                 coords[ index9 + 0 ],
+                 coords[ index9 + 1 ],
+                 coords[ index9 + 2 ] );
         fprintf( ofs, "vertex %f %f %f\n",
-                 m_coords[ index9 + 3 ],
-                 m_coords[ index9 + 4 ],
-                 m_coords[ index9 + 5 ] );
+                 coords[ index9 + 3 ],
+                 coords[ index9 + 4 ],
+                 coords[ index9 + 5 ] );
         fprintf( ofs, "vertex %f %f %f\n",
-                 m_coords[ index9 + 6 ],
-                 m_coords[ index9 + 7 ],
-                 m_coords[ index9 + 8 ] );
+                 coords[ index9 + 6 ],
+                 coords[ index9 + 7 ],
+                 coords[ index9 + 8 ] );
         fprintf( ofs, "endloop\n" );
         fprintf( ofs, "endfacet\n" );
     }
@@ -483,11 +660,12 @@ bool Stl::write_ascii( FILE* ofs )
 /*===========================================================================*/
 /**
  *  @brief  Writes the polygon data as binary format.
- *  @param  ifs [in] file pointer
+ *  @param  ofs [in] file pointer
+ *  @param  coords [in] coordinate values of the triangle soup
  *  @return true, if the writting process is done successfully
  */
 /*===========================================================================*/
-bool Stl::write_binary( FILE* ofs )
+bool Stl::write_binary( FILE* ofs, const kvs::Real32* coords )
 {
     // Header string (80bytes).
     char header[80]; memset( header, 0, 80 );
@@ -508,7 +686,6 @@ bool Stl::write_binary( FILE* ofs )
 
     // Triangles (50*ntriangles bytes)
     const kvs::Real32* normals = m_normals.data();
-    const kvs::Real32* coords = m_coords.data();
     size_t index3 = 0;
     size_t index9 = 0;
     for ( size_t i = 0; i < ntriangles; i++, index3 += 3, index9 += 9 )
@@ -7,6 +7,7 @@
 #include "BitImage.h"
 #include "ColorImage.h"
 #include "GrayImage.h"
+#include "ImageFilter.h"
 #include <kvs/Matrix44>
 #include <kvs/Math>
 #include <kvs/Binary>
@@ -617,6 +618,30 @@ void BitImage::invert()
     }
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Erodes the active pixels with the square structuring element.
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void BitImage::erode( const size_t radius )
+{
+    kvs::UInt8* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::BitErode( BaseClass::width(), BaseClass::height(), pixels, radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Dilates the active pixels with the square structuring element.
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void BitImage::dilate( const size_t radius )
+{
+    kvs::UInt8* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::BitDilate( BaseClass::width(), BaseClass::height(), pixels, radius );
+}
+
 /*==========================================================================*/
 /**
  *  Read a image file.
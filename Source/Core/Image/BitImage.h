@@ -60,6 +60,8 @@ public:
     void invert( const size_t index );
     void invert( const size_t i, const size_t j );
     void invert();
+    void erode( const size_t radius );
+    void dilate( const size_t radius );
     bool read( const std::string& filename );
     bool write( const std::string& filename );
 
@@ -7,6 +7,7 @@
 #include "ColorImage.h"
 #include "GrayImage.h"
 #include "BitImage.h"
+#include "ImageFilter.h"
 #include <kvs/IgnoreUnusedVariable>
 #include <kvs/KVSMLImageObject>
 #include <kvs/RGBColor>
@@ -221,6 +222,118 @@ void ColorImage::resize( const size_t width, const size_t height, Interpolator i
     BaseClass::resizeImage( width, height, this, interpolator );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Scales the image data with the separable resampling filter.
+ *  @param  ratio [in] scaling ratio
+ *  @param  filter [in] resampling filter
+ */
+/*===========================================================================*/
+void ColorImage::scale( const double ratio, const ResamplingFilter filter )
+{
+    const size_t width = static_cast<size_t>( BaseClass::width() * ratio );
+    const size_t height = static_cast<size_t>( BaseClass::height() * ratio );
+    BaseClass::resampleImage( width, height, filter );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resizes the image data with the separable resampling filter.
+ *  @param  width  [in] resized width
+ *  @param  height [in] resized height
+ *  @param  filter [in] resampling filter
+ */
+/*===========================================================================*/
+void ColorImage::resize( const size_t width, const size_t height, const ResamplingFilter filter )
+{
+    BaseClass::resampleImage( width, height, filter );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Blurs the image with the box filter.
+ *  @param  radius [in] filter radius (the filter size is 2 * radius + 1)
+ */
+/*===========================================================================*/
+void ColorImage::boxBlur( const size_t radius )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::BoxBlur( BaseClass::width(), BaseClass::height(), 3, pixels, radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Blurs the image with the Gaussian filter.
+ *  @param  sigma [in] standard deviation of the Gaussian
+ */
+/*===========================================================================*/
+void ColorImage::gaussianBlur( const double sigma )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::GaussianBlur( BaseClass::width(), BaseClass::height(), 3, pixels, sigma );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolves the image with the separable kernel.
+ *  @param  kernel [in] kernel used in both horizontal and vertical directions
+ */
+/*===========================================================================*/
+void ColorImage::convolve( const kvs::ValueArray<kvs::Real32>& kernel )
+{
+    this->convolve( kernel, kernel );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolves the image with the separable kernel.
+ *  @param  xkernel [in] kernel in horizontal direction
+ *  @param  ykernel [in] kernel in vertical direction
+ */
+/*===========================================================================*/
+void ColorImage::convolve(
+    const kvs::ValueArray<kvs::Real32>& xkernel,
+    const kvs::ValueArray<kvs::Real32>& ykernel )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Convolve( BaseClass::width(), BaseClass::height(), 3, pixels, xkernel, ykernel );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Replaces the image with the gradient magnitude by the Sobel filter.
+ */
+/*===========================================================================*/
+void ColorImage::sobel()
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Sobel( BaseClass::width(), BaseClass::height(), 3, pixels );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Erodes the image with the square structuring element.
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void ColorImage::erode( const size_t radius )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Erode( BaseClass::width(), BaseClass::height(), 3, pixels, radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Dilates the image with the square structuring element.
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void ColorImage::dilate( const size_t radius )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Dilate( BaseClass::width(), BaseClass::height(), 3, pixels, radius );
+}
+
 /*==========================================================================*/
 /**
  *  Read a image file.
@@ -50,6 +50,16 @@ public:
     void setPixel( const size_t i, const size_t j, const kvs::RGBColor& pixel );
     void scale( const double ratio, Interpolator interpolator = Bilinear() );
     void resize( const size_t width, const size_t height, Interpolator interpolator = Bilinear() );
+    void scale( const double ratio, const ResamplingFilter filter );
+    void resize( const size_t width, const size_t height, const ResamplingFilter filter );
+
+    void boxBlur( const size_t radius );
+    void gaussianBlur( const double sigma );
+    void convolve( const kvs::ValueArray<kvs::Real32>& kernel );
+    void convolve( const kvs::ValueArray<kvs::Real32>& xkernel, const kvs::ValueArray<kvs::Real32>& ykernel );
+    void sobel();
+    void erode( const size_t radius );
+    void dilate( const size_t radius );
     bool read( const std::string& filename );
     bool write( const std::string& filename ) const;
 
@@ -7,6 +7,7 @@
 #include "GrayImage.h"
 #include "ColorImage.h"
 #include "BitImage.h"
+#include "ImageFilter.h"
 #include <kvs/IgnoreUnusedVariable>
 #include <kvs/Math>
 #include <kvs/File>
@@ -478,6 +479,118 @@ void GrayImage::resize( const size_t width, const size_t height, Interpolator in
     BaseClass::resizeImage( width, height, this, interpolator );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Scales the image data with the separable resampling filter.
+ *  @param  ratio [in] scaling ratio
+ *  @param  filter [in] resampling filter
+ */
+/*===========================================================================*/
+void GrayImage::scale( const double ratio, const ResamplingFilter filter )
+{
+    const size_t width = static_cast<size_t>( BaseClass::width() * ratio );
+    const size_t height = static_cast<size_t>( BaseClass::height() * ratio );
+    BaseClass::resampleImage( width, height, filter );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resizes the image data with the separable resampling filter.
+ *  @param  width  [in] resized width
+ *  @param  height [in] resized height
+ *  @param  filter [in] resampling filter
+ */
+/*===========================================================================*/
+void GrayImage::resize( const size_t width, const size_t height, const ResamplingFilter filter )
+{
+    BaseClass::resampleImage( width, height, filter );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Blurs the image with the box filter.
+ *  @param  radius [in] filter radius (the filter size is 2 * radius + 1)
+ */
+/*===========================================================================*/
+void GrayImage::boxBlur( const size_t radius )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::BoxBlur( BaseClass::width(), BaseClass::height(), 1, pixels, radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Blurs the image with the Gaussian filter.
+ *  @param  sigma [in] standard deviation of the Gaussian
+ */
+/*===========================================================================*/
+void GrayImage::gaussianBlur( const double sigma )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::GaussianBlur( BaseClass::width(), BaseClass::height(), 1, pixels, sigma );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolves the image with the separable kernel.
+ *  @param  kernel [in] kernel used in both horizontal and vertical directions
+ */
+/*===========================================================================*/
+void GrayImage::convolve( const kvs::ValueArray<kvs::Real32>& kernel )
+{
+    this->convolve( kernel, kernel );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolves the image with the separable kernel.
+ *  @param  xkernel [in] kernel in horizontal direction
+ *  @param  ykernel [in] kernel in vertical direction
+ */
+/*===========================================================================*/
+void GrayImage::convolve(
+    const kvs::ValueArray<kvs::Real32>& xkernel,
+    const kvs::ValueArray<kvs::Real32>& ykernel )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Convolve( BaseClass::width(), BaseClass::height(), 1, pixels, xkernel, ykernel );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Replaces the image with the gradient magnitude by the Sobel filter.
+ */
+/*===========================================================================*/
+void GrayImage::sobel()
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Sobel( BaseClass::width(), BaseClass::height(), 1, pixels );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Erodes the image with the square structuring element.
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void GrayImage::erode( const size_t radius )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Erode( BaseClass::width(), BaseClass::height(), 1, pixels, radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Dilates the image with the square structuring element.
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void GrayImage::dilate( const size_t radius )
+{
+    auto* pixels = BaseClass::pixelData().data();
+    kvs::ImageFilter::Dilate( BaseClass::width(), BaseClass::height(), 1, pixels, radius );
+}
+
 /*==========================================================================*/
 /**
  *  Read a image file.
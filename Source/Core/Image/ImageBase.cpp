@@ -9,6 +9,7 @@
 #include "GrayImage.h"
 #include "RGBColor.h"
 #include <kvs/Type>
+#include <kvs/OpenMP>
 #include <utility>
 
 
@@ -214,7 +215,8 @@ void ImageBase::resizeImage(
 
     const double ratio_width  = m_width / static_cast<double>( width );
     const double ratio_height = m_height / static_cast<double>( height );
-    for ( size_t j = 0; j < height; j++ )
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long j = 0; j < static_cast<long>( height ); j++ )
     {
         const double v = j * ratio_height;
         for ( size_t i = 0; i < width; i++ )
@@ -228,6 +230,31 @@ void ImageBase::resizeImage(
     *image = resized_image;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Resamples the image data with the separable filter.
+ *  @param  width [in] resampled width
+ *  @param  height [in] resampled height
+ *  @param  filter [in] resampling filter
+ */
+/*===========================================================================*/
+void ImageBase::resampleImage(
+    const size_t width,
+    const size_t height,
+    const ResamplingFilter filter )
+{
+    // Bit image is not supported.
+    const size_t nchannels = m_bpp / 8;
+    if ( nchannels == 0 ) { return; }
+
+    PixelData pixels( width * height * nchannels );
+    const kvs::ImageResampler resampler( filter );
+    resampler.resample( m_width, m_height, nchannels, m_pixels.data(), width, height, pixels.data() );
+
+    const auto type = static_cast<ImageType>( nchannels );
+    this->create( width, height, type, pixels );
+}
+
 template void ImageBase::resizeImage<kvs::GrayImage,ImageBase::GrayInterpolator>(
     const size_t, const size_t, kvs::GrayImage*, GrayInterpolator );
 
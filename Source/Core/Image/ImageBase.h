@@ -11,6 +11,7 @@
 #include <kvs/Math>
 #include <kvs/RGBColor>
 #include <kvs/Deprecated>
+#include <kvs/ImageResampler>
 #include <functional>
 
 
@@ -37,6 +38,7 @@ public:
     };
 
     using PixelData = kvs::ValueArray<kvs::UInt8>;
+    using ResamplingFilter = kvs::ImageResampler::Filter;
 
 protected:
     using GrayInterpolator = std::function<kvs::UInt8(double,double,const GrayImage&)>;
@@ -84,6 +86,11 @@ protected:
         Image* image,
         Interpolator interpolator );
 
+    void resampleImage(
+        const size_t width,
+        const size_t height,
+        const ResamplingFilter filter );
+
 public:
     KVS_DEPRECATED( const kvs::ValueArray<kvs::UInt8>& data() const ) { return this->pixels(); }
     KVS_DEPRECATED( kvs::ValueArray<kvs::UInt8>& data() ) { return this->pixelData(); }
@@ -0,0 +1,721 @@
+/****************************************************************************/
+/**
+ *  @file   ImageFilter.cpp
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#include "ImageFilter.h"
+#include <kvs/Math>
+#include <kvs/OpenMP>
+#include <kvs/Assert>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+
+namespace
+{
+
+const size_t StripWidth = 64; ///< number of columns in a strip (multiple of 8 for bit image)
+const size_t MaxLanes = StripWidth * 4; ///< max. number of lanes in a line
+
+/*===========================================================================*/
+/**
+ *  @brief  Accessor for the 8-bit interleaved pixel data.
+ */
+/*===========================================================================*/
+struct ByteAccessor
+{
+    size_t width;
+    size_t height;
+    size_t nchannels;
+    kvs::UInt8* pixels;
+
+    float load( const size_t i, const size_t j, const size_t c ) const
+    {
+        return pixels[ ( j * width + i ) * nchannels + c ];
+    }
+
+    void store( const size_t i, const size_t j, const size_t c, const float value ) const
+    {
+        const float v = kvs::Math::Clamp( value, 0.0f, 255.0f ) + 0.5f;
+        pixels[ ( j * width + i ) * nchannels + c ] = static_cast<kvs::UInt8>( v );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Accessor for the bit pixel data (MSB first).
+ */
+/*===========================================================================*/
+struct BitAccessor
+{
+    size_t width;
+    size_t height;
+    size_t nchannels;
+    kvs::UInt8* pixels;
+    size_t bpl;
+
+    float load( const size_t i, const size_t j, const size_t ) const
+    {
+        const kvs::UInt8 mask = static_cast<kvs::UInt8>( 0x80 >> ( i & 7 ) );
+        return ( pixels[ j * bpl + ( i >> 3 ) ] & mask ) ? 1.0f : 0.0f;
+    }
+
+    void store( const size_t i, const size_t j, const size_t, const float value ) const
+    {
+        const kvs::UInt8 mask = static_cast<kvs::UInt8>( 0x80 >> ( i & 7 ) );
+        kvs::UInt8& byte = pixels[ j * bpl + ( i >> 3 ) ];
+        byte = ( value >= 0.5f ) ? ( byte | mask ) : ( byte & ~mask );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Line data passed to the line operators.
+ *
+ *  The element (i,c) of the line is stored at [i * lanes + c]. The source and
+ *  the work buffers can be accessed in [-pad, length + pad), and the
+ *  destination buffer in [0, length).
+ */
+/*===========================================================================*/
+struct Line
+{
+    const float* src; ///< source line
+    float* dst; ///< destination line
+    float* work0; ///< work buffer
+    float* work1; ///< work buffer
+    long length; ///< number of elements
+    size_t lanes; ///< number of lanes for each element
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Applies the line operator to the image rows.
+ *  @param  accessor [in] pixel data accessor
+ *  @param  pad [in] number of padded elements at both sides of the line
+ *  @param  op [in] line operator
+ */
+/*===========================================================================*/
+template <typename Accessor, typename LineOperator>
+void FilterRows( const Accessor& accessor, const long pad, LineOperator op )
+{
+    const long width = static_cast<long>( accessor.width );
+    const long height = static_cast<long>( accessor.height );
+    const size_t lanes = accessor.nchannels;
+    const size_t extent = ( width + 2 * pad ) * lanes;
+
+    KVS_OMP_PARALLEL()
+    {
+        std::vector<float> src( extent );
+        std::vector<float> work0( extent );
+        std::vector<float> work1( extent );
+        std::vector<float> dst( width * lanes );
+
+        Line line;
+        line.src = src.data() + pad * lanes;
+        line.dst = dst.data();
+        line.work0 = work0.data() + pad * lanes;
+        line.work1 = work1.data() + pad * lanes;
+        line.length = width;
+        line.lanes = lanes;
+
+        KVS_OMP_FOR( schedule(static) )
+        for ( long j = 0; j < height; j++ )
+        {
+            for ( long i = -pad; i < width + pad; i++ )
+            {
+                const size_t index = static_cast<size_t>( kvs::Math::Clamp( i, 0L, width - 1 ) );
+                float* s = src.data() + ( i + pad ) * lanes;
+                for ( size_t c = 0; c < lanes; c++ ) { s[c] = accessor.load( index, j, c ); }
+            }
+
+            op( line );
+
+            for ( long i = 0; i < width; i++ )
+            {
+                const float* d = dst.data() + i * lanes;
+                for ( size_t c = 0; c < lanes; c++ ) { accessor.store( i, j, c, d[c] ); }
+            }
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Applies the line operator to the image columns.
+ *  @param  accessor [in] pixel data accessor
+ *  @param  pad [in] number of padded elements at both sides of the line
+ *  @param  op [in] line operator
+ *
+ *  The columns are processed in strips of StripWidth columns, so that the
+ *  lanes of the line are contiguous in memory.
+ */
+/*===========================================================================*/
+template <typename Accessor, typename LineOperator>
+void FilterColumns( const Accessor& accessor, const long pad, LineOperator op )
+{
+    const long width = static_cast<long>( accessor.width );
+    const long height = static_cast<long>( accessor.height );
+    const size_t nchannels = accessor.nchannels;
+    const size_t max_lanes = StripWidth * nchannels;
+    const size_t extent = ( height + 2 * pad ) * max_lanes;
+    const long nstrips = static_cast<long>( ( width + StripWidth - 1 ) / StripWidth );
+
+    KVS_OMP_PARALLEL()
+    {
+        std::vector<float> src( extent );
+        std::vector<float> work0( extent );
+        std::vector<float> work1( extent );
+        std::vector<float> dst( height * max_lanes );
+
+        KVS_OMP_FOR( schedule(static) )
+        for ( long strip = 0; strip < nstrips; strip++ )
+        {
+            const size_t i0 = strip * StripWidth;
+            const size_t ncolumns = std::min( StripWidth, static_cast<size_t>( width ) - i0 );
+            const size_t lanes = ncolumns * nchannels;
+
+            Line line;
+            line.src = src.data() + pad * lanes;
+            line.dst = dst.data();
+            line.work0 = work0.data() + pad * lanes;
+            line.work1 = work1.data() + pad * lanes;
+            line.length = height;
+            line.lanes = lanes;
+
+            for ( long j = -pad; j < height + pad; j++ )
+            {
+                const size_t index = static_cast<size_t>( kvs::Math::Clamp( j, 0L, height - 1 ) );
+                float* s = src.data() + ( j + pad ) * lanes;
+                for ( size_t i = 0; i < ncolumns; i++ )
+                {
+                    for ( size_t c = 0; c < nchannels; c++ )
+                    {
+                        s[ i * nchannels + c ] = accessor.load( i0 + i, index, c );
+                    }
+                }
+            }
+
+            op( line );
+
+            for ( long j = 0; j < height; j++ )
+            {
+                const float* d = dst.data() + j * lanes;
+                for ( size_t i = 0; i < ncolumns; i++ )
+                {
+                    for ( size_t c = 0; c < nchannels; c++ )
+                    {
+                        accessor.store( i0 + i, j, c, d[ i * nchannels + c ] );
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Box filter with the running sum (O(1) per element).
+ *  @param  src [in] source line (accessed in [begin - radius, end + radius])
+ *  @param  dst [out] destination line (written in [begin, end))
+ *  @param  begin [in] first index
+ *  @param  end [in] last index + 1
+ *  @param  lanes [in] number of lanes
+ *  @param  radius [in] filter radius
+ */
+/*===========================================================================*/
+void Box(
+    const float* src,
+    float* dst,
+    const long begin,
+    const long end,
+    const size_t lanes,
+    const long radius )
+{
+    // The running sums are accumulated in double precision to avoid the drift.
+    double sum[ MaxLanes ];
+    for ( size_t c = 0; c < lanes; c++ ) { sum[c] = 0.0; }
+    for ( long k = begin - radius; k <= begin + radius; k++ )
+    {
+        const float* s = src + k * static_cast<long>( lanes );
+        for ( size_t c = 0; c < lanes; c++ ) { sum[c] += s[c]; }
+    }
+
+    const double scale = 1.0 / ( 2 * radius + 1 );
+    for ( long i = begin; i < end; i++ )
+    {
+        float* d = dst + i * static_cast<long>( lanes );
+        const float* add = src + ( i + radius + 1 ) * static_cast<long>( lanes );
+        const float* sub = src + ( i - radius ) * static_cast<long>( lanes );
+        for ( size_t c = 0; c < lanes; c++ )
+        {
+            d[c] = static_cast<float>( sum[c] * scale );
+            sum[c] += add[c] - sub[c];
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Box blur operator.
+ */
+/*===========================================================================*/
+struct BoxOperator
+{
+    long radius;
+
+    void operator () ( const Line& line ) const
+    {
+        Box( line.src, line.dst, 0, line.length, line.lanes, radius );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Gaussian blur operator approximated by three successive box filters.
+ */
+/*===========================================================================*/
+struct GaussianOperator
+{
+    long radius[3];
+
+    GaussianOperator( const double sigma )
+    {
+        // Box sizes for the given sigma (W. Wells, 1986; P. Kovesi, 2010).
+        const int n = 3;
+        const double w_ideal = std::sqrt( 12.0 * sigma * sigma / n + 1.0 );
+        int wl = static_cast<int>( std::floor( w_ideal ) );
+        if ( wl % 2 == 0 ) { wl--; }
+        const int wu = wl + 2;
+        const double m_ideal = ( 12.0 * sigma * sigma - n * wl * wl - 4.0 * n * wl - 3.0 * n ) / ( -4.0 * wl - 4.0 );
+        const int m = static_cast<int>( kvs::Math::Round( m_ideal ) );
+        for ( int i = 0; i < n; i++ ) { radius[i] = ( ( i < m ? wl : wu ) - 1 ) / 2; }
+    }
+
+    long pad() const { return radius[0] + radius[1] + radius[2] + 3; }
+
+    void operator () ( const Line& line ) const
+    {
+        // The intermediate lines are computed over the extended range so that
+        // the final result is equal to the one of the clamped infinite line.
+        const long n = line.length;
+        const long r12 = radius[1] + radius[2] + 2;
+        const long r2 = radius[2] + 1;
+        Box( line.src, line.work0, -r12, n + r12, line.lanes, radius[0] );
+        Box( line.work0, line.work1, -r2, n + r2, line.lanes, radius[1] );
+        Box( line.work1, line.dst, 0, n, line.lanes, radius[2] );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolution operator.
+ */
+/*===========================================================================*/
+struct ConvolutionOperator
+{
+    const kvs::Real32* kernel;
+    long size;
+
+    long pad() const { return size / 2; }
+
+    void operator () ( const Line& line ) const
+    {
+        const long lanes = static_cast<long>( line.lanes );
+        const long center = size / 2;
+        for ( long i = 0; i < line.length; i++ )
+        {
+            float* d = line.dst + i * lanes;
+            for ( long c = 0; c < lanes; c++ ) { d[c] = 0.0f; }
+            for ( long t = 0; t < size; t++ )
+            {
+                const float w = kernel[t];
+                const float* s = line.src + ( i + center - t ) * lanes;
+                for ( long c = 0; c < lanes; c++ ) { d[c] += w * s[c]; }
+            }
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Min/max filter operator with the van Herk/Gil-Werman algorithm.
+ *
+ *  The line is divided into the blocks of the window size, and the prefix and
+ *  suffix min/max values in each block are computed. The min/max value in the
+ *  window is obtained from a suffix value and a prefix value with O(1)
+ *  comparisons per element regardless of the window size.
+ */
+/*===========================================================================*/
+template <typename Compare>
+struct MinMaxOperator
+{
+    long radius;
+    Compare compare;
+
+    static float Select( const float a, const float b, Compare compare )
+    {
+        return compare( a, b ) ? a : b;
+    }
+
+    void operator () ( const Line& line ) const
+    {
+        const long lanes = static_cast<long>( line.lanes );
+        const long size = 2 * radius + 1;
+        const long begin = -radius;
+        const long end = line.length + radius;
+
+        // Prefix values in each block.
+        float* g = line.work0;
+        for ( long p = begin; p < end; p++ )
+        {
+            const float* s = line.src + p * lanes;
+            float* gp = g + p * lanes;
+            if ( ( p - begin ) % size == 0 )
+            {
+                for ( long c = 0; c < lanes; c++ ) { gp[c] = s[c]; }
+            }
+            else
+            {
+                const float* gq = gp - lanes;
+                for ( long c = 0; c < lanes; c++ ) { gp[c] = Select( gq[c], s[c], compare ); }
+            }
+        }
+
+        // Suffix values in each block.
+        float* h = line.work1;
+        for ( long p = end - 1; p >= begin; p-- )
+        {
+            const float* s = line.src + p * lanes;
+            float* hp = h + p * lanes;
+            if ( ( p - begin ) % size == size - 1 || p == end - 1 )
+            {
+                for ( long c = 0; c < lanes; c++ ) { hp[c] = s[c]; }
+            }
+            else
+            {
+                const float* hq = hp + lanes;
+                for ( long c = 0; c < lanes; c++ ) { hp[c] = Select( hq[c], s[c], compare ); }
+            }
+        }
+
+        for ( long i = 0; i < line.length; i++ )
+        {
+            const float* hi = h + ( i - radius ) * lanes;
+            const float* gi = g + ( i + radius ) * lanes;
+            float* d = line.dst + i * lanes;
+            for ( long c = 0; c < lanes; c++ ) { d[c] = Select( hi[c], gi[c], compare ); }
+        }
+    }
+};
+
+struct Less { bool operator () ( const float a, const float b ) const { return a < b; } };
+struct Greater { bool operator () ( const float a, const float b ) const { return a > b; } };
+
+template <typename Accessor, typename Compare>
+void MinMax( const Accessor& accessor, const size_t radius )
+{
+    if ( radius == 0 ) { return; }
+    MinMaxOperator<Compare> op;
+    op.radius = static_cast<long>( radius );
+    const long pad = static_cast<long>( radius );
+    FilterRows( accessor, pad, op );
+    FilterColumns( accessor, pad, op );
+}
+
+inline ByteAccessor Bytes(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels )
+{
+    KVS_ASSERT( nchannels >= 1 && nchannels <= 4 );
+    ByteAccessor accessor = { width, height, nchannels, pixels };
+    return accessor;
+}
+
+inline BitAccessor Bits(
+    const size_t width,
+    const size_t height,
+    kvs::UInt8* pixels )
+{
+    BitAccessor accessor = { width, height, 1, pixels, ( width + 7 ) / 8 };
+    return accessor;
+}
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+namespace ImageFilter
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Blurs the image with the box filter.
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  nchannels [in] number of channels
+ *  @param  pixels [in/out] pixel data
+ *  @param  radius [in] filter radius (the filter size is 2 * radius + 1)
+ */
+/*===========================================================================*/
+void BoxBlur(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const size_t radius )
+{
+    if ( width == 0 || height == 0 || radius == 0 ) { return; }
+
+    const auto accessor = ::Bytes( width, height, nchannels, pixels );
+    ::BoxOperator op;
+    op.radius = static_cast<long>( radius );
+    const long pad = op.radius + 1;
+    ::FilterRows( accessor, pad, op );
+    ::FilterColumns( accessor, pad, op );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Blurs the image with the Gaussian filter.
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  nchannels [in] number of channels
+ *  @param  pixels [in/out] pixel data
+ *  @param  sigma [in] standard deviation of the Gaussian
+ *
+ *  The Gaussian filter is approximated by three successive box filters, so
+ *  that the cost per pixel is independent of the sigma.
+ */
+/*===========================================================================*/
+void GaussianBlur(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const double sigma )
+{
+    if ( width == 0 || height == 0 || sigma <= 0.0 ) { return; }
+
+    const auto accessor = ::Bytes( width, height, nchannels, pixels );
+    const ::GaussianOperator op( sigma );
+    ::FilterRows( accessor, op.pad(), op );
+    ::FilterColumns( accessor, op.pad(), op );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolves the image with the separable kernel.
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  nchannels [in] number of channels
+ *  @param  pixels [in/out] pixel data
+ *  @param  xkernel [in] kernel in horizontal direction (centered at size/2)
+ *  @param  ykernel [in] kernel in vertical direction (centered at size/2)
+ */
+/*===========================================================================*/
+void Convolve(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const kvs::ValueArray<kvs::Real32>& xkernel,
+    const kvs::ValueArray<kvs::Real32>& ykernel )
+{
+    if ( width == 0 || height == 0 ) { return; }
+
+    const auto accessor = ::Bytes( width, height, nchannels, pixels );
+    if ( xkernel.size() > 0 )
+    {
+        ::ConvolutionOperator op;
+        op.kernel = xkernel.data();
+        op.size = static_cast<long>( xkernel.size() );
+        ::FilterRows( accessor, op.pad(), op );
+    }
+
+    if ( ykernel.size() > 0 )
+    {
+        ::ConvolutionOperator op;
+        op.kernel = ykernel.data();
+        op.size = static_cast<long>( ykernel.size() );
+        ::FilterColumns( accessor, op.pad(), op );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Replaces the image with the gradient magnitude by the Sobel filter.
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  nchannels [in] number of channels
+ *  @param  pixels [in/out] pixel data
+ *
+ *  The gradient magnitude is computed for each channel and scaled by 1/4, so
+ *  that a step edge from 0 to 255 is mapped to 255. The image is processed in
+ *  parallel over the bands of rows. Since the pixel data is overwritten in
+ *  place, the original rows adjacent to each band are saved in advance.
+ */
+/*===========================================================================*/
+void Sobel(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels )
+{
+    KVS_ASSERT( nchannels >= 1 && nchannels <= 4 );
+    if ( width == 0 || height == 0 ) { return; }
+
+    const size_t band_height = 64;
+    const size_t nbands = ( height + band_height - 1 ) / band_height;
+    const size_t bpl = width * nchannels;
+
+    // Save the rows just above and below each band.
+    std::vector<kvs::UInt8> halo( nbands * 2 * bpl );
+    for ( size_t b = 0; b < nbands; b++ )
+    {
+        const size_t j0 = b * band_height;
+        const size_t j1 = std::min( j0 + band_height, height );
+        const size_t top = j0 == 0 ? 0 : j0 - 1;
+        const size_t bottom = j1 == height ? height - 1 : j1;
+        std::memcpy( halo.data() + ( 2 * b + 0 ) * bpl, pixels + top * bpl, bpl );
+        std::memcpy( halo.data() + ( 2 * b + 1 ) * bpl, pixels + bottom * bpl, bpl );
+    }
+
+    const long nc = static_cast<long>( nchannels );
+    const long last = static_cast<long>( width ) - 1;
+    KVS_OMP_PARALLEL()
+    {
+        std::vector<kvs::UInt8> rows( 3 * bpl );
+
+        KVS_OMP_FOR( schedule(static) )
+        for ( long b = 0; b < static_cast<long>( nbands ); b++ )
+        {
+            const size_t j0 = b * band_height;
+            const size_t j1 = std::min( j0 + band_height, height );
+
+            kvs::UInt8* prev = rows.data();
+            kvs::UInt8* curr = rows.data() + bpl;
+            kvs::UInt8* next = rows.data() + 2 * bpl;
+            std::memcpy( prev, halo.data() + ( 2 * b + 0 ) * bpl, bpl );
+            std::memcpy( curr, pixels + j0 * bpl, bpl );
+
+            for ( size_t j = j0; j < j1; j++ )
+            {
+                const kvs::UInt8* src = ( j + 1 < j1 ) ? pixels + ( j + 1 ) * bpl : halo.data() + ( 2 * b + 1 ) * bpl;
+                std::memcpy( next, src, bpl );
+
+                kvs::UInt8* dst = pixels + j * bpl;
+                for ( long i = 0; i <= last; i++ )
+                {
+                    const long l = std::max( i - 1, 0L ) * nc;
+                    const long m = i * nc;
+                    const long r = std::min( i + 1, last ) * nc;
+                    for ( long c = 0; c < nc; c++ )
+                    {
+                        const int gx =
+                            ( prev[ r + c ] + 2 * curr[ r + c ] + next[ r + c ] ) -
+                            ( prev[ l + c ] + 2 * curr[ l + c ] + next[ l + c ] );
+                        const int gy =
+                            ( next[ l + c ] + 2 * next[ m + c ] + next[ r + c ] ) -
+                            ( prev[ l + c ] + 2 * prev[ m + c ] + prev[ r + c ] );
+                        const float g = 0.25f * std::sqrt( static_cast<float>( gx * gx + gy * gy ) );
+                        dst[ m + c ] = static_cast<kvs::UInt8>( kvs::Math::Min( g, 255.0f ) + 0.5f );
+                    }
+                }
+
+                std::swap( prev, curr );
+                std::swap( curr, next );
+            }
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Erodes the image with the square structuring element (min filter).
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  nchannels [in] number of channels
+ *  @param  pixels [in/out] pixel data
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void Erode(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const size_t radius )
+{
+    if ( width == 0 || height == 0 ) { return; }
+    ::MinMax<ByteAccessor,Less>( ::Bytes( width, height, nchannels, pixels ), radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Dilates the image with the square structuring element (max filter).
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  nchannels [in] number of channels
+ *  @param  pixels [in/out] pixel data
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void Dilate(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const size_t radius )
+{
+    if ( width == 0 || height == 0 ) { return; }
+    ::MinMax<ByteAccessor,Greater>( ::Bytes( width, height, nchannels, pixels ), radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Erodes the bit image with the square structuring element.
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  pixels [in/out] bit pixel data
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void BitErode(
+    const size_t width,
+    const size_t height,
+    kvs::UInt8* pixels,
+    const size_t radius )
+{
+    if ( width == 0 || height == 0 ) { return; }
+    ::MinMax<BitAccessor,Less>( ::Bits( width, height, pixels ), radius );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Dilates the bit image with the square structuring element.
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @param  pixels [in/out] bit pixel data
+ *  @param  radius [in] radius of the structuring element
+ */
+/*===========================================================================*/
+void BitDilate(
+    const size_t width,
+    const size_t height,
+    kvs::UInt8* pixels,
+    const size_t radius )
+{
+    if ( width == 0 || height == 0 ) { return; }
+    ::MinMax<BitAccessor,Greater>( ::Bits( width, height, pixels ), radius );
+}
+
+} // end of namespace ImageFilter
+
+} // end of namespace kvs
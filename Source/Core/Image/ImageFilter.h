@@ -0,0 +1,87 @@
+/****************************************************************************/
+/**
+ *  @file   ImageFilter.h
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#pragma once
+#include <kvs/Type>
+#include <kvs/ValueArray>
+#include <cstddef>
+
+
+namespace kvs
+{
+
+/*==========================================================================*/
+/**
+ *  Image filtering functions.
+ *
+ *  The functions are applied in-place to the 8-bit interleaved pixel data
+ *  (nchannels: 1 for gray, 3 for RGB and 4 for RGBA image). The separable
+ *  filters are processed in the horizontal direction over the rows and in the
+ *  vertical direction over the column strips, and both of them are processed
+ *  in parallel with only the line buffers for each thread. The pixels outside
+ *  the image are clamped to the edge.
+ */
+/*==========================================================================*/
+namespace ImageFilter
+{
+
+void BoxBlur(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const size_t radius );
+
+void GaussianBlur(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const double sigma );
+
+void Convolve(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const kvs::ValueArray<kvs::Real32>& xkernel,
+    const kvs::ValueArray<kvs::Real32>& ykernel );
+
+void Sobel(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels );
+
+void Erode(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const size_t radius );
+
+void Dilate(
+    const size_t width,
+    const size_t height,
+    const size_t nchannels,
+    kvs::UInt8* pixels,
+    const size_t radius );
+
+void BitErode(
+    const size_t width,
+    const size_t height,
+    kvs::UInt8* pixels,
+    const size_t radius );
+
+void BitDilate(
+    const size_t width,
+    const size_t height,
+    kvs::UInt8* pixels,
+    const size_t radius );
+
+} // end of namespace ImageFilter
+
+} // end of namespace kvs
@@ -0,0 +1,302 @@
+/****************************************************************************/
+/**
+ *  @file   ImageResampler.cpp
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#include "ImageResampler.h"
+#include <kvs/Math>
+#include <kvs/OpenMP>
+#include <kvs/Assert>
+#include <vector>
+#include <cmath>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Filter kernels.
+ */
+/*===========================================================================*/
+double BoxKernel( const double x )
+{
+    return ( x > -0.5 && x <= 0.5 ) ? 1.0 : 0.0;
+}
+
+double TriangleKernel( const double x )
+{
+    const double ax = std::abs( x );
+    return ax < 1.0 ? 1.0 - ax : 0.0;
+}
+
+double CatmullRomKernel( const double x )
+{
+    const double a = -0.5;
+    const double ax = std::abs( x );
+    if ( ax < 1.0 ) { return ( ( a + 2.0 ) * ax - ( a + 3.0 ) ) * ax * ax + 1.0; }
+    if ( ax < 2.0 ) { return ( ( ( ax - 5.0 ) * ax + 8.0 ) * ax - 4.0 ) * a; }
+    return 0.0;
+}
+
+double Sinc( const double x )
+{
+    if ( x == 0.0 ) { return 1.0; }
+    const double px = kvs::Math::pi * x;
+    return std::sin( px ) / px;
+}
+
+double Lanczos3Kernel( const double x )
+{
+    return std::abs( x ) < 3.0 ? Sinc( x ) * Sinc( x / 3.0 ) : 0.0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Precomputed filter weights along one axis.
+ */
+/*===========================================================================*/
+struct Weights
+{
+    size_t ntaps = 0; ///< max. number of taps per destination pixel
+    std::vector<size_t> first; ///< first source index for each destination pixel
+    std::vector<size_t> count; ///< number of taps for each destination pixel
+    std::vector<float> values; ///< normalized weights (ntaps per destination pixel)
+
+    Weights( const size_t src_size, const size_t dst_size, const kvs::ImageResampler::Filter filter )
+    {
+        double support = 0.0;
+        double (*kernel)( double ) = nullptr;
+        switch ( filter )
+        {
+        case kvs::ImageResampler::Box: support = 0.5; kernel = BoxKernel; break;
+        case kvs::ImageResampler::Bilinear: support = 1.0; kernel = TriangleKernel; break;
+        case kvs::ImageResampler::Bicubic: support = 2.0; kernel = CatmullRomKernel; break;
+        case kvs::ImageResampler::Lanczos3: support = 3.0; kernel = Lanczos3Kernel; break;
+        default: break;
+        }
+
+        // The filter is stretched for downsampling in order to avoid aliasing.
+        const double ratio = static_cast<double>( src_size ) / dst_size;
+        const double stretch = kvs::Math::Max( ratio, 1.0 );
+        const double radius = support * stretch;
+
+        ntaps = static_cast<size_t>( std::ceil( radius ) ) * 2 + 3;
+        first.resize( dst_size );
+        count.resize( dst_size );
+        values.assign( dst_size * ntaps, 0.0f );
+
+        const long last_index = static_cast<long>( src_size ) - 1;
+        for ( size_t i = 0; i < dst_size; i++ )
+        {
+            const double center = ( i + 0.5 ) * ratio;
+            const long j0 = kvs::Math::Max( static_cast<long>( std::floor( center - radius ) ), 0L );
+            const long j1 = kvs::Math::Min( static_cast<long>( std::ceil( center + radius ) ), last_index );
+
+            float* w = values.data() + i * ntaps;
+            double sum = 0.0;
+            size_t n = 0;
+            for ( long j = j0; j <= j1 && n < ntaps; j++, n++ )
+            {
+                w[n] = static_cast<float>( kernel( ( j + 0.5 - center ) / stretch ) );
+                sum += w[n];
+            }
+
+            // Trim the zero-weighted taps at both ends.
+            size_t offset = 0;
+            while ( offset < n && w[offset] == 0.0f ) { offset++; }
+            while ( n > offset && w[n - 1] == 0.0f ) { n--; }
+            if ( offset > 0 )
+            {
+                for ( size_t k = offset; k < n; k++ ) { w[ k - offset ] = w[k]; }
+                for ( size_t k = n - offset; k < n; k++ ) { w[k] = 0.0f; }
+            }
+
+            first[i] = static_cast<size_t>( j0 ) + offset;
+            count[i] = n - offset;
+
+            // The weights are normalized since the taps are clipped at the edges.
+            if ( count[i] == 0 )
+            {
+                first[i] = static_cast<size_t>( kvs::Math::Clamp( static_cast<long>( center ), 0L, last_index ) );
+                count[i] = 1;
+                w[0] = 1.0f;
+            }
+            else
+            {
+                const float normalize = static_cast<float>( 1.0 / sum );
+                for ( size_t k = 0; k < count[i]; k++ ) { w[k] *= normalize; }
+            }
+        }
+    }
+};
+
+inline void Store( const float value, float& dst )
+{
+    dst = value;
+}
+
+inline void Store( const float value, kvs::UInt8& dst )
+{
+    dst = static_cast<kvs::UInt8>( kvs::Math::Clamp( value, 0.0f, 255.0f ) + 0.5f );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resamples the rows in horizontal direction.
+ *  @param  src [in] source rows
+ *  @param  src_width [in] source width
+ *  @param  height [in] number of rows
+ *  @param  weights [in] horizontal weights
+ *  @param  dst [out] resampled rows
+ */
+/*===========================================================================*/
+template <size_t NChannels, typename SrcType, typename DstType>
+void HorizontalPass(
+    const SrcType* src,
+    const size_t src_width,
+    const size_t height,
+    const Weights& weights,
+    DstType* dst )
+{
+    const size_t dst_width = weights.first.size();
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long j = 0; j < static_cast<long>( height ); j++ )
+    {
+        const SrcType* src_row = src + j * src_width * NChannels;
+        DstType* dst_row = dst + j * dst_width * NChannels;
+        for ( size_t i = 0; i < dst_width; i++ )
+        {
+            const float* w = weights.values.data() + i * weights.ntaps;
+            const SrcType* s = src_row + weights.first[i] * NChannels;
+            const size_t n = weights.count[i];
+
+            float sum[ NChannels ] = {};
+            for ( size_t k = 0; k < n; k++ )
+            {
+                for ( size_t c = 0; c < NChannels; c++ )
+                {
+                    sum[c] += w[k] * s[ k * NChannels + c ];
+                }
+            }
+
+            for ( size_t c = 0; c < NChannels; c++ ) { Store( sum[c], dst_row[ i * NChannels + c ] ); }
+        }
+    }
+}
+
+template <typename SrcType, typename DstType>
+void HorizontalPass(
+    const size_t nchannels,
+    const SrcType* src,
+    const size_t src_width,
+    const size_t height,
+    const Weights& weights,
+    DstType* dst )
+{
+    switch ( nchannels )
+    {
+    case 1: HorizontalPass<1>( src, src_width, height, weights, dst ); break;
+    case 2: HorizontalPass<2>( src, src_width, height, weights, dst ); break;
+    case 3: HorizontalPass<3>( src, src_width, height, weights, dst ); break;
+    case 4: HorizontalPass<4>( src, src_width, height, weights, dst ); break;
+    default: break;
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resamples the rows in vertical direction.
+ *  @param  src [in] source rows
+ *  @param  row_length [in] number of elements in a row
+ *  @param  weights [in] vertical weights
+ *  @param  dst [out] resampled rows
+ */
+/*===========================================================================*/
+template <typename SrcType, typename DstType>
+void VerticalPass(
+    const SrcType* src,
+    const size_t row_length,
+    const Weights& weights,
+    DstType* dst )
+{
+    // The inner loops run over the contiguous row elements so that they can
+    // be vectorized by the compiler.
+    const size_t dst_height = weights.first.size();
+    KVS_OMP_PARALLEL()
+    {
+        std::vector<float> sum( row_length );
+        KVS_OMP_FOR( schedule(static) )
+        for ( long j = 0; j < static_cast<long>( dst_height ); j++ )
+        {
+            const float* w = weights.values.data() + j * weights.ntaps;
+            const SrcType* s = src + weights.first[j] * row_length;
+            const size_t n = weights.count[j];
+
+            float* acc = sum.data();
+            const float w0 = w[0];
+            for ( size_t i = 0; i < row_length; i++ ) { acc[i] = w0 * s[i]; }
+            for ( size_t k = 1; k < n; k++ )
+            {
+                const float wk = w[k];
+                const SrcType* row = s + k * row_length;
+                for ( size_t i = 0; i < row_length; i++ ) { acc[i] += wk * row[i]; }
+            }
+
+            DstType* d = dst + j * row_length;
+            for ( size_t i = 0; i < row_length; i++ ) { Store( acc[i], d[i] ); }
+        }
+    }
+}
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Resamples the interleaved 8-bit pixel data.
+ *  @param  src_width [in] source image width
+ *  @param  src_height [in] source image height
+ *  @param  nchannels [in] number of channels (1:gray, 3:RGB, 4:RGBA)
+ *  @param  src_pixels [in] source pixel data
+ *  @param  dst_width [in] destination image width
+ *  @param  dst_height [in] destination image height
+ *  @param  dst_pixels [out] destination pixel data (allocated by the caller)
+ */
+/*===========================================================================*/
+void ImageResampler::resample(
+    const size_t src_width,
+    const size_t src_height,
+    const size_t nchannels,
+    const kvs::UInt8* src_pixels,
+    const size_t dst_width,
+    const size_t dst_height,
+    kvs::UInt8* dst_pixels ) const
+{
+    KVS_ASSERT( nchannels >= 1 && nchannels <= 4 );
+    if ( src_width == 0 || src_height == 0 ) { return; }
+    if ( dst_width == 0 || dst_height == 0 ) { return; }
+
+    const Weights xweights( src_width, dst_width, m_filter );
+    const Weights yweights( src_height, dst_height, m_filter );
+
+    // The pass order is selected so that the intermediate buffer gets smaller.
+    if ( dst_width * src_height <= src_width * dst_height )
+    {
+        std::vector<float> buffer( dst_width * src_height * nchannels );
+        ::HorizontalPass( nchannels, src_pixels, src_width, src_height, xweights, buffer.data() );
+        ::VerticalPass( buffer.data(), dst_width * nchannels, yweights, dst_pixels );
+    }
+    else
+    {
+        std::vector<float> buffer( src_width * dst_height * nchannels );
+        ::VerticalPass( src_pixels, src_width * nchannels, yweights, buffer.data() );
+        ::HorizontalPass( nchannels, buffer.data(), src_width, dst_height, xweights, dst_pixels );
+    }
+}
+
+} // end of namespace kvs
@@ -0,0 +1,57 @@
+/****************************************************************************/
+/**
+ *  @file   ImageResampler.h
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#pragma once
+#include <kvs/Type>
+#include <cstddef>
+
+
+namespace kvs
+{
+
+/*==========================================================================*/
+/**
+ *  Image resampler class based on the separable filtering.
+ *
+ *  The image is resampled in two passes (horizontal and vertical). The filter
+ *  weights for each destination column and row are precomputed once, and each
+ *  pass is processed in parallel over the row bands. When the image is down-
+ *  sampled, the filter support is widened by the scaling ratio so that every
+ *  source pixel contributes to the result (area averaging for Box filter).
+ */
+/*==========================================================================*/
+class ImageResampler
+{
+public:
+    enum Filter
+    {
+        Box, ///< box filter (nearest for upsampling, area for downsampling)
+        Bilinear, ///< triangle filter
+        Bicubic, ///< Catmull-Rom cubic filter
+        Lanczos3 ///< Lanczos filter with three lobes
+    };
+
+private:
+    Filter m_filter = Bilinear; ///< resampling filter
+
+public:
+    ImageResampler() = default;
+    explicit ImageResampler( const Filter filter ): m_filter( filter ) {}
+
+    Filter filter() const { return m_filter; }
+    void setFilter( const Filter filter ) { m_filter = filter; }
+
+    void resample(
+        const size_t src_width,
+        const size_t src_height,
+        const size_t nchannels,
+        const kvs::UInt8* src_pixels,
+        const size_t dst_width,
+        const size_t dst_height,
+        kvs::UInt8* dst_pixels ) const;
+};
+
+} // end of namespace kvs
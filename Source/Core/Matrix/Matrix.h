@@ -18,6 +18,7 @@
 #include <kvs/Matrix22>
 #include <kvs/Matrix33>
 #include <kvs/Matrix44>
+#include <kvs/MatrixMultiplication>
 #include <kvs/Deprecated>
 
 
@@ -78,6 +79,8 @@ public:
     static const Matrix Random( const size_t nrows, const size_t ncols, const kvs::UInt32 seed );
     static const Matrix Random( const size_t nrows, const size_t ncols, const T min, const T max );
     static const Matrix Random( const size_t nrows, const size_t ncols, const T min, const T max, const kvs::UInt32 seed );
+    static const Matrix TransposeMultiply( const Matrix& lhs, const Matrix& rhs );
+    static const Matrix MultiplyTranspose( const Matrix& lhs, const Matrix& rhs );
 
 public:
     Matrix(): m_nrows( 0 ), m_ncols( 0 ), m_data( nullptr ) {}
@@ -296,18 +299,11 @@ public:
         const size_t N = rhs.columnSize();
 
         Matrix result( L, N );
-        for ( size_t r = 0; r < L; ++r )
-        {
-            for ( size_t c = 0; c < N; ++c )
-            {
-                T sum(0);
-                for ( size_t k = 0; k < M; ++k )
-                {
-                    sum += lhs[r][k] * rhs[k][c];
-                }
-                result[r][c] = sum;
-            }
-        }
+        kvs::MatrixMultiplication::Multiply(
+            false, false, L, N, M,
+            lhs.row_pointers().data(),
+            rhs.row_pointers().data(),
+            result.row_pointers().data() );
 
         return std::move( result );
     }
@@ -317,11 +313,14 @@ public:
         KVS_ASSERT( lhs.columnSize() == rhs.size() );
 
         const size_t nrows = lhs.rowSize();
+        const size_t ncols = lhs.columnSize();
+
         kvs::Vector<T> result( nrows );
-        for ( size_t r = 0; r < nrows; ++r )
-        {
-            result[r] = lhs[r].dot( rhs );
-        }
+        kvs::MatrixMultiplication::Multiply(
+            false, nrows, ncols,
+            lhs.row_pointers().data(),
+            rhs.data(),
+            result.data() );
 
         return std::move( result );
     }
@@ -334,15 +333,11 @@ public:
         const size_t ncols = rhs.columnSize();
 
         kvs::Vector<T> result( ncols );
-        for ( size_t c = 0; c < ncols; ++c )
-        {
-            T sum(0);
-            for ( size_t r = 0; r < nrows; ++r )
-            {
-                sum += lhs[r] * rhs[r][c];
-            }
-            result[c] = sum;
-        }
+        kvs::MatrixMultiplication::Multiply(
+            true, nrows, ncols,
+            rhs.row_pointers().data(),
+            lhs.data(),
+            result.data() );
 
         return std::move( result );
     }
@@ -369,6 +364,10 @@ public:
         return os << rhs.format( " ", "", "", true );
     }
 
+private:
+    std::vector<const T*> row_pointers() const;
+    std::vector<T*> row_pointers();
+
 public:
     KVS_DEPRECATED( size_t nrows() const ) { return this->rowSize(); }
     KVS_DEPRECATED( size_t ncolumns() const ) { return this->columnSize(); }
@@ -468,6 +467,82 @@ inline const Matrix<T> Matrix<T>::Random( const size_t nrows, const size_t ncols
     return std::move( m );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the product of the transposed matrix and the matrix.
+ *  @param  lhs [in] left-hand matrix (k x m)
+ *  @param  rhs [in] right-hand matrix (k x n)
+ *  @return lhs^t rhs (m x n)
+ */
+/*===========================================================================*/
+template <typename T>
+inline const Matrix<T> Matrix<T>::TransposeMultiply( const Matrix& lhs, const Matrix& rhs )
+{
+    KVS_ASSERT( lhs.rowSize() == rhs.rowSize() );
+
+    const size_t L = lhs.columnSize();
+    const size_t M = lhs.rowSize();
+    const size_t N = rhs.columnSize();
+
+    Matrix result( L, N );
+    kvs::MatrixMultiplication::Multiply(
+        true, false, L, N, M,
+        lhs.row_pointers().data(),
+        rhs.row_pointers().data(),
+        result.row_pointers().data() );
+
+    return std::move( result );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the product of the matrix and the transposed matrix.
+ *  @param  lhs [in] left-hand matrix (m x k)
+ *  @param  rhs [in] right-hand matrix (n x k)
+ *  @return lhs rhs^t (m x n)
+ */
+/*===========================================================================*/
+template <typename T>
+inline const Matrix<T> Matrix<T>::MultiplyTranspose( const Matrix& lhs, const Matrix& rhs )
+{
+    KVS_ASSERT( lhs.columnSize() == rhs.columnSize() );
+
+    const size_t L = lhs.rowSize();
+    const size_t M = lhs.columnSize();
+    const size_t N = rhs.rowSize();
+
+    Matrix result( L, N );
+    kvs::MatrixMultiplication::Multiply(
+        false, true, L, N, M,
+        lhs.row_pointers().data(),
+        rhs.row_pointers().data(),
+        result.row_pointers().data() );
+
+    return std::move( result );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the pointers to the elements of the row vectors.
+ *  @return row pointers
+ */
+/*===========================================================================*/
+template <typename T>
+inline std::vector<const T*> Matrix<T>::row_pointers() const
+{
+    std::vector<const T*> rows( m_nrows );
+    for ( size_t r = 0; r < m_nrows; ++r ) { rows[r] = m_data[r].data(); }
+    return rows;
+}
+
+template <typename T>
+inline std::vector<T*> Matrix<T>::row_pointers()
+{
+    std::vector<T*> rows( m_nrows );
+    for ( size_t r = 0; r < m_nrows; ++r ) { rows[r] = m_data[r].data(); }
+    return rows;
+}
+
 /*==========================================================================*/
 /**
  *  @brief  Constructs a new Matrix.
@@ -0,0 +1,362 @@
+/****************************************************************************/
+/**
+ *  @file   MatrixMultiplication.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ * References:
+ * [1] K. Goto and R. A. van de Geijn, Anatomy of high-performance matrix
+ *     multiplication, ACM Transactions on Mathematical Software, vol. 34,
+ *     no. 3, 2008.
+ */
+/****************************************************************************/
+#include "MatrixMultiplication.h"
+#include <kvs/OpenMP>
+#include <kvs/Math>
+#include <vector>
+#include <algorithm>
+
+
+namespace
+{
+
+// Register block size (MR x NR) of the micro kernel.
+const size_t MR = 4;
+const size_t NR = 8;
+
+// Cache block sizes. The packed panel of op(B) (KC x NC) is shared by all of
+// the threads, and each thread multiplies the packed sliver of op(A) (MR x KC)
+// with the tile of the packed panel of op(B) (KC x NS).
+const size_t KC = 256;
+const size_t NC = 2048;
+const size_t MC = 4096;
+const size_t MS = 64;
+const size_t NS = 256;
+
+// Matrices smaller than this (m * n * k) are multiplied with the naive loops.
+const size_t SmallSize = 48 * 48 * 48;
+
+/*==========================================================================*/
+/**
+ *  @brief  Packs the block of op(A) (mc x kc) into the MR-row slivers.
+ *  @param  transa [in] if true, op(A) = A^t
+ *  @param  a [in] row pointers of A
+ *  @param  i0 [in] first row index of op(A)
+ *  @param  p0 [in] first column index of op(A)
+ *  @param  mc [in] number of rows
+ *  @param  kc [in] number of columns
+ *  @param  packed [out] packed data (ceil(mc/MR) x kc x MR)
+ */
+/*==========================================================================*/
+template <typename T>
+inline void PackA(
+    const bool transa,
+    const T* const* a,
+    const size_t i0,
+    const size_t p0,
+    const size_t mc,
+    const size_t kc,
+    T* packed )
+{
+    const long nslivers = long( ( mc + MR - 1 ) / MR );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long s = 0; s < nslivers; s++ )
+    {
+        T* dst = packed + s * kc * MR;
+        const size_t ib = i0 + s * MR;
+        const size_t mr = kvs::Math::Min( MR, i0 + mc - ib );
+        for ( size_t p = 0; p < kc; p++ )
+        {
+            for ( size_t i = 0; i < MR; i++ )
+            {
+                dst[ p * MR + i ] = i < mr ? ( transa ? a[ p0 + p ][ ib + i ] : a[ ib + i ][ p0 + p ] ) : T(0);
+            }
+        }
+    }
+}
+
+/*==========================================================================*/
+/**
+ *  @brief  Packs the panel of op(B) (kc x nc) into the NR-column slivers.
+ *  @param  transb [in] if true, op(B) = B^t
+ *  @param  b [in] row pointers of B
+ *  @param  p0 [in] first row index of op(B)
+ *  @param  j0 [in] first column index of op(B)
+ *  @param  kc [in] number of rows
+ *  @param  nc [in] number of columns
+ *  @param  packed [out] packed data (ceil(nc/NR) x kc x NR)
+ */
+/*==========================================================================*/
+template <typename T>
+inline void PackB(
+    const bool transb,
+    const T* const* b,
+    const size_t p0,
+    const size_t j0,
+    const size_t kc,
+    const size_t nc,
+    T* packed )
+{
+    const long nslivers = long( ( nc + NR - 1 ) / NR );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long s = 0; s < nslivers; s++ )
+    {
+        T* dst = packed + s * kc * NR;
+        const size_t jb = j0 + s * NR;
+        const size_t nr = kvs::Math::Min( NR, j0 + nc - jb );
+        for ( size_t p = 0; p < kc; p++ )
+        {
+            for ( size_t j = 0; j < NR; j++ )
+            {
+                dst[ p * NR + j ] = j < nr ? ( transb ? b[ jb + j ][ p0 + p ] : b[ p0 + p ][ jb + j ] ) : T(0);
+            }
+        }
+    }
+}
+
+/*==========================================================================*/
+/**
+ *  @brief  Multiplies the packed slivers and adds the result to C.
+ *  @param  kc [in] length of the slivers
+ *  @param  a [in] packed sliver of op(A) (kc x MR)
+ *  @param  b [in] packed sliver of op(B) (kc x NR)
+ *  @param  c [in/out] row pointers of C offset to the first row
+ *  @param  j0 [in] first column index of C
+ *  @param  mr [in] number of valid rows (<= MR)
+ *  @param  nr [in] number of valid columns (<= NR)
+ */
+/*==========================================================================*/
+template <typename T>
+inline void MicroKernel(
+    const size_t kc,
+    const T* a,
+    const T* b,
+    T* const* c,
+    const size_t j0,
+    const size_t mr,
+    const size_t nr )
+{
+    // The MR x NR accumulators are kept in the registers, and the inner loop
+    // over NR is vectorized by the compiler.
+    T ab[ MR * NR ] = {};
+    for ( size_t p = 0; p < kc; p++ )
+    {
+        const T* ap = a + p * MR;
+        const T* bp = b + p * NR;
+        for ( size_t i = 0; i < MR; i++ )
+        {
+            const T ai = ap[i];
+            for ( size_t j = 0; j < NR; j++ ) { ab[ i * NR + j ] += ai * bp[j]; }
+        }
+    }
+
+    for ( size_t i = 0; i < mr; i++ )
+    {
+        T* ci = c[i] + j0;
+        for ( size_t j = 0; j < nr; j++ ) { ci[j] += ab[ i * NR + j ]; }
+    }
+}
+
+/*==========================================================================*/
+/**
+ *  @brief  Calculates C = op(A) op(B) with the packed panels.
+ *  @param  transa [in] if true, op(A) = A^t
+ *  @param  transb [in] if true, op(B) = B^t
+ *  @param  m [in] number of rows of op(A) and C
+ *  @param  n [in] number of columns of op(B) and C
+ *  @param  k [in] number of columns of op(A) and rows of op(B)
+ *  @param  a [in] row pointers of A
+ *  @param  b [in] row pointers of B
+ *  @param  c [out] row pointers of C
+ */
+/*==========================================================================*/
+template <typename T>
+inline void Gemm(
+    const bool transa,
+    const bool transb,
+    const size_t m,
+    const size_t n,
+    const size_t k,
+    const T* const* a,
+    const T* const* b,
+    T* const* c )
+{
+    if ( m * n * k < SmallSize )
+    {
+        kvs::MatrixMultiplication::Multiply<T>( transa, transb, m, n, k, a, b, c );
+        return;
+    }
+
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < long( m ); i++ ) { std::fill( c[i], c[i] + n, T(0) ); }
+
+    std::vector<T> packed_a( ( kvs::Math::Min( MC, m ) + MR ) * KC );
+    std::vector<T> packed_b( ( kvs::Math::Min( NC, n ) + NR ) * KC );
+    for ( size_t jc = 0; jc < n; jc += NC )
+    {
+        const size_t nc = kvs::Math::Min( NC, n - jc );
+        for ( size_t pc = 0; pc < k; pc += KC )
+        {
+            const size_t kc = kvs::Math::Min( KC, k - pc );
+            ::PackB( transb, b, pc, jc, kc, nc, packed_b.data() );
+
+            for ( size_t ic = 0; ic < m; ic += MC )
+            {
+                const size_t mc = kvs::Math::Min( MC, m - ic );
+                ::PackA( transa, a, ic, pc, mc, kc, packed_a.data() );
+
+                // Each tile (MS x NS) of C is updated by a single thread.
+                const size_t ntiles_m = ( mc + MS - 1 ) / MS;
+                const size_t ntiles_n = ( nc + NS - 1 ) / NS;
+                const long ntiles = long( ntiles_m * ntiles_n );
+                KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+                for ( long t = 0; t < ntiles; t++ )
+                {
+                    const size_t is = ( t / ntiles_n ) * MS;
+                    const size_t js = ( t % ntiles_n ) * NS;
+                    const size_t ie = kvs::Math::Min( mc, is + MS );
+                    const size_t je = kvs::Math::Min( nc, js + NS );
+                    for ( size_t jr = js; jr < je; jr += NR )
+                    {
+                        const T* bs = packed_b.data() + ( jr / NR ) * kc * NR;
+                        const size_t nr = kvs::Math::Min( NR, je - jr );
+                        for ( size_t ir = is; ir < ie; ir += MR )
+                        {
+                            const T* as = packed_a.data() + ( ir / MR ) * kc * MR;
+                            const size_t mr = kvs::Math::Min( MR, ie - ir );
+                            ::MicroKernel( kc, as, bs, c + ic + ir, jc + jr, mr, nr );
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*==========================================================================*/
+/**
+ *  @brief  Calculates y = op(A) x.
+ *  @param  transa [in] if true, op(A) = A^t
+ *  @param  m [in] number of rows of A
+ *  @param  n [in] number of columns of A
+ *  @param  a [in] row pointers of A
+ *  @param  x [in] vector
+ *  @param  y [out] vector
+ */
+/*==========================================================================*/
+template <typename T>
+inline void Gemv(
+    const bool transa,
+    const size_t m,
+    const size_t n,
+    const T* const* a,
+    const T* x,
+    T* y )
+{
+    if ( m * n < SmallSize )
+    {
+        kvs::MatrixMultiplication::Multiply<T>( transa, m, n, a, x, y );
+        return;
+    }
+
+    if ( transa )
+    {
+        // Each thread accumulates the rows of A for the block of the columns.
+        const long nblocks = long( ( n + NS - 1 ) / NS );
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long s = 0; s < nblocks; s++ )
+        {
+            const size_t j0 = s * NS;
+            const size_t j1 = kvs::Math::Min( n, j0 + NS );
+            std::fill( y + j0, y + j1, T(0) );
+            for ( size_t i = 0; i < m; i++ )
+            {
+                const T xi = x[i];
+                const T* ai = a[i];
+                for ( size_t j = j0; j < j1; j++ ) { y[j] += xi * ai[j]; }
+            }
+        }
+    }
+    else
+    {
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < long( m ); i++ )
+        {
+            // Four partial sums for the vectorization.
+            const T* ai = a[i];
+            T s0(0), s1(0), s2(0), s3(0);
+            size_t j = 0;
+            for ( ; j + 4 <= n; j += 4 )
+            {
+                s0 += ai[j+0] * x[j+0];
+                s1 += ai[j+1] * x[j+1];
+                s2 += ai[j+2] * x[j+2];
+                s3 += ai[j+3] * x[j+3];
+            }
+            for ( ; j < n; j++ ) { s0 += ai[j] * x[j]; }
+            y[i] = ( s0 + s1 ) + ( s2 + s3 );
+        }
+    }
+}
+
+}
+
+
+namespace kvs
+{
+
+namespace MatrixMultiplication
+{
+
+void Multiply(
+    const bool transa,
+    const bool transb,
+    const size_t m,
+    const size_t n,
+    const size_t k,
+    const float* const* a,
+    const float* const* b,
+    float* const* c )
+{
+    ::Gemm( transa, transb, m, n, k, a, b, c );
+}
+
+void Multiply(
+    const bool transa,
+    const bool transb,
+    const size_t m,
+    const size_t n,
+    const size_t k,
+    const double* const* a,
+    const double* const* b,
+    double* const* c )
+{
+    ::Gemm( transa, transb, m, n, k, a, b, c );
+}
+
+void Multiply(
+    const bool transa,
+    const size_t m,
+    const size_t n,
+    const float* const* a,
+    const float* x,
+    float* y )
+{
+    ::Gemv( transa, m, n, a, x, y );
+}
+
+void Multiply(
+    const bool transa,
+    const size_t m,
+    const size_t n,
+    const double* const* a,
+    const double* x,
+    double* y )
+{
+    ::Gemv( transa, m, n, a, x, y );
+}
+
+} // end of namespace MatrixMultiplication
+
+} // end of namespace kvs
@@ -0,0 +1,143 @@
+/****************************************************************************/
+/**
+ *  @file   MatrixMultiplication.h
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#pragma once
+#include <cstddef>
+
+
+namespace kvs
+{
+
+/*==========================================================================*/
+/**
+ *  Matrix multiplication kernels for the matrices given as the row pointers.
+ *
+ *  The kernels for float and double are cache-tiled and multithreaded GEMM
+ *  (general matrix multiply) with packed panels and a register-blocked micro
+ *  kernel. The kernels for other types are naive loops in the cache-friendly
+ *  order. The results do not depend on the number of threads.
+ */
+/*==========================================================================*/
+namespace MatrixMultiplication
+{
+
+/*==========================================================================*/
+/**
+ *  @brief  Calculates C = op(A) op(B), where op(X) is X or X^t.
+ *  @param  transa [in] if true, op(A) = A^t (k x m), otherwise A (m x k)
+ *  @param  transb [in] if true, op(B) = B^t (n x k), otherwise B (k x n)
+ *  @param  m [in] number of rows of op(A) and C
+ *  @param  n [in] number of columns of op(B) and C
+ *  @param  k [in] number of columns of op(A) and rows of op(B)
+ *  @param  a [in] row pointers of A
+ *  @param  b [in] row pointers of B
+ *  @param  c [out] row pointers of C (m x n)
+ */
+/*==========================================================================*/
+template <typename T>
+inline void Multiply(
+    const bool transa,
+    const bool transb,
+    const size_t m,
+    const size_t n,
+    const size_t k,
+    const T* const* a,
+    const T* const* b,
+    T* const* c )
+{
+    for ( size_t i = 0; i < m; ++i )
+    {
+        T* ci = c[i];
+        for ( size_t j = 0; j < n; ++j ) { ci[j] = T(0); }
+        for ( size_t p = 0; p < k; ++p )
+        {
+            const T aip = transa ? a[p][i] : a[i][p];
+            if ( transb ) { for ( size_t j = 0; j < n; ++j ) { ci[j] += aip * b[j][p]; } }
+            else { const T* bp = b[p]; for ( size_t j = 0; j < n; ++j ) { ci[j] += aip * bp[j]; } }
+        }
+    }
+}
+
+void Multiply(
+    const bool transa,
+    const bool transb,
+    const size_t m,
+    const size_t n,
+    const size_t k,
+    const float* const* a,
+    const float* const* b,
+    float* const* c );
+
+void Multiply(
+    const bool transa,
+    const bool transb,
+    const size_t m,
+    const size_t n,
+    const size_t k,
+    const double* const* a,
+    const double* const* b,
+    double* const* c );
+
+/*==========================================================================*/
+/**
+ *  @brief  Calculates y = op(A) x, where op(A) is A or A^t.
+ *  @param  transa [in] if true, op(A) = A^t, otherwise A
+ *  @param  m [in] number of rows of A
+ *  @param  n [in] number of columns of A
+ *  @param  a [in] row pointers of A (m x n)
+ *  @param  x [in] vector (n for A, m for A^t)
+ *  @param  y [out] vector (m for A, n for A^t)
+ */
+/*==========================================================================*/
+template <typename T>
+inline void Multiply(
+    const bool transa,
+    const size_t m,
+    const size_t n,
+    const T* const* a,
+    const T* x,
+    T* y )
+{
+    if ( transa )
+    {
+        for ( size_t j = 0; j < n; ++j ) { y[j] = T(0); }
+        for ( size_t i = 0; i < m; ++i )
+        {
+            const T* ai = a[i];
+            for ( size_t j = 0; j < n; ++j ) { y[j] += x[i] * ai[j]; }
+        }
+    }
+    else
+    {
+        for ( size_t i = 0; i < m; ++i )
+        {
+            const T* ai = a[i];
+            T sum(0);
+            for ( size_t j = 0; j < n; ++j ) { sum += ai[j] * x[j]; }
+            y[i] = sum;
+        }
+    }
+}
+
+void Multiply(
+    const bool transa,
+    const size_t m,
+    const size_t n,
+    const float* const* a,
+    const float* x,
+    float* y );
+
+void Multiply(
+    const bool transa,
+    const size_t m,
+    const size_t n,
+    const double* const* a,
+    const double* x,
+    double* y );
+
+} // end of namespace MatrixMultiplication
+
+} // end of namespace kvs
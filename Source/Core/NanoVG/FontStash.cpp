@@ -238,6 +238,7 @@ void FontStash::popState()
 void FontStash::draw( const kvs::Vec2& p, const std::string& text )
 {
     fonsDrawText( m_context(), p.x(), p.y(), text.c_str(), NULL );
+    kvs::OpenGL::InvalidateStateTracker(); // bindings changed by fontstash
 }
 
 } // end of namespace kvs
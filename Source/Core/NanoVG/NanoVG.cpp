@@ -68,6 +68,7 @@ void NanoVG::cancelFrame()
 void NanoVG::endFrame()
 {
     nvgEndFrame( m_context() );
+    kvs::OpenGL::InvalidateStateTracker(); // bindings changed by nanovg
 }
 
 void NanoVG::save()
@@ -12,64 +12,15 @@
  */
 /*****************************************************************************/
 #include "AdaptiveKMeans.h"
+#include "KMeansCommon.h"
 #include <kvs/FastKMeans>
-#include <kvs/Matrix>
+#include <kvs/Math>
+#include <kvs/Message>
+#include <kvs/OpenMP>
+#include <vector>
 #include <cmath>
 
 
-namespace
-{
-
-/*===========================================================================*/
-/**
- *  @brief  Returns Mahalanobis distance.
- *  @param  x [in] multivariant vector
- *  @param  u [in] mean values
- *  @return Mahalanobis distance
- */
-/*===========================================================================*/
-inline kvs::Real32 GetMahalanobisDistance(
-    const kvs::ValueArray<kvs::Real32>& x,
-    const kvs::ValueArray<kvs::Real32>& u )
-{
-    const size_t dim = x.size();
-    kvs::Matrix<kvs::Real32> d( dim, 1 );
-    kvs::Matrix<kvs::Real32> dt( 1, dim );
-    for ( size_t i = 0; i < dim; i++ ) { d[i][0] = dt[0][i] = x[i] - u[i]; }
-
-    // Covariance matrix (identity matrix)
-    kvs::Matrix<kvs::Real32> S( dim, dim );
-    S.setIdentity();
-
-    // In this function, the Mahalanobis distance reduces to the Euclidean
-    // distance since the covariance matrix is the identity matrix.
-    return ( dt * S * d )[0][0];
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Returns row array.
- *  @param  table [in] table data
- *  @param  row_index [in] index of the row
- *  @return row array
- */
-/*===========================================================================*/
-inline kvs::ValueArray<kvs::Real32> GetRowArray(
-    const kvs::AnyValueTable& table,
-    const size_t row_index )
-{
-    const size_t ncolumns = table.columnSize();
-    kvs::ValueArray<kvs::Real32> row( ncolumns );
-    for ( size_t i = 0; i < ncolumns; i++ )
-    {
-        row[i] = table.column(i).at<kvs::Real32>( row_index );
-    }
-
-    return row;
-}
-
-}
-
 namespace kvs
 {
 
@@ -101,6 +52,11 @@ void AdaptiveKMeans::run()
     const size_t p = ncolumns; // p-dimension
     const kvs::Real32 Y = p * 0.5f; // transformation power
 
+    // Data points (nrows x ncolumns).
+    const kvs::ValueArray<kvs::Real32> x = kvs::detail::GetDataPoints( m_input_table );
+    const kvs::detail::RowBlocks blocks( nrows );
+    std::vector<kvs::Real64> partial_distortions( blocks.nblocks );
+
     size_t nclusters = 1; // number of clusters (best k)
     kvs::Real32 Jmax = 0.0f; // maximum jump
     kvs::ValueArray<kvs::UInt32> IDs; // cluster IDs with the best k
@@ -110,6 +66,7 @@ void AdaptiveKMeans::run()
     {
         // k-means clustering.
         kvs::FastKMeans kmeans;
+        kmeans.setSeed( m_random.randInteger() );
         kmeans.setSeedingMethod( kvs::FastKMeans::SmartSeeding );
         kmeans.setNumberOfClusters( k );
         kmeans.setMaxIterations( m_max_iterations );
@@ -118,20 +75,29 @@ void AdaptiveKMeans::run()
         kmeans.run();
 
         // Calculate the distortions (averaged Mahalanobis distance per dimension).
-        distortion[k] = 0.0f;
-        for ( size_t i = 0; i < nrows; i++ )
+        // The Mahalanobis distance reduces to the squared Euclidean distance
+        // since the covariance matrix is assumed as the identity matrix.
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long b = 0; b < long( blocks.nblocks ); b++ )
         {
-            kvs::ValueArray<kvs::Real32> cx = kmeans.clusterCenter(0);
-            kvs::ValueArray<kvs::Real32> x = ::GetRowArray( m_input_table, i );
-            kvs::Real32 distance = ::GetMahalanobisDistance( x, cx );
-            for ( size_t j = 1; j < k; j++ )
+            kvs::Real64 sum = 0.0;
+            for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ )
             {
-                cx = kmeans.clusterCenter(j);
-                distance = kvs::Math::Min( distance, ::GetMahalanobisDistance( x, cx ) );
+                const kvs::Real32* xi = x.data() + i * p;
+                kvs::Real32 distance = kvs::detail::GetSquaredDistance( xi, kmeans.clusterCenter(0).data(), p );
+                for ( size_t j = 1; j < k; j++ )
+                {
+                    const kvs::Real32 d = kvs::detail::GetSquaredDistance( xi, kmeans.clusterCenter(j).data(), p );
+                    distance = kvs::Math::Min( distance, d );
+                }
+                sum += distance;
             }
-            distortion[k] += distance;
+            partial_distortions[b] = sum;
         }
-        distortion[k] = ( 1.0f / p ) * ( ( 1.0f / nrows ) * distortion[k] );
+
+        kvs::Real64 sum = 0.0;
+        for ( size_t b = 0; b < blocks.nblocks; b++ ) { sum += partial_distortions[b]; }
+        distortion[k] = static_cast<kvs::Real32>( ( 1.0 / p ) * ( sum / nrows ) );
 
         // Calculate jump in transformed distortion.
         kvs::Real32 Jk = std::pow( distortion[k], -Y ) - std::pow( distortion[k-1], -Y );
@@ -152,6 +118,7 @@ void AdaptiveKMeans::run()
         }
     }
 
+    if ( m_cluster_centers ) delete [] m_cluster_centers;
     m_nclusters = nclusters;
     m_cluster_ids = IDs;
     m_cluster_centers = centers;
@@ -12,6 +12,7 @@
  */
 /*****************************************************************************/
 #pragma once
+#include <kvs/MersenneTwister>
 #include <kvs/ValueArray>
 #include <kvs/AnyValueTable>
 
@@ -27,6 +28,7 @@ namespace kvs
 class AdaptiveKMeans
 {
 private:
+    kvs::MersenneTwister m_random{}; ///< random number generator
     size_t m_nclusters = 0; ///< number of clusters
     size_t m_max_iterations = 100; ///< maximum number of interations
     float m_tolerance = 1.e-6; ///< tolerance of distance
@@ -40,6 +42,7 @@ public:
     AdaptiveKMeans() = default;
     virtual ~AdaptiveKMeans() { if ( m_cluster_centers ) { delete [] m_cluster_centers; } }
 
+    void setSeed( const size_t seed ) { m_random.setSeed( seed ); }
     void setMaxNumberOfClusters( const size_t max_nclusters ) { m_max_nclusters = max_nclusters; }
     void setMaxIterations( const size_t max_iterations ) { m_max_iterations = max_iterations; }
     void setTolerance( const float tolerance ) { m_tolerance = tolerance; }
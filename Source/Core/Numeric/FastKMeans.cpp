@@ -11,12 +11,20 @@
  * [2] D. Arthur and S. Vassilvitskii, k-means++ : The Advantages of Careful
  *     Seeding, in Proceedings of the eighteenth annual ACM-SIAM symposium on
  *     Discrete algorithms, 2007, pp. 1027-1035.
+ * [3] B. Bahmani, B. Moseley, A. Vattani, R. Kumar and S. Vassilvitskii,
+ *     Scalable k-means++, Proceedings of the VLDB Endowment, vol. 5, no. 7,
+ *     pp. 622-633, 2012.
  */
 /*****************************************************************************/
 #include "FastKMeans.h"
+#include "KMeansCommon.h"
 #include <kvs/Value>
 #include <kvs/Message>
 #include <kvs/Math>
+#include <kvs/OpenMP>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
 
 namespace
@@ -27,102 +35,279 @@ namespace
  *  @brief  Returns the distance between the given points.
  *  @param  x0 [in] point 0
  *  @param  x1 [in] point 1
+ *  @param  dim [in] dimension of the points
  *  @return distance
  */
 /*===========================================================================*/
 inline kvs::Real32 GetEuclideanDistance(
-    const kvs::ValueArray<kvs::Real32>& x0,
-    const kvs::ValueArray<kvs::Real32>& x1 )
+    const kvs::Real32* x0,
+    const kvs::Real32* x1,
+    const size_t dim )
 {
-    kvs::Real32 distance = 0.0f;
-    const size_t nrows = x0.size();
-    for ( size_t i = 0; i < nrows; i++ )
+    return std::sqrt( kvs::detail::GetSquaredDistance( x0, x1, dim ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns an uniform random number in [0,1) for the given counters.
+ *  @param  seed [in] seed value
+ *  @param  round [in] round counter
+ *  @param  index [in] row index
+ *  @return uniform random number
+ *
+ *  The random number is generated by hashing the counters (SplitMix64), so
+ *  that it does not depend on the order of the rows processed by the threads.
+ */
+/*===========================================================================*/
+inline kvs::Real64 GetRandomNumber(
+    const kvs::UInt64 seed,
+    const kvs::UInt64 round,
+    const kvs::UInt64 index )
+{
+    kvs::UInt64 z = seed + ( round << 40 ) + index;
+    z += 0x9e3779b97f4a7c15ULL;
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+    z = z ^ ( z >> 31 );
+    return kvs::Real64( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the sum of the values calculated in the block order.
+ *  @param  blocks [in] row blocks
+ *  @param  values [in] values of the rows
+ *  @return sum of the values
+ */
+/*===========================================================================*/
+inline kvs::Real64 GetSum(
+    const kvs::detail::RowBlocks& blocks,
+    const kvs::ValueArray<kvs::Real32>& values )
+{
+    std::vector<kvs::Real64> partial_sums( blocks.nblocks, 0.0 );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long b = 0; b < long( blocks.nblocks ); b++ )
     {
-        const kvs::Real32 diff = x1[i] - x0[i];
-        distance += diff * diff;
+        kvs::Real64 sum = 0.0;
+        for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ ) { sum += values[i]; }
+        partial_sums[b] = sum;
     }
 
-    return distance;
+    kvs::Real64 sum = 0.0;
+    for ( size_t b = 0; b < blocks.nblocks; b++ ) { sum += partial_sums[b]; }
+    return sum;
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Initializes cluster centers with random seeding.
- *  @param  table [in] table data
+ *  @param  data [in] data points
+ *  @param  nrows [in] number of rows
+ *  @param  ncolumns [in] number of columns
  *  @param  nclusters [in] number of clusters
  *  @param  random [in] random number generator
- *  @param  center [out] cluster centers
+ *  @param  c [out] cluster centers
  */
 /*===========================================================================*/
 inline void InitializeCenterWithRandomSeeding(
-    const kvs::AnyValueTable& table,
+    const kvs::ValueArray<kvs::Real32>& data,
+    const size_t nrows,
+    const size_t ncolumns,
     const size_t nclusters,
     kvs::MersenneTwister& random,
-    kvs::ValueArray<kvs::Real32>* center )
+    kvs::ValueArray<kvs::Real32>& c )
 {
-    const size_t nrows = table.column(0).size();
     for ( size_t i = 0; i < nclusters; i++ )
     {
-        const kvs::UInt32 index = static_cast<kvs::UInt32>( nrows * random.rand() );
-        center[i] = table.rowAsValueArray<kvs::Real32>( index );
+        const size_t index = random.randInteger( static_cast<unsigned long>( nrows - 1 ) );
+        std::copy( data.begin() + index * ncolumns, data.begin() + ( index + 1 ) * ncolumns, c.begin() + i * ncolumns );
     }
 }
 
 /*===========================================================================*/
 /**
- *  @brief  Initializes cluster centers with smart seeding.
- *  @param  table [in] table data
+ *  @brief  Returns an index selected with the probability proportional to the value.
+ *  @param  values [in] non-negative values
+ *  @param  total [in] sum of the values
+ *  @param  random [in] random number generator
+ *  @return selected index
+ */
+/*===========================================================================*/
+inline size_t SelectIndex(
+    const std::vector<kvs::Real64>& values,
+    const kvs::Real64 total,
+    kvs::MersenneTwister& random )
+{
+    const size_t nvalues = values.size();
+    const kvs::Real64 r = random.rand53() * total;
+    kvs::Real64 s = 0.0;
+    for ( size_t i = 0; i < nvalues; i++ )
+    {
+        s += values[i];
+        if ( r < s ) { return i; }
+    }
+
+    // Round-off error of the sum.
+    for ( size_t i = nvalues; i > 0; i-- )
+    {
+        if ( values[i-1] > 0.0 ) { return i - 1; }
+    }
+    return 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Initializes cluster centers with weighted k-means++ seeding.
+ *  @param  candidates [in] candidate points
+ *  @param  weights [in] weights of the candidate points
+ *  @param  ncolumns [in] number of columns
  *  @param  nclusters [in] number of clusters
  *  @param  random [in] random number generator
- *  @param  center [out] cluster centers
+ *  @param  c [out] cluster centers
+ */
+/*===========================================================================*/
+inline void InitializeCenterWithWeightedSeeding(
+    const std::vector<kvs::Real32>& candidates,
+    const std::vector<kvs::Real64>& weights,
+    const size_t ncolumns,
+    const size_t nclusters,
+    kvs::MersenneTwister& random,
+    kvs::ValueArray<kvs::Real32>& c )
+{
+    const size_t ncandidates = weights.size();
+
+    kvs::Real64 W = 0.0;
+    for ( size_t i = 0; i < ncandidates; i++ ) { W += weights[i]; }
+
+    size_t index = ::SelectIndex( weights, W, random );
+    std::copy( candidates.begin() + index * ncolumns, candidates.begin() + ( index + 1 ) * ncolumns, c.begin() );
+
+    std::vector<kvs::Real64> D( ncandidates );
+    for ( size_t i = 0; i < ncandidates; i++ )
+    {
+        D[i] = kvs::detail::GetSquaredDistance( &candidates[ i * ncolumns ], c.data(), ncolumns );
+    }
+
+    for ( size_t j = 1; j < nclusters; j++ )
+    {
+        kvs::Real64 S = 0.0;
+        std::vector<kvs::Real64> P( ncandidates );
+        for ( size_t i = 0; i < ncandidates; i++ ) { P[i] = weights[i] * D[i]; S += P[i]; }
+
+        // S is zero if all of the distinct candidates have been selected.
+        index = S > 0.0 ? ::SelectIndex( P, S, random ) : random.randInteger( static_cast<unsigned long>( ncandidates - 1 ) );
+
+        const kvs::Real32* cj = &candidates[ index * ncolumns ];
+        std::copy( cj, cj + ncolumns, c.begin() + j * ncolumns );
+        for ( size_t i = 0; i < ncandidates; i++ )
+        {
+            const kvs::Real64 d = kvs::detail::GetSquaredDistance( &candidates[ i * ncolumns ], cj, ncolumns );
+            D[i] = kvs::Math::Min( D[i], d );
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Initializes cluster centers with scalable k-means++ (k-means||).
+ *  @param  data [in] data points
+ *  @param  nrows [in] number of rows
+ *  @param  ncolumns [in] number of columns
+ *  @param  nclusters [in] number of clusters
+ *  @param  random [in] random number generator
+ *  @param  c [out] cluster centers
+ *
+ *  The candidates are sampled in parallel with the oversampling factor of 2k
+ *  over five rounds [3], and the k centers are selected from the candidates
+ *  weighted by the number of the closest points with k-means++ [2].
  */
 /*===========================================================================*/
 inline void InitializeCenterWithSmartSeeding(
-    const kvs::AnyValueTable& table,
+    const kvs::ValueArray<kvs::Real32>& data,
+    const size_t nrows,
+    const size_t ncolumns,
     const size_t nclusters,
     kvs::MersenneTwister& random,
-    kvs::ValueArray<kvs::Real32>* center )
+    kvs::ValueArray<kvs::Real32>& c )
 {
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
-    const kvs::UInt32 index = static_cast<kvs::UInt32>( nrows * random.rand() );
-    center[0] = table.rowAsValueArray<kvs::Real32>( index );
+    const kvs::detail::RowBlocks blocks( nrows );
+    const size_t nrounds = 5;
+    const kvs::Real64 L = 2.0 * nclusters; // oversampling factor
+    const kvs::UInt64 seed = ( kvs::UInt64( random.randInteger() ) << 32 ) | random.randInteger();
+
+    // Candidates of the centers (row indices).
+    std::vector<kvs::UInt32> candidates;
+    candidates.push_back( static_cast<kvs::UInt32>( random.randInteger( static_cast<unsigned long>( nrows - 1 ) ) ) );
+
+    // D: squared distance from the point to the closest candidate
+    // N: index of the closest candidate
+    kvs::ValueArray<kvs::Real32> D( nrows );
+    kvs::ValueArray<kvs::UInt32> N( nrows );
+    {
+        const kvs::Real32* c0 = data.data() + candidates[0] * ncolumns;
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < long( nrows ); i++ )
+        {
+            D[i] = kvs::detail::GetSquaredDistance( data.data() + i * ncolumns, c0, ncolumns );
+            N[i] = 0;
+        }
+    }
 
-    for ( size_t i = 1; i < nclusters; i++ )
+    std::vector<std::vector<kvs::UInt32> > selected( blocks.nblocks );
+    for ( size_t round = 0; round < nrounds; round++ )
     {
-        kvs::Real32 S = 0.0;
-        kvs::Real32* D = new kvs::Real32 [ nrows ];
-        for ( size_t j = 0; j < nrows; j++ )
+        const kvs::Real64 psi = ::GetSum( blocks, D );
+        if ( !( psi > 0.0 ) ) { break; }
+
+        // Sample each point independently with the probability L * D / psi.
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long b = 0; b < long( blocks.nblocks ); b++ )
         {
-            kvs::Real32 distance = kvs::Value<kvs::Real32>::Max();
-            for ( size_t k = 0; k < nclusters; k++ )
+            selected[b].clear();
+            for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ )
             {
-                const kvs::Real32 d = GetEuclideanDistance( table.rowAsValueArray<kvs::Real32>(j), center[k] );
-                if ( d < distance ) { distance = d; }
+                const kvs::Real64 p = L * D[i] / psi;
+                if ( ::GetRandomNumber( seed, round, i ) < p )
+                {
+                    selected[b].push_back( static_cast<kvs::UInt32>( i ) );
+                }
             }
-            D[j] = distance;
-            S += distance * distance;
         }
 
-        size_t index = 0;
-        kvs::Real32 P = 0.0;
-        for ( size_t j = 0; j < nrows; j++ )
+        const size_t offset = candidates.size();
+        for ( size_t b = 0; b < blocks.nblocks; b++ )
         {
-            const kvs::Real32 DD = D[j] * D[j];
-            if ( P < kvs::Math::Max( P, DD / S ) )
-            {
-                P = DD / S;
-                index = j;
-            }
+            candidates.insert( candidates.end(), selected[b].begin(), selected[b].end() );
         }
+        if ( candidates.size() == offset ) { continue; }
 
-        for ( size_t j = 0; j < ncolumns; j++ )
+        // Update the closest candidates.
+        const long ncandidates = long( candidates.size() );
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < long( nrows ); i++ )
         {
-            center[i].at(j) = table.column(j).at<kvs::Real32>( index );
+            const kvs::Real32* x = data.data() + i * ncolumns;
+            for ( long j = long( offset ); j < ncandidates; j++ )
+            {
+                const kvs::Real32 d = kvs::detail::GetSquaredDistance( x, data.data() + candidates[j] * ncolumns, ncolumns );
+                if ( d < D[i] ) { D[i] = d; N[i] = static_cast<kvs::UInt32>( j ); }
+            }
         }
+    }
+
+    // Weight of the candidate (number of the closest points).
+    const size_t ncandidates = candidates.size();
+    std::vector<kvs::Real64> weights( ncandidates, 0.0 );
+    for ( size_t i = 0; i < nrows; i++ ) { weights[ N[i] ] += 1.0; }
 
-        delete [] D;
+    std::vector<kvs::Real32> points( ncandidates * ncolumns );
+    for ( size_t j = 0; j < ncandidates; j++ )
+    {
+        const kvs::Real32* x = data.data() + candidates[j] * ncolumns;
+        std::copy( x, x + ncolumns, points.begin() + j * ncolumns );
     }
+
+    ::InitializeCenterWithWeightedSeeding( points, weights, ncolumns, nclusters, random, c );
 }
 
 }
@@ -134,6 +319,7 @@ namespace
 /**
  *  @brief  Updates upper and lower bounds and index of the center over all centers.
  *  @param  nclusters [in] number of clusters
+ *  @param  ncolumns [in] number of columns
  *  @param  xi [in] data point at i-th row in the table data
  *  @param  c [in] set of centers
  *  @param  ai [out] index of the centers for xi
@@ -143,89 +329,127 @@ namespace
 /*===========================================================================*/
 inline void PointAllCtrs(
     const size_t nclusters,
-    const kvs::ValueArray<kvs::Real32>& xi,
-    const kvs::ValueArray<kvs::Real32>* c,
+    const size_t ncolumns,
+    const kvs::Real32* xi,
+    const kvs::Real32* c,
     kvs::UInt32& ai,
     kvs::Real32& ui,
     kvs::Real32& li )
 {
     // Algorithm 3: POINT-ALL-CTRS( x(i), c, a(i), u(i), l(i) )
 
+    // The closest and the second closest centers are found in a single pass.
     kvs::UInt32 index = 0;
-    kvs::Real32 dmin = kvs::Value<kvs::Real32>::Max();
+    kvs::Real32 dmin1 = kvs::Value<kvs::Real32>::Max();
+    kvs::Real32 dmin2 = kvs::Value<kvs::Real32>::Max();
     for ( size_t j = 0; j < nclusters; j++ )
     {
-        const kvs::Real32 d = ::GetEuclideanDistance( xi, c[j] );
-        if ( d < dmin )
+        const kvs::Real32 d = kvs::detail::GetSquaredDistance( xi, c + j * ncolumns, ncolumns );
+        if ( d < dmin1 )
         {
-            dmin = d;
+            dmin2 = dmin1;
+            dmin1 = d;
             index = static_cast<kvs::UInt32>(j);
         }
-    }
-    ai = index;
-
-    ui = ::GetEuclideanDistance( xi, c[ai] );
-
-    dmin = kvs::Value<kvs::Real32>::Max();
-    for ( size_t j = 0; j < nclusters; j++ )
-    {
-        if ( j != ai )
+        else if ( d < dmin2 )
         {
-            const kvs::Real32 d = ::GetEuclideanDistance( xi, c[j] );
-            dmin = kvs::Math::Min( dmin, d );
+            dmin2 = d;
         }
     }
-    li = dmin;
+
+    ai = index;
+    ui = std::sqrt( dmin1 );
+    li = nclusters > 1 ? std::sqrt( dmin2 ) : kvs::Value<kvs::Real32>::Max();
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Initializes the upper and lower bounds and the assignments.
+ *  @param  blocks [in] row blocks
  *  @param  nclusters [in] number of clusters
- *  @param  table [in] table data
+ *  @param  ncolumns [in] number of columns
+ *  @param  data [in] data points
  *  @param  c [in] set of cluster centers
- *  @param  q [out] number of points
- *  @param  cp [out] vector sum of all points
  *  @param  u [out] upper bound
  *  @param  l [out] lower bound
  *  @param  a [out] index of the center
  */
 /*===========================================================================*/
 inline void Initialize(
+    const kvs::detail::RowBlocks& blocks,
     const size_t nclusters,
-    const kvs::AnyValueTable& table,
-    const kvs::ValueArray<kvs::Real32>* c,
-    kvs::ValueArray<kvs::UInt32>& q,
-    kvs::ValueArray<kvs::Real32>* cp,
+    const size_t ncolumns,
+    const kvs::ValueArray<kvs::Real32>& data,
+    const kvs::ValueArray<kvs::Real32>& c,
     kvs::ValueArray<kvs::Real32>& u,
     kvs::ValueArray<kvs::Real32>& l,
     kvs::ValueArray<kvs::UInt32>& a )
 {
     // Algorithm 2: INITIALIZE( c, x, q, c', u, l, a )
 
-    for ( size_t j = 0; j < nclusters; j++ )
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < long( blocks.nrows ); i++ )
     {
-        q[j] = 0;
-        cp[j].fill( 0x00 );
+        const kvs::Real32* xi = data.data() + i * ncolumns;
+        ::PointAllCtrs( nclusters, ncolumns, xi, c.data(), a[i], u[i], l[i] );
     }
+}
 
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
-    for ( size_t i = 0; i < nrows; i++ )
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the number of points and the vector sum for each cluster.
+ *  @param  blocks [in] row blocks
+ *  @param  nclusters [in] number of clusters
+ *  @param  ncolumns [in] number of columns
+ *  @param  data [in] data points
+ *  @param  a [in] array of index of the center
+ *  @param  q [out] array of the number of points
+ *  @param  cp [out] set of the vector sum of all points
+ */
+/*===========================================================================*/
+inline void Accumulate(
+    const kvs::detail::RowBlocks& blocks,
+    const size_t nclusters,
+    const size_t ncolumns,
+    const kvs::ValueArray<kvs::Real32>& data,
+    const kvs::ValueArray<kvs::UInt32>& a,
+    kvs::ValueArray<kvs::Int64>& q,
+    kvs::ValueArray<kvs::Real64>& cp )
+{
+    const size_t nsums = nclusters * ncolumns;
+    std::vector<kvs::Real64> partial_cp( blocks.nblocks * nsums, 0.0 );
+    std::vector<kvs::Int64> partial_q( blocks.nblocks * nclusters, 0 );
+
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long b = 0; b < long( blocks.nblocks ); b++ )
     {
-        const kvs::ValueArray<kvs::Real32> xi = table.rowAsValueArray<kvs::Real32>(i);
-        PointAllCtrs( nclusters, xi, c, a[i], u[i], l[i] );
-        q[a[i]] += 1;
-        for ( size_t k = 0; k < ncolumns; k++ )
+        kvs::Real64* sums = partial_cp.data() + b * nsums;
+        kvs::Int64* counts = partial_q.data() + b * nclusters;
+        for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ )
         {
-            cp[a[i]][k] += xi[k];
+            const kvs::Real32* xi = data.data() + i * ncolumns;
+            kvs::Real64* sum = sums + a[i] * ncolumns;
+            for ( size_t k = 0; k < ncolumns; k++ ) { sum[k] += xi[k]; }
+            counts[ a[i] ] += 1;
         }
     }
+
+    // Reduce the partial sums in the block order.
+    q.fill( 0 );
+    cp.fill( 0 );
+    for ( size_t b = 0; b < blocks.nblocks; b++ )
+    {
+        const kvs::Real64* sums = partial_cp.data() + b * nsums;
+        const kvs::Int64* counts = partial_q.data() + b * nclusters;
+        for ( size_t k = 0; k < nsums; k++ ) { cp[k] += sums[k]; }
+        for ( size_t j = 0; j < nclusters; j++ ) { q[j] += counts[j]; }
+    }
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Updates the center locations.
+ *  @param  ncolumns [in] number of columns
  *  @param  cp [in] set of the vector sum of all points
  *  @param  q [in] array of the number of points
  *  @param  c [out] updated cluster centers
@@ -233,25 +457,31 @@ inline void Initialize(
  */
 /*===========================================================================*/
 inline void MoveCenters(
-    const kvs::ValueArray<kvs::Real32>* cp,
-    const kvs::ValueArray<kvs::UInt32>& q,
-    kvs::ValueArray<kvs::Real32>* c,
+    const size_t ncolumns,
+    const kvs::ValueArray<kvs::Real64>& cp,
+    const kvs::ValueArray<kvs::Int64>& q,
+    kvs::ValueArray<kvs::Real32>& c,
     kvs::ValueArray<kvs::Real32>& p )
 {
     // Algorithm 4: MOVE-CENTERS( c', q, c, p )
 
+    std::vector<kvs::Real32> cs( ncolumns );
     const size_t nclusters = q.size();
     for ( size_t j = 0; j < nclusters; j++ )
     {
-        kvs::ValueArray<kvs::Real32> cs = c[j].clone();
+        // The center of the empty cluster is not moved.
+        p[j] = 0.0f;
+        if ( q[j] == 0 ) { continue; }
 
-        const size_t nrows = cp[j].size();
-        const kvs::Real32 qj = static_cast<kvs::Real32>( q[j] );
-        for ( size_t k = 0; k < nrows; k++ )
+        kvs::Real32* cj = c.data() + j * ncolumns;
+        std::copy( cj, cj + ncolumns, cs.begin() );
+
+        const kvs::Real64 qj = static_cast<kvs::Real64>( q[j] );
+        for ( size_t k = 0; k < ncolumns; k++ )
         {
-            c[j][k] = cp[j][k] / qj;
+            cj[k] = static_cast<kvs::Real32>( cp[ j * ncolumns + k ] / qj );
         }
-        p[j] = ::GetEuclideanDistance( cs, c[j] );
+        p[j] = ::GetEuclideanDistance( cs.data(), cj, ncolumns );
     }
 }
 
@@ -273,8 +503,6 @@ inline void UpdateBounds(
     // Algorithm 5: UPDATE-BOUNDS( p, a, u, l )
 
     kvs::UInt32 r = 0;
-    kvs::UInt32 rp = 0;
-
     kvs::Real32 pmax = kvs::Value<kvs::Real32>::Min();
     const size_t nclusters = p.size();
     for ( size_t j = 0; j < nclusters; j++ )
@@ -282,82 +510,22 @@ inline void UpdateBounds(
         if ( p[j] > pmax )
         {
             pmax = p[j];
-            r = j;
+            r = static_cast<kvs::UInt32>(j);
         }
     }
 
-    pmax = kvs::Value<kvs::Real32>::Min();
+    kvs::Real32 ppmax = 0.0f;
     for ( size_t j = 0; j < nclusters; j++ )
     {
-        if ( j != r )
-        {
-            if ( p[j] > pmax )
-            {
-                pmax = p[j];
-                rp = j;
-            }
-        }
+        if ( j != r ) { ppmax = kvs::Math::Max( ppmax, p[j] ); }
     }
 
-    const size_t nrows = u.size();
-    for ( size_t i = 0; i < nrows; i++ )
+    const long nrows = long( u.size() );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nrows; i++ )
     {
-        u[i] += p[a[i]];
-        l[i] -= ( r == a[i] ) ? p[rp] : p[r];
-    }
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Updates the number of points specified by the given index.
- *  @param  m [in] index of the center
- *  @param  a [in] array of index of the center
- *  @param  q [in/out] updated the array of the number of points
- */
-/*===========================================================================*/
-inline void Update(
-    const size_t m,
-    const kvs::ValueArray<kvs::UInt32>& a,
-    kvs::ValueArray<kvs::UInt32>& q )
-{
-    size_t counter = 0;
-    const size_t nrows = a.size();
-    for ( size_t i = 0; i < nrows; i++ )
-    {
-        if ( a[i] == m ) counter++;
-    }
-
-    q[m] = counter;
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Updates the vector sum of all points specified by the given index.
- *  @param  m [in] index of the center
- *  @param  table [in] table data
- *  @param  a [in] array of index of the center
- *  @param  cp [out] set of the vector sum of all points
- */
-/*===========================================================================*/
-inline void Update(
-    const size_t m,
-    const kvs::AnyValueTable& table,
-    const kvs::ValueArray<kvs::UInt32>& a,
-    kvs::ValueArray<kvs::Real32>* cp )
-{
-    const size_t nrows = a.size();
-    const size_t ncolumns = table.columnSize();
-
-    cp[m].fill( 0x00 );
-    for ( size_t i = 0; i < nrows; i++ )
-    {
-        if ( a[i] == m )
-        {
-            for ( size_t k = 0; k < ncolumns; k++ )
-            {
-                cp[m][k] += table.column(k).at<kvs::Real32>(i);
-            }
-        }
+        u[i] += p[ a[i] ];
+        l[i] -= ( r == a[i] ) ? ppmax : pmax;
     }
 }
 
@@ -370,6 +538,13 @@ namespace kvs
 /*===========================================================================*/
 /**
  *  @brief  Executes Hamerly's k-means clustering.
+ *
+ *  The table data is copied to the row-major float array, and the data points
+ *  are processed in parallel with the row blocks. The vector sums of the points
+ *  in the clusters are updated with the partial sums of the points reassigned
+ *  in each block, and they are reduced in the block order. Therefore, the
+ *  result is deterministic for the given seed regardless of the number of the
+ *  threads.
  */
 /*===========================================================================*/
 void FastKMeans::run()
@@ -391,25 +566,29 @@ void FastKMeans::run()
         }
     }
 
+    if ( nrows == 0 || m_nclusters == 0 )
+    {
+        kvsMessageError("The number of rows or clusters is zero.");
+        return;
+    }
+
+    // Data points (nrows x ncolumns).
+    const kvs::ValueArray<kvs::Real32> x = kvs::detail::GetDataPoints( m_input_table );
+    const kvs::detail::RowBlocks blocks( nrows );
+
     // Parameters that relate to cluster centers.
-    /*   c:  cluster center
-     *   cp: vector sum of all points in the cluster
+    /*   c:  cluster center (nclusters x ncolumns)
+     *   cp: vector sum of all points in the cluster (nclusters x ncolumns)
      *   q:  number of points assigned to the cluster
      *   p:  distance that c last moved
-     *   s:  distance from c to its closest other center
+     *   s:  half the distance from c to its closest other center
      */
-    kvs::ValueArray<kvs::Real32>* c = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
-    kvs::ValueArray<kvs::Real32>* cp = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
-    kvs::ValueArray<kvs::UInt32> q( m_nclusters );
+    kvs::ValueArray<kvs::Real32> c( m_nclusters * ncolumns );
+    kvs::ValueArray<kvs::Real64> cp( m_nclusters * ncolumns );
+    kvs::ValueArray<kvs::Int64> q( m_nclusters );
     kvs::ValueArray<kvs::Real32> p( m_nclusters );
     kvs::ValueArray<kvs::Real32> s( m_nclusters );
 
-    for ( size_t j = 0; j < m_nclusters; j++ )
-    {
-        c[j].allocate( ncolumns );
-        cp[j].allocate( ncolumns );
-    }
-
     // Parameters that relate to data points.
     /*   a:  index of the center to which the data point x is assigned
      *   u:  upper bound on the distance between the data point x and
@@ -426,21 +605,25 @@ void FastKMeans::run()
     switch ( m_seeding_method )
     {
     case RandomSeeding:
-        ::InitializeCenterWithRandomSeeding( m_input_table, m_nclusters, m_random, c );
+        ::InitializeCenterWithRandomSeeding( x, nrows, ncolumns, m_nclusters, m_random, c );
         break;
     case SmartSeeding:
-        ::InitializeCenterWithSmartSeeding( m_input_table, m_nclusters, m_random, c );
+        ::InitializeCenterWithSmartSeeding( x, nrows, ncolumns, m_nclusters, m_random, c );
         break;
     default:
-        ::InitializeCenterWithRandomSeeding( m_input_table, m_nclusters, m_random, c );
+        ::InitializeCenterWithRandomSeeding( x, nrows, ncolumns, m_nclusters, m_random, c );
         break;
     }
 
     // Initialize.
-    ::Initialize( m_nclusters, m_input_table, c, q, cp, u, l, a );
+    ::Initialize( blocks, m_nclusters, ncolumns, x, c, u, l, a );
+    ::Accumulate( blocks, m_nclusters, ncolumns, x, a, q, cp );
 
-    // Cluster IDs.
-    kvs::ValueArray<kvs::UInt32> IDs;
+    // Partial sums of the reassigned points for each block.
+    const size_t nsums = m_nclusters * ncolumns;
+    std::vector<kvs::Real64> partial_cp( blocks.nblocks * nsums );
+    std::vector<kvs::Int64> partial_q( blocks.nblocks * m_nclusters );
+    std::vector<kvs::UInt8> reassigned( blocks.nblocks );
 
     // Clustering.
     bool converged = false;
@@ -448,65 +631,93 @@ void FastKMeans::run()
     while ( !converged )
     {
         // Update s.
-        for ( size_t j = 0; j < m_nclusters; j++ )
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long j = 0; j < long( m_nclusters ); j++ )
         {
             kvs::Real32 dmin = kvs::Value<kvs::Real32>::Max();
             for ( size_t jp = 0; jp < m_nclusters; jp++ )
             {
-                if ( jp != j )
+                if ( jp != size_t(j) )
                 {
-                    const kvs::Real32 d = ::GetEuclideanDistance( c[jp], c[j] );
+                    const kvs::Real32 d = kvs::detail::GetSquaredDistance( c.data() + jp * ncolumns, c.data() + j * ncolumns, ncolumns );
                     dmin = kvs::Math::Min( dmin, d );
                 }
             }
-            s[j] = dmin;
+            s[j] = m_nclusters > 1 ? std::sqrt( dmin ) * 0.5f : kvs::Value<kvs::Real32>::Max();
         }
 
-        for ( size_t i = 0; i < nrows; i++ )
+        KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+        for ( long b = 0; b < long( blocks.nblocks ); b++ )
         {
-            const kvs::Real32 m = kvs::Math::Max( s[a[i]] * 0.5f, l[i] );
-            if ( u[i] > m ) // First bound test.
+            reassigned[b] = 0;
+            kvs::Real64* sums = partial_cp.data() + b * nsums;
+            kvs::Int64* counts = partial_q.data() + b * m_nclusters;
+            for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ )
             {
+                const kvs::Real32 m = kvs::Math::Max( s[a[i]], l[i] );
+                if ( !( u[i] > m ) ) { continue; } // First bound test.
+
                 // Tighten upper bound.
-                const kvs::ValueArray<kvs::Real32> xi = m_input_table.rowAsValueArray<kvs::Real32>(i);
-                u[i] = ::GetEuclideanDistance( xi, c[a[i]] );
-                if ( u[i] > m ) // Second bound test.
+                const kvs::Real32* xi = x.data() + i * ncolumns;
+                u[i] = ::GetEuclideanDistance( xi, c.data() + a[i] * ncolumns, ncolumns );
+                if ( !( u[i] > m ) ) { continue; } // Second bound test.
+
+                const kvs::UInt32 ap = a[i];
+                ::PointAllCtrs( m_nclusters, ncolumns, xi, c.data(), a[i], u[i], l[i] );
+                if ( ap != a[i] )
                 {
-                    const kvs::UInt32 ap = a[i];
-                    ::PointAllCtrs( m_nclusters, xi, c, a[i], u[i], l[i] );
-                    if ( ap != a[i] )
+                    if ( !reassigned[b] )
+                    {
+                        std::fill( sums, sums + nsums, 0.0 );
+                        std::fill( counts, counts + m_nclusters, 0 );
+                        reassigned[b] = 1;
+                    }
+
+                    counts[ap] -= 1;
+                    counts[a[i]] += 1;
+                    kvs::Real64* sum_ap = sums + ap * ncolumns;
+                    kvs::Real64* sum_ai = sums + a[i] * ncolumns;
+                    for ( size_t k = 0; k < ncolumns; k++ )
                     {
-                        ::Update( ap, a, q );
-                        ::Update( a[i], a, q );
-                        ::Update( ap, m_input_table, a, cp );
-                        ::Update( a[i], m_input_table, a, cp );
+                        sum_ap[k] -= xi[k];
+                        sum_ai[k] += xi[k];
                     }
                 }
             }
         }
 
-        ::MoveCenters( cp, q, c, p );
-        ::UpdateBounds( p, a, u, l );
+        // Reduce the partial sums in the block order.
+        for ( size_t b = 0; b < blocks.nblocks; b++ )
+        {
+            if ( !reassigned[b] ) { continue; }
 
-        // Update cluster IDs.
-        IDs = a;
+            const kvs::Real64* sums = partial_cp.data() + b * nsums;
+            const kvs::Int64* counts = partial_q.data() + b * m_nclusters;
+            for ( size_t k = 0; k < nsums; k++ ) { cp[k] += sums[k]; }
+            for ( size_t j = 0; j < m_nclusters; j++ ) { q[j] += counts[j]; }
+        }
+
+        ::MoveCenters( ncolumns, cp, q, c, p );
+        ::UpdateBounds( p, a, u, l );
 
-        // Convergence test.
+        // Convergence test (squared distance that the centers moved).
         converged = true;
         for ( size_t j = 0; j < m_nclusters; j++ )
         {
-            if ( !( p[j] < m_tolerance ) ) { converged = false; break; }
+            if ( !( p[j] * p[j] < m_tolerance ) ) { converged = false; break; }
         }
 
         if ( counter++ > m_max_iterations ) break;
     }
 
     if ( m_cluster_centers ) delete [] m_cluster_centers;
-    m_cluster_centers = c;
-
-    delete [] cp;
+    m_cluster_centers = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
+    for ( size_t j = 0; j < m_nclusters; j++ )
+    {
+        m_cluster_centers[j] = kvs::ValueArray<kvs::Real32>( c.data() + j * ncolumns, ncolumns );
+    }
 
-    m_cluster_ids = IDs;
+    m_cluster_ids = a;
 }
 
 } // end of namespace kvs
@@ -11,6 +11,9 @@
  * [2] D. Arthur and S. Vassilvitskii, k-means++ : The Advantages of Careful
  *     Seeding, in Proceedings of the eighteenth annual ACM-SIAM symposium on
  *     Discrete algorithms, 2007, pp. 1027-1035.
+ * [3] B. Bahmani, B. Moseley, A. Vattani, R. Kumar and S. Vassilvitskii,
+ *     Scalable k-means++, Proceedings of the VLDB Endowment, vol. 5, no. 7,
+ *     pp. 622-633, 2012.
  */
 /*****************************************************************************/
 #pragma once
@@ -32,8 +35,8 @@ class FastKMeans
 public:
     enum SeedingMethod
     {
-        RandomSeeding,
-        SmartSeeding
+        RandomSeeding, ///< random rows
+        SmartSeeding ///< scalable k-means++ (k-means||)
     };
 
 private:
@@ -12,163 +12,147 @@
  */
 /*****************************************************************************/
 #include "KMeans.h"
+#include "KMeansCommon.h"
 #include <kvs/Value>
 #include <kvs/Message>
 #include <kvs/Math>
+#include <kvs/OpenMP>
+#include <vector>
+#include <algorithm>
 
 
-namespace
-{
-
-inline kvs::Real32 GetEuclideanDistance(
-    const kvs::AnyValueTable& table,
-    const kvs::UInt32 row_index,
-    const kvs::ValueArray<kvs::Real32>& center )
-{
-    kvs::Real32 distance = 0.0;
-    for ( size_t i = 0; i < table.columnSize(); i++ )
-    {
-        const kvs::Real32 x0 = center[i];
-        const kvs::Real32 x1 = table.column(i).at<kvs::Real32>( row_index );
-        distance += ( x1 - x0 ) * ( x1 - x0 );
-    }
-
-    return distance;
-}
-
-inline kvs::Real32 GetEuclideanDistance(
-    const kvs::AnyValueTable& table,
-    const kvs::ValueArray<kvs::Real32>& center_old,
-    const kvs::ValueArray<kvs::Real32>& center_new )
-{
-    kvs::Real32 distance = 0.0;
-    for ( size_t i = 0; i < table.columnSize(); i++ )
-    {
-        const kvs::Real32 x0 = center_old[i];
-        const kvs::Real32 x1 = center_new[i];
-        distance += ( x1 - x0 ) * ( x1 - x0 );
-    }
-
-    return distance;
-}
-
-}
-
 namespace
 {
 
 /*===========================================================================*/
 /**
- *  @brief  Calculates the cluster centroid.
- *  @param  table [in] table data
- *  @param  cluster_id [in] target cluster ID
+ *  @brief  Calculates the cluster centroids.
+ *  @param  blocks [in] row blocks
+ *  @param  nclusters [in] number of clusters
+ *  @param  ncolumns [in] number of columns
+ *  @param  data [in] data points
  *  @param  ids [in] cluster ID array
- *  @param  center [out] cluster centroid
+ *  @param  centers [in/out] cluster centroids (nclusters x ncolumns)
+ *
+ *  The centroid of the empty cluster is not changed.
  */
 /*===========================================================================*/
-inline void CalculateCenter(
-    const kvs::AnyValueTable& table,
-    const kvs::UInt32 cluster_id,
+inline void CalculateCenters(
+    const kvs::detail::RowBlocks& blocks,
+    const size_t nclusters,
+    const size_t ncolumns,
+    const kvs::ValueArray<kvs::Real32>& data,
     const kvs::ValueArray<kvs::UInt32>& ids,
-    kvs::ValueArray<kvs::Real32>* center )
+    kvs::ValueArray<kvs::Real32>& centers )
 {
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
-
-    for ( size_t j = 0; j < ncolumns; j++ ) { center->at(j) = 0.0; }
+    const size_t nsums = nclusters * ncolumns;
+    std::vector<kvs::Real64> partial_sums( blocks.nblocks * nsums, 0.0 );
+    std::vector<size_t> partial_counts( blocks.nblocks * nclusters, 0 );
 
-    size_t counter = 0;
-    for ( size_t j = 0; j < nrows; j++ )
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long b = 0; b < long( blocks.nblocks ); b++ )
     {
-        if ( ids[j] == cluster_id )
+        kvs::Real64* sums = partial_sums.data() + b * nsums;
+        size_t* counts = partial_counts.data() + b * nclusters;
+        for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ )
         {
-            for ( size_t k = 0; k < ncolumns; k++ )
-            {
-                center->at(k) += table.column(k).at<kvs::Real32>(j);
-            }
-            counter++;
+            const kvs::Real32* x = data.data() + i * ncolumns;
+            kvs::Real64* sum = sums + ids[i] * ncolumns;
+            for ( size_t k = 0; k < ncolumns; k++ ) { sum[k] += x[k]; }
+            counts[ ids[i] ] += 1;
         }
     }
-    if ( counter != 0 )
+
+    // Reduce the partial sums in the block order.
+    std::vector<kvs::Real64> sums( nsums, 0.0 );
+    std::vector<size_t> counts( nclusters, 0 );
+    for ( size_t b = 0; b < blocks.nblocks; b++ )
     {
-        for ( size_t k = 0; k < ncolumns; k++ ) { center->at(k) /= counter; }
+        for ( size_t k = 0; k < nsums; k++ ) { sums[k] += partial_sums[ b * nsums + k ]; }
+        for ( size_t j = 0; j < nclusters; j++ ) { counts[j] += partial_counts[ b * nclusters + j ]; }
     }
-}
 
-/*===========================================================================*/
-/**
- *  @brief  Initialize centers of clusters with random seeding method.
- *  @param  table [in] pointer to table
- *  @param  nclusters [in] number of clusters
- *  @param  ids [i]
- *  @param  centers [in/out] pointer to center array
- */
-/*===========================================================================*/
-inline void InitializeCentersWithRandomSeeding(
-    const kvs::AnyValueTable& table,
-    const size_t nclusters,
-    const kvs::ValueArray<kvs::UInt32>& ids,
-    kvs::ValueArray<kvs::Real32>* centers )
-{
-    for ( size_t i = 0; i < nclusters; i++ )
+    for ( size_t j = 0; j < nclusters; j++ )
     {
-        CalculateCenter( table, i, ids, &centers[i] );
+        if ( counts[j] == 0 ) { continue; }
+        for ( size_t k = 0; k < ncolumns; k++ )
+        {
+            centers[ j * ncolumns + k ] = static_cast<kvs::Real32>( sums[ j * ncolumns + k ] / counts[j] );
+        }
     }
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Initialize centers of clusters with k-means++.
- *  @param  table [in] table data
+ *  @param  blocks [in] row blocks
  *  @param  nclusters [in] number of clusters
- *  @param  ids [i]
- *  @param  centers [in/out] pointer to center array
+ *  @param  ncolumns [in] number of columns
+ *  @param  data [in] data points
+ *  @param  ids [in] initial cluster ID array
+ *  @param  random [in] random number generator
+ *  @param  centers [out] cluster centroids (nclusters x ncolumns)
+ *
+ *  The first center is the centroid of the initial cluster 0, and the others
+ *  are selected with the probability proportional to the squared distance to
+ *  the closest center. The distances are updated in parallel, and the selection
+ *  is done with the partial sums in the block order.
  */
 /*===========================================================================*/
 inline void InitializeCentersWithSmartSeeding(
-    const kvs::AnyValueTable& table,
+    const kvs::detail::RowBlocks& blocks,
     const size_t nclusters,
+    const size_t ncolumns,
+    const kvs::ValueArray<kvs::Real32>& data,
     const kvs::ValueArray<kvs::UInt32>& ids,
-    kvs::ValueArray<kvs::Real32>* centers )
+    kvs::MersenneTwister& random,
+    kvs::ValueArray<kvs::Real32>& centers )
 {
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
-
-    CalculateCenter( table, 0, ids, &(centers[0]) );
-
-    for ( size_t i = 1; i < nclusters; i++ )
+    // Centroid of the initial cluster 0.
+    kvs::ValueArray<kvs::Real32> c0( nclusters * ncolumns );
+    c0.fill( 0 );
+    ::CalculateCenters( blocks, nclusters, ncolumns, data, ids, c0 );
+    std::copy( c0.begin(), c0.begin() + ncolumns, centers.begin() );
+
+    const size_t nrows = blocks.nrows;
+    std::vector<kvs::Real32> D( nrows, kvs::Value<kvs::Real32>::Max() );
+    std::vector<kvs::Real64> S( blocks.nblocks, 0.0 );
+    for ( size_t j = 1; j < nclusters; j++ )
     {
-        kvs::Real32 S = 0.0;
-        kvs::Real32* D = new kvs::Real32 [ nrows ];
-        for ( size_t j = 0; j < nrows; j++ )
+        // Update the squared distances to the closest center.
+        const kvs::Real32* c = centers.data() + ( j - 1 ) * ncolumns;
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long b = 0; b < long( blocks.nblocks ); b++ )
         {
-            kvs::Real32 distance = kvs::Value<kvs::Real32>::Max();
-            for ( size_t k = 0; k < nclusters; k++ )
+            kvs::Real64 s = 0.0;
+            for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ )
             {
-                const kvs::Real32 d = ::GetEuclideanDistance( table, j, centers[k] );
-                if ( d < distance ) { distance = d; }
+                const kvs::Real32 d = kvs::detail::GetSquaredDistance( data.data() + i * ncolumns, c, ncolumns );
+                D[i] = kvs::Math::Min( D[i], d );
+                s += D[i];
             }
-            D[j] = distance;
-            S += distance * distance;
+            S[b] = s;
         }
 
-        size_t index = 0;
-        kvs::Real32 P = 0.0;
-        for ( size_t j = 0; j < nrows; j++ )
+        kvs::Real64 total = 0.0;
+        for ( size_t b = 0; b < blocks.nblocks; b++ ) { total += S[b]; }
+
+        // Select the row with the probability proportional to the distance.
+        size_t index = nrows - 1;
+        kvs::Real64 r = random.rand53() * total;
+        for ( size_t b = 0; b < blocks.nblocks; b++ )
         {
-            const kvs::Real32 DD = D[j] * D[j];
-            if ( P < kvs::Math::Max( P, DD / S ) )
+            if ( r >= S[b] ) { r -= S[b]; continue; }
+            for ( size_t i = blocks.begin( b ); i < blocks.end( b ); i++ )
             {
-                P = DD / S;
-                index = j;
+                if ( r < D[i] ) { index = i; break; }
+                r -= D[i];
             }
+            break;
         }
 
-        for ( size_t j = 0; j < ncolumns; j++ )
-        {
-            centers[i].at(j) = table.column(j).at<kvs::Real32>(index);
-        }
-        delete [] D;
+        const kvs::Real32* x = data.data() + index * ncolumns;
+        std::copy( x, x + ncolumns, centers.begin() + j * ncolumns );
     }
 }
 
@@ -181,6 +165,12 @@ namespace kvs
 /*===========================================================================*/
 /**
  *  @brief  Executes K-means clustering.
+ *
+ *  The table data is copied to the row-major float array, and the assignment
+ *  and the centroid calculation are processed in parallel with the row blocks.
+ *  The partial sums of the blocks are reduced in the block order, so that the
+ *  result is deterministic for the given seed regardless of the number of the
+ *  threads.
  */
 /*===========================================================================*/
 void KMeans::run()
@@ -202,30 +192,38 @@ void KMeans::run()
         }
     }
 
-    // Allocate memory for the cluster center.
-    m_cluster_centers = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
-    for ( size_t i = 0; i < m_nclusters; i++ ) { m_cluster_centers[i].allocate( ncolumns ); }
+    if ( nrows == 0 || m_nclusters == 0 )
+    {
+        kvsMessageError("The number of rows or clusters is zero.");
+        return;
+    }
+
+    // Data points (nrows x ncolumns).
+    const kvs::ValueArray<kvs::Real32> data = kvs::detail::GetDataPoints( m_input_table );
+    const kvs::detail::RowBlocks blocks( nrows );
 
     // Assign initial cluster IDs to each row of the input table randomly.
     kvs::ValueArray<kvs::UInt32> IDs( nrows );
-    for ( size_t i = 0; i < nrows; i++ ) IDs[i] = kvs::UInt32( m_nclusters * m_random() );
+    for ( size_t i = 0; i < nrows; i++ ) IDs[i] = kvs::UInt32( m_random.randInteger( static_cast<unsigned long>( m_nclusters - 1 ) ) );
 
     // Calculate the center of cluster.
+    kvs::ValueArray<kvs::Real32> centers( m_nclusters * ncolumns );
+    centers.fill( 0 );
     switch ( m_seeding_method )
     {
     case RandomSeeding:
-        ::InitializeCentersWithRandomSeeding( m_input_table, m_nclusters, IDs, m_cluster_centers );
+        ::CalculateCenters( blocks, m_nclusters, ncolumns, data, IDs, centers );
         break;
     case SmartSeeding:
-        ::InitializeCentersWithSmartSeeding( m_input_table, m_nclusters, IDs, m_cluster_centers );
+        ::InitializeCentersWithSmartSeeding( blocks, m_nclusters, ncolumns, data, IDs, m_random, centers );
         break;
     default:
-        ::InitializeCentersWithRandomSeeding( m_input_table, m_nclusters, IDs, m_cluster_centers );
+        ::CalculateCenters( blocks, m_nclusters, ncolumns, data, IDs, centers );
         break;
     }
 
-    // Cluster center used for convergence test.
-    kvs::ValueArray<kvs::Real32> center_new( ncolumns );
+    // Cluster centers used for convergence test.
+    kvs::ValueArray<kvs::Real32> centers_new( m_nclusters * ncolumns );
 
     // Clustering.
     bool converged = false;
@@ -233,25 +231,28 @@ void KMeans::run()
     while ( !converged )
     {
         // Calculate euclidean distance between the center of cluster and the point, and update the IDs.
-        for ( size_t i = 0; i < nrows; i++ )
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < long( nrows ); i++ )
         {
-            size_t id = 0;
+            const kvs::Real32* x = data.data() + i * ncolumns;
+            kvs::UInt32 id = 0;
             kvs::Real32 distance = kvs::Value<kvs::Real32>::Max();
             for ( size_t j = 0; j < m_nclusters; j++ )
             {
-                const kvs::Real32 d = ::GetEuclideanDistance( m_input_table, i, m_cluster_centers[j] );
-                if ( d < distance ) { distance = d; id = j; }
+                const kvs::Real32 d = kvs::detail::GetSquaredDistance( x, centers.data() + j * ncolumns, ncolumns );
+                if ( d < distance ) { distance = d; id = static_cast<kvs::UInt32>( j ); }
             }
             IDs[i] = id;
         }
 
         // Convergence test.
+        std::copy( centers.begin(), centers.end(), centers_new.begin() );
+        ::CalculateCenters( blocks, m_nclusters, ncolumns, data, IDs, centers_new );
+
         converged = true;
-        for ( size_t i = 0; i < m_nclusters; i++ )
+        for ( size_t j = 0; j < m_nclusters; j++ )
         {
-            ::CalculateCenter( m_input_table, i, IDs, &center_new );
-
-            const kvs::Real32 distance = ::GetEuclideanDistance( m_input_table, m_cluster_centers[i], center_new );
+            const kvs::Real32 distance = kvs::detail::GetSquaredDistance( centers.data() + j * ncolumns, centers_new.data() + j * ncolumns, ncolumns );
             if ( !( distance < m_tolerance ) )
             {
                 converged = false;
@@ -261,17 +262,18 @@ void KMeans::run()
 
         if ( counter++ > m_max_iterations ) break;
 
-        // Calculate the center of cluster.
-        if ( !converged )
-        {
-            for ( size_t i = 0; i < m_nclusters; i++ )
-            {
-                ::CalculateCenter( m_input_table, i, IDs, &(m_cluster_centers[i]) );
-            }
-        }
+        // Update the center of cluster.
+        if ( !converged ) { std::swap( centers, centers_new ); }
 
     } // end of while
 
+    if ( m_cluster_centers ) delete [] m_cluster_centers;
+    m_cluster_centers = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
+    for ( size_t j = 0; j < m_nclusters; j++ )
+    {
+        m_cluster_centers[j] = kvs::ValueArray<kvs::Real32>( centers.data() + j * ncolumns, ncolumns );
+    }
+
     m_cluster_ids = IDs;
 }
 
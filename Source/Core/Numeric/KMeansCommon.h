@@ -0,0 +1,159 @@
+/*****************************************************************************/
+/**
+ *  @file   KMeansCommon.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <kvs/Type>
+#include <kvs/Math>
+#include <kvs/OpenMP>
+#include <kvs/ValueArray>
+#include <kvs/AnyValueArray>
+#include <kvs/AnyValueTable>
+
+
+namespace kvs
+{
+
+namespace detail
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Row blocks of the data points.
+ *
+ *  The rows are divided into the blocks whose number does not depend on the
+ *  number of threads. The partial sums are calculated for each block and
+ *  reduced in the block order, so that the clustering result is identical for
+ *  any number of threads.
+ */
+/*===========================================================================*/
+struct RowBlocks
+{
+    size_t nrows; ///< number of rows
+    size_t size; ///< number of rows in a block
+    size_t nblocks; ///< number of blocks
+
+    RowBlocks( const size_t nrows ):
+        nrows( nrows ),
+        size( kvs::Math::Max( size_t( 4096 ), ( nrows + 255 ) / 256 ) ),
+        nblocks( ( nrows + size - 1 ) / size ) {}
+
+    size_t begin( const size_t block ) const { return block * size; }
+    size_t end( const size_t block ) const { return kvs::Math::Min( nrows, ( block + 1 ) * size ); }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Visitor to copy the column values to the row-major data array.
+ */
+/*===========================================================================*/
+struct CopyColumn
+{
+    size_t nrows; ///< number of rows
+    size_t ncolumns; ///< number of columns
+    size_t column; ///< column index
+    kvs::Real32* data; ///< row-major data array
+
+    template <typename T>
+    void operator () ( const T* values )
+    {
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < long( nrows ); i++ )
+        {
+            data[ i * ncolumns + column ] = static_cast<kvs::Real32>( values[i] );
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Calls the functor with the pointer to the typed values.
+ *  @param  array [in] value array
+ *  @param  functor [in] functor
+ *  @return true if the value type is supported
+ */
+/*===========================================================================*/
+template <typename Functor>
+inline bool Dispatch( const kvs::AnyValueArray& array, Functor& functor )
+{
+    const void* data = array.data();
+    switch ( array.typeID() )
+    {
+    case kvs::Type::TypeInt8: functor( static_cast<const kvs::Int8*>( data ) ); return true;
+    case kvs::Type::TypeUInt8: functor( static_cast<const kvs::UInt8*>( data ) ); return true;
+    case kvs::Type::TypeInt16: functor( static_cast<const kvs::Int16*>( data ) ); return true;
+    case kvs::Type::TypeUInt16: functor( static_cast<const kvs::UInt16*>( data ) ); return true;
+    case kvs::Type::TypeInt32: functor( static_cast<const kvs::Int32*>( data ) ); return true;
+    case kvs::Type::TypeUInt32: functor( static_cast<const kvs::UInt32*>( data ) ); return true;
+    case kvs::Type::TypeInt64: functor( static_cast<const kvs::Int64*>( data ) ); return true;
+    case kvs::Type::TypeUInt64: functor( static_cast<const kvs::UInt64*>( data ) ); return true;
+    case kvs::Type::TypeReal32: functor( static_cast<const kvs::Real32*>( data ) ); return true;
+    case kvs::Type::TypeReal64: functor( static_cast<const kvs::Real64*>( data ) ); return true;
+    default: return false;
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the data points stored in the row-major float array.
+ *  @param  table [in] table data
+ *  @return data points (nrows x ncolumns)
+ */
+/*===========================================================================*/
+inline kvs::ValueArray<kvs::Real32> GetDataPoints( const kvs::AnyValueTable& table )
+{
+    const size_t nrows = table.column(0).size();
+    const size_t ncolumns = table.columnSize();
+    kvs::ValueArray<kvs::Real32> data( nrows * ncolumns );
+    for ( size_t j = 0; j < ncolumns; j++ )
+    {
+        CopyColumn copy = { nrows, ncolumns, j, data.data() };
+        Dispatch( table.column(j), copy );
+    }
+
+    return data;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the squared distance between the given points.
+ *  @param  x0 [in] point 0
+ *  @param  x1 [in] point 1
+ *  @param  dim [in] dimension of the points
+ *  @return squared distance
+ */
+/*===========================================================================*/
+inline kvs::Real32 GetSquaredDistance(
+    const kvs::Real32* x0,
+    const kvs::Real32* x1,
+    const size_t dim )
+{
+    // The four partial sums are independent of each other, so that the loop
+    // can be vectorized by the compiler.
+    kvs::Real32 s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for ( ; i + 4 <= dim; i += 4 )
+    {
+        const kvs::Real32 d0 = x1[i+0] - x0[i+0];
+        const kvs::Real32 d1 = x1[i+1] - x0[i+1];
+        const kvs::Real32 d2 = x1[i+2] - x0[i+2];
+        const kvs::Real32 d3 = x1[i+3] - x0[i+3];
+        s0 += d0 * d0;
+        s1 += d1 * d1;
+        s2 += d2 * d2;
+        s3 += d3 * d3;
+    }
+    for ( ; i < dim; i++ )
+    {
+        const kvs::Real32 d = x1[i] - x0[i];
+        s0 += d * d;
+    }
+
+    return ( s0 + s1 ) + ( s2 + s3 );
+}
+
+} // end of namespace detail
+
+} // end of namespace kvs
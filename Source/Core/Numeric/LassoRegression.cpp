@@ -138,8 +138,7 @@ void LassoRegression<T>::fit( const kvs::ValueArray<T>& dep, const kvs::ValueTab
     m_adjusted_r2 = 1.0 - ( 1.0 - m_r2 ) * ( n - 1.0 ) / m_dof;
 
     // Standard error
-    const kvs::Matrix<T> Xt = X.transposed();
-    const kvs::Matrix<T> XtX = Xt * X;
+    const kvs::Matrix<T> XtX = kvs::Matrix<T>::TransposeMultiply( X, X );
     const kvs::Matrix<T> XtX_inv = XtX.inverted();
     const kvs::Real64 ve = rss / m_dof;
     m_standard_errors.resize( m_coef.size() );
@@ -79,9 +79,8 @@ void LinearRegression<T>::fit( const kvs::ValueArray<T>& dep, const kvs::ValueTa
     m_dof = n - k - 1;
 
     // Regression coefficients
-    const kvs::Matrix<T> Xt = X.transposed();
-    const kvs::Matrix<T> XtX = Xt * X;
-    const kvs::Vector<T> XtY = Xt * Y;
+    const kvs::Matrix<T> XtX = kvs::Matrix<T>::TransposeMultiply( X, X );
+    const kvs::Vector<T> XtY = Y * X;
     const kvs::Matrix<T> XtX_inv = XtX.inverted();
     m_coef = XtX_inv * XtY;
 
@@ -5,8 +5,13 @@
  */
 /*****************************************************************************/
 #include "MultiDimensionalScaling.h"
+#include "OrthonormalizeCommon.h"
 #include <kvs/Matrix>
 #include <kvs/EigenDecomposition>
+#include <kvs/MersenneTwister>
+#include <kvs/OpenMP>
+#include <kvs/Value>
+#include <vector>
 #include <cmath>
 
 
@@ -15,22 +20,179 @@ namespace
 
 /*===========================================================================*/
 /**
- *  @brief  Squre each element of the matrix.
- *  @param  m [in] input matrix
+ *  @brief  Returns the double-centered matrix of the squared distances.
+ *  @param  D [in] distance matrix (n x n)
+ *  @return inner product matrix (-1/2 H D^2 H, where H is centering matrix)
  */
 /*===========================================================================*/
 template <typename T>
-inline void ToSquare( kvs::Matrix<T>& m )
+inline kvs::Matrix<T> DoubleCenter( const kvs::Matrix<T>& D )
 {
-    const size_t ncolumns = m.columnSize();
-    const size_t nrows = m.rowSize();
-    for ( size_t i = 0; i < ncolumns; i++ )
+    // The centering H D^2 H is calculated with the row/column means of the
+    // squared distances in O(n^2), instead of the matrix products in O(n^3).
+    const size_t n = D.rowSize();
+    std::vector<double> row_means( n );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < long( n ); i++ )
     {
-        for ( size_t j = 0; j < nrows; j++ )
+        double sum = 0.0;
+        for ( size_t j = 0; j < n; j++ ) { sum += double( D[i][j] ) * D[i][j]; }
+        row_means[i] = sum / n;
+    }
+
+    std::vector<double> col_means( n, 0.0 );
+    for ( size_t i = 0; i < n; i++ )
+    {
+        for ( size_t j = 0; j < n; j++ ) { col_means[j] += double( D[i][j] ) * D[i][j]; }
+    }
+    double mean = 0.0;
+    for ( size_t j = 0; j < n; j++ ) { col_means[j] /= n; mean += col_means[j]; }
+    mean /= n;
+
+    kvs::Matrix<T> P( n, n );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < long( n ); i++ )
+    {
+        for ( size_t j = 0; j < n; j++ )
         {
-            m[i][j] = m[i][j] * m[i][j];
+            const double d2 = double( D[i][j] ) * D[i][j];
+            P[i][j] = static_cast<T>( -0.5 * ( d2 - row_means[i] - col_means[j] + mean ) );
         }
     }
+    return P;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the dominant eigen pairs with the subspace iteration.
+ *  @param  A [in] symmetric matrix (n x n)
+ *  @param  k [in] number of eigen pairs to be converged
+ *  @param  p [in] dimension of the subspace (> k)
+ *  @param  shift [in] spectrum shift, which is added to the diagonal of A
+ *  @param  values [out] Ritz values of A + shift I in descending order (p)
+ *  @param  vectors [out] Ritz vectors as row vectors (p x n)
+ *
+ *  The subspace converges to the eigen vectors of A + shift I with the p
+ *  largest absolute eigen values, which are extracted with Rayleigh-Ritz
+ *  projection. Each iteration requires only the matrix products of O(n^2 p).
+ */
+/*===========================================================================*/
+template <typename T>
+inline void SubspaceIteration(
+    const kvs::Matrix<T>& A,
+    const size_t k,
+    const size_t p,
+    const T shift,
+    kvs::Vector<T>& values,
+    kvs::Matrix<T>& vectors )
+{
+    const size_t n = A.rowSize();
+
+    // Initial subspace with the fixed seed, so that the results are reproducible.
+    kvs::MersenneTwister random( 1 );
+    kvs::Matrix<T> Q( p, n );
+    for ( size_t i = 0; i < p; i++ )
+    {
+        for ( size_t j = 0; j < n; j++ ) { Q[i][j] = static_cast<T>( 2.0 * random.rand53() - 1.0 ); }
+    }
+    kvs::detail::Orthonormalize( Q );
+
+    kvs::Matrix<T> W; // Ritz vectors in the subspace
+    kvs::Vector<T> previous( k );
+    const size_t max_iterations = 300;
+    const double tolerance = 1.0e-6;
+    for ( size_t iteration = 0; iteration < max_iterations; iteration++ )
+    {
+        // Y = Q (A + shift I) (= ((A + shift I) Q^t)^t since A is symmetric),
+        // H = Y Q^t.
+        kvs::Matrix<T> Y = Q * A;
+        if ( shift != T(0) ) { Y += shift * Q; }
+        const kvs::Matrix<T> H = kvs::Matrix<T>::MultiplyTranspose( Y, Q );
+
+        using Eigen = kvs::EigenDecomposition<T>;
+        Eigen eigen( H, Eigen::Symmetric );
+        values = eigen.eigenValues();
+        W = eigen.eigenVectors();
+
+        bool converged = iteration > 0;
+        for ( size_t i = 0; i < k; i++ )
+        {
+            const double scale = kvs::Math::Max( std::abs( double( values[0] ) ), 1.0e-30 );
+            if ( std::abs( double( values[i] - previous[i] ) ) > tolerance * scale ) { converged = false; }
+            previous[i] = values[i];
+        }
+        if ( converged ) { break; }
+
+        kvs::detail::Orthonormalize( Y );
+        Q = std::move( Y );
+    }
+
+    // Ritz vectors in the original space.
+    vectors = W * Q;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the top-k eigen pairs of the symmetric matrix.
+ *  @param  A [in] symmetric matrix (n x n)
+ *  @param  k [in] number of eigen pairs
+ *  @param  values [out] eigen values in descending order
+ *  @param  vectors [out] eigen vectors as row vectors (k x n)
+ *
+ *  The eigen pairs are calculated with the subspace iteration for large
+ *  matrices, and with the dense eigen decomposition for small matrices.
+ */
+/*===========================================================================*/
+template <typename T>
+inline void TopEigenPairs(
+    const kvs::Matrix<T>& A,
+    const size_t k,
+    kvs::Vector<T>& values,
+    kvs::Matrix<T>& vectors )
+{
+    const size_t n = A.rowSize();
+    const size_t p = kvs::Math::Min( n, k + 8 ); // oversampled subspace size
+
+    values.resize( k );
+    vectors.resize( k, n );
+    if ( n <= 128 || 2 * p >= n )
+    {
+        using Eigen = kvs::EigenDecomposition<T>;
+        Eigen eigen( A, Eigen::Symmetric );
+        for ( size_t i = 0; i < k; i++ )
+        {
+            values[i] = eigen.eigenValues()[i];
+            vectors[i] = eigen.eigenVectors()[i].normalized();
+        }
+        return;
+    }
+
+    kvs::Vector<T> ritz_values;
+    kvs::Matrix<T> ritz_vectors;
+    ::SubspaceIteration( A, k, p, T(0), ritz_values, ritz_vectors );
+
+    // The subspace holds the eigen values with the largest absolute values.
+    // If the distances are non-Euclidean, the inner product matrix can have
+    // the large negative eigen values, which displace the top-k positive ones
+    // from the subspace. In that case, the iteration is restarted with the
+    // spectrum shifted by the most negative Ritz value, so that all of the
+    // eigen values of the shifted matrix are non-negative and the largest
+    // ones are the dominant ones.
+    T min_absolute = std::abs( ritz_values[0] );
+    for ( size_t i = 1; i < p; i++ ) { min_absolute = kvs::Math::Min( min_absolute, std::abs( ritz_values[i] ) ); }
+
+    T shift = T(0);
+    if ( ritz_values[ k - 1 ] < min_absolute )
+    {
+        shift = -ritz_values[ p - 1 ];
+        ::SubspaceIteration( A, k, p, shift, ritz_values, ritz_vectors );
+    }
+
+    for ( size_t i = 0; i < k; i++ )
+    {
+        values[i] = ritz_values[i] - shift;
+        vectors[i] = ritz_vectors[i].normalized();
+    }
 }
 
 }
@@ -52,17 +214,12 @@ T MultiDimensionalScaling<T>::Euclidean(
     const size_t i,
     const size_t j )
 {
-    kvs::ValueTable<T>& d = const_cast<kvs::ValueTable<T>& >( data );
-    auto rowi = d.beginRow(i);
-    auto rowj = d.beginRow(j);
-    auto endi = d.endRow(i);
     T dist = T(0);
-    while ( rowi != endi )
+    const size_t ncolumns = data.columnSize();
+    for ( size_t c = 0; c < ncolumns; c++ )
     {
-        const T diff = *rowi - *rowj;
+        const T diff = data[c][i] - data[c][j];
         dist += diff * diff;
-        ++rowi;
-        ++rowj;
     }
     return static_cast<T>( std::sqrt( dist ) );
 }
@@ -81,17 +238,11 @@ T MultiDimensionalScaling<T>::Manhattan(
     const size_t i,
     const size_t j )
 {
-    kvs::ValueTable<T>& d = const_cast<kvs::ValueTable<T>& >( data );
-    auto rowi = d.beginRow(i);
-    auto rowj = d.beginRow(j);
-    auto endi = d.endRow(i);
     T dist = T(0);
-    while ( rowi != endi )
+    const size_t ncolumns = data.columnSize();
+    for ( size_t c = 0; c < ncolumns; c++ )
     {
-        const T diff = *rowi - *rowj;
-        dist += std::abs( diff );
-        ++rowi;
-        ++rowj;
+        dist += std::abs( data[c][i] - data[c][j] );
     }
     return dist;
 }
@@ -111,7 +262,8 @@ kvs::Matrix<T> MultiDimensionalScaling<T>::DistanceMatrix(
     // Distance matrix
     const size_t N = data.rowSize();
     kvs::Matrix<T> D( N, N );
-    for ( size_t i = 0; i < N; i++ )
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long i = 0; i < long( N ); i++ )
     {
         for ( size_t j = i + 1; j < N; j++ )
         {
@@ -182,7 +334,17 @@ MultiDimensionalScaling<T>::MultiDimensionalScaling(
 template <typename T>
 void MultiDimensionalScaling<T>::fit( const kvs::ValueTable<T>& data )
 {
-    this->fit( DistanceMatrix( data, m_distance ) );
+    const size_t n = data.rowSize();
+    const size_t k = m_ncomponents > 0 ? m_ncomponents : data.columnSize();
+    if ( m_nlandmarks > 0 && m_nlandmarks < n )
+    {
+        const Distance& distance = m_distance;
+        this->landmark_mds( n, [&]( const size_t i, const size_t j ) { return distance( data, i, j ); }, k );
+    }
+    else
+    {
+        this->classical_mds( DistanceMatrix( data, m_distance ), k );
+    }
 }
 
 /*===========================================================================*/
@@ -194,30 +356,16 @@ void MultiDimensionalScaling<T>::fit( const kvs::ValueTable<T>& data )
 template <typename T>
 void MultiDimensionalScaling<T>::fit( const kvs::Matrix<T>& matrix )
 {
-    const size_t n = matrix.rowSize(); // number of points
-    const size_t k = m_ncomponents; // dimension of the points in the embedded space
-
-    // Inner product matrix (P) can be solved by Young-Householder transformation.
-    const auto& D = matrix;
-    const auto I = kvs::Matrix<T>::Identity( n, n );
-    const auto O = kvs::Matrix<T>::Ones( n, n );
-
-    kvs::Matrix<T> DD( D ); ::ToSquare( DD );
-    const auto H = I - ( 1.0f / n ) * O; // centering matrix
-    const auto P = -0.5f * H * DD * H; // inner product matrix
-
-    // Eigen decomposition.
-    using Eigen = kvs::EigenDecomposition<T>;
-    Eigen eigen( P, Eigen::Symmetric );
-    const kvs::Vector<T>& eval = eigen.eigenValues();
-    const kvs::Matrix<T>& evec = eigen.eigenVectors();
-
-    // Embed the points by using the top-k eigen vectors
-    const kvs::Vector<T> diag( k, eval.data() );
-    const kvs::Matrix<T> A = kvs::Matrix<T>::Diagonal( diag );
-    kvs::Matrix<T> Q( k, n );
-    for ( size_t i = 0; i < k; i++ ) { Q[i] = evec[i].normalized(); }
-    m_embedded_points = A * Q;
+    const size_t n = matrix.rowSize();
+    const size_t k = m_ncomponents > 0 ? m_ncomponents : n;
+    if ( m_nlandmarks > 0 && m_nlandmarks < n )
+    {
+        this->landmark_mds( n, [&]( const size_t i, const size_t j ) { return matrix[i][j]; }, k );
+    }
+    else
+    {
+        this->classical_mds( matrix, k );
+    }
 }
 
 /*===========================================================================*/
@@ -229,7 +377,8 @@ void MultiDimensionalScaling<T>::fit( const kvs::Matrix<T>& matrix )
 template <typename T>
 kvs::ValueTable<T> MultiDimensionalScaling<T>::transform( const kvs::ValueTable<T>& data )
 {
-    return this->transform( DistanceMatrix( data, m_distance ) );
+    if ( m_embedded_points.rowSize() == 0 ) { this->fit( data ); }
+    return this->embedded_table();
 }
 
 /*===========================================================================*/
@@ -242,8 +391,144 @@ template <typename T>
 kvs::ValueTable<T> MultiDimensionalScaling<T>::transform( const kvs::Matrix<T>& matrix )
 {
     if ( m_embedded_points.rowSize() == 0 ) { this->fit( matrix ); }
-    kvs::ValueTable<T> t( m_embedded_points.columnSize(), m_embedded_points.rowSize() );
-    std::copy( m_embedded_points.begin(), m_embedded_points.end(), t.begin() );
+    return this->embedded_table();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Embeds all of the points with classical MDS.
+ *  @param  matrix [in] distance matrix
+ *  @param  ncomponents [in] number of components
+ */
+/*===========================================================================*/
+template <typename T>
+void MultiDimensionalScaling<T>::classical_mds( const kvs::Matrix<T>& matrix, const size_t ncomponents )
+{
+    const size_t n = matrix.rowSize(); // number of points
+    const size_t k = kvs::Math::Min( ncomponents, n ); // dimension of the points in the embedded space
+
+    // Inner product matrix (P) can be solved by Young-Householder transformation.
+    const kvs::Matrix<T> P = ::DoubleCenter( matrix );
+
+    // Top-k eigen pairs.
+    kvs::Vector<T> eval;
+    kvs::Matrix<T> evec;
+    ::TopEigenPairs( P, k, eval, evec );
+
+    // Embed the points by using the top-k eigen vectors scaled by the square
+    // root of the eigen values.
+    m_embedded_points.resize( k, n );
+    for ( size_t i = 0; i < k; i++ )
+    {
+        const T scale = static_cast<T>( std::sqrt( kvs::Math::Max( eval[i], T(0) ) ) );
+        m_embedded_points[i] = scale * evec[i];
+    }
+
+    m_landmark_indices = kvs::ValueArray<kvs::UInt32>();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Embeds the points with landmark MDS.
+ *  @param  npoints [in] number of points
+ *  @param  distance [in] distance function between the i-th and j-th points
+ *  @param  ncomponents [in] number of components
+ *
+ *  The landmarks are selected with the max-min sampling and embedded with
+ *  classical MDS. The other points are embedded with the distance-based
+ *  triangulation to the landmarks [1], which is processed in parallel.
+ */
+/*===========================================================================*/
+template <typename T>
+void MultiDimensionalScaling<T>::landmark_mds(
+    const size_t npoints,
+    const std::function<T(const size_t,const size_t)>& distance,
+    const size_t ncomponents )
+{
+    const size_t n = npoints;
+    const size_t m = m_nlandmarks;
+    const size_t k = kvs::Math::Min( ncomponents, m );
+
+    // Max-min sampling of the landmarks. D2 stores the squared distances from
+    // the landmarks to all of the points (m x n).
+    kvs::ValueArray<kvs::UInt32> landmarks( m );
+    kvs::Matrix<T> D2( m, n );
+    std::vector<T> min_distances( n, kvs::Value<T>::Max() );
+    landmarks[0] = 0;
+    for ( size_t l = 0; l < m; l++ )
+    {
+        const size_t index = landmarks[l];
+        kvs::Vector<T>& d2 = D2[l];
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < long( n ); i++ )
+        {
+            const T d = distance( index, i );
+            d2[i] = d * d;
+            min_distances[i] = kvs::Math::Min( min_distances[i], d );
+        }
+
+        if ( l + 1 < m )
+        {
+            size_t farthest = 0;
+            for ( size_t i = 1; i < n; i++ )
+            {
+                if ( min_distances[i] > min_distances[ farthest ] ) { farthest = i; }
+            }
+            landmarks[ l + 1 ] = static_cast<kvs::UInt32>( farthest );
+        }
+    }
+
+    // Classical MDS for the landmarks.
+    kvs::Matrix<T> DL( m, m );
+    for ( size_t i = 0; i < m; i++ )
+    {
+        for ( size_t j = 0; j < m; j++ ) { DL[i][j] = std::sqrt( D2[i][ landmarks[j] ] ); }
+    }
+
+    kvs::Vector<T> eval;
+    kvs::Matrix<T> evec;
+    ::TopEigenPairs( ::DoubleCenter( DL ), k, eval, evec );
+
+    // Pseudo-inverse transpose of the landmark embedding (k x m), whose rows
+    // are the eigen vectors divided by the square root of the eigen values.
+    kvs::Matrix<T> L( k, m );
+    for ( size_t i = 0; i < k; i++ )
+    {
+        if ( eval[i] > T(0) ) { L[i] = evec[i] / static_cast<T>( std::sqrt( eval[i] ) ); }
+    }
+
+    // Distance-based triangulation: x = -1/2 L ( d2 - mean(d2) ), where mean(d2)
+    // is the mean of the squared distances between the landmarks.
+    for ( size_t l = 0; l < m; l++ )
+    {
+        T mean = T(0);
+        for ( size_t j = 0; j < m; j++ ) { mean += D2[l][ landmarks[j] ]; }
+        mean /= static_cast<T>( m );
+
+        kvs::Vector<T>& d2 = D2[l];
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < long( n ); i++ ) { d2[i] -= mean; }
+    }
+
+    m_embedded_points = static_cast<T>( -0.5 ) * ( L * D2 );
+    m_landmark_indices = landmarks;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the embedded points as the table (npoints x ncomponents).
+ *  @return table of the embedded points
+ */
+/*===========================================================================*/
+template <typename T>
+kvs::ValueTable<T> MultiDimensionalScaling<T>::embedded_table() const
+{
+    const kvs::Matrix<T>& X = m_embedded_points;
+    kvs::ValueTable<T> t( X.columnSize(), X.rowSize() );
+    for ( size_t i = 0; i < X.rowSize(); i++ )
+    {
+        std::copy( X[i].begin(), X[i].end(), t[i].begin() );
+    }
     return t;
 }
 
@@ -3,11 +3,18 @@
  *  @file   MultiDimensionalScaling.h
  *  @author Naohisa Sakamoto
  */
+/*----------------------------------------------------------------------------
+ *
+ * References:
+ * [1] V. de Silva and J. B. Tenenbaum, Sparse multidimensional scaling using
+ *     landmark points, Technical report, Stanford University, 2004.
+ */
 /*****************************************************************************/
 #pragma once
 #include <kvs/Module>
 #include <kvs/ValueTable>
 #include <kvs/Matrix>
+#include <kvs/ValueArray>
 #include <functional>
 
 
@@ -31,6 +38,8 @@ public:
 private:
     Distance m_distance = Euclidean; // distance function
     size_t m_ncomponents = 0; /// number of components (if 0, dimension of the input data matrix)
+    size_t m_nlandmarks = 0; ///< number of landmarks (if 0, classical MDS with all of the points)
+    kvs::ValueArray<kvs::UInt32> m_landmark_indices{}; ///< indices of the landmark points
     kvs::Matrix<T> m_embedded_points{};
 
 public:
@@ -40,14 +49,22 @@ public:
     MultiDimensionalScaling( const kvs::Matrix<T>& matrix, const size_t ncomponents = 0 );
 
     void setNumberOfComponents( const size_t ncomponents ) { m_ncomponents = ncomponents; }
+    void setNumberOfLandmarks( const size_t nlandmarks ) { m_nlandmarks = nlandmarks; }
     void setDistance( Distance distance ) { m_distance = distance; }
     size_t numberOfComponents() const { return m_ncomponents; }
+    size_t numberOfLandmarks() const { return m_nlandmarks; }
+    const kvs::ValueArray<kvs::UInt32>& landmarkIndices() const { return m_landmark_indices; }
     const kvs::Matrix<T>& embeddedPoints() const { return m_embedded_points; }
 
     void fit( const kvs::ValueTable<T>& data );
     void fit( const kvs::Matrix<T>& matrix );
     kvs::ValueTable<T> transform( const kvs::ValueTable<T>& data );
     kvs::ValueTable<T> transform( const kvs::Matrix<T>& matrix );
+
+private:
+    void classical_mds( const kvs::Matrix<T>& matrix, const size_t ncomponents );
+    void landmark_mds( const size_t npoints, const std::function<T(const size_t,const size_t)>& distance, const size_t ncomponents );
+    kvs::ValueTable<T> embedded_table() const;
 };
 
 } // end of namespace kvs
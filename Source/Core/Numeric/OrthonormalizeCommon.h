@@ -0,0 +1,43 @@
+/*****************************************************************************/
+/**
+ *  @file   OrthonormalizeCommon.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <kvs/Matrix>
+
+
+namespace kvs
+{
+
+namespace detail
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Orthonormalizes the row vectors with modified Gram-Schmidt method.
+ *  @param  Q [in/out] row vectors
+ *
+ *  The projection is applied twice, since the row vectors multiplied by the
+ *  matrix in the power iterations are nearly linearly dependent.
+ */
+/*===========================================================================*/
+template <typename T>
+inline void Orthonormalize( kvs::Matrix<T>& Q )
+{
+    const size_t p = Q.rowSize();
+    for ( size_t i = 0; i < p; i++ )
+    {
+        for ( size_t pass = 0; pass < 2; pass++ )
+        {
+            for ( size_t j = 0; j < i; j++ ) { Q[i] -= Q[j].dot( Q[i] ) * Q[j]; }
+        }
+        const T length = Q[i].length();
+        if ( length > T(0) ) { Q[i] /= length; }
+    }
+}
+
+} // end of namespace detail
+
+} // end of namespace kvs
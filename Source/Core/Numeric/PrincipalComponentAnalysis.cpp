@@ -5,10 +5,14 @@
  */
 /*****************************************************************************/
 #include "PrincipalComponentAnalysis.h"
-#include <kvs/Stat>
+#include "OrthonormalizeCommon.h"
 #include <kvs/Matrix>
 #include <kvs/EigenDecomposition>
+#include <kvs/MersenneTwister>
+#include <kvs/OpenMP>
+#include <kvs/Math>
 #include <algorithm>
+#include <cmath>
 
 
 namespace
@@ -16,63 +20,180 @@ namespace
 
 /*===========================================================================*/
 /**
- *  @brief  Returns covariance matrix.
+ *  @brief  Returns mean values and sums of squared deviations of the columns.
  *  @param  data [in] data table
+ *  @param  mean [out] mean values
+ *  @param  m2 [out] sums of squared deviations
  */
 /*===========================================================================*/
 template <typename T>
-inline kvs::Matrix<T> Covariance( const kvs::ValueTable<T>& data )
+inline void Moments(
+    const kvs::ValueTable<T>& data,
+    kvs::Vector<T>& mean,
+    kvs::Vector<double>& m2 )
 {
+    const size_t nrows = data.rowSize();
     const size_t ncols = data.columnSize();
-    kvs::Matrix<T> cov( ncols, ncols );
-    for ( size_t row = 0; row < ncols; ++row )
+    mean.resize( ncols );
+    m2.resize( ncols );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long c = 0; c < long( ncols ); c++ )
     {
-        for ( size_t col = 0; col < ncols; ++col )
-        {
-            cov[row][col] = kvs::Stat::OnlineCov( data[row], data[col] );
-            if ( row != col ) { cov[col][row] = cov[row][col]; }
-        }
+        const auto& column = data[c];
+        double sum = 0.0;
+        for ( size_t i = 0; i < nrows; i++ ) { sum += column[i]; }
+        const double m = nrows > 0 ? sum / nrows : 0.0;
+
+        double sum2 = 0.0;
+        for ( size_t i = 0; i < nrows; i++ ) { sum2 += ( column[i] - m ) * ( column[i] - m ); }
+        mean[c] = static_cast<T>( m );
+        m2[c] = sum2;
     }
-    return std::move( cov );
 }
 
 /*===========================================================================*/
 /**
- *  @brief  Returns mean values.
+ *  @brief  Returns transposed deviation matrix.
  *  @param  data [in] data table
+ *  @param  mean [in] mean values
+ *  @return deviation matrix (ncolumns x nrows)
  */
 /*===========================================================================*/
 template <typename T>
-inline kvs::Vector<T> Mean( const kvs::ValueTable<T>& data )
+inline kvs::Matrix<T> DeviationTransposed(
+    const kvs::ValueTable<T>& data,
+    const kvs::Vector<T>& mean )
 {
+    // The table is stored in column-major order, so each row of the transposed
+    // matrix is copied from the contiguous column.
+    const size_t nrows = data.rowSize();
     const size_t ncols = data.columnSize();
-    kvs::Vector<T> mean( ncols );
-    for ( size_t i = 0; i < ncols; i++ )
+    kvs::Matrix<T> matrix( ncols, nrows );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long c = 0; c < long( ncols ); c++ )
     {
-        mean[i] = kvs::Stat::OnlineMean( data.column(i) );
+        const auto& column = data[c];
+        kvs::Vector<T>& row = matrix[c];
+        for ( size_t i = 0; i < nrows; i++ ) { row[i] = column[i] - mean[c]; }
     }
-    return std::move( mean );
+    return matrix;
 }
 
 /*===========================================================================*/
 /**
- *  @brief  Returns deviation matrix.
- *  @param  data [in] data table
+ *  @brief  Calculates the top-k left singular vectors of the matrix.
+ *  @param  A [in] matrix (m x n)
+ *  @param  k [in] number of singular vectors (<= min(m,n))
+ *  @param  values [out] singular values in descending order
+ *  @param  vectors [out] left singular vectors as row vectors (k x m)
  */
 /*===========================================================================*/
 template <typename T>
-inline kvs::Matrix<T> Deviation( const kvs::ValueTable<T>& data )
+inline void TopLeftSingularVectors(
+    const kvs::Matrix<T>& A,
+    const size_t k,
+    kvs::Vector<T>& values,
+    kvs::Matrix<T>& vectors )
 {
-    auto& d = const_cast<kvs::ValueTable<T>& >( data );
-    const auto mean = Mean( data );
-    const size_t nrows = data.rowSize();
-    const size_t ncols = data.columnSize();
+    // The eigen decomposition is applied to the smaller Gram matrix, A A^t
+    // (m x m) or A^t A (n x n).
+    using Eigen = kvs::EigenDecomposition<T>;
+    const size_t m = A.rowSize();
+    const size_t n = A.columnSize();
+    values.resize( k );
+    vectors.resize( k, m );
+    if ( m <= n )
+    {
+        const Eigen eigen( kvs::Matrix<T>::MultiplyTranspose( A, A ), Eigen::Symmetric );
+        for ( size_t i = 0; i < k; i++ )
+        {
+            values[i] = std::sqrt( kvs::Math::Max( eigen.eigenValues()[i], T(0) ) );
+            vectors[i] = eigen.eigenVectors()[i].normalized();
+        }
+    }
+    else
+    {
+        const Eigen eigen( kvs::Matrix<T>::TransposeMultiply( A, A ), Eigen::Symmetric );
+        kvs::Matrix<T> W( k, n );
+        for ( size_t i = 0; i < k; i++ )
+        {
+            values[i] = std::sqrt( kvs::Math::Max( eigen.eigenValues()[i], T(0) ) );
+            W[i] = eigen.eigenVectors()[i];
+        }
+
+        // u_i = A w_i / s_i
+        vectors = kvs::Matrix<T>::MultiplyTranspose( W, A );
+        for ( size_t i = 0; i < k; i++ )
+        {
+            const T length = vectors[i].length();
+            if ( length > T(0) ) { vectors[i] /= length; }
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the random matrix with the standard normal distribution.
+ *  @param  nrows [in] number of rows
+ *  @param  ncols [in] number of columns
+ *  @param  seed [in] seed of random numbers
+ */
+/*===========================================================================*/
+template <typename T>
+inline kvs::Matrix<T> GaussianMatrix( const size_t nrows, const size_t ncols, const kvs::UInt32 seed )
+{
+    kvs::MersenneTwister random( seed );
     kvs::Matrix<T> matrix( nrows, ncols );
     for ( size_t i = 0; i < nrows; i++ )
     {
-        matrix[i] = kvs::Vector<T>( d.beginRow(i), d.endRow(i) ) - mean;
+        for ( size_t j = 0; j < ncols; j++ )
+        {
+            // Box-Muller transform.
+            const double u1 = 1.0 - random.rand53();
+            const double u2 = random.rand53();
+            matrix[i][j] = static_cast<T>( std::sqrt( -2.0 * std::log( u1 ) ) * std::cos( 2.0 * kvs::Math::pi * u2 ) );
+        }
+    }
+    return matrix;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the top-k left singular vectors with randomized SVD.
+ *  @param  A [in] matrix (m x n)
+ *  @param  k [in] number of singular vectors
+ *  @param  l [in] dimension of the sampled subspace (k + oversamples)
+ *  @param  q [in] number of power iterations
+ *  @param  seed [in] seed of random numbers
+ *  @param  values [out] singular values in descending order
+ *  @param  vectors [out] left singular vectors as row vectors (k x m)
+ */
+/*===========================================================================*/
+template <typename T>
+inline void RandomizedLeftSingularVectors(
+    const kvs::Matrix<T>& A,
+    const size_t k,
+    const size_t l,
+    const size_t q,
+    const kvs::UInt32 seed,
+    kvs::Vector<T>& values,
+    kvs::Matrix<T>& vectors )
+{
+    // Range finder: orthonormal basis Q (n x l) of the range of A^t, which is
+    // stored as Q^t (l x n).
+    kvs::Matrix<T> Qt = ::GaussianMatrix<T>( l, A.rowSize(), seed ) * A;
+    kvs::detail::Orthonormalize( Qt );
+    for ( size_t i = 0; i < q; i++ )
+    {
+        kvs::Matrix<T> Zt = kvs::Matrix<T>::MultiplyTranspose( Qt, A );
+        kvs::detail::Orthonormalize( Zt );
+        Qt = Zt * A;
+        kvs::detail::Orthonormalize( Qt );
     }
-    return std::move( matrix );
+
+    // A Q (m x l) has the same left singular vectors as A approximately, and
+    // its SVD is calculated with the small Gram matrix.
+    ::TopLeftSingularVectors( kvs::Matrix<T>::MultiplyTranspose( A, Qt ), k, values, vectors );
 }
 
 } // end of namespace
@@ -106,21 +227,111 @@ PrincipalComponentAnalysis<T>::PrincipalComponentAnalysis(
 template <typename T>
 void PrincipalComponentAnalysis<T>::fit( const kvs::ValueTable<T>& data )
 {
-    using Eigen = kvs::EigenDecomposition<T>;
-    const kvs::Matrix<T> cov = ::Covariance<T>( data );
-    const Eigen eigen( cov );
-    const T sum = std::accumulate( eigen.eigenValues().begin(), eigen.eigenValues().end(), T(0) );
-
-    m_ncomponents = m_ncomponents == 0 ? data.columnSize() : m_ncomponents;
-    m_components.resize( m_ncomponents, cov.columnSize() );
-    m_explained_variance.resize( m_ncomponents );
-    m_explained_variance_ratio.resize( m_ncomponents );
-    for ( size_t i = 0; i < m_ncomponents; i++ )
+    const size_t nrows = data.rowSize();
+    const size_t ncols = data.columnSize();
+    m_ncomponents = m_ncomponents == 0 ? ncols : m_ncomponents;
+
+    ::Moments( data, m_mean, m_squared_deviation );
+    m_nsamples = nrows;
+
+    // Centered data matrix X (nrows x ncols) is stored as X^t.
+    const kvs::Matrix<T> Xt = ::DeviationTransposed( data, m_mean );
+    const size_t k = kvs::Math::Min( m_ncomponents, ncols, nrows );
+    const size_t l = kvs::Math::Min( k + m_noversamples, ncols, nrows );
+
+    bool randomized = m_solver == Randomized;
+    if ( m_solver == Auto ) { randomized = 2 * l < ncols; }
+
+    if ( randomized )
+    {
+        ::RandomizedLeftSingularVectors( Xt, k, l, m_npower_iterations, m_seed, m_singular_values, m_components );
+    }
+    else
     {
-        m_components[i] = eigen.eigenVectors()[i];
-        m_explained_variance[i] = eigen.eigenValues()[i];
-        m_explained_variance_ratio[i] = eigen.eigenValues()[i] / sum;
+        // Eigen decomposition of X^t X, that is the covariance matrix
+        // multiplied by (nrows - 1).
+        ::TopLeftSingularVectors( Xt, k, m_singular_values, m_components );
     }
+
+    this->update_variance();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the components incrementally with the given data chunk.
+ *  @param  data [in] input data table (chunk)
+ *
+ *  The chunk is merged with the current components weighted by the singular
+ *  values, and the mean values are updated with the combined mean [2].
+ */
+/*===========================================================================*/
+template <typename T>
+void PrincipalComponentAnalysis<T>::partialFit( const kvs::ValueTable<T>& data )
+{
+    const size_t nrows = data.rowSize();
+    const size_t ncols = data.columnSize();
+    if ( nrows == 0 ) { return; }
+    if ( m_nsamples > 0 && m_mean.size() != ncols ) { this->reset(); }
+    m_ncomponents = m_ncomponents == 0 ? ncols : m_ncomponents;
+
+    kvs::Vector<T> mean;
+    kvs::Vector<double> m2;
+    ::Moments( data, mean, m2 );
+
+    // Updated mean and sum of the squared deviations.
+    const size_t nsamples = m_nsamples + nrows;
+    const double ratio = double( m_nsamples ) * nrows / nsamples;
+    kvs::Vector<T> new_mean( ncols );
+    kvs::Vector<double> new_m2( ncols );
+    for ( size_t c = 0; c < ncols; c++ )
+    {
+        const double old_mean = m_nsamples > 0 ? double( m_mean[c] ) : 0.0;
+        const double old_m2 = m_nsamples > 0 ? m_squared_deviation[c] : 0.0;
+        const double delta = old_mean - mean[c];
+        new_mean[c] = static_cast<T>( ( old_mean * m_nsamples + double( mean[c] ) * nrows ) / nsamples );
+        new_m2[c] = old_m2 + m2[c] + ratio * delta * delta;
+    }
+
+    // Stacked matrix [ S V ; X - mean ; sqrt(ratio) (old_mean - mean) ], stored
+    // as the transposed matrix (ncols x (ncomps + nrows + 1)).
+    const size_t ncomps = m_nsamples > 0 ? m_components.rowSize() : 0;
+    const size_t ncorrections = m_nsamples > 0 ? 1 : 0;
+    const size_t nstacks = ncomps + nrows + ncorrections;
+    kvs::Matrix<T> St( ncols, nstacks );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long c = 0; c < long( ncols ); c++ )
+    {
+        kvs::Vector<T>& row = St[c];
+        for ( size_t i = 0; i < ncomps; i++ ) { row[i] = m_singular_values[i] * m_components[i][c]; }
+
+        const auto& column = data[c];
+        for ( size_t i = 0; i < nrows; i++ ) { row[ ncomps + i ] = column[i] - mean[c]; }
+
+        if ( ncorrections > 0 )
+        {
+            row[ nstacks - 1 ] = static_cast<T>( std::sqrt( ratio ) * ( double( m_mean[c] ) - mean[c] ) );
+        }
+    }
+
+    const size_t k = kvs::Math::Min( m_ncomponents, ncols, nstacks );
+    const size_t l = kvs::Math::Min( k + m_noversamples, ncols, nstacks );
+
+    bool randomized = m_solver == Randomized;
+    if ( m_solver == Auto ) { randomized = 2 * l < kvs::Math::Min( ncols, nstacks ); }
+
+    if ( randomized )
+    {
+        ::RandomizedLeftSingularVectors( St, k, l, m_npower_iterations, m_seed, m_singular_values, m_components );
+    }
+    else
+    {
+        ::TopLeftSingularVectors( St, k, m_singular_values, m_components );
+    }
+
+    m_mean = new_mean;
+    m_squared_deviation = new_m2;
+    m_nsamples = nsamples;
+    this->update_variance();
 }
 
 /*===========================================================================*/
@@ -133,12 +344,59 @@ template <typename T>
 kvs::ValueTable<T> PrincipalComponentAnalysis<T>::transform( const kvs::ValueTable<T>& data )
 {
     if ( m_components.rowSize() == 0 ) { this->fit( data ); }
-    kvs::Matrix<T> m = ::Deviation<T>( data ) * m_components.transposed();
-    kvs::ValueTable<T> t( m.rowSize(), m.columnSize() );
-    std::copy( m.begin(), m.end(), t.beginInRowOrder() );
+
+    // Projected points are calculated as V (X - mean)^t (ncomps x nrows), and
+    // each row is stored in the column of the table.
+    const kvs::Matrix<T> m = m_components * ::DeviationTransposed( data, m_mean );
+    kvs::ValueTable<T> t( m.columnSize(), m.rowSize() );
+    for ( size_t i = 0; i < m.rowSize(); i++ )
+    {
+        std::copy( m[i].begin(), m[i].end(), t[i].begin() );
+    }
     return t;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Resets the fitted components and the incremental statistics.
+ */
+/*===========================================================================*/
+template <typename T>
+void PrincipalComponentAnalysis<T>::reset()
+{
+    m_components = kvs::Matrix<T>();
+    m_explained_variance = kvs::Vector<T>();
+    m_explained_variance_ratio = kvs::Vector<T>();
+    m_singular_values = kvs::Vector<T>();
+    m_mean = kvs::Vector<T>();
+    m_squared_deviation = kvs::Vector<double>();
+    m_nsamples = 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the explained variances from the singular values.
+ */
+/*===========================================================================*/
+template <typename T>
+void PrincipalComponentAnalysis<T>::update_variance()
+{
+    const size_t k = m_singular_values.size();
+    const double dof = m_nsamples > 1 ? double( m_nsamples - 1 ) : 1.0;
+    double total = 0.0;
+    for ( size_t c = 0; c < m_squared_deviation.size(); c++ ) { total += m_squared_deviation[c]; }
+    total /= dof;
+
+    m_explained_variance.resize( k );
+    m_explained_variance_ratio.resize( k );
+    for ( size_t i = 0; i < k; i++ )
+    {
+        const double variance = double( m_singular_values[i] ) * m_singular_values[i] / dof;
+        m_explained_variance[i] = static_cast<T>( variance );
+        m_explained_variance_ratio[i] = static_cast<T>( total > 0.0 ? variance / total : 0.0 );
+    }
+}
+
 template class PrincipalComponentAnalysis<float>;
 template class PrincipalComponentAnalysis<double>;
 
@@ -3,6 +3,16 @@
  *  @file   PrincipalComponentAnalysis.h
  *  @author Naohisa Sakamoto
  */
+/*----------------------------------------------------------------------------
+ *
+ * References:
+ * [1] N. Halko, P. G. Martinsson, and J. A. Tropp, Finding structure with
+ *     randomness: probabilistic algorithms for constructing approximate matrix
+ *     decompositions, SIAM Review, vol. 53, no. 2, pp. 217-288, 2011.
+ * [2] D. A. Ross, J. Lim, R.-S. Lin, and M.-H. Yang, Incremental learning for
+ *     robust visual tracking, International Journal of Computer Vision,
+ *     vol. 77, pp. 125-141, 2008.
+ */
 /*****************************************************************************/
 #pragma once
 #include <kvs/Vector>
@@ -16,29 +26,65 @@ namespace kvs
 /*===========================================================================*/
 /**
  *  @brief  Principal Component Analysis (PCA) class.
+ *
+ *  The principal components are calculated with the eigen decomposition of the
+ *  covariance matrix (Exact) or with the randomized truncated SVD of the
+ *  centered data [1] (Randomized), which calculates only the top-k components.
+ *  The components can also be updated incrementally chunk by chunk with
+ *  partialFit() [2], so that a large table can be processed without storing
+ *  the whole data.
  */
 /*===========================================================================*/
 template <typename T>
 class PrincipalComponentAnalysis
 {
+public:
+    enum Solver
+    {
+        Auto, ///< Randomized if the number of components is much smaller than the dimension
+        Exact, ///< eigen decomposition of the covariance matrix
+        Randomized ///< randomized truncated SVD
+    };
+
 private:
     size_t m_ncomponents = 0; /// number of components (if 0, dimension of the input data matrix)
+    Solver m_solver = Auto; ///< solver
+    size_t m_noversamples = 10; ///< number of oversamples for the randomized SVD
+    size_t m_npower_iterations = 4; ///< number of power iterations for the randomized SVD
+    kvs::UInt32 m_seed = 1; ///< seed of random numbers for the randomized SVD
     kvs::Matrix<T> m_components{}; /// eigenvector matrix derived from the covariance matrix of the input data matrix
     kvs::Vector<T> m_explained_variance{}; /// eigen value vector from the covariance matrix of the input data matrix
     kvs::Vector<T> m_explained_variance_ratio{}; /// ratio of the eigen values
+    kvs::Vector<T> m_singular_values{}; ///< singular values of the centered data
+    kvs::Vector<T> m_mean{}; ///< mean values of the input data
+    kvs::Vector<double> m_squared_deviation{}; ///< sum of squared deviations of each column
+    size_t m_nsamples = 0; ///< number of samples seen so far
 
 public:
     PrincipalComponentAnalysis( const size_t ncomps = 0 ): m_ncomponents( ncomps ) {}
     PrincipalComponentAnalysis( const kvs::ValueTable<T>& data, const size_t ncomponents = 0 );
 
     void setNumberOfComponents( const size_t ncomponents ) { m_ncomponents = ncomponents; }
+    void setSolver( const Solver solver ) { m_solver = solver; }
+    void setNumberOfOversamples( const size_t noversamples ) { m_noversamples = noversamples; }
+    void setNumberOfPowerIterations( const size_t niterations ) { m_npower_iterations = niterations; }
+    void setSeed( const kvs::UInt32 seed ) { m_seed = seed; }
     size_t numberOfComponents() const { return m_ncomponents; }
+    Solver solver() const { return m_solver; }
+    size_t numberOfSamples() const { return m_nsamples; }
     const kvs::Matrix<T>& components() const { return m_components; }
     const kvs::Vector<T>& explainedVariance() const { return m_explained_variance; }
     const kvs::Vector<T>& explainedVarianceRatio() const { return m_explained_variance_ratio; }
+    const kvs::Vector<T>& singularValues() const { return m_singular_values; }
+    const kvs::Vector<T>& mean() const { return m_mean; }
 
     void fit( const kvs::ValueTable<T>& data );
+    void partialFit( const kvs::ValueTable<T>& data );
     kvs::ValueTable<T> transform( const kvs::ValueTable<T>& data );
+    void reset();
+
+private:
+    void update_variance();
 };
 
 } // end of namespace kvs
@@ -86,9 +86,8 @@ void RidgeRegression<T>::fit( const kvs::ValueArray<T>& dep, const kvs::ValueTab
         }
     }
 
-    const kvs::Matrix<T> Xt = X.transposed();
-    const kvs::Matrix<T> XtX = Xt * X;
-    const kvs::Vector<T> XtY = Xt * Y;
+    const kvs::Matrix<T> XtX = kvs::Matrix<T>::TransposeMultiply( X, X );
+    const kvs::Vector<T> XtY = Y * X;
     const kvs::Matrix<T> I = ::Identity<T>( XtX[0].size() );
     m_coef = ( XtX + m_complexity * I ).inverted() * XtY;
 
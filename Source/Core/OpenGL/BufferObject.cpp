@@ -76,7 +76,7 @@ void BufferObject::release()
 void BufferObject::bind() const
 {
     KVS_ASSERT( this->isCreated() );
-    KVS_GL_CALL( glBindBuffer( m_target, m_id ) );
+    kvs::OpenGL::BindBuffer( m_target, m_id );
 }
 
 /*===========================================================================*/
@@ -87,7 +87,7 @@ void BufferObject::bind() const
 void BufferObject::unbind() const
 {
     KVS_ASSERT( this->isBound() );
-    KVS_GL_CALL( glBindBuffer( m_target, 0 ) );
+    kvs::OpenGL::BindBuffer( m_target, 0 );
 }
 
 /*===========================================================================*/
@@ -177,6 +177,7 @@ void BufferObject::deleteID()
         if ( this->isBound() ) { this->unbind(); }
         KVS_GL_CALL( glDeleteBuffers( 1, &m_id ) );
         m_id = 0;
+        kvs::OpenGL::InvalidateStateTracker();
     }
 }
 
@@ -241,7 +242,7 @@ void BufferObject::unmapBuffer()
 /*===========================================================================*/
 BufferObject::GuardedBinder::GuardedBinder( const kvs::BufferObject& bo ):
     m_bo( bo ),
-    m_id( kvs::OpenGL::Integer( bo.targetBinding() ) )
+    m_id( kvs::OpenGL::BoundBuffer( bo.target(), bo.targetBinding() ) )
 {
     KVS_ASSERT( bo.isCreated() );
     if ( bo.id() != static_cast<GLuint>( m_id ) ) { bo.bind(); }
@@ -257,7 +258,7 @@ BufferObject::GuardedBinder::~GuardedBinder()
     KVS_ASSERT( m_bo.isCreated() );
     if ( static_cast<GLuint>( m_id ) != m_bo.id() )
     {
-        KVS_GL_CALL( glBindBuffer( m_bo.target(), m_id ) );
+        kvs::OpenGL::BindBuffer( m_bo.target(), m_id );
     }
 }
 
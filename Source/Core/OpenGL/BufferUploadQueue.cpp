@@ -0,0 +1,76 @@
+/*****************************************************************************/
+/**
+ *  @file   BufferUploadQueue.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#include "BufferUploadQueue.h"
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Pushes the upload request of the manager.
+ *  @param  manager [in] pointer to the vertex buffer object manager
+ *  @return upload request
+ *
+ *  The data arrays set to the manager must be kept by the caller (or by
+ *  Request::hold()) until the upload is completed.
+ */
+/*===========================================================================*/
+BufferUploadQueue::RequestPointer BufferUploadQueue::push(
+    kvs::VertexBufferObjectManager* manager )
+{
+    auto request = std::make_shared<Request>( manager );
+    this->push( request );
+    return request;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Pushes the upload request. This method is thread-safe.
+ *  @param  request [in] upload request
+ */
+/*===========================================================================*/
+void BufferUploadQueue::push( const RequestPointer& request )
+{
+    m_npending.fetch_add( 1 );
+    m_queue.push( request );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Uploads the pending requests within the budget.
+ *  @return uploaded data size in bytes
+ *
+ *  This method must be called on the thread with the OpenGL context. The
+ *  requests are uploaded in the pushed order, and a request that is not
+ *  completed within the budget is continued on the next call.
+ */
+/*===========================================================================*/
+size_t BufferUploadQueue::process()
+{
+    size_t uploaded_size = 0;
+    while ( uploaded_size < m_budget )
+    {
+        if ( !m_current && !m_queue.pop( m_current ) ) { break; }
+
+        if ( !m_current->isCanceled() )
+        {
+            auto* manager = m_current->manager();
+            uploaded_size += manager->upload( m_budget - uploaded_size );
+            if ( !manager->isUploaded() ) { break; }
+            m_current->complete();
+        }
+
+        m_current.reset();
+        m_npending.fetch_sub( 1 );
+    }
+
+    m_uploaded_size = uploaded_size;
+    return uploaded_size;
+}
+
+} // end of namespace kvs
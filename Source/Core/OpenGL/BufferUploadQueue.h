@@ -0,0 +1,84 @@
+/*****************************************************************************/
+/**
+ *  @file   BufferUploadQueue.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <kvs/VertexBufferObjectManager>
+#include <kvs/AnyValueArray>
+#include <kvs/MPSCQueue>
+#include <kvs/Noncopyable>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Upload queue class for the vertex buffer objects.
+ *
+ *  The vertex buffer object managers, whose data arrays are set, can be pushed
+ *  to the queue from any thread. The queue is processed on the thread with the
+ *  OpenGL context (e.g. in Scene::paintFunction), and the data is uploaded to
+ *  the buffer objects within the given byte budget per frame, so that adding
+ *  a large object does not stall the rendering.
+ */
+/*===========================================================================*/
+class BufferUploadQueue : public kvs::Noncopyable
+{
+public:
+    /*=======================================================================*/
+    /**
+     *  @brief  Upload request of the vertex buffer object manager.
+     */
+    /*=======================================================================*/
+    class Request
+    {
+    private:
+        kvs::VertexBufferObjectManager* m_manager = nullptr; ///< target manager (reference)
+        std::vector<kvs::AnyValueArray> m_arrays{}; ///< data arrays kept until uploaded
+        std::atomic<bool> m_is_completed{ false }; ///< true if the upload is completed
+        std::atomic<bool> m_is_canceled{ false }; ///< true if the upload is canceled
+
+    public:
+        Request( kvs::VertexBufferObjectManager* manager ): m_manager( manager ) {}
+
+        kvs::VertexBufferObjectManager* manager() { return m_manager; }
+        bool isCompleted() const { return m_is_completed.load(); }
+        bool isCanceled() const { return m_is_canceled.load(); }
+
+        void hold( const kvs::AnyValueArray& array ) { m_arrays.push_back( array ); }
+        void cancel() { m_is_canceled.store( true ); }
+        void complete() { m_arrays.clear(); m_is_completed.store( true ); }
+    };
+
+    using RequestPointer = std::shared_ptr<Request>;
+
+private:
+    kvs::MPSCQueue<RequestPointer> m_queue{}; ///< lock-free queue of the requests
+    RequestPointer m_current{}; ///< request in progress
+    std::atomic<size_t> m_npending{ 0 }; ///< number of pending requests
+    size_t m_budget = 64 * 1024 * 1024; ///< max. data size uploaded per frame [bytes]
+    size_t m_uploaded_size = 0; ///< data size uploaded in the last process [bytes]
+
+public:
+    BufferUploadQueue() = default;
+    virtual ~BufferUploadQueue() = default;
+
+    size_t budget() const { return m_budget; }
+    size_t uploadedSize() const { return m_uploaded_size; }
+    size_t numberOfPendingRequests() const { return m_npending.load(); }
+    bool hasPendingRequests() const { return m_npending.load() > 0; }
+
+    void setBudget( const size_t budget ) { m_budget = budget; }
+
+    RequestPointer push( kvs::VertexBufferObjectManager* manager );
+    void push( const RequestPointer& request );
+    size_t process();
+};
+
+} // end of namespace kvs
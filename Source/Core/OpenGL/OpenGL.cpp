@@ -6,6 +6,7 @@
 /*****************************************************************************/
 #include "OpenGL.h"
 #include <kvs/Assert>
+#include <kvs/IgnoreUnusedVariable>
 
 
 namespace
@@ -234,6 +235,77 @@ inline void Cross( float v1[3], float v2[3], float result[3] )
 }
 
 
+namespace
+{
+
+// The state tracker records the program, the active texture unit, and the
+// texture and buffer bindings set through kvs::OpenGL, and skips the binds
+// to the already bound objects. The unknown bindings are queried from or
+// set to OpenGL. The tracker is disabled by default, since the bindings
+// changed by other libraries must be invalidated explicitly.
+const GLuint UnknownBinding = static_cast<GLuint>( -1 );
+const size_t MaxTrackedTextureUnits = 32;
+const size_t NumberOfTrackedTextureTargets = 4;
+const size_t NumberOfTrackedBufferTargets = 4;
+
+struct TrackedState
+{
+    bool enabled = false; ///< if false, all of the binds are passed to OpenGL
+    GLuint program = UnknownBinding; ///< current program
+    GLint unit = -1; ///< active texture unit (-1: unknown)
+    GLuint textures[ MaxTrackedTextureUnits ][ NumberOfTrackedTextureTargets ]; ///< bound textures
+    GLuint buffers[ NumberOfTrackedBufferTargets ]; ///< bound buffers
+    kvs::OpenGL::StateTrackerCounters counters{}; ///< counters
+
+    TrackedState() { this->invalidate(); }
+
+    void invalidate()
+    {
+        program = UnknownBinding;
+        unit = -1;
+        for ( size_t i = 0; i < MaxTrackedTextureUnits; i++ )
+        {
+            for ( size_t j = 0; j < NumberOfTrackedTextureTargets; j++ ) { textures[i][j] = UnknownBinding; }
+        }
+        for ( size_t i = 0; i < NumberOfTrackedBufferTargets; i++ ) { buffers[i] = UnknownBinding; }
+    }
+
+    GLuint* texture( const GLenum target )
+    {
+        if ( !enabled || unit < 0 || unit >= GLint( MaxTrackedTextureUnits ) ) { return NULL; }
+        switch ( target )
+        {
+        case GL_TEXTURE_1D: return &textures[unit][0];
+        case GL_TEXTURE_2D: return &textures[unit][1];
+        case GL_TEXTURE_3D: return &textures[unit][2];
+        case GL_TEXTURE_RECTANGLE: return &textures[unit][3];
+        default: return NULL;
+        }
+    }
+
+    GLuint* buffer( const GLenum target )
+    {
+        if ( !enabled ) { return NULL; }
+        switch ( target )
+        {
+        case GL_ARRAY_BUFFER: return &buffers[0];
+        case GL_ELEMENT_ARRAY_BUFFER: return &buffers[1];
+        case GL_PIXEL_PACK_BUFFER: return &buffers[2];
+        case GL_PIXEL_UNPACK_BUFFER: return &buffers[3];
+        default: return NULL;
+        }
+    }
+};
+
+inline TrackedState& State()
+{
+    static TrackedState state;
+    return state;
+}
+
+}
+
+
 namespace kvs
 {
 
@@ -684,6 +756,11 @@ void SetBlendFunc( GLenum sfactor, GLenum dfactor )
     KVS_GL_CALL( glBlendFunc( sfactor, dfactor ) );
 }
 
+void SetBlendFuncSeparate( GLenum srgb, GLenum drgb, GLenum salpha, GLenum dalpha )
+{
+    KVS_GL_CALL( glBlendFuncSeparate( srgb, drgb, salpha, dalpha ) );
+}
+
 void SetShadeModel( GLenum mode )
 {
     KVS_GL_CALL( glShadeModel( mode ) );
@@ -1851,6 +1928,9 @@ void PushAttrib( GLbitfield mask )
 void PopAttrib()
 {
     KVS_GL_CALL( glPopAttrib() );
+
+    // The texture bindings can be restored by glPopAttrib.
+    kvs::OpenGL::InvalidateStateTracker();
 }
 
 void PushClientAttrib( GLbitfield mask )
@@ -1861,6 +1941,9 @@ void PushClientAttrib( GLbitfield mask )
 void PopClientAttrib()
 {
     KVS_GL_CALL( glPopClientAttrib() );
+
+    // The buffer bindings can be restored by glPopClientAttrib.
+    kvs::OpenGL::InvalidateStateTracker();
 }
 
 void EnableClientState( GLenum array )
@@ -1923,6 +2006,30 @@ void MultiDrawArrays( GLenum mode, const kvs::ValueArray<GLint>& first, const kv
     kvs::OpenGL::MultiDrawArrays( mode, first.data(), count.data(), first.size() );
 }
 
+void DrawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei instancecount )
+{
+#if defined( GL_VERSION_3_1 )
+    KVS_GL_CALL( glDrawArraysInstanced( mode, first, count, instancecount ) );
+#else
+    kvs::IgnoreUnusedVariable( mode );
+    kvs::IgnoreUnusedVariable( first );
+    kvs::IgnoreUnusedVariable( count );
+    kvs::IgnoreUnusedVariable( instancecount );
+    kvsMessageError("glDrawArraysInstanced is not supported.");
+#endif
+}
+
+void VertexAttribDivisor( GLuint index, GLuint divisor )
+{
+#if defined( GL_VERSION_3_3 )
+    KVS_GL_CALL( glVertexAttribDivisor( index, divisor ) );
+#else
+    kvs::IgnoreUnusedVariable( index );
+    kvs::IgnoreUnusedVariable( divisor );
+    kvsMessageError("glVertexAttribDivisor is not supported.");
+#endif
+}
+
 void DrawElements( GLenum mode, GLsizei count, GLenum type, const GLvoid* indices )
 {
     KVS_GL_CALL( glDrawElements( mode, count, type, indices ) );
@@ -2351,6 +2458,212 @@ void Render2D::end()
     kvs::OpenGL::PopAttrib();
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Enables the state tracker.
+ */
+/*===========================================================================*/
+void EnableStateTracker()
+{
+    ::State().enabled = true;
+    ::State().invalidate();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Disables the state tracker.
+ */
+/*===========================================================================*/
+void DisableStateTracker()
+{
+    ::State().enabled = false;
+    ::State().invalidate();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the state tracker is enabled.
+ *  @return true if the state tracker is enabled
+ */
+/*===========================================================================*/
+bool IsStateTrackerEnabled()
+{
+    return ::State().enabled;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Forgets the tracked bindings.
+ *
+ *  This function should be called when the bindings are changed without
+ *  kvs::OpenGL, e.g. by other libraries or by another GL context.
+ */
+/*===========================================================================*/
+void InvalidateStateTracker()
+{
+    ::State().invalidate();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the counters of the state tracker.
+ *  @return counters
+ */
+/*===========================================================================*/
+StateTrackerCounters& TrackerCounters()
+{
+    return ::State().counters;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resets the counters of the state tracker.
+ */
+/*===========================================================================*/
+void ResetTrackerCounters()
+{
+    ::State().counters = StateTrackerCounters();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Installs the program object unless it is already in use.
+ *  @param  program [in] program object ID
+ */
+/*===========================================================================*/
+void UseProgram( GLuint program )
+{
+    auto& state = ::State();
+    state.counters.program_binds++;
+    if ( state.enabled && state.program == program )
+    {
+        state.counters.elided_program_binds++;
+        return;
+    }
+
+    KVS_GL_CALL( glUseProgram( program ) );
+    if ( state.enabled ) { state.program = program; }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Selects the active texture unit unless it is already selected.
+ *  @param  texture [in] texture unit (GL_TEXTUREi)
+ */
+/*===========================================================================*/
+void ActiveTexture( GLenum texture )
+{
+    auto& state = ::State();
+    const GLint unit = static_cast<GLint>( texture - GL_TEXTURE0 );
+    state.counters.texture_unit_selections++;
+    if ( state.enabled && state.unit == unit )
+    {
+        state.counters.elided_texture_unit_selections++;
+        return;
+    }
+
+    KVS_GL_CALL( glActiveTexture( texture ) );
+    if ( state.enabled ) { state.unit = unit; }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Binds the texture to the active unit unless it is already bound.
+ *  @param  target [in] texture target
+ *  @param  texture [in] texture ID
+ */
+/*===========================================================================*/
+void BindTexture( GLenum target, GLuint texture )
+{
+    auto& state = ::State();
+    GLuint* tracked = state.texture( target );
+    state.counters.texture_binds++;
+    if ( tracked && *tracked == texture )
+    {
+        state.counters.elided_texture_binds++;
+        return;
+    }
+
+    KVS_GL_CALL( glBindTexture( target, texture ) );
+    if ( tracked ) { *tracked = texture; }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Binds the buffer to the target unless it is already bound.
+ *  @param  target [in] buffer target
+ *  @param  buffer [in] buffer ID
+ */
+/*===========================================================================*/
+void BindBuffer( GLenum target, GLuint buffer )
+{
+    auto& state = ::State();
+    GLuint* tracked = state.buffer( target );
+    state.counters.buffer_binds++;
+    if ( tracked && *tracked == buffer )
+    {
+        state.counters.elided_buffer_binds++;
+        return;
+    }
+
+    KVS_GL_CALL( glBindBuffer( target, buffer ) );
+    if ( tracked ) { *tracked = buffer; }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the program object in use.
+ *  @return program object ID
+ */
+/*===========================================================================*/
+GLuint BoundProgram()
+{
+    auto& state = ::State();
+    if ( state.enabled && state.program != UnknownBinding ) { return state.program; }
+
+    const GLuint program = static_cast<GLuint>( kvs::OpenGL::Integer( GL_CURRENT_PROGRAM ) );
+    if ( state.enabled ) { state.program = program; }
+    return program;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the texture bound to the active unit.
+ *  @param  target [in] texture target
+ *  @param  target_binding [in] texture target binding
+ *  @return texture ID
+ */
+/*===========================================================================*/
+GLuint BoundTexture( GLenum target, GLenum target_binding )
+{
+    auto& state = ::State();
+    GLuint* tracked = state.texture( target );
+    if ( tracked && *tracked != UnknownBinding ) { return *tracked; }
+
+    const GLuint texture = static_cast<GLuint>( kvs::OpenGL::Integer( target_binding ) );
+    if ( tracked ) { *tracked = texture; }
+    return texture;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the buffer bound to the target.
+ *  @param  target [in] buffer target
+ *  @param  target_binding [in] buffer target binding
+ *  @return buffer ID
+ */
+/*===========================================================================*/
+GLuint BoundBuffer( GLenum target, GLenum target_binding )
+{
+    auto& state = ::State();
+    GLuint* tracked = state.buffer( target );
+    if ( tracked && *tracked != UnknownBinding ) { return *tracked; }
+
+    const GLuint buffer = static_cast<GLuint>( kvs::OpenGL::Integer( target_binding ) );
+    if ( tracked ) { *tracked = buffer; }
+    return buffer;
+}
+
 } // end of namespace OpenGL
 
 } // end of namespace kvs
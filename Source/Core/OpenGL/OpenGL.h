@@ -82,6 +82,7 @@ void SetDepthMask( GLboolean flag );
 void SetDepthFunc( GLenum func );
 void SetAlphaFunc( GLenum func, GLclampf ref );
 void SetBlendFunc( GLenum sfactor, GLenum dfactor );
+void SetBlendFuncSeparate( GLenum srgb, GLenum drgb, GLenum salpha, GLenum dalpha );
 void SetShadeModel( GLenum mode );
 void SetMatrixMode( GLenum mode );
 void SetPolygonMode( GLenum face, GLenum mode );
@@ -333,6 +334,8 @@ void VertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean norma
 void DrawArrays( GLenum mode, GLint first, GLsizei count );
 void MultiDrawArrays( GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawcount );
 void MultiDrawArrays( GLenum mode, const kvs::ValueArray<GLint>& first, const kvs::ValueArray<GLsizei>& count );
+void DrawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei instancecount );
+void VertexAttribDivisor( GLuint index, GLuint divisor );
 
 void DrawElements( GLenum mode, GLsizei count, GLenum type, const GLvoid* indices );
 void MultiDrawElements( GLenum mode, const GLsizei* count, GLenum type, const GLvoid* const* indices, GLsizei drawcount );
@@ -351,6 +354,40 @@ GLint UnProject(
 void DrawCylinder( GLdouble base, GLdouble top, GLdouble height, GLint slices, GLint stacks );
 void DrawSphere( GLdouble radius, GLint slices, GLint stacks );
 
+/*===========================================================================*/
+/**
+ *  @brief  Counters of the state tracker.
+ */
+/*===========================================================================*/
+struct StateTrackerCounters
+{
+    size_t program_binds = 0; ///< number of requested program binds
+    size_t elided_program_binds = 0; ///< number of elided program binds
+    size_t texture_unit_selections = 0; ///< number of requested texture unit selections
+    size_t elided_texture_unit_selections = 0; ///< number of elided texture unit selections
+    size_t texture_binds = 0; ///< number of requested texture binds
+    size_t elided_texture_binds = 0; ///< number of elided texture binds
+    size_t buffer_binds = 0; ///< number of requested buffer binds
+    size_t elided_buffer_binds = 0; ///< number of elided buffer binds
+    size_t uniform_lookups = 0; ///< number of requested uniform location lookups
+    size_t elided_uniform_lookups = 0; ///< number of lookups found in the location cache
+};
+
+void EnableStateTracker();
+void DisableStateTracker();
+bool IsStateTrackerEnabled();
+void InvalidateStateTracker();
+StateTrackerCounters& TrackerCounters();
+void ResetTrackerCounters();
+
+void UseProgram( GLuint program );
+void ActiveTexture( GLenum texture );
+void BindTexture( GLenum target, GLuint texture );
+void BindBuffer( GLenum target, GLuint buffer );
+GLuint BoundProgram();
+GLuint BoundTexture( GLenum target, GLenum target_binding );
+GLuint BoundBuffer( GLenum target, GLenum target_binding );
+
 /*===========================================================================*/
 /**
  *  @brief  WithPushedMatrix class.
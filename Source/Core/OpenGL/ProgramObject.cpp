@@ -96,7 +96,10 @@ bool ProgramObject::link() const
 {
     KVS_ASSERT( this->isCreated() );
     KVS_GL_CALL( glLinkProgram( m_id ) );
-    return this->isLinked();
+    if ( !this->isLinked() ) { return false; }
+
+    this->cacheUniformLocations();
+    return true;
 }
 
 /*===========================================================================*/
@@ -201,7 +204,7 @@ void ProgramObject::build(
 void ProgramObject::bind() const
 {
     KVS_ASSERT( this->isCreated() );
-    KVS_GL_CALL( glUseProgram( m_id ) );
+    kvs::OpenGL::UseProgram( m_id );
     m_is_bound = true;
 }
 
@@ -213,7 +216,7 @@ void ProgramObject::bind() const
 void ProgramObject::unbind() const
 {
     KVS_ASSERT( this->isBound() );
-    KVS_GL_CALL( glUseProgram( 0 ) );
+    kvs::OpenGL::UseProgram( 0 );
     m_is_bound = false;
 }
 
@@ -274,8 +277,22 @@ bool ProgramObject::isLinked() const
 /*===========================================================================*/
 GLint ProgramObject::uniformLocation( const GLchar *name ) const
 {
+    auto& counters = kvs::OpenGL::TrackerCounters();
+    counters.uniform_lookups++;
+
+    const std::string key( name );
+    const auto cached = m_uniform_locations.find( key );
+    if ( cached != m_uniform_locations.end() )
+    {
+        counters.elided_uniform_lookups++;
+        return cached->second;
+    }
+
+    // The location of the name not given by the introspection, e.g. the
+    // element of the array or the inactive uniform (-1), is also cached.
     GLint result = 0;
     KVS_GL_CALL( result = glGetUniformLocation( m_id, name ) );
+    m_uniform_locations[ key ] = result;
     return result;
 }
 
@@ -508,6 +525,8 @@ void ProgramObject::deleteID()
         if ( this->isBound() ) { this->unbind(); }
         KVS_GL_CALL( glDeleteProgram( m_id ) );
         m_id = 0;
+        m_uniform_locations.clear();
+        kvs::OpenGL::InvalidateStateTracker();
     }
 }
 
@@ -541,6 +560,44 @@ void ProgramObject::setParameter( GLenum pname, GLint value )
 #endif
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Caches the locations of the active uniform variables.
+ */
+/*===========================================================================*/
+void ProgramObject::cacheUniformLocations() const
+{
+    m_uniform_locations.clear();
+
+    GLint nuniforms = 0;
+    GLint max_length = 0;
+    KVS_GL_CALL( glGetProgramiv( m_id, GL_ACTIVE_UNIFORMS, &nuniforms ) );
+    KVS_GL_CALL( glGetProgramiv( m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length ) );
+    if ( nuniforms <= 0 || max_length <= 0 ) { return; }
+
+    std::vector<GLchar> buffer( max_length + 1 );
+    for ( GLint i = 0; i < nuniforms; i++ )
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        KVS_GL_CALL( glGetActiveUniform( m_id, GLuint( i ), max_length, &length, &size, &type, buffer.data() ) );
+
+        std::string name( buffer.data(), length );
+        GLint location = -1;
+        KVS_GL_CALL( location = glGetUniformLocation( m_id, name.c_str() ) );
+        m_uniform_locations[ name ] = location;
+
+        // The array is also accessed with the name without "[0]".
+        const std::string suffix( "[0]" );
+        if ( name.size() > suffix.size() &&
+             name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0 )
+        {
+            m_uniform_locations[ name.substr( 0, name.size() - suffix.size() ) ] = location;
+        }
+    }
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Constructs a program object binder.
@@ -562,7 +619,7 @@ ProgramObject::Binder::Binder( const ProgramObject& po ) :
 ProgramObject::Binder::~Binder()
 {
     KVS_ASSERT( m_po.isCreated() );
-    KVS_GL_CALL( glUseProgram( 0 ) );
+    kvs::OpenGL::UseProgram( 0 );
 }
 
 // DEPRECATED
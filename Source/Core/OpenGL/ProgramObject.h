@@ -17,6 +17,8 @@
 #include <kvs/Matrix44>
 #include <kvs/ValueArray>
 #include <kvs/Deprecated>
+#include <string>
+#include <unordered_map>
 
 
 namespace kvs
@@ -35,6 +37,7 @@ private:
     GLenum m_geom_output_type = 0; ///< output type for geometry shader
     GLint m_geom_output_vertices = 0; ///< number of vertices for geometry shader
     mutable bool m_is_bound = false; ///< binding flag
+    mutable std::unordered_map<std::string,GLint> m_uniform_locations{}; ///< cache of uniform locations
 
 public:
     class Binder;
@@ -87,6 +90,7 @@ protected:
     void createID();
     void deleteID();
     void setParameter( GLenum pname, GLint value );
+    void cacheUniformLocations() const;
 
 public:
     KVS_DEPRECATED( bool link( const kvs::VertexShader& vertex_shader, const kvs::FragmentShader& fragment_shader ) );
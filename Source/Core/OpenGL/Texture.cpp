@@ -49,7 +49,7 @@ void Texture::Unbind( const Texture& texture, const GLint unit )
 /*===========================================================================*/
 void Texture::Unbind( const GLenum target )
 {
-    KVS_GL_CALL( glBindTexture( target, 0 ) );
+    kvs::OpenGL::BindTexture( target, 0 );
 }
 
 /*===========================================================================*/
@@ -62,7 +62,7 @@ void Texture::SelectActiveUnit( const GLint unit )
 {
     KVS_ASSERT( unit >= 0 );
     KVS_ASSERT( unit < kvs::OpenGL::MaxCombinedTextureImageUnits() );
-    KVS_GL_CALL( glActiveTexture( GL_TEXTURE0 + unit ) );
+    kvs::OpenGL::ActiveTexture( GL_TEXTURE0 + unit );
 }
 
 /*===========================================================================*/
@@ -166,7 +166,7 @@ void Texture::setSize( const size_t width, const size_t height, const size_t dep
 void Texture::bind() const
 {
     KVS_ASSERT( this->isCreated() );
-    KVS_GL_CALL( glBindTexture( m_target, m_id ) );
+    kvs::OpenGL::BindTexture( m_target, m_id );
 }
 
 /*===========================================================================*/
@@ -177,7 +177,7 @@ void Texture::bind() const
 void Texture::unbind() const
 {
     KVS_ASSERT( this->isBound() );
-    KVS_GL_CALL( glBindTexture( m_target, 0 ) );
+    kvs::OpenGL::BindTexture( m_target, 0 );
 }
 
 /*===========================================================================*/
@@ -246,6 +246,7 @@ void Texture::deleteID()
         if ( this->isBound() ) { this->unbind(); }
         KVS_GL_CALL( glDeleteTextures( 1, &m_id ) );
         m_id = 0;
+        kvs::OpenGL::InvalidateStateTracker();
     }
 }
 
@@ -802,7 +803,7 @@ Texture::Binder::~Binder()
 /*===========================================================================*/
 Texture::GuardedBinder::GuardedBinder( const Texture& texture ):
     m_texture( texture ),
-    m_id( kvs::OpenGL::Integer( texture.targetBinding() ) )
+    m_id( kvs::OpenGL::BoundTexture( texture.target(), texture.targetBinding() ) )
 {
     if ( m_texture.id() != static_cast<GLuint>( m_id ) )
     {
@@ -820,7 +821,7 @@ Texture::GuardedBinder::~GuardedBinder()
     KVS_ASSERT( m_texture.isCreated() );
     if ( static_cast<GLuint>( m_id ) != m_texture.id() )
     {
-        KVS_GL_CALL( glBindTexture( m_texture.target(), m_id ) );
+        kvs::OpenGL::BindTexture( m_texture.target(), m_id );
     }
 }
 
@@ -6,6 +6,8 @@
 /*****************************************************************************/
 #include "VertexBufferObjectManager.h"
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 
 namespace
@@ -35,6 +37,58 @@ inline GLenum GLType( const kvs::AnyValueArray& array )
     return kvs::Type::UnknownType;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the buffer range can be mapped (OpenGL 3.0 or later).
+ *  @return true if glMapBufferRange is available
+ */
+/*===========================================================================*/
+inline bool IsMapBufferRangeSupported()
+{
+#if defined( GL_VERSION_3_0 )
+    static const bool supported = std::atoi( kvs::OpenGL::Version().c_str() ) >= 3;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Loads the data to the range of the bound buffer object.
+ *  @param  buffer [in] buffer object
+ *  @param  size [in] data size in bytes
+ *  @param  data [in] pointer to the data
+ *  @param  offset [in] offset bytes in the buffer object
+ *
+ *  The range is written via the unsynchronized mapping if available, since
+ *  the range has not been used for drawing yet, which avoids the extra copy
+ *  of the data in the driver.
+ */
+/*===========================================================================*/
+inline void Load(
+    kvs::BufferObject& buffer,
+    const size_t size,
+    const GLvoid* data,
+    const size_t offset )
+{
+#if defined( GL_VERSION_3_0 )
+    if ( ::IsMapBufferRangeSupported() )
+    {
+        const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void* mapped = nullptr;
+        KVS_GL_CALL( mapped = glMapBufferRange( buffer.target(), offset, size, access ) );
+        if ( mapped )
+        {
+            std::memcpy( mapped, data, size );
+            buffer.unmap();
+            return;
+        }
+    }
+#endif
+    buffer.load( size, data, offset );
+}
+
 }
 
 namespace kvs
@@ -201,73 +255,91 @@ void VertexBufferObjectManager::setVertexAttribArray(
 /*===========================================================================*/
 void VertexBufferObjectManager::create()
 {
-    const size_t vbo_size = this->vertex_buffer_object_size();
-    if ( vbo_size > 0 )
-    {
-        m_vbo.create( vbo_size );
-        {
-            size_t offset = 0;
-            m_vbo.bind();
-            if ( m_vertex_array.size > 0 )
-            {
-                m_vertex_array.offset = offset;
-                offset += m_vbo.load(
-                    m_vertex_array.size,
-                    m_vertex_array.pointer,
-                    m_vertex_array.offset  );
-            }
+    this->allocate();
+    this->upload( this->data_size() );
+}
 
-            if ( m_color_array.size > 0 )
-            {
-                m_color_array.offset = offset;
-                offset += m_vbo.load(
-                    m_color_array.size,
-                    m_color_array.pointer,
-                    m_color_array.offset );
-            }
+/*===========================================================================*/
+/**
+ *  @brief  Allocates a vertex buffer object and an index buffer object.
+ *
+ *  The buffer objects are allocated without the data, which can be loaded
+ *  incrementally with upload(). The data arrays must be kept until the upload
+ *  is completed.
+ */
+/*===========================================================================*/
+void VertexBufferObjectManager::allocate()
+{
+    m_vbo_size = this->vertex_buffer_object_size();
+    m_ibo_size = m_vbo_size > 0 ? m_index_array.size : 0;
+    m_loaded_size = 0;
+    m_is_allocated = true;
 
-            if ( m_normal_array.size > 0 )
+    if ( m_vbo_size > 0 )
+    {
+        size_t offset = 0;
+        auto set_offset = [&] ( VertexBuffer& array )
+        {
+            if ( array.size > 0 )
             {
-                m_normal_array.offset = offset;
-                offset += m_vbo.load(
-                    m_normal_array.size,
-                    m_normal_array.pointer,
-                    m_normal_array.offset );
+                array.offset = offset;
+                offset += BufferObject::PaddedBufferSize( array.size );
             }
+        };
 
-            if ( m_tex_coord_array.size > 0 )
-            {
-                m_tex_coord_array.offset = offset;
-                offset +=  m_vbo.load(
-                    m_tex_coord_array.size,
-                    m_tex_coord_array.pointer,
-                    m_tex_coord_array.offset );
-            }
+        set_offset( m_vertex_array );
+        set_offset( m_color_array );
+        set_offset( m_normal_array );
+        set_offset( m_tex_coord_array );
+        for ( auto& array : m_vertex_attrib_arrays ) { set_offset( array ); }
 
-            for ( size_t i = 0; i < m_vertex_attrib_arrays.size(); i++ )
-            {
-                if ( m_vertex_attrib_arrays[i].size > 0 )
-                {
-                    m_vertex_attrib_arrays[i].offset = offset;
-                    offset +=  m_vbo.load(
-                        m_vertex_attrib_arrays[i].size,
-                        m_vertex_attrib_arrays[i].pointer,
-                        m_vertex_attrib_arrays[i].offset );
-                }
-            }
+        m_vbo.create( m_vbo_size );
+        if ( m_ibo_size > 0 ) { m_ibo.create( m_ibo_size ); }
+    }
+}
 
-            m_vbo.unbind();
-        }
+/*===========================================================================*/
+/**
+ *  @brief  Uploads the data to the allocated buffer objects incrementally.
+ *  @param  max_size [in] max. data size in bytes uploaded in this call
+ *  @return uploaded data size in bytes
+ */
+/*===========================================================================*/
+size_t VertexBufferObjectManager::upload( const size_t max_size )
+{
+    if ( !m_is_allocated ) { this->allocate(); }
+    if ( m_vbo_size == 0 ) { return 0; }
 
-        const size_t ibo_size = m_index_array.size;
-        if ( ibo_size > 0 )
+    size_t uploaded_size = 0;
+    size_t begin = 0; // beginning of the array in the sequence of the data arrays
+    auto load = [&] ( kvs::BufferObject& buffer, const size_t size, const GLvoid* pointer, const size_t offset )
+    {
+        const size_t end = begin + size;
+        if ( m_loaded_size < end && uploaded_size < max_size )
         {
-            m_ibo.create( ibo_size );
-            m_ibo.bind();
-            m_ibo.load( m_index_array.size, m_index_array.pointer, 0 );
-            m_ibo.unbind();
+            const size_t loaded = m_loaded_size - begin;
+            const size_t n = std::min( size - loaded, max_size - uploaded_size );
+            const GLubyte* data = static_cast<const GLubyte*>( pointer ) + loaded;
+            kvs::BufferObject::Binder binder( buffer );
+            ::Load( buffer, n, data, offset + loaded );
+            m_loaded_size += n;
+            uploaded_size += n;
         }
+        begin = end;
+    };
+
+    const VertexBuffer* arrays[] = { &m_vertex_array, &m_color_array, &m_normal_array, &m_tex_coord_array };
+    for ( const auto* array : arrays )
+    {
+        if ( array->size > 0 ) { load( m_vbo, array->size, array->pointer, array->offset ); }
     }
+    for ( const auto& array : m_vertex_attrib_arrays )
+    {
+        if ( array.size > 0 ) { load( m_vbo, array.size, array.pointer, array.offset ); }
+    }
+    if ( m_ibo_size > 0 ) { load( m_ibo, m_index_array.size, m_index_array.pointer, 0 ); }
+
+    return uploaded_size;
 }
 
 /*===========================================================================*/
@@ -303,6 +375,8 @@ void VertexBufferObjectManager::release()
     m_ibo.release();
     m_vbo_size = 0;
     m_ibo_size = 0;
+    m_loaded_size = 0;
+    m_is_allocated = false;
 
     m_vertex_array = VertexBuffer();
     m_color_array = VertexBuffer();
@@ -429,6 +503,26 @@ size_t VertexBufferObjectManager::vertex_buffer_object_size() const
     return vbo_size;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns data size to be loaded to the buffer objects.
+ *  @return data size in bytes (without padding)
+ */
+/*===========================================================================*/
+size_t VertexBufferObjectManager::data_size() const
+{
+    if ( this->vertex_buffer_object_size() == 0 ) { return 0; }
+
+    size_t size = 0;
+    size += m_vertex_array.size;
+    size += m_color_array.size;
+    size += m_normal_array.size;
+    size += m_tex_coord_array.size;
+    for ( const auto& array : m_vertex_attrib_arrays ) { size += array.size; }
+    size += m_index_array.size;
+    return size;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Enables client-side capability
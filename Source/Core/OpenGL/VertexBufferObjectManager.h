@@ -67,6 +67,8 @@ private:
     kvs::IndexBufferObject m_ibo{}; ///< index buffer object (IBO)
     size_t m_vbo_size = 0; ///< data size of VBO
     size_t m_ibo_size = 0; ///< data size of IBO
+    size_t m_loaded_size = 0; ///< data size loaded to VBO and IBO
+    bool m_is_allocated = false; ///< true if VBO and IBO are allocated
 
     VertexBuffer m_vertex_array; ///< vertex array buffer
     VertexBuffer m_color_array; ///< color array buffer
@@ -104,6 +106,9 @@ public:
     void setVertexAttribArray( const kvs::AnyValueArray& array, const size_t index, const size_t dim, const bool normalized = false, const size_t stride = 0 );
 
     void create();
+    void allocate();
+    size_t upload( const size_t max_size );
+    bool isUploaded() const { return m_is_allocated && m_loaded_size == this->data_size(); }
     void bind() const;
     void unbind() const;
     void release();
@@ -117,6 +122,7 @@ public:
 
 private:
     size_t vertex_buffer_object_size() const;
+    size_t data_size() const;
     void enable_client_state() const;
     void disable_client_state() const;
 };
@@ -0,0 +1,83 @@
+/****************************************************************************/
+/**
+ *  @file   MPSCQueue.h
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#pragma once
+#include <kvs/Noncopyable>
+#include <atomic>
+#include <utility>
+
+
+namespace kvs
+{
+
+/*==========================================================================*/
+/**
+ *  Lock-free multi-producer single-consumer queue class.
+ *
+ *  push() can be called from any thread concurrently, and pop() must be called
+ *  from a single consumer thread. The queue is an intrusive linked list with a
+ *  stub node, in which the producers are serialized only by an atomic exchange
+ *  of the head node. pop() may return false while a producer is linking the
+ *  node, and the value can be popped on the next call.
+ */
+/*==========================================================================*/
+template <typename T>
+class MPSCQueue : public kvs::Noncopyable
+{
+private:
+    struct Node
+    {
+        std::atomic<Node*> next{ nullptr }; ///< next node
+        T value{}; ///< value
+    };
+
+    std::atomic<Node*> m_head{ nullptr }; ///< last pushed node (producer side)
+    Node* m_tail = nullptr; ///< stub node (consumer side)
+
+public:
+    MPSCQueue()
+    {
+        Node* stub = new Node;
+        m_head.store( stub, std::memory_order_relaxed );
+        m_tail = stub;
+    }
+
+    ~MPSCQueue()
+    {
+        T value;
+        while ( this->pop( value ) ) {}
+        delete m_tail;
+    }
+
+    bool isEmpty() const
+    {
+        return m_tail->next.load( std::memory_order_acquire ) == nullptr;
+    }
+
+    void push( T value )
+    {
+        Node* node = new Node;
+        node->value = std::move( value );
+        Node* prev = m_head.exchange( node, std::memory_order_acq_rel );
+        prev->next.store( node, std::memory_order_release );
+    }
+
+    bool pop( T& value )
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load( std::memory_order_acquire );
+        if ( !next ) { return false; }
+
+        // The next node becomes the new stub node.
+        value = std::move( next->value );
+        next->value = T();
+        m_tail = next;
+        delete tail;
+        return true;
+    }
+};
+
+} // end of namespace kvs
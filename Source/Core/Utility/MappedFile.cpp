@@ -0,0 +1,136 @@
+/****************************************************************************/
+/**
+ *  @file   MappedFile.cpp
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#include "MappedFile.h"
+#include <kvs/Message>
+#if defined( KVS_PLATFORM_WINDOWS )
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Maps the file into memory.
+ *  @param  filename [in] filename
+ *  @return true, if the file is mapped successfully
+ */
+/*===========================================================================*/
+bool MappedFile::open( const std::string& filename )
+{
+    this->close();
+
+#if defined( KVS_PLATFORM_WINDOWS )
+    HANDLE file = ::CreateFileA(
+        filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if ( file == INVALID_HANDLE_VALUE )
+    {
+        kvsMessageError() << "Cannot open " << filename << "." << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if ( !::GetFileSizeEx( file, &size ) )
+    {
+        kvsMessageError() << "Cannot get the size of " << filename << "." << std::endl;
+        ::CloseHandle( file );
+        return false;
+    }
+
+    m_file = file;
+    m_size = static_cast<size_t>( size.QuadPart );
+    if ( m_size > 0 )
+    {
+        HANDLE mapping = ::CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+        const void* data = mapping ? ::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) : NULL;
+        if ( !data )
+        {
+            kvsMessageError() << "Cannot map " << filename << "." << std::endl;
+            if ( mapping ) { ::CloseHandle( mapping ); }
+            ::CloseHandle( file );
+            m_file = nullptr;
+            m_size = 0;
+            return false;
+        }
+        m_mapping = mapping;
+        m_data = static_cast<const unsigned char*>( data );
+    }
+#else
+    const int descriptor = ::open( filename.c_str(), O_RDONLY );
+    if ( descriptor < 0 )
+    {
+        kvsMessageError() << "Cannot open " << filename << "." << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    if ( ::fstat( descriptor, &status ) != 0 )
+    {
+        kvsMessageError() << "Cannot get the size of " << filename << "." << std::endl;
+        ::close( descriptor );
+        return false;
+    }
+
+    m_descriptor = descriptor;
+    m_size = static_cast<size_t>( status.st_size );
+    if ( m_size > 0 )
+    {
+        void* data = ::mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+        if ( data == MAP_FAILED )
+        {
+            kvsMessageError() << "Cannot map " << filename << "." << std::endl;
+            ::close( descriptor );
+            m_descriptor = -1;
+            m_size = 0;
+            return false;
+        }
+        ::madvise( data, m_size, MADV_SEQUENTIAL );
+        m_data = static_cast<const unsigned char*>( data );
+    }
+#endif
+
+    m_is_open = true;
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Unmaps the file.
+ */
+/*===========================================================================*/
+void MappedFile::close()
+{
+    if ( !m_is_open ) { return; }
+
+#if defined( KVS_PLATFORM_WINDOWS )
+    if ( m_data ) { ::UnmapViewOfFile( m_data ); }
+    if ( m_mapping ) { ::CloseHandle( m_mapping ); }
+    if ( m_file ) { ::CloseHandle( m_file ); }
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if ( m_data ) { ::munmap( const_cast<unsigned char*>( m_data ), m_size ); }
+    if ( m_descriptor >= 0 ) { ::close( m_descriptor ); }
+    m_descriptor = -1;
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_is_open = false;
+}
+
+} // end of namespace kvs
@@ -0,0 +1,52 @@
+/****************************************************************************/
+/**
+ *  @file   MappedFile.h
+ *  @author Naohisa Sakamoto
+ */
+/****************************************************************************/
+#pragma once
+#include <string>
+#include <cstddef>
+#include <kvs/Platform>
+#include <kvs/Noncopyable>
+
+
+namespace kvs
+{
+
+/*==========================================================================*/
+/**
+ *  Read-only memory-mapped file class.
+ *
+ *  The file is mapped into the address space on open() and unmapped on
+ *  close() or destruction, so that the file contents can be decoded directly
+ *  (and in parallel) without reading through the stream buffers.
+ */
+/*==========================================================================*/
+class MappedFile : public kvs::Noncopyable
+{
+private:
+    bool m_is_open = false; ///< true if the file is mapped
+    const unsigned char* m_data = nullptr; ///< pointer to the mapped data
+    size_t m_size = 0; ///< file size in bytes
+#if defined( KVS_PLATFORM_WINDOWS )
+    void* m_file = nullptr; ///< file handle
+    void* m_mapping = nullptr; ///< file mapping handle
+#else
+    int m_descriptor = -1; ///< file descriptor
+#endif
+
+public:
+    MappedFile() = default;
+    explicit MappedFile( const std::string& filename ) { this->open( filename ); }
+    ~MappedFile() { this->close(); }
+
+    bool isOpen() const { return m_is_open; }
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    bool open( const std::string& filename );
+    void close();
+};
+
+} // end of namespace kvs
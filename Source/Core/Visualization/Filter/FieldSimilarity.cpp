@@ -12,38 +12,284 @@
 /*****************************************************************************/
 #include "FieldSimilarity.h"
 #include <kvs/Assert>
+#include <kvs/OpenMP>
+#include <kvs/Math>
+#include <kvs/IgnoreUnusedVariable>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
 
 namespace
 {
 
+// Number of voxels converted to float and compared at once. The blocks of
+// all of the fields in the tile are kept in the cache during the comparison.
+const size_t BlockSize = 1024;
+
+// The voxels are divided into the fixed number of chunks, so that the partial
+// sums are reduced in the same order regardless of the number of threads.
+const size_t MaxChunks = 256;
+
 template <typename T>
+inline void Convert( const void* data, const size_t offset, const size_t count, float* dst )
+{
+    const T* src = static_cast<const T*>( data ) + offset;
+    for ( size_t i = 0; i < count; i++ ) { dst[i] = static_cast<float>( src[i] ); }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Converts the values of the array to float.
+ *  @param  array [in] value array
+ *  @param  offset [in] index of the first value
+ *  @param  count [in] number of values
+ *  @param  dst [out] converted values
+ */
+/*===========================================================================*/
+inline void Convert( const kvs::AnyValueArray& array, const size_t offset, const size_t count, float* dst )
+{
+    const void* data = array.data();
+    switch ( array.typeID() )
+    {
+    case kvs::Type::TypeInt8: ::Convert<kvs::Int8>( data, offset, count, dst ); break;
+    case kvs::Type::TypeUInt8: ::Convert<kvs::UInt8>( data, offset, count, dst ); break;
+    case kvs::Type::TypeInt16: ::Convert<kvs::Int16>( data, offset, count, dst ); break;
+    case kvs::Type::TypeUInt16: ::Convert<kvs::UInt16>( data, offset, count, dst ); break;
+    case kvs::Type::TypeInt32: ::Convert<kvs::Int32>( data, offset, count, dst ); break;
+    case kvs::Type::TypeUInt32: ::Convert<kvs::UInt32>( data, offset, count, dst ); break;
+    case kvs::Type::TypeInt64: ::Convert<kvs::Int64>( data, offset, count, dst ); break;
+    case kvs::Type::TypeUInt64: ::Convert<kvs::UInt64>( data, offset, count, dst ); break;
+    case kvs::Type::TypeReal32: ::Convert<kvs::Real32>( data, offset, count, dst ); break;
+    case kvs::Type::TypeReal64: ::Convert<kvs::Real64>( data, offset, count, dst ); break;
+    default: std::fill( dst, dst + count, 0.0f ); break;
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the sum of the values.
+ *  @param  a [in] values
+ *  @param  n [in] number of values
+ */
+/*===========================================================================*/
+inline float Sum( const float* a, const size_t n )
+{
+    float sums[8] = {};
+    size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        for ( size_t k = 0; k < 8; k++ ) { sums[k] += a[ i + k ]; }
+    }
+    float rest = 0.0f;
+    for ( ; i < n; i++ ) { rest += a[i]; }
+    return ( ( sums[0] + sums[1] ) + ( sums[2] + sums[3] ) ) + ( ( sums[4] + sums[5] ) + ( sums[6] + sums[7] ) ) + rest;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the sum of the absolute differences (L1 distance).
+ *  @param  a [in] values of the first field
+ *  @param  b [in] values of the second field
+ *  @param  n [in] number of values
+ */
+/*===========================================================================*/
+inline float AbsDiffSum( const float* a, const float* b, const size_t n )
+{
+    // Eight independent partial sums are vectorized by the compiler, which
+    // cannot reorder a single floating-point reduction.
+    float sums[8] = {};
+    size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        for ( size_t k = 0; k < 8; k++ ) { sums[k] += std::fabs( a[ i + k ] - b[ i + k ] ); }
+    }
+    float rest = 0.0f;
+    for ( ; i < n; i++ ) { rest += std::fabs( a[i] - b[i] ); }
+    return ( ( sums[0] + sums[1] ) + ( sums[2] + sums[3] ) ) + ( ( sums[4] + sums[5] ) + ( sums[6] + sums[7] ) ) + rest;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the sums of the fields and the L1 distances for all of
+ *          the pairs of the fields in the two tiles.
+ *  @param  tile0 [in] values of the fields in the first tile
+ *  @param  tile1 [in] values of the fields in the second tile
+ *  @param  sums0 [out] sums of the values of the fields in the first tile
+ *  @param  sums1 [out] sums of the values of the fields in the second tile
+ *  @param  distances [out] L1 distances (tile0.size() x tile1.size())
+ */
+/*===========================================================================*/
+inline void TileSums(
+    const std::vector<kvs::AnyValueArray>& tile0,
+    const std::vector<kvs::AnyValueArray>& tile1,
+    std::vector<double>& sums0,
+    std::vector<double>& sums1,
+    std::vector<double>& distances )
+{
+    const size_t n0 = tile0.size();
+    const size_t n1 = tile1.size();
+    const size_t npairs = n0 * n1;
+    const size_t nsums = n0 + n1 + npairs;
+    const size_t nvoxels = tile0[0].size();
+    const size_t nblocks = ( nvoxels + BlockSize - 1 ) / BlockSize;
+    const size_t nchunks = kvs::Math::Max( size_t(1), kvs::Math::Min( MaxChunks, nblocks ) );
+
+    // Partial sums of each chunk: n0 + n1 field sums followed by the npairs
+    // distances.
+    std::vector<double> chunk_sums( nchunks * nsums, 0.0 );
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long c = 0; c < long( nchunks ); c++ )
+    {
+        // Each block of the fields is converted only once and compared with
+        // all of the fields in the other tile.
+        std::vector<float> buffer( ( n0 + n1 ) * BlockSize );
+        double* csums = chunk_sums.data() + c * nsums;
+        double* cdistances = csums + n0 + n1;
+        const size_t b0 = nblocks * c / nchunks;
+        const size_t b1 = nblocks * ( c + 1 ) / nchunks;
+        for ( size_t b = b0; b < b1; b++ )
+        {
+            const size_t offset = b * BlockSize;
+            const size_t count = kvs::Math::Min( BlockSize, nvoxels - offset );
+            for ( size_t i = 0; i < n0; i++ ) { ::Convert( tile0[i], offset, count, buffer.data() + i * BlockSize ); }
+            for ( size_t j = 0; j < n1; j++ ) { ::Convert( tile1[j], offset, count, buffer.data() + ( n0 + j ) * BlockSize ); }
+            for ( size_t i = 0; i < n0 + n1; i++ ) { csums[i] += ::Sum( buffer.data() + i * BlockSize, count ); }
+
+            for ( size_t i = 0; i < n0; i++ )
+            {
+                const float* a = buffer.data() + i * BlockSize;
+                for ( size_t j = 0; j < n1; j++ )
+                {
+                    const float* v = buffer.data() + ( n0 + j ) * BlockSize;
+                    cdistances[ i * n1 + j ] += ::AbsDiffSum( a, v, count );
+                }
+            }
+        }
+    }
+
+    std::vector<double> totals( nsums, 0.0 );
+    for ( size_t c = 0; c < nchunks; c++ )
+    {
+        for ( size_t k = 0; k < nsums; k++ ) { totals[k] += chunk_sums[ c * nsums + k ]; }
+    }
+    sums0.assign( totals.begin(), totals.begin() + n0 );
+    sums1.assign( totals.begin() + n0, totals.begin() + n0 + n1 );
+    distances.assign( totals.begin() + n0 + n1, totals.end() );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the similarity of the two fields.
+ *  @param  nvoxels [in] number of voxels
+ *  @param  max_value [in] max. value used for the normalization
+ *  @param  sum [in] sum of the values of the both fields
+ *  @param  distance [in] L1 distance between the fields
+ *
+ *  With the normalized value v' = (v - min_value) / (max_value - min_value),
+ *  the similarity sum(1 - max(v0',v1')) / sum(1 - min(v0',v1')) is equal to
+ *  (n max_value - sum(max(v0,v1))) / (n max_value - sum(min(v0,v1))). The
+ *  sums of min. and max. values are obtained from the sums of the fields and
+ *  the L1 distance, since min(a,b) + max(a,b) = a + b and
+ *  max(a,b) - min(a,b) = |a - b|. Therefore, only the L1 distance has to be
+ *  calculated for each pair.
+ */
+/*===========================================================================*/
 inline float Similarity(
-    const kvs::ValueArray<T>& values0,
-    const kvs::ValueArray<T>& values1,
-    const float min_value,
-    const float max_value )
+    const size_t nvoxels,
+    const double max_value,
+    const double sum,
+    const double distance )
+{
+    const double n = static_cast<double>( nvoxels );
+    const double min_sum = 0.5 * ( sum - distance );
+    const double max_sum = 0.5 * ( sum + distance );
+    return static_cast<float>( ( n * max_value - max_sum ) / ( n * max_value - min_sum ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Loads the fields in the tile.
+ *  @param  volumes [in] volume object list
+ *  @param  begin [in] index of the first volume
+ *  @param  end [in] index of the end volume
+ *  @param  values [out] values of the fields
+ *  @param  max_values [out] max. values of the fields
+ */
+/*===========================================================================*/
+inline void LoadTile(
+    const kvs::StructuredVolumeObjectList& volumes,
+    const size_t begin,
+    const size_t end,
+    std::vector<kvs::AnyValueArray>& values,
+    std::vector<double>& max_values )
 {
-    const auto f = 1.0f / ( max_value - min_value );
-    auto normalize = [&] ( const float value )
+    values.clear();
+    max_values.clear();
+    for ( size_t i = begin; i < end; i++ )
     {
-        return ( value - min_value ) * f;
-    };
+        const auto volume = volumes.load( i );
+        if ( !volume.hasMinMaxValues() ) { volume.updateMinMaxValues(); }
+        KVS_ASSERT( values.empty() || values[0].size() == volume.values().size() );
+        values.push_back( volume.values() );
+        max_values.push_back( volume.maxValue() );
+    }
+}
 
-    float min = 0.0f;
-    float max = 0.0f;
-    const size_t size = values0.size();
+/*===========================================================================*/
+/**
+ *  @brief  Returns the similarity matrix of the fields.
+ *  @param  volumes [in] volume object list
+ *  @param  has_max_value [in] if true, max_value is used for all of the pairs
+ *  @param  max_value [in] max. value
+ *  @param  tile_size [in] number of fields in the tile
+ *
+ *  The fields are processed by the tiles of the similarity matrix. At most
+ *  two tiles of the fields are loaded at the same time, and the fields are
+ *  loaded O(N^2 / tile_size) times instead of O(N^2) times.
+ */
+/*===========================================================================*/
+inline kvs::Matrix<float> SimilarityMatrix(
+    const kvs::StructuredVolumeObjectList& volumes,
+    const bool has_max_value,
+    const double max_value,
+    const size_t tile_size )
+{
+    const size_t nvolumes = volumes.size();
+    const size_t ts = kvs::Math::Max( size_t(1), tile_size );
+    kvs::Matrix<float> s( nvolumes, nvolumes );
+    for ( size_t i = 0; i < nvolumes; i++ ) { s[i][i] = 1.0f; }
 
-    #pragma omp parallel for reduction(+:min,max)
-    for ( size_t i = 0; i < size; ++i )
+    std::vector<kvs::AnyValueArray> tile0, tile1;
+    std::vector<double> max0, max1, sums0, sums1, distances;
+    for ( size_t i0 = 0; i0 < nvolumes; i0 += ts )
     {
-        const auto v0 = normalize( static_cast<float>( values0[i] ) );
-        const auto v1 = normalize( static_cast<float>( values1[i] ) );
-        min += 1.0f - std::min( v0, v1 );
-        max += 1.0f - std::max( v0, v1 );
+        const size_t i1 = kvs::Math::Min( nvolumes, i0 + ts );
+        ::LoadTile( volumes, i0, i1, tile0, max0 );
+        for ( size_t j0 = i0; j0 < nvolumes; j0 += ts )
+        {
+            const size_t j1 = kvs::Math::Min( nvolumes, j0 + ts );
+            if ( j0 == i0 ) { tile1 = tile0; max1 = max0; }
+            else { ::LoadTile( volumes, j0, j1, tile1, max1 ); }
+
+            ::TileSums( tile0, tile1, sums0, sums1, distances );
+
+            const size_t nvoxels = tile0[0].size();
+            for ( size_t i = i0; i < i1; i++ )
+            {
+                for ( size_t j = kvs::Math::Max( j0, i + 1 ); j < j1; j++ )
+                {
+                    const size_t p = ( i - i0 ) * ( j1 - j0 ) + ( j - j0 );
+                    const double m = has_max_value ? max_value : kvs::Math::Max( max0[ i - i0 ], max1[ j - j0 ] );
+                    const double sum = sums0[ i - i0 ] + sums1[ j - j0 ];
+                    s[i][j] = ::Similarity( nvoxels, m, sum, distances[p] );
+                    s[j][i] = s[i][j];
+                }
+            }
+        }
     }
 
-    return max / min;
+    return s;
 }
 
 } // end of namespace
@@ -72,85 +318,30 @@ float FieldSimilarity(
     KVS_ASSERT( volume0.volumeType() == volume1.volumeType() );
     KVS_ASSERT( volume0.values().size() == volume1.values().size() );
     KVS_ASSERT( volume0.values().typeID() == volume1.values().typeID() );
+    kvs::IgnoreUnusedVariable( min_value );
 
-    const auto values0 = volume0.values();
-    const auto values1 = volume1.values();
-    switch ( volume0.values().typeID() )
-    {
-    case kvs::Type::TypeInt8:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::Int8>(),
-            values1.asValueArray<kvs::Int8>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeInt16:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::Int16>(),
-            values1.asValueArray<kvs::Int16>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeInt32:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::Int32>(),
-            values1.asValueArray<kvs::Int32>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeInt64:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::Int64>(),
-            values1.asValueArray<kvs::Int64>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeUInt8:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::UInt8>(),
-            values1.asValueArray<kvs::UInt8>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeUInt16:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::UInt16>(),
-            values1.asValueArray<kvs::UInt16>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeUInt32:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::UInt32>(),
-            values1.asValueArray<kvs::UInt32>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeUInt64:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::UInt64>(),
-            values1.asValueArray<kvs::UInt64>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeReal32:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::Real32>(),
-            values1.asValueArray<kvs::Real32>(),
-            min_value, max_value );
-    }
-    case kvs::Type::TypeReal64:
-    {
-        return ::Similarity(
-            values0.asValueArray<kvs::Real64>(),
-            values1.asValueArray<kvs::Real64>(),
-            min_value, max_value );
-    }
-    default: break;
-    }
+    const std::vector<kvs::AnyValueArray> tile0( 1, volume0.values() );
+    const std::vector<kvs::AnyValueArray> tile1( 1, volume1.values() );
+    std::vector<double> sums0, sums1, distances;
+    ::TileSums( tile0, tile1, sums0, sums1, distances );
+    return ::Similarity( volume0.values().size(), max_value, sums0[0] + sums1[0], distances[0] );
+}
 
-    return 0.0f;
+kvs::Matrix<float> FieldSimilarityMatrix(
+    const kvs::StructuredVolumeObjectList& volumes,
+    const size_t tile_size )
+{
+    return ::SimilarityMatrix( volumes, false, 0.0, tile_size );
+}
+
+kvs::Matrix<float> FieldSimilarityMatrix(
+    const kvs::StructuredVolumeObjectList& volumes,
+    const float min_value,
+    const float max_value,
+    const size_t tile_size )
+{
+    kvs::IgnoreUnusedVariable( min_value );
+    return ::SimilarityMatrix( volumes, true, max_value, tile_size );
 }
 
 } // end of namespace kvs
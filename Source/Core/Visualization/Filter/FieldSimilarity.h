@@ -12,6 +12,8 @@
 /*****************************************************************************/
 #pragma once
 #include <kvs/VolumeObjectBase>
+#include <kvs/StructuredVolumeObjectList>
+#include <kvs/Matrix>
 
 
 namespace kvs
@@ -27,4 +29,14 @@ float FieldSimilarity(
     const float min_value,
     const float max_value );
 
+kvs::Matrix<float> FieldSimilarityMatrix(
+    const kvs::StructuredVolumeObjectList& volumes,
+    const size_t tile_size = 8 );
+
+kvs::Matrix<float> FieldSimilarityMatrix(
+    const kvs::StructuredVolumeObjectList& volumes,
+    const float min_value,
+    const float max_value,
+    const size_t tile_size = 8 );
+
 } // end of namespace kvs
@@ -203,6 +203,7 @@ void KMeansClustering::adaptive_kmeans( const kvs::TableObject* object )
     const size_t max_nclusters = m_nclusters > 0 ? m_nclusters : 100;
 
     kvs::AdaptiveKMeans kmeans;
+    kmeans.setSeed( m_seed );
     kmeans.setMaxNumberOfClusters( max_nclusters );
     kmeans.setMaxIterations( m_max_iterations );
     kmeans.setTolerance( m_tolerance );
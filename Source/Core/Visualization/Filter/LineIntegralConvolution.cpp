@@ -8,6 +8,330 @@
 #include <kvs/DebugNew>
 #include <kvs/MersenneTwister>
 #include <kvs/Vector3>
+#include <kvs/OpenMP>
+#include <vector>
+
+
+namespace
+{
+
+// Number of the seed voxels traced at a time. The seeds that have been hit by
+// the streamlines of the previous batches are skipped.
+const size_t BatchSize = 1024;
+
+// Number of the seed voxels traced by a single thread at a time.
+const size_t ChunkSize = 32;
+
+// Stride of the lattice of the seed voxels. The seed voxels are picked from
+// the interleaved lattices (SeedStride^3 sets) so that the streamlines in a
+// batch are spread over the whole volume.
+const size_t SeedStride = 4;
+
+// Minimum length of the streamline extended beyond the filter kernel.
+const double MinExtension = 16.0;
+
+// Maximum number of the hits accumulated into a voxel.
+const kvs::UInt16 MaxHits = 65535;
+
+struct Step
+{
+    kvs::UInt32 index; ///< voxel index
+    float length; ///< length of the streamline segment in the voxel
+    float noise; ///< noise value of the voxel
+};
+
+struct Contribution
+{
+    kvs::UInt32 index; ///< voxel index
+    float value; ///< convolved value
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the resolution at the specified level.
+ *  @param  resolution [in] resolution of the input volume
+ *  @param  level [in] resolution level
+ *  @return resolution (1/2^level of the input resolution)
+ */
+/*===========================================================================*/
+inline kvs::Vec3ui Resolution( const kvs::Vec3ui& resolution, const size_t level )
+{
+    const size_t f = size_t(1) << level;
+    return kvs::Vec3ui(
+        kvs::UInt32( ( resolution.x() + f - 1 ) / f ),
+        kvs::UInt32( ( resolution.y() + f - 1 ) / f ),
+        kvs::UInt32( ( resolution.z() + f - 1 ) / f ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the vector field sampled at the specified level.
+ *  @param  values [in] vector values of the input volume
+ *  @param  resolution [in] resolution of the input volume
+ *  @param  level [in] resolution level
+ *  @return vector values at the resolution of the level
+ */
+/*===========================================================================*/
+template <typename T>
+inline kvs::ValueArray<T> Downsample( const T* values, const kvs::Vec3ui& resolution, const size_t level )
+{
+    const kvs::Vec3ui r = ::Resolution( resolution, level );
+    const size_t f = size_t(1) << level;
+    kvs::ValueArray<T> dst( size_t( r.x() ) * r.y() * r.z() * 3 );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long k = 0; k < long( r.z() ); k++ )
+    {
+        const size_t sk = size_t(k) * f;
+        for ( size_t j = 0; j < r.y(); j++ )
+        {
+            const size_t sj = j * f;
+            T* d = dst.data() + ( ( size_t(k) * r.y() + j ) * r.x() ) * 3;
+            for ( size_t i = 0; i < r.x(); i++, d += 3 )
+            {
+                const size_t si = i * f;
+                const T* s = values + ( ( sk * resolution.y() + sj ) * resolution.x() + si ) * 3;
+                d[0] = s[0]; d[1] = s[1]; d[2] = s[2];
+            }
+        }
+    }
+    return dst;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Traces the streamline by walking the voxels from the seed voxel.
+ *  @param  field [in] vector values
+ *  @param  noise [in] noise values
+ *  @param  r [in] resolution
+ *  @param  seed [in] index of the seed voxel
+ *  @param  direction [in] 1 for the forward and -1 for the backward tracing
+ *  @param  max_length [in] maximum length of the streamline
+ *  @param  steps [out] voxels passed by the streamline
+ *  @return true if the streamline reached the maximum length
+ */
+/*===========================================================================*/
+template <typename T>
+inline bool Trace(
+    const T* field,
+    const kvs::UInt8* noise,
+    const kvs::Vec3ui& r,
+    const kvs::Vec3i& seed,
+    const T direction,
+    const T max_length,
+    std::vector<Step>& steps )
+{
+    steps.clear();
+
+    const long stride[3] = { 1, long( r.x() ), long( r.x() ) * long( r.y() ) };
+    const size_t max_steps = size_t( max_length * 4 ) + 16;
+
+    kvs::Vec3i p = seed;
+    kvs::Vector3<T> entry_pos( T( p[0] + 0.5 ), T( p[1] + 0.5 ), T( p[2] + 0.5 ) );
+    long loc = p[0] + stride[1] * p[1] + stride[2] * p[2];
+
+    T acc_length = T(0);
+    for ( size_t n = 0; acc_length < max_length && n < max_steps; n++ )
+    {
+        const kvs::Vector3<T> u = direction * kvs::Vector3<T>( field + 3 * loc );
+
+        T t_min = T( 1.0e+10 );
+        int l_min = -1;
+        for ( int l = 0; l < 3; l++ )
+        {
+            if ( kvs::Math::IsZero( u[l] ) ) { continue; }
+
+            const T face = u[l] < T(0) ? T( p[l] ) : T( p[l] + 1 );
+            const T t = kvs::Math::Max( ( face - entry_pos[l] ) / u[l], T(0) );
+            if ( t < t_min ) { t_min = t; l_min = l; }
+        }
+
+        // Stagnation point.
+        if ( l_min == -1 ) { return false; }
+
+        const T length = t_min * static_cast<T>( u.length() );
+        if ( !kvs::Math::IsZero( length ) )
+        {
+            const Step step = { kvs::UInt32( loc ), float( length ), float( noise[loc] ) };
+            steps.push_back( step );
+            acc_length += length;
+        }
+
+        // Move to the neighboring voxel.
+        const int inc = u[l_min] < T(0) ? -1 : 1;
+        entry_pos += u * t_min;
+        entry_pos[l_min] = T( inc < 0 ? p[l_min] : p[l_min] + 1 );
+        p[l_min] += inc;
+        loc += inc * stride[l_min];
+
+        if ( p[l_min] < 0 || p[l_min] >= int( r[l_min] ) ) { return false; }
+    }
+
+    return acc_length >= max_length;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolves the noise along the streamline from the seed voxel.
+ *  @param  backward [in] voxels passed by the backward streamline
+ *  @param  forward [in] voxels passed by the forward streamline
+ *  @param  backward_reached [in] true if the backward streamline is not terminated
+ *  @param  forward_reached [in] true if the forward streamline is not terminated
+ *  @param  half_length [in] half length of the filter kernel
+ *  @param  steps [out] voxels passed by the whole streamline (work buffer)
+ *  @param  sums [out] prefix sums of the length and the noise (work buffer)
+ *  @param  contributions [out] convolved values of the voxels on the streamline
+ */
+/*===========================================================================*/
+inline void Convolve(
+    const std::vector<Step>& backward,
+    const std::vector<Step>& forward,
+    const bool backward_reached,
+    const bool forward_reached,
+    const double half_length,
+    std::vector<Step>& steps,
+    std::vector<double>& sums,
+    std::vector<Contribution>& contributions )
+{
+    contributions.clear();
+
+    // Streamline from the backward end to the forward end. The segments in the
+    // seed voxel are merged.
+    steps.assign( backward.rbegin(), backward.rend() );
+    if ( !steps.empty() && !forward.empty() && steps.back().index == forward.front().index )
+    {
+        steps.back().length += forward.front().length;
+        steps.insert( steps.end(), forward.begin() + 1, forward.end() );
+    }
+    else
+    {
+        steps.insert( steps.end(), forward.begin(), forward.end() );
+    }
+
+    // Prefix sums of the length and the length-weighted noise, stored as
+    // (length, noise) pairs.
+    const size_t n = steps.size();
+    sums.resize( 2 * ( n + 1 ) );
+    sums[0] = 0.0;
+    sums[1] = 0.0;
+    for ( size_t t = 0; t < n; t++ )
+    {
+        sums[ 2 * t + 2 ] = sums[ 2 * t ] + steps[t].length;
+        sums[ 2 * t + 3 ] = sums[ 2 * t + 1 ] + double( steps[t].length ) * steps[t].noise;
+    }
+
+    // Running box filter over the centers of the segments. The voxels whose
+    // kernel is cut off by the tracing length are left for the other
+    // streamlines.
+    const double total_length = sums[ 2 * n ];
+    size_t lower = 0;
+    size_t upper = 0;
+    for ( size_t t = 0; t < n; t++ )
+    {
+        const double center = sums[ 2 * t ] + 0.5 * steps[t].length;
+        while ( sums[ 2 * lower ] + 0.5 * steps[lower].length < center - half_length ) { lower++; }
+        while ( upper < n && sums[ 2 * upper ] + 0.5 * steps[upper].length <= center + half_length ) { upper++; }
+
+        if ( backward_reached && center - half_length < 0.0 ) { continue; }
+        if ( forward_reached && center + half_length > total_length ) { continue; }
+
+        const double length = sums[ 2 * upper ] - sums[ 2 * lower ];
+        const double value = sums[ 2 * upper + 1 ] - sums[ 2 * lower + 1 ];
+        const Contribution c = { steps[t].index, float( value / length ) };
+        contributions.push_back( c );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Convolves the noise along the streamlines from the seed voxels.
+ *  @param  field [in] vector values
+ *  @param  noise [in] noise values
+ *  @param  r [in] resolution
+ *  @param  seeds [in] indices of the seed voxels
+ *  @param  max_length [in] maximum length of the streamline in each direction
+ *  @param  half_length [in] half length of the filter kernel
+ *  @param  sums [in/out] sums of the convolved values
+ *  @param  hits [in/out] number of the hits
+ */
+/*===========================================================================*/
+template <typename T>
+inline void ConvolveSeeds(
+    const T* field,
+    const kvs::UInt8* noise,
+    const kvs::Vec3ui& r,
+    const std::vector<kvs::UInt32>& seeds,
+    const T max_length,
+    const double half_length,
+    kvs::ValueArray<float>& sums,
+    kvs::ValueArray<kvs::UInt16>& hits )
+{
+    // The voxels are divided into the slabs, and the contributions to each
+    // slab are accumulated by a single thread in the order of the seeds, so
+    // that the result does not depend on the number of threads.
+    const size_t nnodes = sums.size();
+    const size_t nslabs = size_t( kvs::Math::Max( kvs::OpenMP::GetMaxThreads(), 1 ) );
+    const size_t nchunks = ( seeds.size() + ChunkSize - 1 ) / ChunkSize;
+    std::vector<std::vector<Contribution> > buckets( nchunks * nslabs );
+
+    // Trace the streamlines from the seeds in parallel.
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long c = 0; c < long( nchunks ); c++ )
+    {
+        std::vector<Step> backward;
+        std::vector<Step> forward;
+        std::vector<Step> steps;
+        std::vector<double> prefix_sums;
+        std::vector<Contribution> contributions;
+        const size_t s0 = size_t(c) * ChunkSize;
+        const size_t s1 = kvs::Math::Min( seeds.size(), s0 + ChunkSize );
+        for ( size_t s = s0; s < s1; s++ )
+        {
+            const size_t seed = seeds[s];
+            const kvs::Vec3i p(
+                int( seed % r.x() ),
+                int( ( seed / r.x() ) % r.y() ),
+                int( seed / ( size_t( r.x() ) * r.y() ) ) );
+
+            const bool b = ::Trace( field, noise, r, p, T(-1), max_length, backward );
+            const bool f = ::Trace( field, noise, r, p, T(1), max_length, forward );
+            if ( backward.empty() && forward.empty() )
+            {
+                // The seed is on the stagnation point.
+                const Contribution contribution = { kvs::UInt32( seed ), float( noise[seed] ) };
+                buckets[ c * nslabs + seed * nslabs / nnodes ].push_back( contribution );
+                continue;
+            }
+
+            ::Convolve( backward, forward, b, f, half_length, steps, prefix_sums, contributions );
+            for ( size_t t = 0; t < contributions.size(); t++ )
+            {
+                const size_t slab = size_t( contributions[t].index ) * nslabs / nnodes;
+                buckets[ c * nslabs + slab ].push_back( contributions[t] );
+            }
+        }
+    }
+
+    // Accumulate the contributions.
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long slab = 0; slab < long( nslabs ); slab++ )
+    {
+        for ( size_t c = 0; c < nchunks; c++ )
+        {
+            const std::vector<Contribution>& bucket = buckets[ c * nslabs + slab ];
+            for ( size_t t = 0; t < bucket.size(); t++ )
+            {
+                const size_t index = bucket[t].index;
+                if ( hits[index] < MaxHits )
+                {
+                    sums[index] += bucket[t].value;
+                    hits[index]++;
+                }
+            }
+        }
+    }
+}
+
+} // end of namespace
 
 
 namespace kvs
@@ -20,7 +344,8 @@ namespace kvs
 /*===========================================================================*/
 LineIntegralConvolution::LineIntegralConvolution():
     m_length( 0.0 ),
-    m_noise( NULL )
+    m_noise( NULL ),
+    m_resolution_level( 0 )
 {
 }
 
@@ -31,7 +356,8 @@ LineIntegralConvolution::LineIntegralConvolution():
  */
 /*===========================================================================*/
 LineIntegralConvolution::LineIntegralConvolution( const kvs::StructuredVolumeObject* volume ):
-    m_noise( NULL )
+    m_noise( NULL ),
+    m_resolution_level( 0 )
 {
     const kvs::Vector3ui& r = volume->resolution();
     m_length = kvs::Math::Max<double>( r.x(), r.y(), r.z() ) * 0.1;
@@ -47,7 +373,8 @@ LineIntegralConvolution::LineIntegralConvolution( const kvs::StructuredVolumeObj
 /*===========================================================================*/
 LineIntegralConvolution::LineIntegralConvolution( const kvs::StructuredVolumeObject* volume, const double length ):
     m_length( length ),
-    m_noise( NULL )
+    m_noise( NULL ),
+    m_resolution_level( 0 )
 {
     this->exec( volume );
 }
@@ -141,25 +468,28 @@ void LineIntegralConvolution::filtering( const kvs::StructuredVolumeObject* volu
 /*===========================================================================*/
 void LineIntegralConvolution::create_noise_volume( const kvs::StructuredVolumeObject* volume )
 {
-    //kvs::StructuredVolumeObject::Values data;
-    kvs::ValueArray<kvs::UInt8> data( volume->numberOfNodes() );
+    const kvs::Vec3ui resolution = ::Resolution( volume->resolution(), m_resolution_level );
+    const size_t nnodes = size_t( resolution.x() ) * resolution.y() * resolution.z();
+
+    kvs::ValueArray<kvs::UInt8> data( nnodes );
     kvs::UInt8* pdata = data.data();
 
     // Random number generator. R = [0,1)
     kvs::MersenneTwister R;
 
     // Create a white noise volume.
-    for ( size_t i = 0; i < volume->numberOfNodes(); i++ )
+    for ( size_t i = 0; i < nnodes; i++ )
     {
         *(pdata++) = static_cast<kvs::UInt8>( R() * 255.0 );
     }
 
     // Copy the white noise volume to m_noise.
+    if ( m_noise ) { delete m_noise; }
     m_noise = new kvs::StructuredVolumeObject();
     m_noise->setVeclen( 1 );
     m_noise->setValues( kvs::AnyValueArray( data ) );
     m_noise->setGridType( Uniform );
-    m_noise->setResolution( volume->resolution() );
+    m_noise->setResolution( resolution );
 }
 
 /*===========================================================================*/
@@ -171,131 +501,71 @@ void LineIntegralConvolution::create_noise_volume( const kvs::StructuredVolumeOb
 template <typename T>
 void LineIntegralConvolution::convolution( const kvs::StructuredVolumeObject* volume )
 {
-    kvs::Vector3<T> u;         // vector of node
-    kvs::Vector3<T> p;         // position of node
-    kvs::Vector3<T> travel_t;  //
-    kvs::Vector3<T> entry_pos; //
+    const kvs::Vec3ui resol = m_noise->resolution();
+    const size_t nnodes = m_noise->numberOfNodes();
+    const kvs::UInt8* noise_data = static_cast<const kvs::UInt8*>( m_noise->values().data() );
+
+    // Vector field at the resolution level.
+    const T* src_data = static_cast<const T*>( volume->values().data() );
+    kvs::ValueArray<T> coarse_data;
+    if ( m_resolution_level > 0 )
+    {
+        coarse_data = ::Downsample( src_data, volume->resolution(), m_resolution_level );
+        src_data = coarse_data.data();
+    }
 
-    const kvs::UInt8*           noise_data = static_cast<const kvs::UInt8*>( m_noise->values().data() );
-    const T*                    src_data = static_cast<const T*>( volume->values().data() );
+    // The stream length is given in the voxel unit of the input volume.
+    const double half_length = 0.5 * m_length / double( size_t(1) << m_resolution_level );
+    const T max_length = T( half_length + kvs::Math::Max( 2.0 * half_length, MinExtension ) );
 
-    kvs::ValueArray<kvs::UInt8> dst_data( volume->numberOfNodes() );
+    // The convolved values of the streamlines are accumulated with the number
+    // of hits, and the output value is the average of them.
+    kvs::ValueArray<float> sums( nnodes );
+    kvs::ValueArray<kvs::UInt16> hits( nnodes );
+    sums.fill( 0.0f );
+    hits.fill( 0 );
 
-    const kvs::Vector3ui resol( volume->resolution() );
+    std::vector<kvs::UInt32> seeds;
+    seeds.reserve( BatchSize );
 
-    unsigned int counter = 0;
-    for( size_t k = 0; k < resol.z(); k++ )
+    const size_t noffsets = SeedStride * SeedStride * SeedStride;
+    for ( size_t offset = 0; offset < noffsets; offset++ )
     {
-        for( size_t j = 0; j < resol.y(); j++ )
+        const size_t ox = offset % SeedStride;
+        const size_t oy = ( offset / SeedStride ) % SeedStride;
+        const size_t oz = offset / ( SeedStride * SeedStride );
+        for ( size_t k = oz; k < resol.z(); k += SeedStride )
         {
-            for( size_t i = 0; i < resol.x(); i++ )
+            for ( size_t j = oy; j < resol.y(); j += SeedStride )
             {
-                int i_c = i;
-                int j_c = j;
-                int k_c = k;
-
-                T acc_length = T(0);
-                T acc_data   = T(0);
-
-                unsigned int loc_c = counter;
-
-                for( int m = 1; m > -2; m -= 2  )
+                for ( size_t i = ox; i < resol.x(); i += SeedStride )
                 {
-                    i_c = i;
-                    j_c = j;
-                    k_c = k;
+                    const size_t index = ( k * resol.y() + j ) * resol.x() + i;
+                    if ( hits[index] > 0 ) { continue; }
 
-                    entry_pos[0] = T( i + 0.5 );
-                    entry_pos[1] = T( j + 0.5 );
-                    entry_pos[2] = T( k + 0.5 );
-
-                    loc_c = counter;
-
-                    while( acc_length < m_length )
+                    seeds.push_back( kvs::UInt32( index ) );
+                    if ( seeds.size() == BatchSize )
                     {
-                        T   t_min = 1.0e+10;
-                        int l_min = -1;
-                        int inc;
-
-                        int scalar = noise_data[loc_c];
-
-                        u = (T)m * kvs::Vector3<T>( src_data + 3 * loc_c );
-
-                        p[0] = T( i_c );
-                        p[1] = T( j_c );
-                        p[2] = T( k_c );
-
-                        for( int l = 0; l < 3; l++ )
-                        {
-                            if( kvs::Math::IsZero( u[l] ) )
-                            {
-                                travel_t[l] = T( 1.1e+10 );
-                            }
-                            else if( u[l] < T(0) )
-                            {
-                                travel_t[l] = ( p[l] - entry_pos[l] ) / u[l];
-                            }
-                            else
-                            {
-                                travel_t[l] = ( p[l] + 1 - entry_pos[l] ) / u[l];
-                            }
-
-                            if( travel_t[l] < t_min )
-                            {
-                                t_min = travel_t[l];
-                                l_min = l;
-                            }
-                        }
-
-                        if( l_min == -1 ) break;
-
-                        entry_pos += u * t_min;
-
-                        inc = u[l_min] < T(0) ? -1 : 1;
-
-                        if( l_min == 0 )
-                        {
-                            loc_c += inc;
-                            i_c   += inc;
-                        }
-                        else if( l_min == 1 )
-                        {
-                            loc_c += inc * resol.x();
-                            j_c   += inc;
-                        }
-                        else if( l_min == 2 )
-                        { 
-                            loc_c += inc * resol.x() * resol.y();
-                            k_c   += inc;
-                        }
-
-                        T length = t_min * static_cast<T>( u.length() );
-
-                        /* For small length (close to 0.0) it enters in a infinite loop */
-                        if( kvs::Math::IsZero( length ) ) length = T( 1.1e+10 );
-
-                        if( acc_length < 1.1e-10 ) acc_length = T(0);
-
-                        acc_data   += length * scalar;
-                        acc_length += length;
-
-                        if( i_c < 0 || i_c >= static_cast<int>(resol.x()) ||
-                            j_c < 0 || j_c >= static_cast<int>(resol.y()) ||
-                            k_c < 0 || k_c >= static_cast<int>(resol.z()) ) break;
+                        ::ConvolveSeeds( src_data, noise_data, resol, seeds, max_length, half_length, sums, hits );
+                        seeds.clear();
                     }
                 }
-
-                acc_data /= acc_length;
-                dst_data[counter] = (kvs::UInt8)( (int)(acc_data) % 256 );
-
-                counter++;
             }
         }
     }
+    ::ConvolveSeeds( src_data, noise_data, resol, seeds, max_length, half_length, sums, hits );
+
+    kvs::ValueArray<kvs::UInt8> dst_data( nnodes );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < long( nnodes ); i++ )
+    {
+        const float value = hits[i] > 0 ? sums[i] / hits[i] : float( noise_data[i] );
+        dst_data[i] = static_cast<kvs::UInt8>( kvs::Math::Clamp( int( value ), 0, 255 ) );
+    }
 
     SuperClass::setGridType( volume->gridType() );
     SuperClass::setVeclen( 1 );
-    SuperClass::setResolution( volume->resolution() );
+    SuperClass::setResolution( resol );
     SuperClass::setValues( kvs::AnyValueArray( dst_data ) );
     SuperClass::setMinMaxValues( 0, 255 );
 }
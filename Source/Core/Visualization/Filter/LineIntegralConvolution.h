@@ -18,6 +18,13 @@ namespace kvs
 /*===========================================================================*/
 /**
  *  @brief  LIC class.
+ *
+ *  The convolution is calculated in the manner of Fast-LIC. A long streamline
+ *  traced from a seed voxel is convolved with a running box filter, and the
+ *  result is accumulated into all of the voxels passed by the streamline. The
+ *  seed voxels that have already been hit are skipped. The resolution level
+ *  can be specified for the coarse-to-fine preview, where the level n computes
+ *  the LIC volume with 1/2^n resolution of the input volume.
  */
 /*===========================================================================*/
 class LineIntegralConvolution : public kvs::FilterBase, public kvs::StructuredVolumeObject
@@ -30,6 +37,7 @@ protected:
 
     double m_length; ///< stream length
     kvs::StructuredVolumeObject* m_noise; ///< white noise volume
+    size_t m_resolution_level; ///< resolution level (0: full resolution)
 
 public:
 
@@ -39,6 +47,9 @@ public:
     virtual ~LineIntegralConvolution();
 
     void setLength( const double length );
+    void setResolutionLevel( const size_t level ) { m_resolution_level = level; }
+    double length() const { return m_length; }
+    size_t resolutionLevel() const { return m_resolution_level; }
 
     SuperClass* exec( const kvs::ObjectBase* object );
 
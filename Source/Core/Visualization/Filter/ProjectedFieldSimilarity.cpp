@@ -18,44 +18,19 @@
 namespace
 {
 
-inline kvs::Matrix<float> DistanceMatrix(
-    const kvs::StructuredVolumeObjectList& volumes,
-    const float min_value,
-    const float max_value )
-{
-    const auto nvolumes = volumes.size();
-    kvs::Matrix<float> d( nvolumes, nvolumes );
-    #pragma omp parallel for
-    for ( size_t i = 0; i < nvolumes - 1; ++i )
-    {
-        #pragma omp parallel for
-        for ( size_t j = i + 1; j < nvolumes; ++j )
-        {
-            auto vi = volumes.load( i );
-            auto vj = volumes.load( j );
-            d[i][j] = 1.0f - kvs::FieldSimilarity( vi, vj, min_value, max_value );
-            d[j][i] = d[i][j];
-        }
-    }
-    return d;
-}
-
-inline kvs::Matrix<float> DistanceMatrix(
-    const kvs::StructuredVolumeObjectList& volumes )
+/*===========================================================================*/
+/**
+ *  @brief  Returns the dissimilarity matrix (1 - similarity).
+ *  @param  similarity [in] similarity matrix
+ */
+/*===========================================================================*/
+inline kvs::Matrix<float> Dissimilarity( const kvs::Matrix<float>& similarity )
 {
-    const auto nvolumes = volumes.size();
-    kvs::Matrix<float> d( nvolumes, nvolumes );
-    #pragma omp parallel for
-    for ( size_t i = 0; i < nvolumes - 1; ++i )
+    const size_t n = similarity.rowSize();
+    kvs::Matrix<float> d( n, n );
+    for ( size_t i = 0; i < n; ++i )
     {
-        #pragma omp parallel for
-        for ( size_t j = i + 1; j < nvolumes; ++j )
-        {
-            auto vi = volumes.load( i );
-            auto vj = volumes.load( j );
-            d[i][j] = 1.0f - kvs::FieldSimilarity( vi, vj );
-            d[j][i] = d[i][j];
-        }
+        for ( size_t j = 0; j < n; ++j ) { d[i][j] = i == j ? 0.0f : 1.0f - similarity[i][j]; }
     }
     return d;
 }
@@ -85,9 +60,9 @@ ThisClass::SuperClass* ThisClass::exec( const kvs::ObjectBase* object )
         return nullptr;
     }
 
-    m_dissimilarity_matrix = m_has_min_max_values ?
-        ::DistanceMatrix( *object_list, m_min_value, m_max_value ):
-        ::DistanceMatrix( *object_list );
+    m_dissimilarity_matrix = ::Dissimilarity( m_has_min_max_values ?
+        kvs::FieldSimilarityMatrix( *object_list, m_min_value, m_max_value ):
+        kvs::FieldSimilarityMatrix( *object_list ) );
 
     kvs::MultiDimensionalScaling<float> mds( 2 );
     SuperClass::setTable( mds.transform( m_dissimilarity_matrix ) );
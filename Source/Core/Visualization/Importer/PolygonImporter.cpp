@@ -9,6 +9,66 @@
 #include <kvs/KVSMLPolygonObject>
 #include <kvs/Math>
 #include <kvs/Vector3>
+#include <kvs/OpenMP>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the area-weighted vertex normals of the triangles.
+ *  @param  coords [in] coordinate values
+ *  @param  connections [in] connections
+ *  @return normal vectors at the vertices
+ */
+/*===========================================================================*/
+kvs::ValueArray<kvs::Real32> VertexNormals(
+    const kvs::ValueArray<kvs::Real32>& coords,
+    const kvs::ValueArray<kvs::UInt32>& connections )
+{
+    const size_t nvertices = coords.size() / 3;
+    const size_t ntriangles = connections.size() / 3;
+    kvs::ValueArray<kvs::Real32> normals( nvertices * 3 );
+    normals.fill( 0.0f );
+
+    const kvs::Real32* pcoords = coords.data();
+    const kvs::UInt32* pconnections = connections.data();
+    for ( size_t i = 0; i < ntriangles; i++ )
+    {
+        const kvs::UInt32 id0 = pconnections[ 3 * i + 0 ];
+        const kvs::UInt32 id1 = pconnections[ 3 * i + 1 ];
+        const kvs::UInt32 id2 = pconnections[ 3 * i + 2 ];
+        const kvs::Vec3 v0( pcoords + 3 * id0 );
+        const kvs::Vec3 v1( pcoords + 3 * id1 );
+        const kvs::Vec3 v2( pcoords + 3 * id2 );
+        const kvs::Vec3 n = ( v1 - v0 ).cross( v2 - v0 );
+        for ( const kvs::UInt32 id : { id0, id1, id2 } )
+        {
+            normals[ 3 * id + 0 ] += n.x();
+            normals[ 3 * id + 1 ] += n.y();
+            normals[ 3 * id + 2 ] += n.z();
+        }
+    }
+
+    const long nnormals = static_cast<long>( nvertices );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nnormals; i++ )
+    {
+        const kvs::Vec3 n( normals.data() + 3 * i );
+        const float length = n.length();
+        if ( length > 0.0f )
+        {
+            normals[ 3 * i + 0 ] = n.x() / length;
+            normals[ 3 * i + 1 ] = n.y() / length;
+            normals[ 3 * i + 2 ] = n.z() / length;
+        }
+    }
+
+    return normals;
+}
+
+} // end of namespace
 
 
 namespace kvs
@@ -147,17 +207,37 @@ PolygonImporter::SuperClass* PolygonImporter::exec( const kvs::FileFormatBase* f
 /**
  *  @brief  Imports the STL format data.
  *  @param  stl [in] pointer to the STL format file
+ *
+ *  The facet normals in the file are imported as the polygon normals. If the
+ *  welding is enabled, the shared vertices are welded to import as the indexed
+ *  triangles with the smoothed vertex normals instead.
  */
 /*==========================================================================*/
 void PolygonImporter::import( const kvs::Stl* stl )
 {
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
-    SuperClass::setColorType( kvs::PolygonObject::PolygonColor );
-    SuperClass::setNormalType( kvs::PolygonObject::PolygonNormal );
-    SuperClass::setCoords( stl->coords() );
     SuperClass::setColor( kvs::RGBColor( 255, 255, 255 ) );
-    SuperClass::setNormals( stl->normals() );
     SuperClass::setOpacity( 255 );
+
+    if ( m_enable_welding )
+    {
+        kvs::Stl welded( *stl );
+        welded.weld();
+
+        SuperClass::setColorType( kvs::PolygonObject::VertexColor );
+        SuperClass::setNormalType( kvs::PolygonObject::VertexNormal );
+        SuperClass::setCoords( welded.coords() );
+        SuperClass::setConnections( welded.connections() );
+        SuperClass::setNormals( ::VertexNormals( welded.coords(), welded.connections() ) );
+    }
+    else
+    {
+        SuperClass::setColorType( kvs::PolygonObject::PolygonColor );
+        SuperClass::setNormalType( kvs::PolygonObject::PolygonNormal );
+        SuperClass::setCoords( stl->coords() );
+        SuperClass::setNormals( stl->normals() );
+    }
+
     SuperClass::updateMinMaxCoords();
 }
 
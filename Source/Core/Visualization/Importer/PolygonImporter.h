@@ -27,12 +27,20 @@ class PolygonImporter : public kvs::ImporterBase, public kvs::PolygonObject
     kvsModuleBaseClass( kvs::ImporterBase );
     kvsModuleSuperClass( kvs::PolygonObject );
 
+private:
+    bool m_enable_welding = false; ///< flag for welding the shared vertices (STL)
+
 public:
     PolygonImporter();
     PolygonImporter( const std::string& filename );
     PolygonImporter( const kvs::FileFormatBase* file_format );
     virtual ~PolygonImporter();
 
+    bool isWeldingEnabled() const { return m_enable_welding; }
+    void setWeldingEnabled( const bool enable = true ) { m_enable_welding = enable; }
+    void enableWelding() { this->setWeldingEnabled( true ); }
+    void disableWelding() { this->setWeldingEnabled( false ); }
+
     SuperClass* exec( const kvs::FileFormatBase* file_format );
 
 private:
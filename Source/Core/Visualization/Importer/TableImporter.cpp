@@ -7,7 +7,412 @@
 #include "TableImporter.h"
 #include <kvs/DebugNew>
 #include <kvs/KVSMLTableObject>
+#include <kvs/Csv>
+#include <kvs/ValueArray>
+#include <kvs/Message>
+#include <kvs/OpenMP>
 #include <string>
+#include <vector>
+#include <fstream>
+#include <cstdlib>
+#include <limits>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Field types of CSV data.
+ */
+/*===========================================================================*/
+enum FieldType
+{
+    Integer = 1, ///< integer value within 32-bit
+    Real = 2, ///< floating-point value
+    Text = 4, ///< non-numeric text
+    Missing = 8 ///< empty field
+};
+
+// Chunk size of the CSV data scanned by a thread.
+const size_t ChunkSize = 4 * 1024 * 1024;
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the field of the CSV data.
+ *  @param  begin [in] pointer to the first character of the field
+ *  @param  end [in] pointer to the end of the field
+ *  @param  value [out] parsed value
+ *  @return field type
+ */
+/*===========================================================================*/
+inline FieldType ParseField( const char* begin, const char* end, double* value )
+{
+    while ( begin < end && ( *begin == ' ' || *begin == '\t' || *begin == '"' ) ) { ++begin; }
+    while ( end > begin && ( end[-1] == ' ' || end[-1] == '\t' || end[-1] == '"' ) ) { --end; }
+    if ( begin == end ) { *value = std::numeric_limits<double>::quiet_NaN(); return Missing; }
+
+    // Integer with up to 9 digits, which can be stored in 32-bit integer.
+    const char* p = begin;
+    const bool negative = *p == '-';
+    if ( *p == '-' || *p == '+' ) { ++p; }
+    if ( p < end && end - p <= 9 )
+    {
+        long integer = 0;
+        const char* q = p;
+        while ( q < end && '0' <= *q && *q <= '9' ) { integer = integer * 10 + ( *q - '0' ); ++q; }
+        if ( q == end )
+        {
+            *value = static_cast<double>( negative ? -integer : integer );
+            return Integer;
+        }
+    }
+
+    char* last = nullptr;
+    *value = std::strtod( begin, &last );
+    if ( last == end ) { return Real; }
+
+    *value = std::numeric_limits<double>::quiet_NaN();
+    return Text;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Splits the row of the CSV data into the fields.
+ *  @param  begin [in] pointer to the first character of the row
+ *  @param  end [in] pointer to the end of the data
+ *  @param  fields [out] pairs of the first and end pointers of the fields
+ *  @return pointer to the first character of the next row
+ */
+/*===========================================================================*/
+inline const char* SplitRow(
+    const char* begin,
+    const char* end,
+    std::vector<std::pair<const char*,const char*>>& fields )
+{
+    fields.clear();
+    bool quoted = false;
+    const char* field = begin;
+    const char* p = begin;
+    for ( ; p < end; ++p )
+    {
+        const char c = *p;
+        if ( c == '"' ) { quoted = !quoted; }
+        else if ( quoted ) { continue; }
+        else if ( c == ',' ) { fields.emplace_back( field, p ); field = p + 1; }
+        else if ( c == '\n' || c == '\r' ) { break; }
+    }
+    fields.emplace_back( field, p );
+
+    // Linefeed code: Windows CRLF(\r\n), Unix LF(\n), Mac CR(\r)
+    if ( p < end && *p == '\r' ) { ++p; }
+    if ( p < end && *p == '\n' ) { ++p; }
+    return p;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the row has no characters except white spaces.
+ *  @param  fields [in] fields of the row
+ */
+/*===========================================================================*/
+inline bool IsEmptyRow( const std::vector<std::pair<const char*,const char*>>& fields )
+{
+    if ( fields.size() > 1 ) { return false; }
+    for ( const char* p = fields[0].first; p < fields[0].second; ++p )
+    {
+        if ( *p != ' ' && *p != '\t' ) { return false; }
+    }
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the boundaries of the chunks at the row boundaries.
+ *  @param  begin [in] pointer to the first character of the data
+ *  @param  end [in] pointer to the end of the data
+ *  @return boundaries of the chunks (number of chunks + 1)
+ */
+/*===========================================================================*/
+inline std::vector<const char*> SplitChunks( const char* begin, const char* end )
+{
+    // The quotation marks are tracked from the beginning of the data, since
+    // the linefeeds in the quoted fields are not the row boundaries.
+    std::vector<const char*> chunks( 1, begin );
+    bool quoted = false;
+    const char* target = begin + ChunkSize;
+    for ( const char* p = begin; p < end; ++p )
+    {
+        if ( *p == '"' ) { quoted = !quoted; }
+        else if ( !quoted && *p == '\n' && p + 1 >= target )
+        {
+            chunks.push_back( p + 1 );
+            target = p + 1 + ChunkSize;
+        }
+    }
+    if ( chunks.back() != end ) { chunks.push_back( end ); }
+    return chunks;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Column arrays of the CSV data.
+ */
+/*===========================================================================*/
+struct Columns
+{
+    std::vector<int> types; ///< field types (bitwise OR of FieldType)
+    std::vector<kvs::ValueArray<kvs::Int32>> integers; ///< integer columns
+    std::vector<kvs::ValueArray<kvs::Real64>> reals; ///< real columns
+
+    // Allocates the typed arrays. The column that has only integers is stored
+    // as 32-bit integer, and the other columns are stored as 64-bit real with
+    // NaN for the missing and text fields.
+    void allocate( const size_t nrows )
+    {
+        const size_t ncols = types.size();
+        integers.resize( ncols );
+        reals.resize( ncols );
+        for ( size_t j = 0; j < ncols; j++ )
+        {
+            if ( types[j] == Integer ) { integers[j].allocate( nrows ); }
+            else { reals[j].allocate( nrows ); }
+        }
+    }
+
+    void set( const size_t row, const size_t col, const double value )
+    {
+        if ( integers[col].size() > 0 ) { integers[col][row] = static_cast<kvs::Int32>( value ); }
+        else { reals[col][row] = value; }
+    }
+
+    bool hasText() const
+    {
+        for ( auto type : types ) { if ( type & Text ) { return true; } }
+        return false;
+    }
+
+    void addTo( kvs::TableObject* table, const std::vector<std::string>& labels ) const
+    {
+        for ( size_t j = 0; j < types.size(); j++ )
+        {
+            const std::string label = j < labels.size() ? labels[j] : "";
+            if ( integers[j].size() > 0 ) { table->addColumn( kvs::AnyValueArray( integers[j] ), label ); }
+            else { table->addColumn( kvs::AnyValueArray( reals[j] ), label ); }
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the labels if the row is a header.
+ *  @param  fields [in] fields of the first row
+ *  @param  labels [out] labels
+ *  @return true if the row is a header, which has non-numeric fields
+ */
+/*===========================================================================*/
+inline bool ReadHeader(
+    const std::vector<std::pair<const char*,const char*>>& fields,
+    std::vector<std::string>& labels )
+{
+    bool is_header = false;
+    double value = 0.0;
+    for ( const auto& field : fields )
+    {
+        if ( ParseField( field.first, field.second, &value ) == Text ) { is_header = true; }
+    }
+    if ( !is_header ) { return false; }
+
+    labels.clear();
+    for ( const auto& field : fields )
+    {
+        const char* b = field.first;
+        const char* e = field.second;
+        while ( b < e && ( *b == ' ' || *b == '"' ) ) { ++b; }
+        while ( e > b && ( e[-1] == ' ' || e[-1] == '"' ) ) { --e; }
+        labels.push_back( std::string( b, e ) );
+    }
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Imports the CSV file into the typed columns.
+ *  @param  filename [in] filename
+ *  @param  table [in] pointer to the table object
+ *  @return true if the importing process is done successfully
+ *
+ *  The file is split into the chunks at the row boundaries and scanned in
+ *  parallel twice: the first pass counts the rows and infers the type of
+ *  each column, and the second pass parses the values directly into the
+ *  typed arrays at the row offsets of the chunks.
+ */
+/*===========================================================================*/
+inline bool ImportCsv( const std::string& filename, kvs::TableObject* table )
+{
+    std::ifstream ifs( filename.c_str(), std::ios::binary );
+    if ( !ifs.is_open() )
+    {
+        kvsMessageError( "Cannot open %s.", filename.c_str() );
+        return false;
+    }
+
+    ifs.seekg( 0, std::ios::end );
+    const size_t size = static_cast<size_t>( ifs.tellg() );
+    ifs.seekg( 0, std::ios::beg );
+    std::vector<char> buffer( size + 1, '\0' ); // null-terminated for strtod
+    ifs.read( buffer.data(), size );
+    ifs.close();
+
+    const char* begin = buffer.data();
+    const char* end = begin + size;
+
+    // Header and number of columns from the first row.
+    std::vector<std::pair<const char*,const char*>> fields;
+    std::vector<std::string> labels;
+    const char* next = ::SplitRow( begin, end, fields );
+    const size_t ncols = fields.size();
+    if ( ::ReadHeader( fields, labels ) ) { begin = next; }
+
+    // First pass: number of rows and field types for each chunk.
+    const std::vector<const char*> chunks = ::SplitChunks( begin, end );
+    const size_t nchunks = chunks.size() - 1;
+    std::vector<size_t> offsets( nchunks + 1, 0 );
+    std::vector<int> chunk_types( nchunks * ncols, 0 );
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long c = 0; c < long( nchunks ); c++ )
+    {
+        std::vector<std::pair<const char*,const char*>> row;
+        int* types = chunk_types.data() + c * ncols;
+        size_t nrows = 0;
+        double value = 0.0;
+        for ( const char* p = chunks[c]; p < chunks[c+1]; )
+        {
+            p = ::SplitRow( p, chunks[c+1], row );
+            if ( ::IsEmptyRow( row ) ) { continue; }
+            for ( size_t j = 0; j < ncols; j++ )
+            {
+                types[j] |= j < row.size() ? ::ParseField( row[j].first, row[j].second, &value ) : Missing;
+            }
+            nrows++;
+        }
+        offsets[c+1] = nrows;
+    }
+
+    ::Columns columns;
+    columns.types.assign( ncols, 0 );
+    for ( size_t c = 0; c < nchunks; c++ )
+    {
+        offsets[c+1] += offsets[c];
+        for ( size_t j = 0; j < ncols; j++ ) { columns.types[j] |= chunk_types[ c * ncols + j ]; }
+    }
+
+    const size_t nrows = offsets[nchunks];
+    columns.allocate( nrows );
+
+    // Second pass: values of the rows in each chunk.
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long c = 0; c < long( nchunks ); c++ )
+    {
+        std::vector<std::pair<const char*,const char*>> row;
+        size_t index = offsets[c];
+        double value = 0.0;
+        for ( const char* p = chunks[c]; p < chunks[c+1]; )
+        {
+            p = ::SplitRow( p, chunks[c+1], row );
+            if ( ::IsEmptyRow( row ) ) { continue; }
+            for ( size_t j = 0; j < ncols; j++ )
+            {
+                if ( j < row.size() ) { ::ParseField( row[j].first, row[j].second, &value ); }
+                else { value = std::numeric_limits<double>::quiet_NaN(); }
+                columns.set( index, j, value );
+            }
+            index++;
+        }
+    }
+
+    if ( columns.hasText() )
+    {
+        kvsMessageWarning( "Non-numeric fields in %s are imported as NaN.", filename.c_str() );
+    }
+
+    columns.addTo( table, labels );
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Converts the CSV data read by kvs::Csv into the typed columns.
+ *  @param  csv [in] pointer to the CSV data
+ *  @param  table [in] pointer to the table object
+ *  @return true if the conversion is done successfully
+ */
+/*===========================================================================*/
+inline bool ImportCsv( const kvs::Csv* csv, kvs::TableObject* table )
+{
+    const size_t nlines = csv->numberOfRows();
+    if ( nlines == 0 ) { return false; }
+
+    std::vector<std::pair<const char*,const char*>> fields;
+    for ( const auto& item : csv->row(0) ) { fields.emplace_back( item.data(), item.data() + item.size() ); }
+    std::vector<std::string> labels;
+    const size_t first = ::ReadHeader( fields, labels ) ? 1 : 0;
+    const size_t ncols = fields.size();
+
+    // Rows with only an empty field (e.g. the last linefeed) are skipped.
+    std::vector<size_t> rows;
+    for ( size_t i = first; i < nlines; i++ )
+    {
+        const auto& row = csv->row(i);
+        if ( row.size() > 1 || ( row.size() == 1 && !row[0].empty() ) ) { rows.push_back( i ); }
+    }
+
+    // Each column is parsed in parallel.
+    ::Columns columns;
+    columns.types.assign( ncols, 0 );
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long j = 0; j < long( ncols ); j++ )
+    {
+        int type = 0;
+        double value = 0.0;
+        for ( const auto i : rows )
+        {
+            const auto& row = csv->row(i);
+            if ( size_t( j ) >= row.size() ) { type |= Missing; continue; }
+            const std::string& item = row[j];
+            type |= ::ParseField( item.data(), item.data() + item.size(), &value );
+        }
+        columns.types[j] = type;
+    }
+
+    columns.allocate( rows.size() );
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long j = 0; j < long( ncols ); j++ )
+    {
+        double value = 0.0;
+        for ( size_t r = 0; r < rows.size(); r++ )
+        {
+            const auto& row = csv->row( rows[r] );
+            if ( size_t( j ) < row.size() )
+            {
+                const std::string& item = row[j];
+                ::ParseField( item.data(), item.data() + item.size(), &value );
+            }
+            else { value = std::numeric_limits<double>::quiet_NaN(); }
+            columns.set( r, j, value );
+        }
+    }
+
+    if ( columns.hasText() )
+    {
+        kvsMessageWarning( "Non-numeric fields in %s are imported as NaN.", csv->filename().c_str() );
+    }
+
+    columns.addTo( table, labels );
+    return true;
+}
+
+} // end of namespace
 
 
 namespace kvs
@@ -34,6 +439,10 @@ TableImporter::TableImporter( const std::string& filename )
     {
         BaseClass::setSuccess( SuperClass::read( filename ) );
     }
+    else if ( kvs::Csv::CheckExtension( filename ) )
+    {
+        BaseClass::setSuccess( ::ImportCsv( filename, this ) );
+    }
     else
     {
         BaseClass::setSuccess( false );
@@ -73,6 +482,10 @@ TableImporter::SuperClass* TableImporter::exec( const kvs::FileFormatBase* file_
     {
         BaseClass::setSuccess( SuperClass::read( file_format->filename() ) );
     }
+    else if ( const auto* csv = dynamic_cast<const kvs::Csv*>( file_format ) )
+    {
+        BaseClass::setSuccess( ::ImportCsv( csv, this ) );
+    }
     else
     {
         BaseClass::setSuccess( false );
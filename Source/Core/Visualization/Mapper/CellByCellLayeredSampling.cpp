@@ -620,7 +620,14 @@ void CellByCellLayeredSampling::generate_particles( const kvs::UnstructuredVolum
     // Generate particles for each cell.
     const kvs::UInt32 repetitions = m_repetition_level;
     CellByCellSampling::ColoredParticles particles( color_map );
-    particles.allocate( N * repetitions );
+    if ( m_enable_compression )
+    {
+        particles.allocateCompressed( nparticles, repetitions, volume );
+    }
+    else
+    {
+        particles.allocate( N * repetitions );
+    }
     KVS_OMP_PARALLEL()
     {
         kvs::TetrahedralCell* cell = new kvs::TetrahedralCell( volume );
@@ -679,10 +686,7 @@ void CellByCellLayeredSampling::generate_particles( const kvs::UnstructuredVolum
 
     delete pregenerated_particles;
 
-    SuperClass::setCoords( particles.coords() );
-    SuperClass::setColors( particles.colors() );
-    SuperClass::setNormals( particles.normals() );
-    SuperClass::setSize( 1.0f );
+    particles.setTo( this );
 }
 
 } // end of namespace kvs
@@ -215,7 +215,14 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::StructuredVolu
     // Generate particles for each cell.
     const kvs::UInt32 repetitions = m_repetition_level;
     CellByCellSampling::ColoredParticles particles( color_map );
-    particles.allocate( N * repetitions );
+    if ( m_enable_compression )
+    {
+        particles.allocateCompressed( nparticles, repetitions, ncells );
+    }
+    else
+    {
+        particles.allocate( N * repetitions );
+    }
     KVS_OMP_PARALLEL()
     {
         kvs::TrilinearInterpolator interpolator( volume );
@@ -286,10 +293,7 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::StructuredVolu
         } // end of repetition loop
     }
 
-    SuperClass::setCoords( particles.coords() );
-    SuperClass::setColors( particles.colors() );
-    SuperClass::setNormals( particles.normals() );
-    SuperClass::setSize( 1.0f );
+    particles.setTo( this );
 }
 
 /*===========================================================================*/
@@ -333,7 +337,14 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::UnstructuredVo
     // Generate particles
     const kvs::UInt32 repetitions = m_repetition_level;
     CellByCellSampling::ColoredParticles particles( color_map );
-    particles.allocate( N * repetitions );
+    if ( m_enable_compression )
+    {
+        particles.allocateCompressed( nparticles, repetitions, volume );
+    }
+    else
+    {
+        particles.allocate( N * repetitions );
+    }
     KVS_OMP_PARALLEL()
     {
         kvs::CellBase* cell = CellByCellSampling::Cell( volume );
@@ -397,10 +408,7 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::UnstructuredVo
         delete cell;
     }
 
-    SuperClass::setCoords( particles.coords() );
-    SuperClass::setColors( particles.colors() );
-    SuperClass::setNormals( particles.normals() );
-    SuperClass::setSize( 1.0f );
+    particles.setTo( this );
 }
 
 } // end of namespace kvs
@@ -219,7 +219,14 @@ void CellByCellRejectionSampling::generate_particles( const kvs::StructuredVolum
     // Generate particles for each cell.
     const kvs::UInt32 repetitions = m_repetition_level;
     CellByCellSampling::ColoredParticles particles( color_map );
-    particles.allocate( N * repetitions );
+    if ( m_enable_compression )
+    {
+        particles.allocateCompressed( nparticles, repetitions, ncells );
+    }
+    else
+    {
+        particles.allocate( N * repetitions );
+    }
     KVS_OMP_PARALLEL()
     {
         kvs::TrilinearInterpolator interpolator( volume );
@@ -265,10 +272,7 @@ void CellByCellRejectionSampling::generate_particles( const kvs::StructuredVolum
         }
     }
 
-    SuperClass::setCoords( particles.coords() );
-    SuperClass::setColors( particles.colors() );
-    SuperClass::setNormals( particles.normals() );
-    SuperClass::setSize( 1.0f );
+    particles.setTo( this );
 }
 
 /*===========================================================================*/
@@ -312,7 +316,14 @@ void CellByCellRejectionSampling::generate_particles( const kvs::UnstructuredVol
     // Generate particles for each cell.
     const kvs::UInt32 repetitions = m_repetition_level;
     CellByCellSampling::ColoredParticles particles( color_map );
-    particles.allocate( N * repetitions );
+    if ( m_enable_compression )
+    {
+        particles.allocateCompressed( nparticles, repetitions, volume );
+    }
+    else
+    {
+        particles.allocate( N * repetitions );
+    }
     KVS_OMP_PARALLEL()
     {
         kvs::CellBase* cell = CellByCellSampling::Cell( volume );
@@ -353,10 +364,7 @@ void CellByCellRejectionSampling::generate_particles( const kvs::UnstructuredVol
         delete cell;
     }
 
-    SuperClass::setCoords( particles.coords() );
-    SuperClass::setColors( particles.colors() );
-    SuperClass::setNormals( particles.normals() );
-    SuperClass::setSize( 1.0f );
+    particles.setTo( this );
 }
 
 } // end of namespace kvs
@@ -34,6 +34,7 @@ private:
     size_t m_repetition_level = 1; ///< repetition level
     float m_sampling_step = 0.5f; ///< sampling step in the object coordinate
     float m_object_depth = 0.0f; ///< object depth
+    bool m_enable_compression = false; ///< flag for compressed particles
 
 public:
     CellByCellRejectionSampling() = default;
@@ -56,11 +57,15 @@ public:
     size_t repetitionLevel() const { return m_repetition_level; }
     float samplingStep() const { return m_sampling_step; }
     float objectDepth() const { return m_object_depth; }
+    bool isCompressionEnabled() const { return m_enable_compression; }
 
     void attachCamera( const kvs::Camera* camera ) { m_camera = camera; }
     void setRepetitionLevel( const size_t repetition_level ) { m_repetition_level = repetition_level; }
     void setSamplingStep( const float step ) { m_sampling_step = step; }
     void setObjectDepth( const float depth ) { m_object_depth = depth; }
+    void setCompressionEnabled( const bool enable = true ) { m_enable_compression = enable; }
+    void enableCompression() { this->setCompressionEnabled( true ); }
+    void disableCompression() { this->setCompressionEnabled( false ); }
 
 private:
     void mapping( const kvs::StructuredVolumeObject* volume );
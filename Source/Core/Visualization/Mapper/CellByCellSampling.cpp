@@ -194,6 +194,121 @@ namespace kvs
 namespace CellByCellSampling
 {
 
+/*===========================================================================*/
+/**
+ *  @brief  Allocates the compressed particles for the structured volume.
+ *  @param  nparticles [in] number of particles in each cell
+ *  @param  repetitions [in] number of repetitions
+ *  @param  ncells [in] number of cells in each axis
+ */
+/*===========================================================================*/
+void ColoredParticles::allocateCompressed(
+    const kvs::ValueArray<kvs::UInt32>& nparticles,
+    const size_t repetitions,
+    const kvs::Vec3ui& ncells )
+{
+    size_t N = 0;
+    for ( const auto n : nparticles ) { N += n; }
+
+    m_compressed_points.allocate( N * repetitions );
+    m_compressed_points.setColorMap( m_color_map );
+
+    // The particles are generated cell by cell in each repetition, so that
+    // the bounding box of a block is the union of the producing cells.
+    for ( size_t r = 0; r < repetitions; ++r )
+    {
+        size_t cell_index_counter = 0;
+        size_t particle_index_counter = N * r;
+        for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
+        {
+            for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
+            {
+                for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
+                {
+                    const size_t n = nparticles[ cell_index_counter++ ];
+                    if ( n == 0 ) continue;
+
+                    const kvs::Vec3 min_coord( static_cast<float>( x ), static_cast<float>( y ), static_cast<float>( z ) );
+                    const kvs::Vec3 max_coord( min_coord + kvs::Vec3::Ones() );
+                    m_compressed_points.expandBlock( particle_index_counter, n, min_coord, max_coord );
+                    particle_index_counter += n;
+                }
+            }
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Allocates the compressed particles for the unstructured volume.
+ *  @param  nparticles [in] number of particles in each cell
+ *  @param  repetitions [in] number of repetitions
+ *  @param  volume [in] pointer to the volume object
+ */
+/*===========================================================================*/
+void ColoredParticles::allocateCompressed(
+    const kvs::ValueArray<kvs::UInt32>& nparticles,
+    const size_t repetitions,
+    const kvs::UnstructuredVolumeObject* volume )
+{
+    size_t N = 0;
+    for ( const auto n : nparticles ) { N += n; }
+
+    m_compressed_points.allocate( N * repetitions );
+    m_compressed_points.setColorMap( m_color_map );
+
+    const size_t ncells = volume->numberOfCells();
+    const size_t nnodes = volume->numberOfCellNodes();
+    const kvs::Real32* coords = volume->coords().data();
+    const kvs::UInt32* connections = volume->connections().data();
+    for ( size_t r = 0; r < repetitions; ++r )
+    {
+        size_t particle_index_counter = N * r;
+        for ( size_t index = 0; index < ncells; ++index )
+        {
+            const size_t n = nparticles[index];
+            if ( n == 0 ) continue;
+
+            const kvs::UInt32* cell = connections + index * nnodes;
+            kvs::Vec3 min_coord( coords + 3 * cell[0] );
+            kvs::Vec3 max_coord( min_coord );
+            for ( size_t i = 1; i < nnodes; ++i )
+            {
+                const kvs::Vec3 coord( coords + 3 * cell[i] );
+                for ( int j = 0; j < 3; ++j )
+                {
+                    min_coord[j] = kvs::Math::Min( min_coord[j], coord[j] );
+                    max_coord[j] = kvs::Math::Max( max_coord[j], coord[j] );
+                }
+            }
+
+            m_compressed_points.expandBlock( particle_index_counter, n, min_coord, max_coord );
+            particle_index_counter += n;
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the particles to the point object.
+ *  @param  object [in] pointer to the point object
+ */
+/*===========================================================================*/
+void ColoredParticles::setTo( kvs::PointObject* object ) const
+{
+    if ( this->isCompressed() )
+    {
+        object->setCompressedPoints( m_compressed_points );
+    }
+    else
+    {
+        object->setCoords( m_coords );
+        object->setColors( m_colors );
+        object->setNormals( m_normals );
+    }
+    object->setSize( 1.0f );
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Returns the density specified by the scalar value.
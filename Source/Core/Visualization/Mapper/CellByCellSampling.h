@@ -23,6 +23,8 @@
 #include <kvs/StructuredVolumeObject>
 #include <kvs/UnstructuredVolumeObject>
 #include <kvs/OpenMP>
+#include <kvs/CompressedPointArray>
+#include <kvs/PointObject>
 
 
 namespace kvs
@@ -198,12 +200,15 @@ private:
     kvs::ValueArray<kvs::Real32> m_coords; ///< coorinate value array
     kvs::ValueArray<kvs::Real32> m_normals; ///< normal vector array
     kvs::ValueArray<kvs::UInt8> m_colors; ///< color value array
+    kvs::CompressedPointArray m_compressed_points; ///< compressed point array
 
 public:
     ColoredParticles( const kvs::ColorMap& color_map ): m_color_map( color_map ) {}
     const kvs::ValueArray<kvs::Real32>& coords() const { return m_coords; }
     const kvs::ValueArray<kvs::Real32>& normals() const { return m_normals; }
     const kvs::ValueArray<kvs::UInt8>& colors() const { return m_colors; }
+    const kvs::CompressedPointArray& compressedPoints() const { return m_compressed_points; }
+    bool isCompressed() const { return !m_compressed_points.empty(); }
 
     void allocate( const size_t nparticles )
     {
@@ -212,8 +217,24 @@ public:
         m_colors.allocate( nparticles * 3 );
     }
 
+    void allocateCompressed(
+        const kvs::ValueArray<kvs::UInt32>& nparticles,
+        const size_t repetitions,
+        const kvs::Vec3ui& ncells );
+
+    void allocateCompressed(
+        const kvs::ValueArray<kvs::UInt32>& nparticles,
+        const size_t repetitions,
+        const kvs::UnstructuredVolumeObject* volume );
+
     void push( const size_t index, const Particle& particle )
     {
+        if ( this->isCompressed() )
+        {
+            m_compressed_points.set( index, particle.coord, particle.normal, particle.scalar );
+            return;
+        }
+
         const kvs::RGBColor color = m_color_map.at( particle.scalar );
         const size_t index3 = index * 3;
         m_coords[ index3 + 0 ] = particle.coord.x();
@@ -226,6 +247,8 @@ public:
         m_colors[ index3 + 1 ] = color.g();
         m_colors[ index3 + 2 ] = color.b();
     }
+
+    void setTo( kvs::PointObject* object ) const;
 };
 
 /*===========================================================================*/
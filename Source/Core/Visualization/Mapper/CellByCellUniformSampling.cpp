@@ -217,7 +217,14 @@ void CellByCellUniformSampling::generate_particles( const kvs::StructuredVolumeO
     // Genrate a set of particles.
     const kvs::UInt32 repetitions = m_repetition_level;
     CellByCellSampling::ColoredParticles particles( color_map );
-    particles.allocate( N * repetitions );
+    if ( m_enable_compression )
+    {
+        particles.allocateCompressed( nparticles, repetitions, ncells );
+    }
+    else
+    {
+        particles.allocate( N * repetitions );
+    }
 /*
     kvs::ValueArray<kvs::Real32> coords( 3 * N * repetitions );
     kvs::ValueArray<kvs::Real32> normals( 3 * N * repetitions );
@@ -269,10 +276,7 @@ void CellByCellUniformSampling::generate_particles( const kvs::StructuredVolumeO
         }
     }
 
-    SuperClass::setCoords( particles.coords() );
-    SuperClass::setColors( particles.colors() );
-    SuperClass::setNormals( particles.normals() );
-    SuperClass::setSize( 1.0f );
+    particles.setTo( this );
 }
 
 /*===========================================================================*/
@@ -315,7 +319,14 @@ void CellByCellUniformSampling::generate_particles( const kvs::UnstructuredVolum
     // Generate particles
     const kvs::UInt32 repetitions = m_repetition_level;
     CellByCellSampling::ColoredParticles particles( color_map );
-    particles.allocate( N * repetitions );
+    if ( m_enable_compression )
+    {
+        particles.allocateCompressed( nparticles, repetitions, volume );
+    }
+    else
+    {
+        particles.allocate( N * repetitions );
+    }
     KVS_OMP_PARALLEL()
     {
         kvs::CellBase* cell = CellByCellSampling::Cell( volume );
@@ -344,10 +355,7 @@ void CellByCellUniformSampling::generate_particles( const kvs::UnstructuredVolum
         delete cell;
     }
 
-    SuperClass::setCoords( particles.coords() );
-    SuperClass::setColors( particles.colors() );
-    SuperClass::setNormals( particles.normals() );
-    SuperClass::setSize( 1.0f );
+    particles.setTo( this );
 }
 
 } // end of namespace kvs
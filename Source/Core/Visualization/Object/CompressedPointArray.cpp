@@ -0,0 +1,298 @@
+/*****************************************************************************/
+/**
+ *  @file   CompressedPointArray.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#include "CompressedPointArray.h"
+#include <limits>
+#include <kvs/Math>
+#include <kvs/Assert>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Quantizes the value in [0,1] to the unsigned integer.
+ *  @param  value [in] value in [0,1]
+ *  @param  max_value [in] max. value of the quantized value
+ *  @return quantized value
+ */
+/*===========================================================================*/
+inline int Quantize( const float value, const int max_value )
+{
+    return kvs::Math::Round( kvs::Math::Clamp( value, 0.0f, 1.0f ) * max_value );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Encodes the normal vector by the octahedral mapping.
+ *  @param  normal [in] normal vector
+ *  @param  code [out] encoded normal vector (2 bytes)
+ */
+/*===========================================================================*/
+inline void EncodeNormal( const kvs::Vec3& normal, kvs::UInt8* code )
+{
+    const float l1 =
+        kvs::Math::Abs( normal.x() ) +
+        kvs::Math::Abs( normal.y() ) +
+        kvs::Math::Abs( normal.z() );
+    if ( kvs::Math::IsZero( l1 ) ) { code[0] = code[1] = 128; return; }
+
+    // Project onto the octahedron, and fold the lower hemisphere.
+    float u = normal.x() / l1;
+    float v = normal.y() / l1;
+    if ( normal.z() < 0.0f )
+    {
+        const float u0 = u;
+        u = ( 1.0f - kvs::Math::Abs( v ) ) * kvs::Math::Sgn( u0 );
+        v = ( 1.0f - kvs::Math::Abs( u0 ) ) * kvs::Math::Sgn( v );
+    }
+
+    code[0] = static_cast<kvs::UInt8>( ::Quantize( u * 0.5f + 0.5f, 255 ) );
+    code[1] = static_cast<kvs::UInt8>( ::Quantize( v * 0.5f + 0.5f, 255 ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Decodes the normal vector encoded by the octahedral mapping.
+ *  @param  code [in] encoded normal vector (2 bytes)
+ *  @return normalized normal vector
+ */
+/*===========================================================================*/
+inline kvs::Vec3 DecodeNormal( const kvs::UInt8* code )
+{
+    const float u = code[0] / 255.0f * 2.0f - 1.0f;
+    const float v = code[1] / 255.0f * 2.0f - 1.0f;
+    kvs::Vec3 n( u, v, 1.0f - kvs::Math::Abs( u ) - kvs::Math::Abs( v ) );
+    const float t = kvs::Math::Max( -n.z(), 0.0f );
+    n.x() += n.x() >= 0.0f ? -t : t;
+    n.y() += n.y() >= 0.0f ? -t : t;
+    return n.normalized();
+}
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the data size of the compressed points in bytes.
+ *  @return data size in bytes
+ */
+/*===========================================================================*/
+size_t CompressedPointArray::byteSize() const
+{
+    return
+        m_coords.byteSize() +
+        m_normals.byteSize() +
+        m_color_indices.byteSize() +
+        m_palette.byteSize() +
+        m_block_min_coords.byteSize() +
+        m_block_max_coords.byteSize();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the number of points in the block.
+ *  @param  block [in] block index
+ *  @return number of points
+ */
+/*===========================================================================*/
+size_t CompressedPointArray::blockCount( const size_t block ) const
+{
+    const size_t first = this->blockFirst( block );
+    return kvs::Math::Min( first + size_t( BlockSize ), this->numberOfPoints() ) - first;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Allocates the point arrays.
+ *  @param  npoints [in] number of points
+ */
+/*===========================================================================*/
+void CompressedPointArray::allocate( const size_t npoints )
+{
+    m_coords.allocate( npoints * 3 );
+    m_normals.allocate( npoints * 2 );
+    m_color_indices.allocate( npoints );
+
+    // The bounding boxes are initialized to be empty.
+    const size_t nblocks = ( npoints + BlockSize - 1 ) / BlockSize;
+    m_block_min_coords.allocate( nblocks * 3 );
+    m_block_max_coords.allocate( nblocks * 3 );
+    m_block_min_coords.fill( std::numeric_limits<kvs::Real32>::max() );
+    m_block_max_coords.fill( -std::numeric_limits<kvs::Real32>::max() );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the point arrays.
+ */
+/*===========================================================================*/
+void CompressedPointArray::release()
+{
+    m_coords.release();
+    m_normals.release();
+    m_color_indices.release();
+    m_palette.release();
+    m_block_min_coords.release();
+    m_block_max_coords.release();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the color palette sampled from the color map.
+ *  @param  color_map [in] color map with the value range
+ */
+/*===========================================================================*/
+void CompressedPointArray::setColorMap( const kvs::ColorMap& color_map )
+{
+    m_min_value = color_map.minValue();
+    m_max_value = color_map.maxValue();
+
+    m_palette.allocate( PaletteSize * 3 );
+    const float scale = ( m_max_value - m_min_value ) / ( PaletteSize - 1 );
+    for ( size_t i = 0; i < PaletteSize; i++ )
+    {
+        const kvs::RGBColor color = color_map.at( m_min_value + scale * i );
+        m_palette[ 3 * i + 0 ] = color.r();
+        m_palette[ 3 * i + 1 ] = color.g();
+        m_palette[ 3 * i + 2 ] = color.b();
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Expands the bounding boxes of the blocks overlapped with the range.
+ *  @param  first [in] index of the first point in the range
+ *  @param  count [in] number of points in the range
+ *  @param  min_coord [in] min. coordinate of the points in the range
+ *  @param  max_coord [in] max. coordinate of the points in the range
+ */
+/*===========================================================================*/
+void CompressedPointArray::expandBlock(
+    const size_t first,
+    const size_t count,
+    const kvs::Vec3& min_coord,
+    const kvs::Vec3& max_coord )
+{
+    if ( count == 0 ) { return; }
+
+    const size_t first_block = first / BlockSize;
+    const size_t last_block = ( first + count - 1 ) / BlockSize;
+    for ( size_t block = first_block; block <= last_block; block++ )
+    {
+        kvs::Real32* min_coords = m_block_min_coords.data() + block * 3;
+        kvs::Real32* max_coords = m_block_max_coords.data() + block * 3;
+        for ( size_t i = 0; i < 3; i++ )
+        {
+            min_coords[i] = kvs::Math::Min( min_coords[i], min_coord[i] );
+            max_coords[i] = kvs::Math::Max( max_coords[i], max_coord[i] );
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the point.
+ *  @param  index [in] point index
+ *  @param  coord [in] coordinate in the bounding box of the block
+ *  @param  normal [in] normal vector
+ *  @param  value [in] scalar value for the color palette
+ */
+/*===========================================================================*/
+void CompressedPointArray::set(
+    const size_t index,
+    const kvs::Vec3& coord,
+    const kvs::Vec3& normal,
+    const kvs::Real32 value )
+{
+    KVS_ASSERT( index < this->numberOfPoints() );
+
+    const size_t block = index / BlockSize;
+    const kvs::Vec3 min_coord = this->blockMinCoord( block );
+    const kvs::Vec3 max_coord = this->blockMaxCoord( block );
+    for ( size_t i = 0; i < 3; i++ )
+    {
+        const float extent = max_coord[i] - min_coord[i];
+        const float t = extent > 0.0f ? ( coord[i] - min_coord[i] ) / extent : 0.0f;
+        m_coords[ 3 * index + i ] = static_cast<kvs::Int16>( ::Quantize( t, 65535 ) - 32768 );
+    }
+
+    ::EncodeNormal( normal, m_normals.data() + 2 * index );
+
+    const float range = m_max_value - m_min_value;
+    const float t = range > 0.0f ? ( value - m_min_value ) / range : 0.0f;
+    m_color_indices[ index ] = static_cast<kvs::UInt8>( ::Quantize( t, PaletteSize - 1 ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the decoded coordinate of the point.
+ *  @param  index [in] point index
+ *  @return coordinate
+ */
+/*===========================================================================*/
+kvs::Vec3 CompressedPointArray::coord( const size_t index ) const
+{
+    const size_t block = index / BlockSize;
+    const kvs::Vec3 min_coord = this->blockMinCoord( block );
+    const kvs::Vec3 max_coord = this->blockMaxCoord( block );
+    const kvs::Int16* q = m_coords.data() + 3 * index;
+    const kvs::Vec3 t(
+        ( q[0] + 32768 ) / 65535.0f,
+        ( q[1] + 32768 ) / 65535.0f,
+        ( q[2] + 32768 ) / 65535.0f );
+    return min_coord + t * ( max_coord - min_coord );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the decoded normal vector of the point.
+ *  @param  index [in] point index
+ *  @return normalized normal vector
+ */
+/*===========================================================================*/
+kvs::Vec3 CompressedPointArray::normal( const size_t index ) const
+{
+    return ::DecodeNormal( m_normals.data() + 2 * index );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the color of the point.
+ *  @param  index [in] point index
+ *  @return color in the palette
+ */
+/*===========================================================================*/
+kvs::RGBColor CompressedPointArray::color( const size_t index ) const
+{
+    return kvs::RGBColor( m_palette.data() + 3 * m_color_indices[ index ] );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a deep copy of the compressed points.
+ *  @return compressed point array
+ */
+/*===========================================================================*/
+CompressedPointArray CompressedPointArray::clone() const
+{
+    CompressedPointArray other;
+    other.m_coords = m_coords.clone();
+    other.m_normals = m_normals.clone();
+    other.m_color_indices = m_color_indices.clone();
+    other.m_palette = m_palette.clone();
+    other.m_block_min_coords = m_block_min_coords.clone();
+    other.m_block_max_coords = m_block_max_coords.clone();
+    other.m_min_value = m_min_value;
+    other.m_max_value = m_max_value;
+    return other;
+}
+
+} // end of namespace kvs
@@ -0,0 +1,82 @@
+/*****************************************************************************/
+/**
+ *  @file   CompressedPointArray.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <kvs/ValueArray>
+#include <kvs/Type>
+#include <kvs/Vector3>
+#include <kvs/RGBColor>
+#include <kvs/ColorMap>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Compressed point array class.
+ *
+ *  Each point is stored in 9 bytes: the coordinate quantized to 16 bits per
+ *  axis relative to the bounding box of the block that contains the point,
+ *  the normal vector encoded to 2x8 bits by the octahedral mapping, and the
+ *  8-bit index to the color palette sampled from the color map. The points
+ *  are divided into the blocks of BlockSize consecutive points, and the
+ *  bounding boxes of the blocks have to be given by expandBlock() before
+ *  the points are set.
+ */
+/*===========================================================================*/
+class CompressedPointArray
+{
+public:
+    enum
+    {
+        BlockSize = 65536, ///< number of points in a block
+        PaletteSize = 256 ///< number of colors in the palette
+    };
+
+private:
+    kvs::ValueArray<kvs::Int16> m_coords{}; ///< quantized coordinates (offset by -32768)
+    kvs::ValueArray<kvs::UInt8> m_normals{}; ///< octahedral-encoded normal vectors
+    kvs::ValueArray<kvs::UInt8> m_color_indices{}; ///< indices to the color palette
+    kvs::ValueArray<kvs::UInt8> m_palette{}; ///< color palette (RGB x PaletteSize)
+    kvs::ValueArray<kvs::Real32> m_block_min_coords{}; ///< min. coordinates of the blocks
+    kvs::ValueArray<kvs::Real32> m_block_max_coords{}; ///< max. coordinates of the blocks
+    kvs::Real32 m_min_value = 0.0f; ///< min. value of the palette
+    kvs::Real32 m_max_value = 1.0f; ///< max. value of the palette
+
+public:
+    CompressedPointArray() = default;
+
+    size_t numberOfPoints() const { return m_color_indices.size(); }
+    size_t numberOfBlocks() const { return m_block_min_coords.size() / 3; }
+    size_t byteSize() const;
+    bool empty() const { return m_color_indices.empty(); }
+
+    const kvs::ValueArray<kvs::Int16>& coords() const { return m_coords; }
+    const kvs::ValueArray<kvs::UInt8>& normals() const { return m_normals; }
+    const kvs::ValueArray<kvs::UInt8>& colorIndices() const { return m_color_indices; }
+    const kvs::ValueArray<kvs::UInt8>& palette() const { return m_palette; }
+    const kvs::ValueArray<kvs::Real32>& blockMinCoords() const { return m_block_min_coords; }
+    const kvs::ValueArray<kvs::Real32>& blockMaxCoords() const { return m_block_max_coords; }
+    kvs::Vec3 blockMinCoord( const size_t block ) const { return kvs::Vec3( m_block_min_coords.data() + block * 3 ); }
+    kvs::Vec3 blockMaxCoord( const size_t block ) const { return kvs::Vec3( m_block_max_coords.data() + block * 3 ); }
+    size_t blockFirst( const size_t block ) const { return block * BlockSize; }
+    size_t blockCount( const size_t block ) const;
+
+    void allocate( const size_t npoints );
+    void release();
+    void setColorMap( const kvs::ColorMap& color_map );
+    void expandBlock( const size_t first, const size_t count, const kvs::Vec3& min_coord, const kvs::Vec3& max_coord );
+    void set( const size_t index, const kvs::Vec3& coord, const kvs::Vec3& normal, const kvs::Real32 value );
+
+    kvs::Vec3 coord( const size_t index ) const;
+    kvs::Vec3 normal( const size_t index ) const;
+    kvs::RGBColor color( const size_t index ) const;
+
+    CompressedPointArray clone() const;
+};
+
+} // end of namespace kvs
@@ -382,6 +382,7 @@ void PointObject::shallowCopy( const PointObject& other )
 {
     BaseClass::shallowCopy( other );
     m_sizes = other.sizes();
+    m_compressed_points = other.compressedPoints();
 }
 
 /*===========================================================================*/
@@ -394,6 +395,7 @@ void PointObject::deepCopy( const PointObject& other )
 {
     BaseClass::deepCopy( other );
     m_sizes = other.sizes().clone();
+    m_compressed_points = other.compressedPoints().clone();
 }
 
 /*===========================================================================*/
@@ -405,6 +407,7 @@ void PointObject::clear()
 {
     BaseClass::clear();
     m_sizes.release();
+    m_compressed_points.release();
 }
 
 /*===========================================================================*/
@@ -419,6 +422,12 @@ void PointObject::print( std::ostream& os, const kvs::Indent& indent ) const
     os << indent << "Object type : " << "point object" << std::endl;
     BaseClass::print( os, indent );
     os << indent << "Number of sizes : " << this->numberOfSizes() << std::endl;
+    if ( this->isCompressed() )
+    {
+        const auto& points = this->compressedPoints();
+        os << indent << "Number of compressed points : " << points.numberOfPoints() << std::endl;
+        os << indent << "Size of compressed points : " << points.byteSize() << " [bytes]" << std::endl;
+    }
 }
 
 /*===========================================================================*/
@@ -14,6 +14,7 @@
 #include <kvs/Module>
 #include <kvs/Indent>
 #include <kvs/Deprecated>
+#include <kvs/CompressedPointArray>
 
 
 namespace kvs
@@ -34,6 +35,7 @@ class PointObject : public kvs::GeometryObjectBase
 
 private:
     kvs::ValueArray<kvs::Real32> m_sizes{}; ///< size array
+    kvs::CompressedPointArray m_compressed_points{}; ///< compressed points
 
 public:
     PointObject();
@@ -51,11 +53,14 @@ public:
 
     void setSizes( const kvs::ValueArray<kvs::Real32>& sizes ) { m_sizes = sizes; }
     void setSize( const kvs::Real32 size );
+    void setCompressedPoints( const kvs::CompressedPointArray& points ) { m_compressed_points = points; }
 
     size_t numberOfSizes() const { return m_sizes.size(); }
+    bool isCompressed() const { return !m_compressed_points.empty(); }
 
     kvs::Real32 size( const size_t index = 0 ) const { return m_sizes[index]; }
     const kvs::ValueArray<kvs::Real32>& sizes() const { return m_sizes; }
+    const kvs::CompressedPointArray& compressedPoints() const { return m_compressed_points; }
 
 public:
     KVS_DEPRECATED( PointObject(
@@ -8,6 +8,9 @@
 #include <kvs/Value>
 #include <kvs/Math>
 #include <kvs/KVSMLTableObject>
+#include <kvs/OpenMP>
+#include <kvs/Assert>
+#include <algorithm>
 #include <utility>
 
 
@@ -35,115 +38,165 @@ kvs::KVSMLTableObject::WritingDataType GetWritingDataType( const bool ascii, con
     }
 }
 
-std::pair<kvs::Real64,kvs::Real64> GetMinMaxValues( const kvs::AnyValueArray& array )
+/*===========================================================================*/
+/**
+ *  @brief  Functor to calculate the min. and max. values of the column.
+ */
+/*===========================================================================*/
+struct MinMax
 {
-    kvs::Real64 min_value = kvs::Value<kvs::Real64>::Max();
-    kvs::Real64 max_value = kvs::Value<kvs::Real64>::Min();
-    const std::type_info& type = array.typeInfo()->type();
-    if ( type == typeid( kvs::Int8 ) )
-    {
-        const kvs::Int8* value = static_cast<const kvs::Int8*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
-        {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
-        }
-    }
-    else if ( type == typeid( kvs::UInt8 ) )
+    size_t nrows;
+    kvs::Real64 min_value;
+    kvs::Real64 max_value;
+
+    template <typename T>
+    void operator ()( const T* values )
     {
-        const kvs::UInt8* value = static_cast<const kvs::UInt8*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+        // NaN values (e.g. missing values in CSV) are ignored.
+        for ( size_t i = 0; i < nrows; i++ )
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
+            const kvs::Real64 value = static_cast<kvs::Real64>( values[i] );
+            if ( value < min_value ) { min_value = value; }
+            if ( value > max_value ) { max_value = value; }
         }
     }
-    else if ( type == typeid( kvs::Int16 ) )
+};
+
+std::pair<kvs::Real64,kvs::Real64> GetMinMaxValues( const kvs::AnyValueArray& array )
+{
+    ::MinMax minmax = { array.size(), kvs::Value<kvs::Real64>::Max(), kvs::Value<kvs::Real64>::Min() };
+    if ( !kvs::TableObject::Visit( array, minmax ) || minmax.min_value > minmax.max_value )
     {
-        const kvs::Int16* value = static_cast<const kvs::Int16*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
-        {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
-        }
+        minmax.min_value = 0.0;
+        minmax.max_value = 0.0;
     }
-    else if ( type == typeid( kvs::UInt16 ) )
+
+    return std::pair<kvs::Real64,kvs::Real64>( minmax.min_value, minmax.max_value );
+}
+
+template <typename T>
+void Clear( T& values )
+{
+    if ( values.size() > 0 ) { values.clear(); T().swap( values ); }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Functor to count up the rows out of the range.
+ */
+/*===========================================================================*/
+struct CountFails
+{
+    size_t nrows;
+    kvs::Real64 min_range;
+    kvs::Real64 max_range;
+    kvs::UInt16* counts;
+
+    template <typename T>
+    void operator ()( const T* values ) const
     {
-        const kvs::UInt16* value = static_cast<const kvs::UInt16*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+        const long n = static_cast<long>( nrows );
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < n; i++ )
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
+            const kvs::Real64 value = static_cast<kvs::Real64>( values[i] );
+            if ( !( min_range <= value && value <= max_range ) ) { counts[i]++; }
         }
     }
-    else if ( type == typeid( kvs::Int32 ) )
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Functor to sort the row indices by the value.
+ *
+ *  The rows with NaN are excluded since they are always out of the range.
+ *  The chunks of the indices are sorted in parallel and merged.
+ */
+/*===========================================================================*/
+struct SortRows
+{
+    size_t nrows;
+    kvs::ValueArray<kvs::UInt32> indices;
+
+    template <typename T>
+    void operator ()( const T* values )
     {
-        const kvs::Int32* value = static_cast<const kvs::Int32*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+        std::vector<kvs::UInt32> sorted;
+        sorted.reserve( nrows );
+        for ( size_t i = 0; i < nrows; i++ )
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
+            if ( values[i] == values[i] ) { sorted.push_back( static_cast<kvs::UInt32>( i ) ); }
         }
-    }
-    else if ( type == typeid( kvs::UInt32 ) )
-    {
-        const kvs::UInt32* value = static_cast<const kvs::UInt32*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+
+        auto less = [values] ( const kvs::UInt32 a, const kvs::UInt32 b )
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
-        }
-    }
-    else if ( type == typeid( kvs::Int64 ) )
-    {
-        const kvs::Int64* value = static_cast<const kvs::Int64*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+            return values[a] < values[b] || ( values[a] == values[b] && a < b );
+        };
+
+        const long n = static_cast<long>( sorted.size() );
+        const long nchunks = std::max( 1L, std::min<long>( kvs::OpenMP::GetMaxThreads(), n / 4096 ) );
+        const long chunk_size = ( n + nchunks - 1 ) / nchunks;
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < nchunks; i++ )
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
+            const long begin = std::min( i * chunk_size, n );
+            const long end = std::min( begin + chunk_size, n );
+            std::sort( sorted.begin() + begin, sorted.begin() + end, less );
         }
-    }
-    else if ( type == typeid( kvs::UInt64 ) )
-    {
-        const kvs::UInt64* value = static_cast<const kvs::UInt64*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+
+        for ( long width = chunk_size; width < n; width *= 2 )
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
+            const long npairs = ( n + 2 * width - 1 ) / ( 2 * width );
+            KVS_OMP_PARALLEL_FOR( schedule(static) )
+            for ( long i = 0; i < npairs; i++ )
+            {
+                const long begin = i * 2 * width;
+                const long middle = std::min( begin + width, n );
+                const long end = std::min( begin + 2 * width, n );
+                std::inplace_merge( sorted.begin() + begin, sorted.begin() + middle, sorted.begin() + end, less );
+            }
         }
+
+        indices = kvs::ValueArray<kvs::UInt32>( sorted );
     }
-    else if ( type == typeid( kvs::Real32 ) )
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Functor to find the rows whose values are in the given interval.
+ *
+ *  The interval is [lower, upper) if closed_upper is false, otherwise
+ *  (lower, upper]. The rows are given by [begin, end) in the sorted indices.
+ */
+/*===========================================================================*/
+struct FindRows
+{
+    const kvs::ValueArray<kvs::UInt32>& indices;
+    kvs::Real64 lower;
+    kvs::Real64 upper;
+    bool closed_upper;
+    size_t begin;
+    size_t end;
+
+    template <typename T>
+    void operator ()( const T* values )
     {
-        const kvs::Real32* value = static_cast<const kvs::Real32*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+        const kvs::UInt32* first = indices.data();
+        const kvs::UInt32* last = first + indices.size();
+        if ( closed_upper )
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
+            auto less = [values] ( const kvs::Real64 v, const kvs::UInt32 i ) { return v < values[i]; };
+            begin = std::upper_bound( first, last, lower, less ) - first;
+            end = std::upper_bound( first, last, upper, less ) - first;
         }
-    }
-    else if ( type == typeid( kvs::Real64 ) )
-    {
-        const kvs::Real64* value = static_cast<const kvs::Real64*>( array.data() );
-        for( size_t i = 0; i < array.size(); i++ )
+        else
         {
-            min_value = kvs::Math::Min( min_value, kvs::Real64( value[i] ) );
-            max_value = kvs::Math::Max( max_value, kvs::Real64( value[i] ) );
+            auto less = [values] ( const kvs::UInt32 i, const kvs::Real64 v ) { return values[i] < v; };
+            begin = std::lower_bound( first, last, lower, less ) - first;
+            end = std::lower_bound( first, last, upper, less ) - first;
         }
     }
-    else if ( type == typeid( std::string ) )
-    {
-        min_value = 0.0;
-        max_value = 0.0;
-    }
-
-    return std::pair<kvs::Real64,kvs::Real64>( min_value, max_value );
-}
-
-template <typename T>
-void Clear( T& values )
-{
-    if ( values.size() > 0 ) { values.clear(); T().swap( values ); }
-}
+};
 
 } // end of namespace
 
@@ -168,7 +221,9 @@ void TableObject::shallowCopy( const TableObject& other )
     this->m_max_values = other.maxValues();
     this->m_min_ranges = other.minRanges();
     this->m_max_ranges = other.maxRanges();
-    this->m_inside_range_flags = other.insideRangeFlags();
+    this->m_inside_range_flags = other.insideRangeFlags().clone();
+    this->m_fail_counts = other.m_fail_counts.clone();
+    this->m_sorted_indices = other.m_sorted_indices;
 }
 
 /*===========================================================================*/
@@ -185,18 +240,22 @@ void TableObject::deepCopy( const TableObject& other )
     ::Clear( m_max_values );
     ::Clear( m_min_ranges );
     ::Clear( m_max_ranges );
-    ::Clear( m_inside_range_flags );
+    ::Clear( m_sorted_indices );
+    m_inside_range_flags.release();
+    m_fail_counts.release();
 
     BaseClass::operator=( other );
     this->m_nrows = other.numberOfRows();
     this->m_ncolumns = other.numberOfColumns();
-    for ( size_t i = 0; i < m_table.columnSize(); i++ ) this->m_table.pushBackColumn( other.column(i).clone() );
-    for ( size_t i = 0; i < m_labels.size(); i++ ) this->m_labels.push_back( other.label(i) );
-    for ( size_t i = 0; i < m_min_values.size(); i++ ) this->m_min_values.push_back( other.minValue(i) );
-    for ( size_t i = 0; i < m_max_values.size(); i++ ) this->m_max_values.push_back( other.maxValue(i) );
-    for ( size_t i = 0; i < m_min_ranges.size(); i++ ) this->m_min_ranges.push_back( other.minRange(i) );
-    for ( size_t i = 0; i < m_max_ranges.size(); i++ ) this->m_max_ranges.push_back( other.maxRange(i) );
-    for ( size_t i = 0; i < m_inside_range_flags.size(); i++ ) this->m_inside_range_flags.push_back( other.insideRange(i) );
+    for ( size_t i = 0; i < other.table().columnSize(); i++ ) this->m_table.pushBackColumn( other.column(i).clone() );
+    for ( size_t i = 0; i < other.labels().size(); i++ ) this->m_labels.push_back( other.label(i) );
+    for ( size_t i = 0; i < other.minValues().size(); i++ ) this->m_min_values.push_back( other.minValue(i) );
+    for ( size_t i = 0; i < other.maxValues().size(); i++ ) this->m_max_values.push_back( other.maxValue(i) );
+    for ( size_t i = 0; i < other.minRanges().size(); i++ ) this->m_min_ranges.push_back( other.minRange(i) );
+    for ( size_t i = 0; i < other.maxRanges().size(); i++ ) this->m_max_ranges.push_back( other.maxRange(i) );
+    this->m_inside_range_flags = other.insideRangeFlags().clone();
+    this->m_fail_counts = other.m_fail_counts.clone();
+    this->m_sorted_indices.resize( m_ncolumns );
 }
 
 /*===========================================================================*/
@@ -320,7 +379,15 @@ void TableObject::addColumn(
     m_max_values.push_back( max_value );
     m_min_ranges.push_back( min_value );
     m_max_ranges.push_back( max_value );
-    m_inside_range_flags.resize( m_nrows, 1 );
+    m_sorted_indices.push_back( kvs::ValueArray<kvs::UInt32>() );
+    if ( m_inside_range_flags.size() != m_nrows )
+    {
+        m_inside_range_flags = InsideRangeFlags( m_nrows, true );
+    }
+
+    // The fail counts will be recalculated with the new column.
+    KVS_ASSERT( m_ncolumns <= 0xFFFF );
+    m_fail_counts.release();
 }
 
 /*===========================================================================*/
@@ -338,7 +405,11 @@ void TableObject::setTable( const kvs::AnyValueTable& table, const Labels& label
     ::Clear( m_max_values );
     ::Clear( m_min_ranges );
     ::Clear( m_max_ranges );
-    ::Clear( m_inside_range_flags );
+    ::Clear( m_sorted_indices );
+    m_inside_range_flags.release();
+    m_fail_counts.release();
+    m_nrows = 0;
+    m_ncolumns = 0;
 
     for ( size_t i = 0; i < table.columnSize(); i++ )
     {
@@ -406,51 +477,28 @@ void TableObject::setMinRange( const size_t column_index, const kvs::Real64 rang
     const kvs::Real64 min_range_new = kvs::Math::Clamp( range, min_value, max_range );
 
     if ( kvs::Math::Equal( min_range_old, min_range_new ) ) return;
+    if ( m_table.columns().size() > 0 ) { this->update_fail_counts(); }
     m_min_ranges[column_index] = min_range_new;
 
-    const size_t nrows = this->numberOfRows();
-    const size_t ncolumns = this->numberOfColumns();
     if ( m_table.columns().size() > 0 )
     {
         if ( min_range_new > min_range_old )
         {
-            /* In case of flags turned off, you just have to check whether the value
-             * in the specified column is included in the range.
+            /* The values in [A,B) turn off.
              *
              *  (before) |xxx+oooooooo*xxxxxx|  o: on, x: off, +: min_range, *: max_range
              *  (after)  |xxxAxxxxBooo*xxxxxx|  A: min_range_old, B: min_range_new
              */
-            const kvs::AnyValueArray& column = this->column( column_index );
-            for ( size_t i = 0; i < nrows; i++ )
-            {
-                const kvs::Real64 value = column[i].to<kvs::Real64>();
-                if (  min_range_old <= value && value <= min_range_new )
-                {
-                    m_inside_range_flags[i] = 0;
-                }
-            }
+            this->update_range_flags( column_index, min_range_old, min_range_new, false, +1 );
         }
         else
         {
-            /* In case of flags turned on, you have to check the all of colums.
+            /* The values in [A,B) turn on for the column.
              *
              *  (before) |xxxxxxxx+ooo*xxxxxx|  o: on, x: off, +: min_range, *: max_range
              *  (after)  |xxxAooooBooo*xxxxxx|  A: min_range, B: min_range_old
              */
-            for ( size_t i = 0; i < nrows; i++ )
-            {
-                m_inside_range_flags[i] = 1;
-                for ( size_t j = 0; j < ncolumns; j++ )
-                {
-                    const kvs::AnyValueArray& column = this->column( j );
-                    const kvs::Real64 value = column[i].to<kvs::Real64>();
-                    if (  !( m_min_ranges[j] <= value && value <= m_max_ranges[j] ) )
-                    {
-                        m_inside_range_flags[i] = 0;
-                        break;
-                    }
-                }
-            }
+            this->update_range_flags( column_index, min_range_new, min_range_old, false, -1 );
         }
     }
 }
@@ -471,51 +519,28 @@ void TableObject::setMaxRange( const size_t column_index, const kvs::Real64 rang
     const kvs::Real64 max_range_new = kvs::Math::Clamp( range, min_range, max_value );
 
     if ( kvs::Math::Equal( max_range_old, max_range_new ) ) return;
+    if ( m_table.columns().size() > 0 ) { this->update_fail_counts(); }
     m_max_ranges[column_index] = max_range_new;
 
-    const size_t nrows = this->numberOfRows();
-    const size_t ncolumns = this->numberOfColumns();
     if ( m_table.columns().size() > 0 )
     {
         if ( max_range_new > max_range_old )
         {
-            /* In case of flags turned on, you have to check the all of colums.
+            /* The values in (A,B] turn on for the column.
              *
              *  (before) |xxx*oooooooo+xxxxxx|  o: on, x: off, *: min_range, +: max_range
              *  (after)  |xxx*ooooooooAoooBxx|  A: max_range_old, B: max_range_new
              */
-            for ( size_t i = 0; i < nrows; i++ )
-            {
-                m_inside_range_flags[i] = 1;
-                for ( size_t j = 0; j < ncolumns; j++ )
-                {
-                    const kvs::AnyValueArray& column = this->column( j );
-                    const kvs::Real64 value = column[i].to<kvs::Real64>();
-                    if (  !( m_min_ranges[j] <= value && value <= m_max_ranges[j] ) )
-                    {
-                        m_inside_range_flags[i] = 0;
-                        break;
-                    }
-                }
-            }
+            this->update_range_flags( column_index, max_range_old, max_range_new, true, -1 );
         }
         else
         {
-            /* In case of flags turned off, you just have to check whether the value
-             * in the specified column is included in the range.
+            /* The values in (B,A] turn off.
              *
              *  (before) |xxx*oooooooo+xxxxxx|  o: on, x: off, *: min_range, +: max_range
              *  (after)  |xxx*ooooBxxxAxxxxxx|  A: max_range_old, B: max_range_new
              */
-            const kvs::AnyValueArray& column = this->column( column_index );
-            for ( size_t i = 0; i < nrows; i++ )
-            {
-                const kvs::Real64 value = column[i].to<kvs::Real64>();
-                if (  max_range_new <= value && value <= max_range_old )
-                {
-                    m_inside_range_flags[i] = 0;
-                }
-            }
+            this->update_range_flags( column_index, max_range_new, max_range_old, true, +1 );
         }
     }
 }
@@ -618,7 +643,102 @@ void TableObject::resetRange()
         m_min_ranges[i] = this->minValue(i);
     }
 
-    std::fill( m_inside_range_flags.begin(), m_inside_range_flags.end(), 1 );
+    m_inside_range_flags.set();
+    m_fail_counts.release();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the inside range flags.
+ *  @param  inside_range_flags [in] inside range flags
+ */
+/*===========================================================================*/
+void TableObject::setInsideRangeFlags( const InsideRangeFlags& inside_range_flags )
+{
+    m_inside_range_flags = inside_range_flags.clone();
+    m_fail_counts.release();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the fail counts for each row if not calculated.
+ *
+ *  The fail count of the row is the number of columns whose values are out of
+ *  the range. This is calculated by scanning all of the columns only once
+ *  after the table or the ranges are set, and then it is updated
+ *  incrementally for the rows affected by the range changes.
+ */
+/*===========================================================================*/
+void TableObject::update_fail_counts()
+{
+    const size_t nrows = this->numberOfRows();
+    if ( m_fail_counts.size() == nrows ) { return; }
+
+    m_fail_counts.allocate( nrows );
+    m_fail_counts.fill( 0 );
+    for ( size_t j = 0; j < this->numberOfColumns(); j++ )
+    {
+        ::CountFails count = { this->column(j).size(), m_min_ranges[j], m_max_ranges[j], m_fail_counts.data() };
+        kvs::TableObject::Visit( this->column(j), count );
+    }
+
+    m_inside_range_flags = InsideRangeFlags( nrows, true );
+    for ( size_t i = 0; i < nrows; i++ )
+    {
+        if ( m_fail_counts[i] > 0 ) { m_inside_range_flags.reset( i ); }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Builds the row indices sorted by the values of the column if not built.
+ *  @param  column_index [in] column index
+ */
+/*===========================================================================*/
+void TableObject::update_sorted_indices( const size_t column_index )
+{
+    if ( m_sorted_indices[column_index].size() > 0 ) { return; }
+
+    const kvs::AnyValueArray& column = this->column( column_index );
+    ::SortRows sort = { column.size(), kvs::ValueArray<kvs::UInt32>() };
+    kvs::TableObject::Visit( column, sort );
+    m_sorted_indices[column_index] = sort.indices;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the fail counts and the flags of the rows in the interval.
+ *  @param  column_index [in] column index
+ *  @param  lower [in] lower bound of the interval
+ *  @param  upper [in] upper bound of the interval
+ *  @param  closed_upper [in] (lower, upper] if true, otherwise [lower, upper)
+ *  @param  dcount [in] difference of the fail count (+1 or -1)
+ *
+ *  The rows in the interval are found by the binary search on the sorted
+ *  indices, so that the cost is proportional to the number of affected rows.
+ */
+/*===========================================================================*/
+void TableObject::update_range_flags(
+    const size_t column_index,
+    const kvs::Real64 lower,
+    const kvs::Real64 upper,
+    const bool closed_upper,
+    const int dcount )
+{
+    this->update_sorted_indices( column_index );
+
+    const kvs::ValueArray<kvs::UInt32>& indices = m_sorted_indices[column_index];
+    ::FindRows find = { indices, lower, upper, closed_upper, 0, 0 };
+    if ( !kvs::TableObject::Visit( this->column( column_index ), find ) ) { return; }
+
+    kvs::UInt16* counts = m_fail_counts.data();
+    for ( size_t i = find.begin; i < find.end; i++ )
+    {
+        const kvs::UInt32 row = indices[i];
+        counts[row] = static_cast<kvs::UInt16>( counts[row] + dcount );
+        if ( counts[row] == 0 ) { m_inside_range_flags.set( row ); }
+        else { m_inside_range_flags.reset( row ); }
+    }
 }
 
 } // end of namespace kvs
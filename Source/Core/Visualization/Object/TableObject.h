@@ -12,6 +12,8 @@
 #include <kvs/Type>
 #include <kvs/AnyValueArray>
 #include <kvs/AnyValueTable>
+#include <kvs/BitArray>
+#include <kvs/ValueArray>
 #include <kvs/Indent>
 #include <kvs/Deprecated>
 
@@ -33,7 +35,9 @@ public:
     using Columns = kvs::AnyValueTable::Columns;
     using Labels = std::vector<std::string>;
     using Values = std::vector<kvs::Real64>;
-    using InsideRangeFlags = std::vector<kvs::UInt8>;
+    using InsideRangeFlags = kvs::BitArray;
+    using FailCounts = kvs::ValueArray<kvs::UInt16>;
+    using SortedIndices = std::vector<kvs::ValueArray<kvs::UInt32>>;
 
 private:
     size_t m_nrows = 0; ///< number of rows
@@ -45,6 +49,8 @@ private:
     Values m_min_ranges{}; ///< min. value range
     Values m_max_ranges{}; ///< max. value range
     InsideRangeFlags m_inside_range_flags{}; ///< check flags for value range
+    FailCounts m_fail_counts{}; ///< number of columns out of the range for each row
+    SortedIndices m_sorted_indices{}; ///< row indices sorted by the value for each column
 
 public:
     TableObject(): BaseClass( Table ) {}
@@ -87,8 +93,13 @@ public:
     kvs::Real64 maxValue( const size_t index ) const { return m_max_values[index]; }
     kvs::Real64 minRange( const size_t column_index ) const { return m_min_ranges[column_index]; }
     kvs::Real64 maxRange( const size_t column_index ) const { return m_max_ranges[column_index]; }
-    bool insideRange( const size_t row_index ) const { return m_inside_range_flags[row_index] == 1; }
+    bool insideRange( const size_t row_index ) const { return m_inside_range_flags.test( row_index ); }
     template <typename T> T at( const size_t row, const size_t col ) const { return m_table.column(col).at<T>(row); }
+    template <typename T> kvs::ValueArray<T> columnAs( const size_t index ) const { return m_table.column(index).asValueArray<T>(); }
+    template <typename Visitor> bool visitColumn( const size_t index, Visitor&& visitor ) const { return Visit( this->column(index), visitor ); }
+
+    template <typename Visitor>
+    static bool Visit( const kvs::AnyValueArray& array, Visitor&& visitor );
 
 protected:
     void setNumberOfRows( const size_t nrows ) { m_nrows = nrows; }
@@ -96,9 +107,14 @@ protected:
     void setLabels( const Labels& labels ) { m_labels = labels; }
     void setMinValues( const Values& min_values ) { m_min_values = min_values; }
     void setMaxValues( const Values& max_values ) { m_max_values = max_values; }
-    void setMinRanges( const Values& min_ranges ) { m_min_ranges = min_ranges; }
-    void setMaxRanges( const Values& max_ranges ) { m_max_ranges = max_ranges; }
-    void setInsideRangeFlags( const InsideRangeFlags& inside_range_flags ) { m_inside_range_flags = inside_range_flags; }
+    void setMinRanges( const Values& min_ranges ) { m_min_ranges = min_ranges; m_fail_counts.release(); }
+    void setMaxRanges( const Values& max_ranges ) { m_max_ranges = max_ranges; m_fail_counts.release(); }
+    void setInsideRangeFlags( const InsideRangeFlags& inside_range_flags );
+
+private:
+    void update_fail_counts();
+    void update_sorted_indices( const size_t column_index );
+    void update_range_flags( const size_t column_index, const kvs::Real64 lower, const kvs::Real64 upper, const bool inclusive, const int dcount );
 
 public:
     typedef KVS_DEPRECATED( std::vector<std::string> LabelList );
@@ -116,4 +132,35 @@ public:
     KVS_DEPRECATED( const InsideRangeFlags& insideRangeList() const ) { return this->insideRangeFlags(); }
 };
 
+/*===========================================================================*/
+/**
+ *  @brief  Calls the visitor with the typed pointer to the column values.
+ *  @param  array [in] column array
+ *  @param  visitor [in] visitor that has operator()( const T* values )
+ *  @return false if the array is not numeric
+ *
+ *  The type is dispatched only once for the column, so the loop over the
+ *  values in the visitor is compiled for each value type.
+ */
+/*===========================================================================*/
+template <typename Visitor>
+inline bool TableObject::Visit( const kvs::AnyValueArray& array, Visitor&& visitor )
+{
+    const void* data = array.data();
+    switch ( array.typeID() )
+    {
+    case kvs::Type::TypeInt8: visitor( static_cast<const kvs::Int8*>( data ) ); return true;
+    case kvs::Type::TypeUInt8: visitor( static_cast<const kvs::UInt8*>( data ) ); return true;
+    case kvs::Type::TypeInt16: visitor( static_cast<const kvs::Int16*>( data ) ); return true;
+    case kvs::Type::TypeUInt16: visitor( static_cast<const kvs::UInt16*>( data ) ); return true;
+    case kvs::Type::TypeInt32: visitor( static_cast<const kvs::Int32*>( data ) ); return true;
+    case kvs::Type::TypeUInt32: visitor( static_cast<const kvs::UInt32*>( data ) ); return true;
+    case kvs::Type::TypeInt64: visitor( static_cast<const kvs::Int64*>( data ) ); return true;
+    case kvs::Type::TypeUInt64: visitor( static_cast<const kvs::UInt64*>( data ) ); return true;
+    case kvs::Type::TypeReal32: visitor( static_cast<const kvs::Real32*>( data ) ); return true;
+    case kvs::Type::TypeReal64: visitor( static_cast<const kvs::Real64*>( data ) ); return true;
+    default: return false;
+    }
+}
+
 } // end of namespace kvs
@@ -0,0 +1,598 @@
+/*****************************************************************************/
+/**
+ *  @file   BatchedGeometryRenderer.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#include "BatchedGeometryRenderer.h"
+#include <kvs/DebugNew>
+#include <kvs/OpenGL>
+#include <kvs/ShaderSource>
+#include <kvs/IndexBufferObject>
+#include <kvs/IgnoreUnusedVariable>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the connections of the polygon object are shared.
+ *  @param  polygon [in] pointer to the polygon object
+ *  @return true if the vertices can be referred by the connections
+ */
+/*===========================================================================*/
+inline bool HasConnections( const kvs::PolygonObject* polygon )
+{
+    // The vertices are duplicated for each polygon in case of the polygon
+    // normal or the polygon color.
+    return
+        polygon->numberOfConnections() > 0 &&
+        polygon->normalType() != kvs::PolygonObject::PolygonNormal &&
+        polygon->colorType() != kvs::PolygonObject::PolygonColor;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the line segments of the line object.
+ *  @param  line [in] pointer to the line object
+ *  @return vertex indices and line color index of the segments (3 x nsegments)
+ */
+/*===========================================================================*/
+std::vector<size_t> LineSegments( const kvs::LineObject* line )
+{
+    std::vector<size_t> segments;
+    auto append = [&] ( const size_t v0, const size_t v1, const size_t c )
+    {
+        segments.push_back( v0 );
+        segments.push_back( v1 );
+        segments.push_back( c );
+    };
+
+    const kvs::UInt32* connections = line->connections().data();
+    switch ( line->lineType() )
+    {
+    case kvs::LineObject::Strip:
+    {
+        const size_t nvertices = line->numberOfVertices();
+        for ( size_t i = 0; i + 1 < nvertices; i++ ) { append( i, i + 1, i ); }
+        break;
+    }
+    case kvs::LineObject::Uniline:
+    {
+        const size_t nconnections = line->connections().size();
+        for ( size_t i = 0; i + 1 < nconnections; i++ )
+        {
+            append( connections[i], connections[ i + 1 ], i );
+        }
+        break;
+    }
+    case kvs::LineObject::Polyline:
+    {
+        const size_t nlines = line->connections().size() / 2;
+        for ( size_t i = 0, index = 0; i < nlines; i++ )
+        {
+            const size_t id0 = connections[ 2 * i + 0 ];
+            const size_t id1 = connections[ 2 * i + 1 ];
+            for ( size_t j = id0; j < id1; j++, index++ ) { append( j, j + 1, index ); }
+        }
+        break;
+    }
+    case kvs::LineObject::Segment:
+    {
+        const size_t nsegments = line->connections().size() / 2;
+        for ( size_t i = 0; i < nsegments; i++ )
+        {
+            append( connections[ 2 * i + 0 ], connections[ 2 * i + 1 ], i );
+        }
+        break;
+    }
+    default: break;
+    }
+
+    return segments;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the color of the geometry object.
+ *  @param  object [in] pointer to the geometry object
+ *  @param  index [in] color index
+ *  @return color (white if the object has no color)
+ */
+/*===========================================================================*/
+inline kvs::RGBColor Color( const kvs::GeometryObjectBase* object, const size_t index )
+{
+    const size_t ncolors = object->numberOfColors();
+    if ( ncolors == 0 ) { return kvs::RGBColor::White(); }
+    return object->color( ncolors == 1 ? 0 : index );
+}
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Appends a vertex to the merged arrays.
+ *  @param  coord [in] coordinate
+ *  @param  color [in] color
+ *  @param  alpha [in] opacity
+ *  @param  normal [in] normal vector
+ *  @param  object_index [in] index of the object containing the vertex
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::BufferObject::appendVertex(
+    const kvs::Vec3& coord,
+    const kvs::RGBColor& color,
+    const kvs::UInt8 alpha,
+    const kvs::Vec3& normal,
+    const size_t object_index )
+{
+    m_coords.insert( m_coords.end(), { coord.x(), coord.y(), coord.z() } );
+    m_colors.insert( m_colors.end(), { color.r(), color.g(), color.b(), alpha } );
+    m_normals.insert( m_normals.end(), { normal.x(), normal.y(), normal.z() } );
+    m_object_indices.push_back( static_cast<kvs::Real32>( object_index ) );
+    m_is_modified = true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Adds a range of the indices to the draw list.
+ *  @param  first [in] index of the first index
+ *  @param  count [in] number of indices
+ *
+ *  The range is merged into the last one if they are contiguous, so that the
+ *  consecutive visible objects are drawn as a single range.
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::BufferObject::addDrawRange( const size_t first, const size_t count )
+{
+    if ( count == 0 ) { return; }
+
+    const auto* offset = reinterpret_cast<const GLvoid*>( first * sizeof( kvs::UInt32 ) );
+    if ( !m_counts.empty() )
+    {
+        const auto* last = static_cast<const kvs::UInt8*>( m_offsets.back() );
+        if ( last + m_counts.back() * sizeof( kvs::UInt32 ) == offset )
+        {
+            m_counts.back() += static_cast<GLsizei>( count );
+            return;
+        }
+    }
+
+    m_counts.push_back( static_cast<GLsizei>( count ) );
+    m_offsets.push_back( offset );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the buffer object.
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::BufferObject::release()
+{
+    m_manager.release();
+    m_is_modified = !m_connections.empty();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the buffer object from the merged arrays.
+ *  @param  shader_program [in] shader program for the attribute location
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::BufferObject::create( const kvs::ProgramObject& shader_program )
+{
+    m_manager.release();
+    m_is_modified = false;
+    if ( m_connections.empty() ) { return; }
+
+    // The merged arrays are kept to append the objects after the creation.
+    const kvs::ValueArray<kvs::Real32> coords( m_coords );
+    const kvs::ValueArray<kvs::UInt8> colors( m_colors );
+    const kvs::ValueArray<kvs::Real32> normals( m_normals );
+    const kvs::ValueArray<kvs::Real32> indices( m_object_indices );
+    const kvs::ValueArray<kvs::UInt32> connections( m_connections );
+
+    const auto location = shader_program.attributeLocation("object_index");
+    m_manager.setVertexAttribArray( indices, location, 1 );
+    m_manager.setVertexArray( coords, 3 );
+    m_manager.setColorArray( colors, 4 );
+    m_manager.setNormalArray( normals );
+    m_manager.setIndexArray( connections );
+    m_manager.create();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws the ranges in the draw list by a single multi-draw call.
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::BufferObject::draw()
+{
+    if ( m_counts.empty() ) { return; }
+
+    kvs::VertexBufferObjectManager::Binder bind( m_manager );
+    kvs::IndexBufferObject::Binder bind_ibo( m_manager.indexBufferObject() );
+    const auto drawcount = static_cast<GLsizei>( m_counts.size() );
+    kvs::OpenGL::MultiDrawElements( m_mode, m_counts.data(), GL_UNSIGNED_INT, m_offsets.data(), drawcount );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Executes rendering process.
+ *  @param  object [in] pointer to the bounding object (not referred)
+ *  @param  camera [in] pointer to the camera
+ *  @param  light [in] pointer to the light
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light )
+{
+    kvs::IgnoreUnusedVariable( object );
+    kvs::IgnoreUnusedVariable( camera );
+    kvs::IgnoreUnusedVariable( light );
+
+    BaseClass::startTimer();
+    kvs::OpenGL::WithPushedAttrib p( GL_ALL_ATTRIB_BITS );
+
+    // The buffers are recreated with the rebuilt shader programs, since the
+    // location of the object index attribute could be changed.
+    if ( !m_triangle_shader.isCreated() || !m_line_shader.isCreated() )
+    {
+        this->create_shader_programs();
+        m_triangles.release();
+        m_lines.release();
+    }
+
+    if ( m_triangles.isModified() ) { m_triangles.create( m_triangle_shader ); }
+    if ( m_lines.isModified() ) { m_lines.create( m_line_shader ); }
+    if ( m_is_draw_list_modified ) { this->update_draw_lists(); }
+    if ( m_is_xform_modified ) { this->update_xform_texture(); }
+
+    kvs::OpenGL::Enable( GL_DEPTH_TEST );
+    kvs::Texture::Binder unit( m_xform_texture, 0 );
+    if ( m_triangles.numberOfDrawCalls() > 0 )
+    {
+        kvs::OpenGL::SetPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+        this->setup_shader_program( m_triangle_shader );
+        kvs::ProgramObject::Binder bind( m_triangle_shader );
+        m_triangles.draw();
+    }
+
+    if ( m_lines.numberOfDrawCalls() > 0 )
+    {
+        kvs::OpenGL::SetLineWidth( m_line_width );
+        this->setup_shader_program( m_line_shader );
+        kvs::ProgramObject::Binder bind( m_line_shader );
+        m_lines.draw();
+    }
+
+    BaseClass::stopTimer();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Adds a polygon object to the batch.
+ *  @param  polygon [in] pointer to the polygon object (triangles)
+ *  @return index of the object in the batch
+ *
+ *  The vertices are copied into the merged arrays, so that the polygon object
+ *  can be deleted after the addition.
+ */
+/*===========================================================================*/
+size_t BatchedGeometryRenderer::addObject( const kvs::PolygonObject* polygon )
+{
+    const size_t object_index = m_entries.size();
+    Entry entry;
+    entry.buffer_object = &m_triangles;
+    entry.first = m_triangles.numberOfIndices();
+    if ( polygon->polygonType() != kvs::PolygonObject::Triangle )
+    {
+        const auto type = polygon->polygonType();
+        kvsMessageError() << "Not supported polygon type (" << type << ")." << std::endl;
+        m_entries.push_back( entry );
+        return object_index;
+    }
+
+    this->expand_bounds( polygon );
+
+    const bool has_normal = polygon->normals().size() > 0;
+    const bool has_opacity = polygon->opacities().size() > 0;
+    const bool is_single_alpha = polygon->opacities().size() == 1;
+    const bool is_polygon_normal = polygon->normalType() == kvs::PolygonObject::PolygonNormal;
+    const bool is_polygon_color = polygon->colorType() == kvs::PolygonObject::PolygonColor;
+    auto append = [&] ( const size_t vertex, const size_t face )
+    {
+        const size_t c = is_polygon_color ? face : vertex;
+        const kvs::UInt8 alpha = !has_opacity ? 255 : polygon->opacity( is_single_alpha ? 0 : c );
+        const kvs::Vec3 normal = !has_normal ? kvs::Vec3::Zero() : polygon->normal( is_polygon_normal ? face : vertex );
+        m_triangles.appendVertex( polygon->coord( vertex ), ::Color( polygon, c ), alpha, normal, object_index );
+    };
+
+    const size_t base = m_triangles.numberOfVertices();
+    const kvs::UInt32* connections = polygon->connections().data();
+    if ( ::HasConnections( polygon ) )
+    {
+        const size_t nvertices = polygon->numberOfVertices();
+        for ( size_t i = 0; i < nvertices; i++ ) { append( i, 0 ); }
+
+        const size_t nindices = polygon->connections().size();
+        for ( size_t i = 0; i < nindices; i++ ) { m_triangles.appendIndex( base + connections[i] ); }
+    }
+    else
+    {
+        const size_t nconnections = polygon->numberOfConnections();
+        const size_t nfaces = nconnections > 0 ? nconnections : polygon->numberOfVertices() / 3;
+        for ( size_t i = 0; i < nfaces; i++ )
+        {
+            for ( size_t j = 0; j < 3; j++ )
+            {
+                append( nconnections > 0 ? connections[ 3 * i + j ] : 3 * i + j, i );
+                m_triangles.appendIndex( base + 3 * i + j );
+            }
+        }
+    }
+
+    entry.count = m_triangles.numberOfIndices() - entry.first;
+    m_entries.push_back( entry );
+    m_is_draw_list_modified = true;
+    m_is_xform_modified = true;
+    return object_index;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Adds a line object to the batch.
+ *  @param  line [in] pointer to the line object
+ *  @return index of the object in the batch
+ *
+ *  The lines are converted into the line segments and copied into the merged
+ *  arrays, so that the line object can be deleted after the addition.
+ */
+/*===========================================================================*/
+size_t BatchedGeometryRenderer::addObject( const kvs::LineObject* line )
+{
+    this->expand_bounds( line );
+
+    const size_t object_index = m_entries.size();
+    Entry entry;
+    entry.buffer_object = &m_lines;
+    entry.first = m_lines.numberOfIndices();
+
+    const kvs::Vec3 normal = kvs::Vec3::Zero();
+    const size_t base = m_lines.numberOfVertices();
+    const auto segments = ::LineSegments( line );
+    const size_t nsegments = segments.size() / 3;
+    if ( line->colorType() == kvs::LineObject::VertexColor || line->numberOfColors() <= 1 )
+    {
+        const size_t nvertices = line->numberOfVertices();
+        for ( size_t i = 0; i < nvertices; i++ )
+        {
+            m_lines.appendVertex( line->coord( i ), ::Color( line, i ), 255, normal, object_index );
+        }
+
+        for ( size_t i = 0; i < nsegments; i++ )
+        {
+            m_lines.appendIndex( base + segments[ 3 * i + 0 ] );
+            m_lines.appendIndex( base + segments[ 3 * i + 1 ] );
+        }
+    }
+    else
+    {
+        // The vertices are duplicated for each segment in case of the line color.
+        for ( size_t i = 0; i < nsegments; i++ )
+        {
+            const kvs::RGBColor color = ::Color( line, segments[ 3 * i + 2 ] );
+            m_lines.appendVertex( line->coord( segments[ 3 * i + 0 ] ), color, 255, normal, object_index );
+            m_lines.appendVertex( line->coord( segments[ 3 * i + 1 ] ), color, 255, normal, object_index );
+            m_lines.appendIndex( base + 2 * i + 0 );
+            m_lines.appendIndex( base + 2 * i + 1 );
+        }
+    }
+
+    entry.count = m_lines.numberOfIndices() - entry.first;
+    m_entries.push_back( entry );
+    m_is_draw_list_modified = true;
+    m_is_xform_modified = true;
+    return object_index;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a new object to register the renderer to the scene.
+ *  @return pointer to the empty polygon object with the bounding box
+ *
+ *  The returned object has no vertices, and only its bounding box, which
+ *  covers the batched objects, and its modeling matrix are used. The object
+ *  is owned by the caller or the scene.
+ */
+/*===========================================================================*/
+kvs::PolygonObject* BatchedGeometryRenderer::createBoundingObject() const
+{
+    auto* object = new kvs::PolygonObject();
+    object->setMinMaxObjectCoords( m_min_coord, m_max_coord );
+    object->setMinMaxExternalCoords( m_min_coord, m_max_coord );
+    return object;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the visibility of the object.
+ *  @param  index [in] index of the object
+ *  @param  visible [in] if true, the object is drawn
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::setVisible( const size_t index, const bool visible )
+{
+    if ( m_entries[ index ].visible == visible ) { return; }
+    m_entries[ index ].visible = visible;
+    m_is_draw_list_modified = true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the modeling transform of the object.
+ *  @param  index [in] index of the object
+ *  @param  xform [in] transform applied in the object coordinates
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::setXform( const size_t index, const kvs::Xform& xform )
+{
+    m_entries[ index ].xform = xform;
+    m_is_xform_modified = true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Expands the bounding box by the object.
+ *  @param  object [in] pointer to the geometry object
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::expand_bounds( const kvs::GeometryObjectBase* object )
+{
+    const size_t nvertices = object->numberOfVertices();
+    if ( nvertices == 0 ) { return; }
+
+    const bool is_empty = m_triangles.numberOfVertices() == 0 && m_lines.numberOfVertices() == 0;
+    if ( is_empty )
+    {
+        m_min_coord = object->coord( 0 );
+        m_max_coord = object->coord( 0 );
+    }
+
+    const kvs::Real32* coords = object->coords().data();
+    for ( size_t i = 0; i < nvertices; i++ )
+    {
+        for ( int j = 0; j < 3; j++ )
+        {
+            m_min_coord[j] = kvs::Math::Min( m_min_coord[j], coords[ 3 * i + j ] );
+            m_max_coord[j] = kvs::Math::Max( m_max_coord[j], coords[ 3 * i + j ] );
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the shader programs for the triangles and the lines.
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::create_shader_programs()
+{
+    m_triangle_shader.release();
+    m_line_shader.release();
+
+    {
+        kvs::ShaderSource vert( "batch.vert" );
+        kvs::ShaderSource frag( "shader.frag" );
+        if ( BaseClass::isShadingEnabled() )
+        {
+            switch ( m_shading_model->type() )
+            {
+            case kvs::Shader::LambertShading: frag.define("ENABLE_LAMBERT_SHADING"); break;
+            case kvs::Shader::PhongShading: frag.define("ENABLE_PHONG_SHADING"); break;
+            case kvs::Shader::BlinnPhongShading: frag.define("ENABLE_BLINN_PHONG_SHADING"); break;
+            default: break; // NO SHADING
+            }
+        }
+        m_triangle_shader.build( vert, frag );
+    }
+
+    // The lines are drawn without shading.
+    {
+        kvs::ShaderSource vert( "batch.vert" );
+        kvs::ShaderSource frag( "shader.frag" );
+        m_line_shader.build( vert, frag );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the draw lists of the buffer objects by the visibilities.
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::update_draw_lists()
+{
+    m_triangles.clearDrawList();
+    m_lines.clearDrawList();
+    for ( const auto& entry : m_entries )
+    {
+        if ( !entry.visible ) { continue; }
+        entry.buffer_object->addDrawRange( entry.first, entry.count );
+    }
+
+    m_is_draw_list_modified = false;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the texture of the modeling matrices.
+ *
+ *  The 4x4 matrix of the i-th object is stored in the four texels from
+ *  (4*(i%ObjectsPerRow), i/ObjectsPerRow) as the columns.
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::update_xform_texture()
+{
+    const size_t nobjects = kvs::Math::Max( m_entries.size(), size_t(1) );
+    const size_t width = 4 * ObjectsPerRow;
+    const size_t height = ( nobjects + ObjectsPerRow - 1 ) / ObjectsPerRow;
+
+    kvs::ValueArray<kvs::Real32> matrices( width * height * 4 );
+    matrices.fill( 0.0f );
+    for ( size_t i = 0; i < m_entries.size(); i++ )
+    {
+        m_entries[i].xform.toArray( matrices.data() + 16 * i );
+    }
+
+    if ( m_xform_texture.isCreated() && m_xform_texture.height() == height )
+    {
+        kvs::Texture::Binder unit( m_xform_texture );
+        m_xform_texture.load( width, height, matrices.data() );
+    }
+    else
+    {
+        m_xform_texture.release();
+        m_xform_texture.setWrapS( GL_CLAMP_TO_EDGE );
+        m_xform_texture.setWrapT( GL_CLAMP_TO_EDGE );
+        m_xform_texture.setMagFilter( GL_NEAREST );
+        m_xform_texture.setMinFilter( GL_NEAREST );
+        m_xform_texture.setPixelFormat( GL_RGBA32F_ARB, GL_RGBA, GL_FLOAT );
+        m_xform_texture.create( width, height, matrices.data() );
+    }
+
+    m_is_xform_modified = false;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Setups the uniform variables of the shader program.
+ *  @param  shader_program [in] shader program
+ */
+/*===========================================================================*/
+void BatchedGeometryRenderer::setup_shader_program( kvs::ProgramObject& shader_program )
+{
+    const auto& model = *m_shading_model;
+    kvs::ProgramObject::Binder bind( shader_program );
+    shader_program.setUniform( "shading.Ka", model.Ka );
+    shader_program.setUniform( "shading.Kd", model.Kd );
+    shader_program.setUniform( "shading.Ks", model.Ks );
+    shader_program.setUniform( "shading.S",  model.S );
+
+    const kvs::Mat4 M = kvs::OpenGL::ModelViewMatrix();
+    const kvs::Mat4 PM = kvs::OpenGL::ProjectionMatrix() * M;
+    const kvs::Mat3 N = kvs::Mat3( M[0].xyz(), M[1].xyz(), M[2].xyz() );
+    shader_program.setUniform( "ModelViewMatrix", M );
+    shader_program.setUniform( "ModelViewProjectionMatrix", PM );
+    shader_program.setUniform( "NormalMatrix", N );
+
+    const kvs::Vec2 size(
+        static_cast<float>( m_xform_texture.width() ),
+        static_cast<float>( m_xform_texture.height() ) );
+    shader_program.setUniform( "xform_texture", 0 );
+    shader_program.setUniform( "xform_texture_size", size );
+}
+
+} // end of namespace kvs
@@ -0,0 +1,150 @@
+/*****************************************************************************/
+/**
+ *  @file   BatchedGeometryRenderer.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <kvs/DebugNew>
+#include <kvs/Module>
+#include <kvs/RendererBase>
+#include <kvs/PolygonObject>
+#include <kvs/LineObject>
+#include <kvs/Shader>
+#include <kvs/ProgramObject>
+#include <kvs/VertexBufferObjectManager>
+#include <kvs/Texture2D>
+#include <kvs/Xform>
+#include <vector>
+#include <string>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Batched geometry renderer class.
+ *
+ *  Many small polygon and line objects are merged into the shared vertex
+ *  buffers (one for the triangles and one for the lines), and the visible
+ *  objects are drawn by a single multi-draw call per buffer. The modeling
+ *  matrices of the objects are stored in a floating-point texture, which is
+ *  fetched in the vertex shader by the object index attribute, so that the
+ *  visibility and the transform of each object can be changed without
+ *  rebuilding the buffers.
+ *
+ *  The renderer is registered to the scene with the object returned from
+ *  createBoundingObject(), whose bounding box and modeling matrix are shared
+ *  by all of the batched objects.
+ */
+/*===========================================================================*/
+class BatchedGeometryRenderer : public kvs::RendererBase
+{
+    kvsModule( kvs::BatchedGeometryRenderer, Renderer );
+    kvsModuleBaseClass( kvs::RendererBase );
+
+public:
+    enum
+    {
+        ObjectsPerRow = 64 ///< number of objects in a row of the transform texture
+    };
+
+    class BufferObject
+    {
+    private:
+        GLenum m_mode = GL_TRIANGLES; ///< geometric primitive
+        kvs::VertexBufferObjectManager m_manager{}; ///< VBOs
+        std::vector<kvs::Real32> m_coords{}; ///< merged coordinates
+        std::vector<kvs::UInt8> m_colors{}; ///< merged colors (RGBA)
+        std::vector<kvs::Real32> m_normals{}; ///< merged normal vectors
+        std::vector<kvs::Real32> m_object_indices{}; ///< object indices of the vertices
+        std::vector<kvs::UInt32> m_connections{}; ///< merged connections
+        std::vector<GLsizei> m_counts{}; ///< numbers of indices to be drawn
+        std::vector<const GLvoid*> m_offsets{}; ///< byte offsets of indices to be drawn
+        bool m_is_modified = false; ///< true if the arrays are not uploaded
+    public:
+        BufferObject( const GLenum mode ): m_mode( mode ) {}
+        virtual ~BufferObject() { this->release(); }
+        GLenum mode() const { return m_mode; }
+        size_t numberOfVertices() const { return m_coords.size() / 3; }
+        size_t numberOfIndices() const { return m_connections.size(); }
+        size_t numberOfDrawCalls() const { return m_counts.size(); }
+        bool isModified() const { return m_is_modified; }
+        void appendVertex( const kvs::Vec3& coord, const kvs::RGBColor& color, const kvs::UInt8 alpha, const kvs::Vec3& normal, const size_t object_index );
+        void appendIndex( const size_t index ) { m_connections.push_back( static_cast<kvs::UInt32>( index ) ); m_is_modified = true; }
+        void clearDrawList() { m_counts.clear(); m_offsets.clear(); }
+        void addDrawRange( const size_t first, const size_t count );
+        void release();
+        void create( const kvs::ProgramObject& shader_program );
+        void draw();
+    };
+
+    struct Entry
+    {
+        BufferObject* buffer_object = nullptr; ///< buffer object containing the object
+        size_t first = 0; ///< index of the first index in the buffer object
+        size_t count = 0; ///< number of indices
+        bool visible = true; ///< visibility
+        kvs::Xform xform{}; ///< modeling transform
+    };
+
+private:
+    kvs::Shader::ShadingModel* m_shading_model = nullptr; ///< shading method
+    std::vector<Entry> m_entries{}; ///< batched objects
+    BufferObject m_triangles{ GL_TRIANGLES }; ///< buffer object for the triangles
+    BufferObject m_lines{ GL_LINES }; ///< buffer object for the lines
+    kvs::ProgramObject m_triangle_shader{}; ///< shader program for the triangles
+    kvs::ProgramObject m_line_shader{}; ///< shader program for the lines
+    kvs::Texture2D m_xform_texture{}; ///< texture of the modeling matrices
+    kvs::Vec3 m_min_coord{ 0.0f, 0.0f, 0.0f }; ///< min. coordinate of the objects
+    kvs::Vec3 m_max_coord{ 0.0f, 0.0f, 0.0f }; ///< max. coordinate of the objects
+    float m_line_width = 1.0f; ///< line width
+    bool m_is_draw_list_modified = true; ///< true if the visibilities are changed
+    bool m_is_xform_modified = true; ///< true if the transforms are changed
+
+public:
+    BatchedGeometryRenderer(): m_shading_model( new kvs::Shader::Lambert() ) {}
+    virtual ~BatchedGeometryRenderer() { if ( m_shading_model ) { delete m_shading_model; } }
+
+    void exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
+
+    size_t addObject( const kvs::PolygonObject* polygon );
+    size_t addObject( const kvs::LineObject* line );
+    kvs::PolygonObject* createBoundingObject() const;
+
+    size_t numberOfObjects() const { return m_entries.size(); }
+    size_t numberOfDrawCalls() const { return m_triangles.numberOfDrawCalls() + m_lines.numberOfDrawCalls(); }
+    bool isVisible( const size_t index ) const { return m_entries[ index ].visible; }
+    const kvs::Xform& xform( const size_t index ) const { return m_entries[ index ].xform; }
+    const kvs::Vec3& minObjectCoord() const { return m_min_coord; }
+    const kvs::Vec3& maxObjectCoord() const { return m_max_coord; }
+    float lineWidth() const { return m_line_width; }
+
+    void setVisible( const size_t index, const bool visible = true );
+    void show( const size_t index ) { this->setVisible( index, true ); }
+    void hide( const size_t index ) { this->setVisible( index, false ); }
+    void setXform( const size_t index, const kvs::Xform& xform );
+    void setLineWidth( const float width ) { m_line_width = width; }
+
+    template <typename Model>
+    void setShadingModel( const Model model )
+    {
+        if ( m_shading_model ) { delete m_shading_model; m_shading_model = NULL; }
+        m_shading_model = new Model( model );
+        if ( !m_shading_model )
+        {
+            kvsMessageError("Cannot create a specified shading model.");
+        }
+        m_triangle_shader.release();
+    }
+
+private:
+    void expand_bounds( const kvs::GeometryObjectBase* object );
+    void create_shader_programs();
+    void update_draw_lists();
+    void update_xform_texture();
+    void setup_shader_program( kvs::ProgramObject& shader_program );
+};
+
+} // end of namespace kvs
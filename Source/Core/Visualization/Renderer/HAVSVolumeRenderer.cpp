@@ -20,8 +20,12 @@
 /*****************************************************************************/
 #include "HAVSVolumeRenderer.h"
 #include <set>
+#include <vector>
+#include <utility>
 #include <kvs/Coordinate>
 #include <kvs/OpenGL>
+#include <kvs/OpenMP>
+#include <kvs/Timer>
 #include <kvs/VertexShader>
 #include <kvs/FragmentShader>
 #include <kvs/PreIntegrationTable3D>
@@ -30,24 +34,87 @@
 namespace
 {
 
+// Minimum number of the faces sorted by a thread.
+const size_t RadixBlockSize = 65536;
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the number of blocks for the parallel radix sort.
+ *  @param  length [in] number of faces
+ *  @return number of blocks
+ */
+/*===========================================================================*/
+size_t NumberOfBlocks( const size_t length )
+{
+    const size_t nthreads = static_cast<size_t>( kvs::OpenMP::GetMaxThreads() );
+    const size_t nblocks = ( length + RadixBlockSize - 1 ) / RadixBlockSize;
+    return kvs::Math::Max( size_t(1), kvs::Math::Min( nthreads, nblocks ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sorts the faces by the specified byte of the distance.
+ *  @param  byte [in] byte (0: least significant byte)
+ *  @param  length [in] number of faces
+ *  @param  src [in] source faces
+ *  @param  dst [out] destination faces
+ *  @param  nblocks [in] number of blocks
+ *  @param  offsets [in,out] work buffer for the histograms of the blocks
+ *  @param  count [in] histogram of the digits for the single block (or NULL)
+ */
+/*===========================================================================*/
 void PartialSort(
-    int byte,
-    int length,
-    kvs::HAVSVolumeRenderer::SortedFace* src,
+    const int byte,
+    const size_t length,
+    const kvs::HAVSVolumeRenderer::SortedFace* src,
     kvs::HAVSVolumeRenderer::SortedFace* dst,
-    int* count )
+    const size_t nblocks,
+    std::vector<size_t>& offsets,
+    const size_t* count = NULL )
 {
-    unsigned int i;
-    kvs::HAVSVolumeRenderer::SortedFace* k;
+    const int shift = byte * 8;
+    const size_t block_size = ( length + nblocks - 1 ) / nblocks;
+    if ( count ) { offsets.assign( count, count + 256 ); }
+    else { offsets.assign( nblocks * 256, 0 ); }
+
+    // Histogram of the digits for each block, which is not needed for the
+    // single block since it is given as the histogram of all of the faces.
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long b = 0; b < static_cast<long>( count ? 0 : nblocks ); b++ )
+    {
+        size_t* count = &offsets[ b * 256 ];
+        const size_t begin = b * block_size;
+        const size_t end = kvs::Math::Min( begin + block_size, length );
+        for ( size_t i = begin; i < end; i++ )
+        {
+            count[ ( src[i].distance() >> shift ) & 0xff ]++;
+        }
+    }
 
-    static int index[256];
-    index[0] = 0;
-    for ( i = 1; i < 256; i++ ) index[i] = index[i-1] + count[i-1];
+    // Start positions in the order of (digit, block), which keeps the sort
+    // stable independently of the number of blocks.
+    size_t sum = 0;
+    for ( size_t d = 0; d < 256; d++ )
+    {
+        for ( size_t b = 0; b < nblocks; b++ )
+        {
+            const size_t count = offsets[ b * 256 + d ];
+            offsets[ b * 256 + d ] = sum;
+            sum += count;
+        }
+    }
 
-    for ( i = 0; i < static_cast<unsigned int>( length ); i++ )
+    // Scatter the faces of each block.
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long b = 0; b < static_cast<long>( nblocks ); b++ )
     {
-        k = &src[i];
-        dst[ index[ ( k->distance() >> (byte*8))&0xff ]++ ] = *k;
+        size_t* index = &offsets[ b * 256 ];
+        const size_t begin = b * block_size;
+        const size_t end = kvs::Math::Min( begin + block_size, length );
+        for ( size_t i = begin; i < end; i++ )
+        {
+            dst[ index[ ( src[i].distance() >> shift ) & 0xff ]++ ] = src[i];
+        }
     }
 }
 
@@ -159,7 +226,12 @@ void HAVSVolumeRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs
         this->update_framebuffer();
    }
 
+    kvs::Timer sorting_timer( kvs::Timer::Start );
     this->sort_geometry( camera, object );
+    sorting_timer.stop();
+    m_sorting_time = static_cast<float>( sorting_timer.msec() );
+
+    kvs::Timer drawing_timer( kvs::Timer::Start );
     this->enable_MRT_rendering();
     this->draw_initialization_pass();
     this->draw_geometry_pass();
@@ -169,6 +241,8 @@ void HAVSVolumeRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs
 
     kvs::OpenGL::PopAttrib();
     kvs::OpenGL::Finish();
+    drawing_timer.stop();
+    m_drawing_time = static_cast<float>( drawing_timer.msec() );
 
     BaseClass::stopTimer();
 }
@@ -180,6 +254,10 @@ void HAVSVolumeRenderer::initialize()
     m_meshes = NULL;
     m_enable_vbo = true;
     m_pindices = NULL;
+    m_is_sorted = false;
+    m_sorted_eye = kvs::Vec3::Zero();
+    m_sorting_time = 0.0f;
+    m_drawing_time = 0.0f;
 }
 
 void HAVSVolumeRenderer::attachVolumeObject( const kvs::UnstructuredVolumeObject* volume )
@@ -367,8 +445,11 @@ void HAVSVolumeRenderer::disable_MRT_rendering()
 
 void HAVSVolumeRenderer::sort_geometry( kvs::Camera* camera, kvs::ObjectBase* object )
 {
-    // Visibility sorting in the object coordinate system.
+    // Visibility sorting in the object coordinate system. The sorted index
+    // array in the buffer is reused while the eye position is not changed.
     const kvs::Vec3 position = kvs::WorldCoordinate( camera->position() ).toObjectCoordinate( object ).position();
+    if ( m_is_sorted && position == m_sorted_eye ) { return; }
+
     const HAVSVolumeRenderer::Vertex eye( position );
     m_meshes->sort( eye );
 
@@ -378,13 +459,16 @@ void HAVSVolumeRenderer::sort_geometry( kvs::Camera* camera, kvs::ObjectBase* ob
         m_pindices = static_cast<GLuint*>( m_vertex_indices.map( kvs::IndexBufferObject::WriteOnly ) );
     }
 
-    for ( size_t i = 0, index = 0; i < m_meshes->nrenderfaces(); i++ )
+    const long nrenderfaces = static_cast<long>( m_meshes->nrenderfaces() );
+    GLuint* pindices = m_pindices;
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nrenderfaces; i++ )
     {
-        for ( size_t j = 0; j < 3; j++, index++ )
+        const kvs::UInt32 face_index = m_meshes->sortedFace( i );
+        const HAVSVolumeRenderer::Face& face = m_meshes->face( face_index );
+        for ( size_t j = 0; j < 3; j++ )
         {
-            const kvs::UInt32 face_index = m_meshes->sortedFace( i );
-            const GLuint vertex_index = static_cast<GLuint>( m_meshes->face( face_index ).index( j ) );
-            m_pindices[ index ] = vertex_index;
+            pindices[ 3 * i + j ] = static_cast<GLuint>( face.index( j ) );
         }
     }
 
@@ -393,6 +477,9 @@ void HAVSVolumeRenderer::sort_geometry( kvs::Camera* camera, kvs::ObjectBase* ob
         m_vertex_indices.unmap();
         m_vertex_indices.unbind();
     }
+
+    m_sorted_eye = position;
+    m_is_sorted = true;
 }
 
 void HAVSVolumeRenderer::draw_initialization_pass()
@@ -737,30 +824,20 @@ void HAVSVolumeRenderer::Meshes::build()
 
 void HAVSVolumeRenderer::Meshes::sort( HAVSVolumeRenderer::Vertex eye )
 {
-    HAVSVolumeRenderer::SortedFace sorted_face;
-    ::FloatOrInt dist2;
-    size_t sorted_face_count = 0;
-    size_t i = 0;
-
-    // Add boundary faces first.
-    for ( i = 0; i < m_nboundaryfaces; i++ )
-    {
-        const size_t f = m_boundary_faces[i];
-        const HAVSVolumeRenderer::Vertex fc = m_centers[f];
-        dist2.f = static_cast<float>(( eye - fc ).norm2());
-        sorted_face = HAVSVolumeRenderer::SortedFace( f, dist2.i );
-        m_sorted_faces[sorted_face_count++] = sorted_face;
-    }
-
-    // Add internal faces as determined by LOD budget
-    const size_t internal_count = m_nrenderfaces - m_nboundaryfaces;
-    for ( i = 0; i < internal_count; i++ )
-    {
-        const size_t f = m_internal_faces[i];
-        const HAVSVolumeRenderer::Vertex fc = m_centers[f];
-        dist2.f = static_cast<float>(( eye - fc ).norm2());
-        sorted_face = HAVSVolumeRenderer::SortedFace( f, dist2.i );
-        m_sorted_faces[sorted_face_count++] = sorted_face;
+    // Boundary faces first, and then internal faces as determined by LOD budget.
+    const long nboundaryfaces = static_cast<long>( m_nboundaryfaces );
+    const long nrenderfaces = static_cast<long>( m_nrenderfaces );
+    const kvs::UInt32* boundary_faces = m_boundary_faces.data();
+    const kvs::UInt32* internal_faces = m_internal_faces.data();
+    const HAVSVolumeRenderer::Vertex* centers = m_centers;
+    HAVSVolumeRenderer::SortedFace* sorted_faces = m_sorted_faces;
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < nrenderfaces; i++ )
+    {
+        const kvs::UInt32 f = ( i < nboundaryfaces ) ? boundary_faces[i] : internal_faces[ i - nboundaryfaces ];
+        ::FloatOrInt dist2;
+        dist2.f = static_cast<float>(( eye - centers[f] ).norm2());
+        sorted_faces[i] = HAVSVolumeRenderer::SortedFace( f, dist2.i );
     }
 
     this->radix_sort( m_sorted_faces, m_radix_temp, 0, m_nrenderfaces );
@@ -786,28 +863,57 @@ void HAVSVolumeRenderer::Meshes::radix_sort(
     int lo,
     int up )
 {
-    int length = up -lo;
-    unsigned int i;
-    unsigned int u;
+    const size_t length = static_cast<size_t>( up - lo );
+    if ( length == 0 ) { return; }
 
     SortedFace* uints = array + lo;
-    int count[4][256] = {{0}};
+    const size_t nblocks = ::NumberOfBlocks( length );
+    const size_t block_size = ( length + nblocks - 1 ) / nblocks;
+
+    // Generate count arrays of all the bytes, which are used to skip the
+    // passes where all of the faces have the same digit.
+    std::vector<size_t> counts( nblocks * 4 * 256, 0 );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long b = 0; b < static_cast<long>( nblocks ); b++ )
+    {
+        size_t* count = &counts[ b * 4 * 256 ];
+        const size_t begin = b * block_size;
+        const size_t end = kvs::Math::Min( begin + block_size, length );
+        for ( size_t i = begin; i < end; i++ )
+        {
+            const kvs::UInt32 u = uints[i].distance();
+            count[ 0 * 256 + ( u & 0xff ) ]++;
+            count[ 1 * 256 + ( ( u >> 8 ) & 0xff ) ]++;
+            count[ 2 * 256 + ( ( u >> 16 ) & 0xff ) ]++;
+            count[ 3 * 256 + ( ( u >> 24 ) & 0xff ) ]++;
+        }
+    }
 
-    // Generate count arrays.
-    for ( i = 0; i < static_cast<unsigned int>( length ); i++ )
+    // Start sorting.
+    SortedFace* src = uints;
+    SortedFace* dst = temp;
+    std::vector<size_t> offsets;
+    for ( int byte = 0; byte < 4; byte++ )
     {
-        u = uints[i].distance();
-        count[0][ u & 0xff ]++;
-        count[1][ (u >> 8) & 0xff ]++;
-        count[2][ (u >> 16) & 0xff ]++;
-        count[3][ (u >> 24) & 0xff ]++;
+        bool trivial = false;
+        for ( size_t d = 0; d < 256 && !trivial; d++ )
+        {
+            size_t total = 0;
+            for ( size_t b = 0; b < nblocks; b++ ) { total += counts[ ( b * 4 + byte ) * 256 + d ]; }
+            trivial = ( total == length );
+        }
+        if ( trivial ) { continue; }
+
+        const size_t* count = ( nblocks == 1 ) ? &counts[ byte * 256 ] : NULL;
+        ::PartialSort( byte, length, src, dst, nblocks, offsets, count );
+        std::swap( src, dst );
     }
 
-    // Start sorting.
-    ::PartialSort( 0, length, uints, temp,  count[0] );
-    ::PartialSort( 1, length, temp,  uints, count[1] );
-    ::PartialSort( 2, length, uints, temp,  count[2] );
-    ::PartialSort( 3, length, temp,  uints, count[3] );
+    if ( src != uints )
+    {
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < static_cast<long>( length ); i++ ) { uints[i] = src[i]; }
+    }
 }
 
 } // end of namespace kvs
@@ -74,6 +74,10 @@ private:
     kvs::FrameBufferObject m_mrt_framebuffer; ///< MRT frame buffer object
     kvs::Texture2D m_mrt_texture[4]; ///< MRT textures
     float m_modelview[16]; ///< modelview matrix
+    bool m_is_sorted; ///< flag for checking if the index array is sorted
+    kvs::Vec3 m_sorted_eye; ///< eye position in the object coordinate for the sorted index array
+    float m_sorting_time; ///< time for sorting the faces in the last frame [msec]
+    float m_drawing_time; ///< time for drawing the faces in the last frame [msec]
 
 public:
     HAVSVolumeRenderer();
@@ -85,6 +89,8 @@ public:
     void disableVBO() { m_enable_vbo = false; }
     size_t kBufferSize() const { return m_k_size; }
     bool isVBOEnabled() const { return m_enable_vbo; }
+    float sortingTime() const { return m_sorting_time; }
+    float drawingTime() const { return m_drawing_time; }
 
     void exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
     void initialize();
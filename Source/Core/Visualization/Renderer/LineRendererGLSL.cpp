@@ -393,6 +393,11 @@ void LineRenderer::RenderPass::create(
         }
     }
 
+    if ( m_enable_oit )
+    {
+        frag.define("ENABLE_WEIGHTED_BLENDED_OIT");
+    }
+
     m_shader_program.build( vert, frag );
 }
 
@@ -462,6 +467,7 @@ void LineRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Ligh
     const size_t width = camera->windowWidth();
     const size_t height = camera->windowHeight();
     const auto shading_enabled = BaseClass::isShadingEnabled();
+    const auto oit_enabled = m_enable_oit && m_opacity < 255;
     auto& shading_model = *m_shading_model;
 
     if ( this->isWindowCreated() )
@@ -469,6 +475,7 @@ void LineRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Ligh
         this->setWindowSize( width, height );
         this->createBufferObject( object );
         shading_model.two_side_lighting = false;
+        m_render_pass.setOITEnabled( oit_enabled );
         m_render_pass.create( shading_model, shading_enabled );
     }
 
@@ -481,9 +488,17 @@ void LineRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Ligh
     {
         this->updateBufferObject( object );
         shading_model.two_side_lighting = false;
+        m_render_pass.setOITEnabled( oit_enabled );
         m_render_pass.update( shading_model, shading_enabled );
     }
 
+    if ( m_render_pass.isOITEnabled() != oit_enabled )
+    {
+        m_render_pass.setOITEnabled( oit_enabled );
+        m_render_pass.update( shading_model, shading_enabled );
+        if ( !oit_enabled ) { m_oit_buffer.release(); }
+    }
+
     m_render_pass.setup( shading_model );
     this->drawBufferObject( camera );
 
@@ -560,7 +575,37 @@ void LineRenderer::drawBufferObject( const kvs::Camera* camera )
     kvs::OpenGL::SetLineWidth( line_width * dpr );
     kvs::OpenGL::Enable( GL_DEPTH_TEST );
     kvs::OpenGL::Enable( GL_BLEND );
-    m_render_pass.draw( line );
+    if ( m_render_pass.isOITEnabled() ) { this->drawBufferObjectWithOIT( camera ); }
+    else { m_render_pass.draw( line ); }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws buffer object with the weighted blended OIT.
+ *  @param  camera [in] pointer to the camera
+ */
+/*===========================================================================*/
+void LineRenderer::drawBufferObjectWithOIT( const kvs::Camera* camera )
+{
+    const auto dpr = camera->devicePixelRatio();
+    const size_t framebuffer_width = static_cast<size_t>( m_width * dpr );
+    const size_t framebuffer_height = static_cast<size_t>( m_height * dpr );
+    if ( m_oit_buffer.width() != framebuffer_width ||
+         m_oit_buffer.height() != framebuffer_height )
+    {
+        m_oit_buffer.create( framebuffer_width, framebuffer_height );
+    }
+
+    auto& shader = m_render_pass.shaderProgram();
+    {
+        kvs::ProgramObject::Binder bind( shader );
+        shader.setUniform( "opacity", m_opacity / 255.0f );
+    }
+
+    m_oit_buffer.bind();
+    m_render_pass.draw( m_object );
+    m_oit_buffer.unbind();
+    m_oit_buffer.draw();
 }
 
 } // end of namespace glsl
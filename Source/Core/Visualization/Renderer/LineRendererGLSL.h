@@ -12,6 +12,7 @@
 #include <kvs/Shader>
 #include <kvs/ProgramObject>
 #include <kvs/VertexBufferObjectManager>
+#include <kvs/WeightedBlendedBuffer>
 #include <kvs/Deprecated>
 #include <string>
 
@@ -25,6 +26,10 @@ namespace glsl
 /*===========================================================================*/
 /**
  *  @brief  Line renderer class.
+ *
+ *  If the order-independent transparency (OIT) is enabled and the opacity is
+ *  less than 255, the lines are composited by the weighted blended OIT in a
+ *  single geometry pass.
  */
 /*===========================================================================*/
 class LineRenderer : public kvs::LineRenderer
@@ -57,6 +62,7 @@ public:
         kvs::ProgramObject m_shader_program{}; ///< shader program
         float m_outline_width = 0.0f; ///< outline width
         kvs::RGBColor m_outline_color{ kvs::RGBColor::Black() }; ///< outline color
+        bool m_enable_oit = false; ///< flag for weighted blended OIT
     public:
         RenderPass( BufferObject& buffer_object ): m_buffer_object( buffer_object ) {}
         virtual ~RenderPass() { this->release(); }
@@ -66,11 +72,13 @@ public:
         kvs::ProgramObject& shaderProgram() { return m_shader_program; }
         float outlineWidth() const { return m_outline_width; }
         const kvs::RGBColor& outlineColor() const { return m_outline_color; }
+        bool isOITEnabled() const { return m_enable_oit; }
         void setVertexShaderFile( const std::string& file ) { m_vert_shader_file = file; }
         void setFragmentShaderFile( const std::string& file ) { m_frag_shader_file = file; }
         void setShaderFiles( const std::string& vert_file, const std::string& frag_file );
         void setOutlineWidth( const float width ) { m_outline_width = width; }
         void setOutlineColor( const kvs::RGBColor color ) { m_outline_color = color; }
+        void setOITEnabled( const bool enable = true ) { m_enable_oit = enable; }
         virtual void release() { m_shader_program.release(); }
         virtual void create( const kvs::Shader::ShadingModel& model, const bool enable );
         virtual void update( const kvs::Shader::ShadingModel& model, const bool enable );
@@ -86,6 +94,9 @@ private:
 
     BufferObject m_buffer_object{}; ///< buffer object
     RenderPass m_render_pass{ m_buffer_object }; ///< render pass
+    kvs::UInt8 m_opacity = 255; ///< line opacity for OIT
+    bool m_enable_oit = false; ///< flag for order-independent transparency
+    kvs::WeightedBlendedBuffer m_oit_buffer{}; ///< buffer for weighted blended OIT
 
 public:
     LineRenderer(): m_shading_model( new kvs::Shader::Lambert() ) {}
@@ -109,6 +120,13 @@ public:
     void setOutlineWidth( const float width ) { m_render_pass.setOutlineWidth( width ); }
     void setOutlineColor( const kvs::RGBColor color ) { m_render_pass.setOutlineColor( color ); }
 
+    kvs::UInt8 opacity() const { return m_opacity; }
+    bool isOITEnabled() const { return m_enable_oit; }
+    void setOpacity( const kvs::UInt8 opacity ) { m_opacity = opacity; }
+    void setOITEnabled( const bool enable = true ) { m_enable_oit = enable; }
+    void enableOIT() { this->setOITEnabled( true ); }
+    void disableOIT() { this->setOITEnabled( false ); }
+
     template <typename Model>
     void setShadingModel( const Model model )
     {
@@ -135,6 +153,7 @@ protected:
     void createBufferObject( const kvs::ObjectBase* object );
     void updateBufferObject( const kvs::ObjectBase* object );
     void drawBufferObject( const kvs::Camera* camera );
+    void drawBufferObjectWithOIT( const kvs::Camera* camera );
 
 public:
     template <typename ShadingType>
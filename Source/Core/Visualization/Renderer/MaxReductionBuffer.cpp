@@ -0,0 +1,158 @@
+/*****************************************************************************/
+/**
+ *  @file   MaxReductionBuffer.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#include "MaxReductionBuffer.h"
+#include <kvs/OpenGL>
+#include <kvs/ShaderSource>
+#include <string>
+
+
+namespace
+{
+
+const GLint ReductionFactor = 4;
+
+const std::string ReductionVertexShader(
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4( gl_Vertex.xy * 2.0 - 1.0, 0.0, 1.0 );\n"
+    "}\n"
+    );
+
+const std::string ReductionFragmentShader(
+    "#version 120\n"
+    "#extension GL_EXT_gpu_shader4 : enable\n"
+    "uniform sampler2D source_texture;\n"
+    "uniform ivec2 source_size;\n"
+    "void main()\n"
+    "{\n"
+    "    ivec2 p = ivec2( gl_FragCoord.xy ) * 4;\n"
+    "    float value = 0.0;\n"
+    "    for ( int j = 0; j < 4; j++ )\n"
+    "    {\n"
+    "        for ( int i = 0; i < 4; i++ )\n"
+    "        {\n"
+    "            ivec2 q = p + ivec2( i, j );\n"
+    "            if ( q.x < source_size.x && q.y < source_size.y )\n"
+    "            {\n"
+    "                value = max( value, texelFetch2D( source_texture, q, 0 ).r );\n"
+    "            }\n"
+    "        }\n"
+    "    }\n"
+    "    gl_FragColor = vec4( value );\n"
+    "}\n"
+    );
+
+inline size_t ReducedSize( const size_t size )
+{
+    return ( size + ReductionFactor - 1 ) / ReductionFactor;
+}
+
+}
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the buffer resources.
+ */
+/*===========================================================================*/
+void MaxReductionBuffer::release()
+{
+    for ( size_t i = 0; i < 2; i++ )
+    {
+        m_framebuffers[i].release();
+        m_textures[i].release();
+    }
+    m_shader.release();
+    m_width = 0;
+    m_height = 0;
+    m_result = 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Reduces the texture to the max. value.
+ *  @param  texture [in] non-negative floating-point texture
+ */
+/*===========================================================================*/
+void MaxReductionBuffer::reduce( const kvs::Texture2D& texture )
+{
+    const size_t width = ::ReducedSize( texture.width() );
+    const size_t height = ::ReducedSize( texture.height() );
+    if ( width == 0 || height == 0 ) { return; }
+    if ( m_width != width || m_height != height ) { this->create( width, height ); }
+
+    kvs::OpenGL::WithPushedAttrib attrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT );
+    kvs::OpenGL::Disable( GL_BLEND );
+    kvs::OpenGL::Disable( GL_DEPTH_TEST );
+
+    kvs::ProgramObject::Binder bind_shader( m_shader );
+    m_shader.setUniform( "source_texture", 0 );
+
+    // The source region is reduced by 4x4 into the other texture until the
+    // region becomes a single texel.
+    const kvs::Texture2D* source = &texture;
+    size_t source_width = texture.width();
+    size_t source_height = texture.height();
+    size_t target = 0;
+    do
+    {
+        const size_t w = ::ReducedSize( source_width );
+        const size_t h = ::ReducedSize( source_height );
+
+        kvs::FrameBufferObject::Binder bind_framebuffer( m_framebuffers[ target ] );
+        kvs::Texture::Binder bind_source( *source, 0 );
+        kvs::OpenGL::SetViewport( 0, 0, GLsizei( w ), GLsizei( h ) );
+        m_shader.setUniform( "source_size", kvs::Vec2i( int( source_width ), int( source_height ) ) );
+        kvs::OpenGL::Begin( GL_QUADS );
+        kvs::OpenGL::Vertex( kvs::Vec2( 0, 0 ) );
+        kvs::OpenGL::Vertex( kvs::Vec2( 1, 0 ) );
+        kvs::OpenGL::Vertex( kvs::Vec2( 1, 1 ) );
+        kvs::OpenGL::Vertex( kvs::Vec2( 0, 1 ) );
+        kvs::OpenGL::End();
+
+        m_result = target;
+        source = &m_textures[ target ];
+        source_width = w;
+        source_height = h;
+        target = 1 - target;
+    } while ( source_width > 1 || source_height > 1 );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the reduction textures and the shader.
+ *  @param  width [in] width of the reduction textures
+ *  @param  height [in] height of the reduction textures
+ */
+/*===========================================================================*/
+void MaxReductionBuffer::create( const size_t width, const size_t height )
+{
+    this->release();
+    m_width = width;
+    m_height = height;
+
+    for ( size_t i = 0; i < 2; i++ )
+    {
+        m_textures[i].setWrapS( GL_CLAMP_TO_EDGE );
+        m_textures[i].setWrapT( GL_CLAMP_TO_EDGE );
+        m_textures[i].setMagFilter( GL_NEAREST );
+        m_textures[i].setMinFilter( GL_NEAREST );
+        m_textures[i].setPixelFormat( GL_R32F, GL_RED, GL_FLOAT );
+        m_textures[i].create( width, height );
+        m_framebuffers[i].create();
+        m_framebuffers[i].attachColorTexture( m_textures[i] );
+    }
+
+    const kvs::ShaderSource vert( ::ReductionVertexShader );
+    const kvs::ShaderSource frag( ::ReductionFragmentShader );
+    m_shader.build( vert, frag );
+}
+
+} // end of namespace kvs
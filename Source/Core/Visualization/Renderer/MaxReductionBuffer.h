@@ -0,0 +1,50 @@
+/*****************************************************************************/
+/**
+ *  @file   MaxReductionBuffer.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <kvs/Texture2D>
+#include <kvs/FrameBufferObject>
+#include <kvs/ProgramObject>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Buffer class for the max. reduction of the floating-point texture.
+ *
+ *  The max. value of the red component of the non-negative texture is reduced
+ *  on the GPU by the render passes, each of which takes the max. of the 4x4
+ *  texels, with two ping-pong textures. The result is stored in the texel
+ *  (0,0) of the result texture, which can be fetched in the shader without
+ *  reading the pixels back to the CPU.
+ */
+/*===========================================================================*/
+class MaxReductionBuffer
+{
+private:
+    size_t m_width = 0; ///< width of the reduction textures
+    size_t m_height = 0; ///< height of the reduction textures
+    size_t m_result = 0; ///< index of the texture storing the result
+    kvs::Texture2D m_textures[2]; ///< ping-pong textures for the reduction
+    kvs::FrameBufferObject m_framebuffers[2]; ///< framebuffers for the reduction
+    kvs::ProgramObject m_shader{}; ///< shader for the reduction
+
+public:
+    MaxReductionBuffer() = default;
+    virtual ~MaxReductionBuffer() { this->release(); }
+
+    const kvs::Texture2D& resultTexture() const { return m_textures[ m_result ]; }
+
+    void release();
+    void reduce( const kvs::Texture2D& texture );
+
+private:
+    void create( const size_t width, const size_t height );
+};
+
+} // end of namespace kvs
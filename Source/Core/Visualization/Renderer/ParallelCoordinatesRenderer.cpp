@@ -11,6 +11,112 @@
 #include <kvs/ObjectBase>
 #include <kvs/TableObject>
 #include <kvs/IgnoreUnusedVariable>
+#include <kvs/ShaderSource>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Vertex shader for the polylines.
+ *
+ *  Each instance is a line segment of a row between the neighboring axes. The
+ *  normalized values of the row on the axes are given as the instanced vertex
+ *  attributes, and the rows out of the range are clipped away by referring to
+ *  the packed inside-range flags.
+ */
+/*===========================================================================*/
+const std::string LineVertexShader =
+    "#version 120\n"
+    "#extension GL_EXT_gpu_shader4 : enable\n" +
+    kvs::TableBuffer::InsideRangeFunction() +
+    "attribute float value0;\n"
+    "attribute float value1;\n"
+    "attribute float color_value;\n"
+    "uniform sampler2D flag_texture;\n"
+    "uniform sampler1D color_map_texture;\n"
+    "uniform int flag_texture_width;\n"
+    "uniform float color_map_resolution;\n"
+    "uniform vec2 axis_x;\n"
+    "uniform vec2 axis_y;\n"
+    "uniform float opacity;\n"
+    "void main()\n"
+    "{\n"
+    "    if ( !InsideRange( flag_texture, flag_texture_width, gl_InstanceID ) )\n"
+    "    {\n"
+    "        gl_Position = vec4( 2.0, 2.0, 2.0, 1.0 );\n"
+    "        return;\n"
+    "    }\n"
+    "    float x = gl_VertexID == 0 ? axis_x.x : axis_x.y;\n"
+    "    float y = mix( axis_y.x, axis_y.y, gl_VertexID == 0 ? value0 : value1 );\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4( x, y, 0.0, 1.0 );\n"
+    "#if defined( ENABLE_DENSITY_MODE )\n"
+    "    gl_FrontColor = vec4( 1.0 );\n"
+    "#else\n"
+    "    float s = ( color_value * ( color_map_resolution - 1.0 ) + 0.5 ) / color_map_resolution;\n"
+    "    gl_FrontColor = vec4( texture1D( color_map_texture, s ).rgb, opacity );\n"
+    "#endif\n"
+    "}\n";
+
+const std::string LineFragmentShader(
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n"
+    );
+
+/*===========================================================================*/
+/**
+ *  @brief  Shaders for the tone mapping of the density.
+ *
+ *  The accumulated density is mapped to the color map in the log scale.
+ */
+/*===========================================================================*/
+const std::string ToneMappingVertexShader(
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4( gl_Vertex.xy * 2.0 - 1.0, 0.0, 1.0 );\n"
+    "}\n"
+    );
+
+const std::string ToneMappingFragmentShader(
+    "#version 120\n"
+    "#extension GL_EXT_gpu_shader4 : enable\n"
+    "uniform sampler2D density_texture;\n"
+    "uniform sampler1D color_map_texture;\n"
+    "uniform float color_map_resolution;\n"
+    "uniform sampler2D max_density_texture;\n"
+    "uniform float opacity;\n"
+    "void main()\n"
+    "{\n"
+    "    float density = texelFetch2D( density_texture, ivec2( gl_FragCoord.xy ), 0 ).r;\n"
+    "    if ( density <= 0.0 ) { discard; }\n"
+    "    float max_density = texelFetch2D( max_density_texture, ivec2( 0, 0 ), 0 ).r;\n"
+    "    float t = log( 1.0 + density ) / log( 1.0 + max_density );\n"
+    "    float s = ( t * ( color_map_resolution - 1.0 ) + 0.5 ) / color_map_resolution;\n"
+    "    gl_FragColor = vec4( texture1D( color_map_texture, s ).rgb, opacity );\n"
+    "}\n"
+    );
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws the rectangle covering the viewport.
+ */
+/*===========================================================================*/
+inline void DrawRectangle()
+{
+    kvs::OpenGL::Begin( GL_QUADS );
+    kvs::OpenGL::Vertex( kvs::Vec2( 0, 0 ) );
+    kvs::OpenGL::Vertex( kvs::Vec2( 1, 0 ) );
+    kvs::OpenGL::Vertex( kvs::Vec2( 1, 1 ) );
+    kvs::OpenGL::Vertex( kvs::Vec2( 0, 1 ) );
+    kvs::OpenGL::End();
+}
+
+} // end of namespace
 
 
 namespace kvs
@@ -134,6 +240,17 @@ void ThisClass::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light*
 
     kvs::OpenGL::Render2D render( kvs::OpenGL::Viewport() );
     render.begin();
+    if ( kvs::TableBuffer::IsSupported() )
+    {
+        // The polylines are drawn by the instanced rendering of the buffers.
+        const kvs::Rectangle rect( kvs::Vec2i( x0, y0 ), kvs::Vec2i( x1, y1 ) );
+        this->create_shaders();
+        m_table_buffer.update( table );
+        this->update_color_map_texture();
+        if ( m_enable_density_mode ) { this->draw_density( table, rect, dpr ); }
+        else { this->draw_lines( table, rect, dpr ); }
+    }
+    else
     {
         const auto& color_axis_values = table->column( m_active_axis );
         const size_t nrows = table->column(0).size();
@@ -163,4 +280,171 @@ void ThisClass::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light*
     BaseClass::stopTimer();
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Creates the shader programs if not created.
+ */
+/*===========================================================================*/
+void ThisClass::create_shaders()
+{
+    if ( m_line_shader.isCreated() ) { return; }
+
+    kvs::ShaderSource line_vert( ::LineVertexShader );
+    kvs::ShaderSource line_frag( ::LineFragmentShader );
+    m_line_shader.build( line_vert, line_frag );
+
+    kvs::ShaderSource density_vert( ::LineVertexShader );
+    kvs::ShaderSource density_frag( ::LineFragmentShader );
+    density_vert.define( "ENABLE_DENSITY_MODE" );
+    m_density_shader.build( density_vert, density_frag );
+
+    kvs::ShaderSource tone_mapping_vert( ::ToneMappingVertexShader );
+    kvs::ShaderSource tone_mapping_frag( ::ToneMappingFragmentShader );
+    m_tone_mapping_shader.build( tone_mapping_vert, tone_mapping_frag );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Uploads the color map table to the texture.
+ */
+/*===========================================================================*/
+void ThisClass::update_color_map_texture()
+{
+    const size_t resolution = m_color_map.resolution();
+    if ( m_color_map_texture.width() != resolution )
+    {
+        m_color_map_texture.release();
+        m_color_map_texture.setWrapS( GL_CLAMP_TO_EDGE );
+        m_color_map_texture.setMagFilter( GL_LINEAR );
+        m_color_map_texture.setMinFilter( GL_LINEAR );
+        m_color_map_texture.setPixelFormat( GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE );
+        m_color_map_texture.create( resolution, m_color_map.table().data() );
+        return;
+    }
+
+    kvs::Texture::GuardedBinder binder( m_color_map_texture );
+    m_color_map_texture.load( resolution, m_color_map.table().data() );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws the polylines with the instanced rendering.
+ *  @param  table [in] pointer to the table data
+ *  @param  rect [in] rectangle of the plot region
+ *  @param  dpr [in] device pixel ratio
+ *
+ *  The line segments between each pair of the neighboring axes are drawn as
+ *  the instances by a single draw call, in which the column values of the
+ *  pair are referred to with the offsets in the column buffer.
+ */
+/*===========================================================================*/
+void ThisClass::draw_lines( const kvs::TableObject* table, const kvs::Rectangle& rect, const float dpr )
+{
+    const size_t nrows = table->numberOfRows();
+    const size_t naxes = table->numberOfColumns();
+    if ( nrows == 0 || naxes < 2 ) { return; }
+
+    auto& shader = m_enable_density_mode ? m_density_shader : m_line_shader;
+    kvs::ProgramObject::Binder bind_shader( shader );
+    kvs::Texture::Binder bind_flag( m_table_buffer.flagTexture(), 0 );
+    kvs::Texture::Binder bind_color_map( m_color_map_texture, 1 );
+    kvs::VertexBufferObject::Binder bind_buffer( m_table_buffer.columnBuffer() );
+
+    shader.setUniform( "flag_texture", 0 );
+    shader.setUniform( "color_map_texture", 1 );
+    shader.setUniform( "flag_texture_width", static_cast<GLint>( m_table_buffer.flagTexture().width() ) );
+    shader.setUniform( "color_map_resolution", static_cast<GLfloat>( m_color_map.resolution() ) );
+    shader.setUniform( "axis_y", kvs::Vec2( rect.y1(), rect.y0() ) * dpr );
+    shader.setUniform( "opacity", m_line_opacity );
+
+    const GLint locations[3] = {
+        shader.attributeLocation( "value0" ),
+        shader.attributeLocation( "value1" ),
+        shader.attributeLocation( "color_value" ) };
+    for ( const auto location : locations )
+    {
+        if ( location < 0 ) { continue; }
+        kvs::OpenGL::EnableVertexAttribArray( location );
+        kvs::OpenGL::VertexAttribDivisor( location, 1 );
+    }
+
+    m_table_buffer.setColumnPointer( locations[2], m_active_axis );
+
+    kvs::OpenGL::SetLineWidth( m_line_width * dpr );
+    const float dx = float( rect.width() ) / ( naxes - 1 );
+    for ( size_t j = 0; j < naxes - 1; j++ )
+    {
+        const float x = rect.x0() + dx * j;
+        shader.setUniform( "axis_x", kvs::Vec2( x, x + dx ) * dpr );
+        m_table_buffer.setColumnPointer( locations[0], j );
+        m_table_buffer.setColumnPointer( locations[1], j + 1 );
+        kvs::OpenGL::DrawArraysInstanced( GL_LINES, 0, 2, static_cast<GLsizei>( nrows ) );
+    }
+
+    for ( const auto location : locations )
+    {
+        if ( location < 0 ) { continue; }
+        kvs::OpenGL::VertexAttribDivisor( location, 0 );
+        kvs::OpenGL::DisableVertexAttribArray( location );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws the density of the polylines.
+ *  @param  table [in] pointer to the table data
+ *  @param  rect [in] rectangle of the plot region
+ *  @param  dpr [in] device pixel ratio
+ *
+ *  The number of the polylines passing through each pixel is accumulated to
+ *  the floating-point framebuffer by the additive blending, and the density
+ *  is drawn with the color map in the log scale normalized by the max. density,
+ *  which is reduced on the GPU without reading the pixels back.
+ */
+/*===========================================================================*/
+void ThisClass::draw_density( const kvs::TableObject* table, const kvs::Rectangle& rect, const float dpr )
+{
+    const kvs::Vec4 vp = kvs::OpenGL::Viewport();
+    const size_t width = static_cast<size_t>( vp[0] + vp[2] );
+    const size_t height = static_cast<size_t>( vp[1] + vp[3] );
+    if ( m_density_texture.width() != width || m_density_texture.height() != height )
+    {
+        m_density_framebuffer.release();
+        m_density_texture.release();
+        m_density_texture.setWrapS( GL_CLAMP_TO_EDGE );
+        m_density_texture.setWrapT( GL_CLAMP_TO_EDGE );
+        m_density_texture.setMagFilter( GL_NEAREST );
+        m_density_texture.setMinFilter( GL_NEAREST );
+        m_density_texture.setPixelFormat( GL_R32F, GL_RED, GL_FLOAT );
+        m_density_texture.create( width, height );
+        m_density_framebuffer.create();
+        m_density_framebuffer.attachColorTexture( m_density_texture );
+    }
+
+    // Accumulate the density.
+    {
+        kvs::FrameBufferObject::Binder bind_framebuffer( m_density_framebuffer );
+        kvs::OpenGL::SetClearColor( kvs::Vec4::Zero() );
+        kvs::OpenGL::Clear( GL_COLOR_BUFFER_BIT );
+        kvs::OpenGL::SetBlendFunc( GL_ONE, GL_ONE );
+        this->draw_lines( table, rect, dpr );
+    }
+
+    // Reduce the density to the max. density.
+    m_max_density_buffer.reduce( m_density_texture );
+
+    // Draw the density with the color map.
+    kvs::OpenGL::SetBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    kvs::ProgramObject::Binder bind_shader( m_tone_mapping_shader );
+    kvs::Texture::Binder bind_density( m_density_texture, 0 );
+    kvs::Texture::Binder bind_color_map( m_color_map_texture, 1 );
+    kvs::Texture::Binder bind_max_density( m_max_density_buffer.resultTexture(), 2 );
+    m_tone_mapping_shader.setUniform( "density_texture", 0 );
+    m_tone_mapping_shader.setUniform( "color_map_texture", 1 );
+    m_tone_mapping_shader.setUniform( "max_density_texture", 2 );
+    m_tone_mapping_shader.setUniform( "color_map_resolution", static_cast<GLfloat>( m_color_map.resolution() ) );
+    m_tone_mapping_shader.setUniform( "opacity", m_line_opacity );
+    ::DrawRectangle();
+}
+
 } // end of namespace kvs
@@ -10,6 +10,13 @@
 #include <kvs/ColorMap>
 #include <kvs/Margins>
 #include <kvs/TableObject>
+#include <kvs/Rectangle>
+#include <kvs/TableBuffer>
+#include <kvs/ProgramObject>
+#include <kvs/Texture1D>
+#include <kvs/Texture2D>
+#include <kvs/FrameBufferObject>
+#include <kvs/MaxReductionBuffer>
 
 
 namespace kvs
@@ -37,6 +44,16 @@ private:
     kvs::Real32 m_line_opacity = 1.0f; ///< line opacity
     kvs::Real32 m_line_width = 1.0f; ///< line width
     kvs::ColorMap m_color_map{ 256 }; ///< color map
+    bool m_enable_density_mode = false; ///< flag for density mode
+
+    kvs::TableBuffer m_table_buffer{}; ///< buffers of the table for the instanced rendering
+    kvs::Texture1D m_color_map_texture{}; ///< color map texture
+    kvs::ProgramObject m_line_shader{}; ///< shader for the polylines
+    kvs::ProgramObject m_density_shader{}; ///< shader for the density accumulation
+    kvs::ProgramObject m_tone_mapping_shader{}; ///< shader for the tone mapping of the density
+    kvs::FrameBufferObject m_density_framebuffer{}; ///< framebuffer for the density accumulation
+    kvs::Texture2D m_density_texture{}; ///< floating-point density texture
+    kvs::MaxReductionBuffer m_max_density_buffer{}; ///< buffer for the max. density
 
 public:
     ParallelCoordinatesRenderer() { m_color_map.create(); }
@@ -46,12 +63,16 @@ public:
     void setLineWidth( const kvs::Real32 width ) { m_line_width = width; }
     void setColorMap( const kvs::ColorMap& color_map ) { m_color_map = color_map; }
     void selectAxis( const size_t index ) { m_active_axis = index; }
+    void setDensityModeEnabled( const bool enable = true ) { m_enable_density_mode = enable; }
+    void enableDensityMode() { this->setDensityModeEnabled( true ); }
+    void disableDensityMode() { this->setDensityModeEnabled( false ); }
 
     const kvs::Margins& margins() const { return m_margins; }
     const kvs::ColorMap& colorMap() const { return m_color_map; }
     size_t activeAxis() const { return m_active_axis; }
     kvs::Real32 lineOpacity() const { return m_line_opacity; }
     kvs::Real32 lineWidth() const { return m_line_width; }
+    bool isDensityModeEnabled() const { return m_enable_density_mode; }
     void setAntiAliasingEnabled( const bool aa = true, const bool msaa = false ) const;
     void enableAntiAliasing( const bool multisample = false ) const;
     void disableAntiAliasing() const;
@@ -61,6 +82,12 @@ public:
 protected:
     void updateColorMapRange( const kvs::TableObject* table );
     void updateAntiAliasing();
+
+private:
+    void create_shaders();
+    void update_color_map_texture();
+    void draw_lines( const kvs::TableObject* table, const kvs::Rectangle& rect, const float dpr );
+    void draw_density( const kvs::TableObject* table, const kvs::Rectangle& rect, const float dpr );
 };
 
 } // end of namespace kvs
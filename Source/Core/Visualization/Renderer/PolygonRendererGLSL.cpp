@@ -344,13 +344,27 @@ namespace kvs
 namespace glsl
 {
 
+/*===========================================================================*/
+/**
+ *  @brief  Releases the buffer object.
+ */
+/*===========================================================================*/
+void PolygonRenderer::BufferObject::release()
+{
+    if ( m_request ) { m_request->cancel(); m_request.reset(); }
+    m_manager.release();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Creates a buffer object.
  *  @param  object [in] pointer to polgon object  
+ *  @param  queue [in] upload queue (if null, the data is uploaded immediately)
  */
 /*===========================================================================*/
-void PolygonRenderer::BufferObject::create( const kvs::ObjectBase* object )
+void PolygonRenderer::BufferObject::create(
+    const kvs::ObjectBase* object,
+    kvs::BufferUploadQueue* queue )
 {
     const auto* polygon = kvs::PolygonObject::DownCast( object );
     if ( polygon->polygonType() != kvs::PolygonObject::Triangle )
@@ -366,12 +380,35 @@ void PolygonRenderer::BufferObject::create( const kvs::ObjectBase* object )
     auto colors = ::VertexColors( polygon );
     auto normals = ::VertexNormals( polygon );
 
+    // Opacities of the vertices, which determine the render passes for OIT.
+    m_has_opaque_vertices = colors.size() == 0;
+    m_has_transparent_vertices = false;
+    for ( size_t i = 3; i < colors.size(); i += 4 )
+    {
+        if ( colors[i] == 255 ) { m_has_opaque_vertices = true; }
+        else { m_has_transparent_vertices = true; }
+        if ( m_has_opaque_vertices && m_has_transparent_vertices ) { break; }
+    }
+
     m_manager.setVertexArray( coords, 3 );
     m_manager.setColorArray( colors, 4 );
     if ( has_normal ) { m_manager.setNormalArray( normals ); }
     if ( has_connection ) { m_manager.setIndexArray( polygon->connections() ); }
 
-    m_manager.create();
+    if ( queue )
+    {
+        // The arrays are kept in the request until the upload is completed.
+        m_request = std::make_shared<kvs::BufferUploadQueue::Request>( &m_manager );
+        m_request->hold( coords );
+        m_request->hold( colors );
+        m_request->hold( normals );
+        m_request->hold( polygon->connections() );
+        queue->push( m_request );
+    }
+    else
+    {
+        m_manager.create();
+    }
 }
 
 /*===========================================================================*/
@@ -436,6 +473,11 @@ void PolygonRenderer::RenderPass::create(
         }
     }
 
+    if ( m_enable_oit )
+    {
+        frag.define("ENABLE_WEIGHTED_BLENDED_OIT");
+    }
+
     m_shader_program.build( vert, frag );
 }
 
@@ -515,6 +557,7 @@ void PolygonRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::L
         this->setWindowSize( width, height );
         this->createBufferObject( object );
         shading_model.two_side_lighting = BaseClass::isTwoSideLightingEnabled();
+        m_render_pass.setOITEnabled( m_enable_oit );
         m_render_pass.create( shading_model, shading_enabled );
     }
 
@@ -527,15 +570,50 @@ void PolygonRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::L
     {
         this->updateBufferObject( object );
         shading_model.two_side_lighting = BaseClass::isTwoSideLightingEnabled();
+        m_render_pass.setOITEnabled( m_enable_oit );
+        m_render_pass.update( shading_model, shading_enabled );
+    }
+
+    if ( m_render_pass.isOITEnabled() != m_enable_oit )
+    {
+        m_render_pass.setOITEnabled( m_enable_oit );
         m_render_pass.update( shading_model, shading_enabled );
+        if ( !m_enable_oit ) { m_oit_buffer.release(); }
     }
 
-    m_render_pass.setup( shading_model );
-    this->drawBufferObject( camera );
+    // The object is drawn after the upload is completed.
+    if ( m_buffer_object.isUploaded() )
+    {
+        m_render_pass.setup( shading_model );
+        this->drawBufferObject( camera );
+    }
 
     BaseClass::stopTimer();
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Prepares the buffer object and pushes it to the upload queue.
+ *  @param  object [in] pointer to the polygon object
+ *
+ *  The vertex arrays are built without any OpenGL calls, so that this method
+ *  can be called from a worker thread before the renderer is executed. The
+ *  upload queue must be set in advance, and the screen should be redrawn
+ *  after the preparation to start the upload.
+ */
+/*===========================================================================*/
+void PolygonRenderer::prepare( const kvs::ObjectBase* object )
+{
+    if ( !m_upload_queue )
+    {
+        kvsMessageError() << "Upload queue is not set." << std::endl;
+        return;
+    }
+
+    m_object = object;
+    m_buffer_object.create( object, m_upload_queue );
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Creates buffer object.
@@ -544,8 +622,11 @@ void PolygonRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::L
 /*===========================================================================*/
 void PolygonRenderer::createBufferObject( const kvs::ObjectBase* object )
 {
+    // The buffer object has already been pushed to the queue by prepare().
+    if ( m_object == object && m_buffer_object.isRequested() ) { return; }
+
     m_object = object;
-    m_buffer_object.create( object );
+    m_buffer_object.create( object, m_upload_queue );
 }
 
 /*===========================================================================*/
@@ -578,7 +659,50 @@ void PolygonRenderer::drawBufferObject( const kvs::Camera* camera )
 
     kvs::OpenGL::Enable( GL_DEPTH_TEST );
     kvs::OpenGL::SetPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-    m_render_pass.draw( m_object );
+    if ( m_render_pass.isOITEnabled() ) { this->drawBufferObjectWithOIT( camera ); }
+    else { m_render_pass.draw( m_object ); }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws buffer object with the weighted blended OIT.
+ *  @param  camera [in] pointer to the camera
+ */
+/*===========================================================================*/
+void PolygonRenderer::drawBufferObjectWithOIT( const kvs::Camera* camera )
+{
+    // Opaque fragments are drawn first, so that they occlude the transparent
+    // fragments behind them.
+    auto& shader = m_render_pass.shaderProgram();
+    if ( m_buffer_object.hasOpaqueVertices() )
+    {
+        {
+            kvs::ProgramObject::Binder bind( shader );
+            shader.setUniform( "opaque_pass", 1 );
+        }
+        m_render_pass.draw( m_object );
+    }
+
+    if ( m_buffer_object.hasTransparentVertices() )
+    {
+        const auto dpr = camera->devicePixelRatio();
+        const size_t framebuffer_width = static_cast<size_t>( m_width * dpr );
+        const size_t framebuffer_height = static_cast<size_t>( m_height * dpr );
+        if ( m_oit_buffer.width() != framebuffer_width ||
+             m_oit_buffer.height() != framebuffer_height )
+        {
+            m_oit_buffer.create( framebuffer_width, framebuffer_height );
+        }
+
+        {
+            kvs::ProgramObject::Binder bind( shader );
+            shader.setUniform( "opaque_pass", 0 );
+        }
+        m_oit_buffer.bind();
+        m_render_pass.draw( m_object );
+        m_oit_buffer.unbind();
+        m_oit_buffer.draw();
+    }
 }
 
 } // end of namespace glsl
@@ -11,6 +11,8 @@
 #include <kvs/Shader>
 #include <kvs/ProgramObject>
 #include <kvs/VertexBufferObjectManager>
+#include <kvs/BufferUploadQueue>
+#include <kvs/WeightedBlendedBuffer>
 #include <kvs/Deprecated>
 #include <string>
 
@@ -24,6 +26,10 @@ namespace glsl
 /*===========================================================================*/
 /**
  *  @brief  Polygon renderer class.
+ *
+ *  If the order-independent transparency (OIT) is enabled, the transparent
+ *  fragments are composited by the weighted blended OIT in a single geometry
+ *  pass, and the opaque fragments, if any, are drawn in a preceding pass.
  */
 /*===========================================================================*/
 class PolygonRenderer : public kvs::PolygonRenderer
@@ -36,12 +42,19 @@ public:
     {
     private:
         kvs::VertexBufferObjectManager m_manager{}; ///< VBOs
+        kvs::BufferUploadQueue::RequestPointer m_request{}; ///< upload request
+        bool m_has_opaque_vertices = true; ///< true if the object has opaque vertices
+        bool m_has_transparent_vertices = false; ///< true if the object has transparent vertices
     public:
         BufferObject() = default;
         virtual ~BufferObject() { this->release(); }
         kvs::VertexBufferObjectManager& manager() { return m_manager; }
-        void release() { m_manager.release(); }
-        void create( const kvs::ObjectBase* object );
+        bool isRequested() const { return m_request != nullptr; }
+        bool isUploaded() const { return !m_request || m_request->isCompleted(); }
+        bool hasOpaqueVertices() const { return m_has_opaque_vertices; }
+        bool hasTransparentVertices() const { return m_has_transparent_vertices; }
+        void release();
+        void create( const kvs::ObjectBase* object, kvs::BufferUploadQueue* queue = nullptr );
         void draw( const kvs::ObjectBase* object );
     };
 
@@ -52,6 +65,7 @@ public:
         std::string m_vert_shader_file = "shader.vert"; ///< vertex shader file
         std::string m_frag_shader_file = "shader.frag"; ///< fragment shader file
         kvs::ProgramObject m_shader_program{}; ///< shader program
+        bool m_enable_oit = false; ///< flag for weighted blended OIT
     public:
         RenderPass( BufferObject& buffer_object ): m_buffer_object( buffer_object ) {}
         virtual ~RenderPass() { this->release(); }
@@ -59,9 +73,11 @@ public:
         const std::string& vertexShaderFile() const { return m_vert_shader_file; }
         const std::string& fragmentShaderFile() const { return m_frag_shader_file; }
         kvs::ProgramObject& shaderProgram() { return m_shader_program; }
+        bool isOITEnabled() const { return m_enable_oit; }
         void setVertexShaderFile( const std::string& file ) { m_vert_shader_file = file; }
         void setFragmentShaderFile( const std::string& file ) { m_frag_shader_file = file; }
         void setShaderFiles( const std::string& vert_file, const std::string& frag_file );
+        void setOITEnabled( const bool enable = true ) { m_enable_oit = enable; }
         virtual void release() { m_shader_program.release(); }
         virtual void create( const kvs::Shader::ShadingModel& model, const bool enable );
         virtual void update( const kvs::Shader::ShadingModel& model, const bool enable );
@@ -77,6 +93,9 @@ private:
 
     BufferObject m_buffer_object{}; ///< buffer object
     RenderPass m_render_pass{ m_buffer_object }; ///< render pass
+    kvs::BufferUploadQueue* m_upload_queue = nullptr; ///< upload queue (reference)
+    bool m_enable_oit = false; ///< flag for order-independent transparency
+    kvs::WeightedBlendedBuffer m_oit_buffer{}; ///< buffer for weighted blended OIT
 
 public:
     PolygonRenderer(): m_shading_model( new kvs::Shader::Lambert() ) {}
@@ -93,6 +112,13 @@ public:
         this->setVertexShaderFile( vert_file );
         this->setFragmentShaderFile( frag_file );
     }
+    void setUploadQueue( kvs::BufferUploadQueue* queue ) { m_upload_queue = queue; }
+    void prepare( const kvs::ObjectBase* object );
+
+    bool isOITEnabled() const { return m_enable_oit; }
+    void setOITEnabled( const bool enable = true ) { m_enable_oit = enable; }
+    void enableOIT() { this->setOITEnabled( true ); }
+    void disableOIT() { this->setOITEnabled( false ); }
 
     template <typename Model>
     void setShadingModel( const Model model )
@@ -120,6 +146,7 @@ protected:
     void createBufferObject( const kvs::ObjectBase* object );
     void updateBufferObject( const kvs::ObjectBase* object );
     void drawBufferObject( const kvs::Camera* camera );
+    void drawBufferObjectWithOIT( const kvs::Camera* camera );
 
 public:
     template <typename ShadingType>
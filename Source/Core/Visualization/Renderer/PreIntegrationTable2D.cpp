@@ -7,6 +7,7 @@
 #include "PreIntegrationTable2D.h"
 #include <kvs/Assert>
 #include <kvs/Math>
+#include <kvs/OpenMP>
 
 
 namespace
@@ -127,21 +128,9 @@ void PreIntegrationTable2D::setTransferFunction( const kvs::TransferFunction& tr
         tau[i] = ::AlphaToTau( omap[i] );
     }
 
-    kvs::ValueArray<kvs::Real64> T( resolution );
-    const double L = 1.0f / ( resolution - 1 );
-    double Tau = 0.0f;
-    double tau0 = tau[0];
-    T[0] = Tau;
-    for ( size_t i = 1; i < resolution; i++ )
-    {
-        double tau1 = tau[i];
-        Tau += L / 2.0 * ( tau1 + tau0 );
-        T[i] = Tau;
-        tau0 = tau1;
-    }
-
     m_tau = tau;
-    m_T = T;
+    m_T.allocate( resolution );
+    this->update_T( 0 );
 }
 
 /*===========================================================================*/
@@ -151,29 +140,115 @@ void PreIntegrationTable2D::setTransferFunction( const kvs::TransferFunction& tr
 /*===========================================================================*/
 void PreIntegrationTable2D::create()
 {
-    kvs::ValueArray<kvs::Real64> T = m_T;
-    kvs::ValueArray<kvs::Real64> tau = m_tau;
+    const size_t resolution = m_tau.size();
+    m_table.allocate( resolution * resolution );
+    this->update_table( 0, resolution );
+}
 
-    const size_t resolution = tau.size();
-    kvs::ValueArray<kvs::Real32> table( resolution * resolution );
-    for ( size_t i = 0, index = 0; i < resolution; i++ )
+/*===========================================================================*/
+/**
+ *  @brief  Updates pre-integration table for the modified transfer function.
+ *  @param  transfer_function [in] transfer function
+ *  @return true if the table is changed
+ *
+ *  Only the entries affected by the band of the changed opacities are rebuilt.
+ *  If the resolution is changed or the table is not created, the whole table
+ *  is created.
+ */
+/*===========================================================================*/
+bool PreIntegrationTable2D::update( const kvs::TransferFunction& transfer_function )
+{
+    const kvs::ValueArray<kvs::Real32> omap = transfer_function.opacityMap().table();
+    const size_t resolution = omap.size();
+    if ( resolution != m_tau.size() || m_table.size() != resolution * resolution )
+    {
+        this->setTransferFunction( transfer_function );
+        this->create();
+        return true;
+    }
+
+    size_t begin = resolution;
+    size_t end = 0;
+    for ( size_t i = 0; i < resolution; i++ )
     {
-        for ( size_t j = 0; j < resolution; j++, index++ )
+        const double tau = ::AlphaToTau( omap[i] );
+        if ( tau != m_tau[i] )
         {
-            if ( i == j )
-            {
-                table[index] = tau[i];
-            }
-            else
-            {
-                const double sf = j / static_cast<double>( resolution - 1 );
-                const double sb = i / static_cast<double>( resolution - 1 );
-                table[index] = ( T[i] - T[j] ) / ( sb - sf );
-            }
+            m_tau[i] = tau;
+            begin = kvs::Math::Min( begin, i );
+            end = i + 1;
         }
     }
 
-    m_table = table;
+    if ( begin >= end ) { return false; }
+
+    this->update_T( begin );
+    this->update_table( begin, end );
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the integral of the tau from the specified index.
+ *  @param  begin [in] first index of the changed tau
+ */
+/*===========================================================================*/
+void PreIntegrationTable2D::update_T( const size_t begin )
+{
+    const size_t resolution = m_tau.size();
+    const double L = 1.0f / ( resolution - 1 );
+    const size_t first = kvs::Math::Max( begin, size_t(1) );
+    m_T[0] = 0.0;
+    double Tau = m_T[ first - 1 ];
+    for ( size_t i = first; i < resolution; i++ )
+    {
+        Tau += L / 2.0 * ( m_tau[i] + m_tau[ i - 1 ] );
+        m_T[i] = Tau;
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the table entries affected by the band of the changed tau.
+ *  @param  begin [in] first index of the band
+ *  @param  end [in] last index of the band plus one
+ *
+ *  The entry (i,j) is given by the prefix integral as (T[i]-T[j])/(sb-sf), so
+ *  that it is changed only if the range [min(i,j),max(i,j)] overlaps the band.
+ *  The rows are computed in parallel, and the branchless inner loops on both
+ *  sides of the diagonal can be vectorized.
+ */
+/*===========================================================================*/
+void PreIntegrationTable2D::update_table( const size_t begin, const size_t end )
+{
+    const size_t resolution = m_tau.size();
+    const double* T = m_T.data();
+    const double scale = static_cast<double>( resolution - 1 );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < static_cast<long>( resolution ); i++ )
+    {
+        const size_t row = static_cast<size_t>( i );
+        const size_t j_begin = row < begin ? begin : 0;
+        const size_t j_end = row >= end ? end : resolution;
+        const double Ti = T[i];
+        const double si = static_cast<double>( i );
+        kvs::Real32* table = m_table.data() + row * resolution;
+
+        for ( size_t j = j_begin; j < kvs::Math::Min( row, j_end ); j++ )
+        {
+            table[j] = static_cast<kvs::Real32>( ( Ti - T[j] ) * scale / ( si - j ) );
+        }
+
+        if ( j_begin <= row && row < j_end )
+        {
+            table[ row ] = static_cast<kvs::Real32>( m_tau[ row ] );
+        }
+
+        for ( size_t j = kvs::Math::Max( row + 1, j_begin ); j < j_end; j++ )
+        {
+            table[j] = static_cast<kvs::Real32>( ( Ti - T[j] ) * scale / ( si - j ) );
+        }
+    }
 }
 
 } // end of namespace kvs
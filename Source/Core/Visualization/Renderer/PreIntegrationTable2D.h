@@ -44,6 +44,12 @@ public:
 
     void setTransferFunction( const kvs::TransferFunction& transfer_function );
     void create();
+    bool update( const kvs::TransferFunction& transfer_function );
+
+private:
+
+    void update_T( const size_t begin );
+    void update_table( const size_t begin, const size_t end );
 };
 
 } // end of namespace kvs
@@ -12,8 +12,10 @@
 /*****************************************************************************/
 #include "PreIntegrationTable3D.h"
 #include <vector>
+#include <algorithm>
 #include <kvs/Math>
 #include <kvs/ValueArray>
+#include <kvs/OpenMP>
 
 
 namespace
@@ -190,6 +192,21 @@ inline kvs::Vec4 OpacityWeightedColor( const kvs::Vec4& color, const float t )
     return kvs::Vec4( color[0] * a, color[1] * a, color[2] * a, a );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the entry is affected by the band of the scalars.
+ *  @param  sb [in] index of the back scalar
+ *  @param  sf [in] index of the front scalar
+ *  @param  begin [in] first index of the band
+ *  @param  end [in] last index of the band plus one
+ *  @return true if the scalar range of the entry overlaps the band
+ */
+/*===========================================================================*/
+inline bool IsAffected( const size_t sb, const size_t sf, const size_t begin, const size_t end )
+{
+    return kvs::Math::Max( sb, sf ) >= begin && kvs::Math::Min( sb, sf ) < end;
+}
+
 }
 
 
@@ -201,7 +218,8 @@ namespace kvs
  *  @brief  Constructs a new PreIntegrationTable3D class.
  */
 /*===========================================================================*/
-PreIntegrationTable3D::PreIntegrationTable3D()
+PreIntegrationTable3D::PreIntegrationTable3D():
+    m_max_size_of_cell( 0.0f )
 {
     this->setScalarResolution( 128 );
     this->setDepthResolution( 128 );
@@ -216,7 +234,8 @@ PreIntegrationTable3D::PreIntegrationTable3D()
 /*===========================================================================*/
 PreIntegrationTable3D::PreIntegrationTable3D( const size_t scalar_resolution, const size_t depth_resolution ):
     m_scalar_resolution( scalar_resolution ),
-    m_depth_resolution( depth_resolution )
+    m_depth_resolution( depth_resolution ),
+    m_max_size_of_cell( 0.0f )
 {
 }
 
@@ -247,22 +266,85 @@ void PreIntegrationTable3D::setTransferFunction(
 /*===========================================================================*/
 void PreIntegrationTable3D::create( const float max_size_of_cell )
 {
-    // Compute pre-integration table.
     const size_t slice_size = 4 * m_scalar_resolution * m_scalar_resolution;
+    m_max_size_of_cell = max_size_of_cell;
     m_table.allocate( slice_size * m_depth_resolution );
     m_table.fill( 0.0f );
+    this->update_table( 0, m_scalar_resolution );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates pre-integration table for the modified transfer function.
+ *  @param  transfer_function [in] transfer function
+ *  @param  min_scalar [in] minimum scalar value
+ *  @param  max_scalar [in] maximum scalar value
+ *  @return true if the table is changed
+ *
+ *  Only the entries whose scalar range overlaps the band of the changed
+ *  colors and opacities are recomputed, since the entry (sb,sf) of each slice
+ *  depends only on the transfer function in [min(sb,sf),max(sb,sf)]. The
+ *  table has to be created by create() in advance.
+ */
+/*===========================================================================*/
+bool PreIntegrationTable3D::update(
+    const kvs::TransferFunction& transfer_function,
+    const float min_scalar,
+    const float max_scalar )
+{
+    const size_t N = m_scalar_resolution;
+    const kvs::ValueArray<kvs::Real32> TF = ::Serialize( transfer_function, min_scalar, max_scalar, N );
+    if ( m_transfer_function.size() != TF.size() ||
+         m_table.size() != 4 * N * N * m_depth_resolution )
+    {
+        m_transfer_function = TF;
+        this->create( m_max_size_of_cell );
+        return true;
+    }
+
+    size_t begin = N;
+    size_t end = 0;
+    for ( size_t i = 0; i < N; i++ )
+    {
+        if ( !std::equal( &TF[ 4 * i ], &TF[ 4 * i ] + 4, &m_transfer_function[ 4 * i ] ) )
+        {
+            begin = kvs::Math::Min( begin, i );
+            end = i + 1;
+        }
+    }
+
+    if ( begin >= end ) { return false; }
 
-    const float dl = max_size_of_cell / float( m_depth_resolution - 1 );
+    // The band is extended by one, since the incremental levels refer to the
+    // neighboring entries with the linear interpolation.
+    m_transfer_function = TF;
+    this->update_table( begin > 0 ? begin - 1 : 0, kvs::Math::Min( end + 1, N ) );
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the entries affected by the band of the scalars.
+ *  @param  begin [in] first index of the band
+ *  @param  end [in] last index of the band plus one
+ */
+/*===========================================================================*/
+void PreIntegrationTable3D::update_table( const size_t begin, const size_t end )
+{
+    const size_t slice_size = 4 * m_scalar_resolution * m_scalar_resolution;
+    const float dl = m_max_size_of_cell / float( m_depth_resolution - 1 );
     kvs::Real32* slice0 = m_table.data();
-    this->compute_exact_level( slice0, dl );
+    this->compute_exact_level( slice0, dl, begin, end );
 
+    // Each level depends on the previous one, so that the levels are computed
+    // in order and the entries in each level are computed in parallel.
     float l = dl;
     for ( size_t i = 1; i < m_depth_resolution; i++ )
     {
         l += dl;
         kvs::Real32* slice = slice0 + i * slice_size;
         const kvs::Real32* slicep = slice0 + ( i - 1 ) * slice_size;
-        this->compute_incremental_level( slice, slicep, slice0, l, dl );
+        this->compute_incremental_level( slice, slicep, slice0, l, dl, begin, end );
     }
 }
 
@@ -271,16 +353,26 @@ void PreIntegrationTable3D::create( const float max_size_of_cell )
  *  @brief  Computes 2D pre-integration table by numerical integration.
  *  @param  slice0 [in/out] pointer to the head of the first slice
  *  @param  dl [in] thickness of a slice
+ *  @param  begin [in] first index of the band to be computed
+ *  @param  end [in] last index of the band to be computed plus one
  */
 /*===========================================================================*/
-void PreIntegrationTable3D::compute_exact_level( float* slice0, const float dl )
+void PreIntegrationTable3D::compute_exact_level(
+    float* slice0,
+    const float dl,
+    const size_t begin,
+    const size_t end )
 {
     const size_t N = m_scalar_resolution;
     const kvs::ValueArray<kvs::Real32>& TF = m_transfer_function;
-    for ( size_t sb = 0, index = 0; sb < N; sb++ )
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long row = 0; row < static_cast<long>( N ); row++ )
     {
-        for ( size_t sf = 0; sf < N; sf++, index++ )
+        const size_t sb = static_cast<size_t>( row );
+        for ( size_t sf = 0, index = sb * N; sf < N; sf++, index++ )
         {
+            if ( !::IsAffected( sb, sf, begin, end ) ) { continue; }
+
             kvs::Vec4 c( 0.0f, 0.0f, 0.0f, 0.0f );
 
             if ( sb == sf )
@@ -328,6 +420,8 @@ void PreIntegrationTable3D::compute_exact_level( float* slice0, const float dl )
  *  @param  slice0 [in] pointer to the head of the first slice
  *  @param  l [in] thickness between the first and the current slices
  *  @param  dl [in] thickness of a slice
+ *  @param  begin [in] first index of the band to be computed
+ *  @param  end [in] last index of the band to be computed plus one
  */
 /*===========================================================================*/
 void PreIntegrationTable3D::compute_incremental_level(
@@ -335,13 +429,19 @@ void PreIntegrationTable3D::compute_incremental_level(
     const float* slicep,
     const float* slice0,
     const float l,
-    const float dl )
+    const float dl,
+    const size_t begin,
+    const size_t end )
 {
     const size_t N = m_scalar_resolution;
-    for ( size_t i = 0, index = 0; i < N; i++ )
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long row = 0; row < static_cast<long>( N ); row++ )
     {
-        for ( size_t j = 0; j < N; j++, index++ )
+        const size_t i = static_cast<size_t>( row );
+        for ( size_t j = 0, index = i * N; j < N; j++, index++ )
         {
+            if ( !::IsAffected( i, j, begin, end ) ) { continue; }
+
             const float sf = ( 2.0f * j + 1.0f ) / ( 2.0f * N );
             const float sb = ( 2.0f * i + 1.0f ) / ( 2.0f * N );
             const float sp = ( ( l - dl ) * sf + ( dl * sb ) ) / l;
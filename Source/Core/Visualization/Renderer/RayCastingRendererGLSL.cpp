@@ -10,6 +10,8 @@
 #include <kvs/Vector3>
 #include <kvs/OpenGL>
 #include <kvs/Coordinate>
+#include <kvs/OpenMP>
+#include <cmath>
 
 
 namespace
@@ -17,28 +19,53 @@ namespace
 
 /*===========================================================================*/
 /**
- *  @brief  Normalizes value array.
+ *  @brief  Converts value array to 32-bit float value array.
  *  @param  volume [in] pointer to the volume object
- *  @param  min_value [in] minimum value of the volume data
- *  @param  max_value [in] maximum value of the volume data
- *  @return normalized value array
+ *  @return float value array
  */
 /*===========================================================================*/
 template <typename T>
-kvs::AnyValueArray NormalizeValues(
-    const kvs::StructuredVolumeObject* volume,
-    const kvs::Real32 min_value,
-    const kvs::Real32 max_value )
+kvs::AnyValueArray ToReal32( const kvs::StructuredVolumeObject* volume )
 {
-    const kvs::Real32 scale = 1.0f / ( max_value - min_value );
-    const size_t nnodes = volume->numberOfNodes();
+    const size_t nvalues = volume->values().size();
     const T* src = static_cast<const T*>( volume->values().data() );
 
-    kvs::ValueArray<kvs::Real32> data( nnodes );
+    kvs::ValueArray<kvs::Real32> data( nvalues );
     kvs::Real32* dst = data.data();
-    for ( size_t i = 0; i < nnodes; i++ )
+    for ( size_t i = 0; i < nvalues; i++ )
+    {
+        *(dst++) = static_cast<kvs::Real32>( *(src++) );
+    }
+
+    return kvs::AnyValueArray( data );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Quantizes value array to 16-bit unsigned value array.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  min_value [in] value mapped to 0
+ *  @param  max_value [in] value mapped to 65535
+ *  @return quantized value array
+ */
+/*===========================================================================*/
+template <typename T>
+kvs::AnyValueArray Quantize(
+    const kvs::StructuredVolumeObject* volume,
+    const kvs::Real64 min_value,
+    const kvs::Real64 max_value )
+{
+    const kvs::Real64 max_level = kvs::Value<kvs::UInt16>::Max();
+    const kvs::Real64 scale = max_value > min_value ? max_level / ( max_value - min_value ) : 0.0;
+    const size_t nvalues = volume->values().size();
+    const T* src = static_cast<const T*>( volume->values().data() );
+
+    kvs::ValueArray<kvs::UInt16> data( nvalues );
+    kvs::UInt16* dst = data.data();
+    for ( size_t i = 0; i < nvalues; i++ )
     {
-        *(dst++) = static_cast<kvs::Real32>(( *(src++) - min_value ) * scale);
+        const kvs::Real64 level = ( static_cast<kvs::Real64>( *(src++) ) - min_value ) * scale + 0.5;
+        *(dst++) = static_cast<kvs::UInt16>( kvs::Math::Clamp( level, 0.0, max_level ) );
     }
 
     return kvs::AnyValueArray( data );
@@ -68,6 +95,187 @@ kvs::AnyValueArray SignedToUnsigned( const kvs::StructuredVolumeObject* volume )
     return kvs::AnyValueArray( data );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the gradient vector estimated by the central difference.
+ *  @param  src [in] pointer to the values
+ *  @param  r [in] volume resolution
+ *  @param  i [in] index in x
+ *  @param  j [in] index in y
+ *  @param  k [in] index in z
+ *  @return gradient vector
+ *
+ *  The sign convention follows VolumeGradient in volume.h, i.e. the vector
+ *  points from the higher values to the lower values.
+ */
+/*===========================================================================*/
+template <typename T>
+inline kvs::Vec3 CentralDifference(
+    const T* src,
+    const kvs::Vec3u& r,
+    const size_t i,
+    const size_t j,
+    const size_t k )
+{
+    const size_t dx = 1;
+    const size_t dy = r.x();
+    const size_t dz = r.x() * r.y();
+    const size_t index = i * dx + j * dy + k * dz;
+    const size_t i0 = i > 0 ? index - dx : index;
+    const size_t i1 = i + 1 < r.x() ? index + dx : index;
+    const size_t j0 = j > 0 ? index - dy : index;
+    const size_t j1 = j + 1 < r.y() ? index + dy : index;
+    const size_t k0 = k > 0 ? index - dz : index;
+    const size_t k1 = k + 1 < r.z() ? index + dz : index;
+    return kvs::Vec3(
+        static_cast<float>( static_cast<kvs::Real64>( src[i0] ) - static_cast<kvs::Real64>( src[i1] ) ),
+        static_cast<float>( static_cast<kvs::Real64>( src[j0] ) - static_cast<kvs::Real64>( src[j1] ) ),
+        static_cast<float>( static_cast<kvs::Real64>( src[k0] ) - static_cast<kvs::Real64>( src[k1] ) ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the gradient array packed in the RGB10_A2 format.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  scale [out] max. magnitude of the gradient
+ *  @return packed gradient array (R: bits 0-9, G: bits 10-19, B: bits 20-29)
+ *
+ *  The gradient is divided by the max. magnitude and mapped from [-1,1] to
+ *  [0,1], so that the magnitude can be restored with the scale in the shader.
+ *  The slices are processed in parallel, in two passes for the max. magnitude
+ *  and the packing, instead of keeping the float gradients in memory.
+ */
+/*===========================================================================*/
+template <typename T>
+kvs::ValueArray<kvs::UInt32> PackedGradient(
+    const kvs::StructuredVolumeObject* volume,
+    kvs::Real32* scale )
+{
+    const T* src = static_cast<const T*>( volume->values().data() );
+    const kvs::Vec3u r = volume->resolution();
+    const long nslices = static_cast<long>( r.z() );
+
+    // Max. magnitude for each slice.
+    kvs::ValueArray<kvs::Real32> max_length( nslices );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long k = 0; k < nslices; k++ )
+    {
+        float max_length2 = 0.0f;
+        for ( size_t j = 0; j < r.y(); j++ )
+        {
+            for ( size_t i = 0; i < r.x(); i++ )
+            {
+                const kvs::Vec3 g = ::CentralDifference<T>( src, r, i, j, k );
+                max_length2 = kvs::Math::Max( max_length2, static_cast<float>( g.squaredLength() ) );
+            }
+        }
+        max_length[k] = std::sqrt( max_length2 );
+    }
+
+    float length = 0.0f;
+    for ( long k = 0; k < nslices; k++ ) { length = kvs::Math::Max( length, max_length[k] ); }
+    *scale = length > 0.0f ? length : 1.0f;
+
+    const float max_level = 1023.0f;
+    const float s = 0.5f * max_level / *scale;
+    const float t = 0.5f * max_level + 0.5f;
+    const size_t slice_size = r.x() * r.y();
+    kvs::ValueArray<kvs::UInt32> data( slice_size * r.z() );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long k = 0; k < nslices; k++ )
+    {
+        kvs::UInt32* dst = data.data() + k * slice_size;
+        for ( size_t j = 0; j < r.y(); j++ )
+        {
+            for ( size_t i = 0; i < r.x(); i++ )
+            {
+                const kvs::Vec3 g = ::CentralDifference<T>( src, r, i, j, k );
+                const kvs::UInt32 x = static_cast<kvs::UInt32>( kvs::Math::Clamp( g.x() * s + t, 0.0f, max_level ) );
+                const kvs::UInt32 y = static_cast<kvs::UInt32>( kvs::Math::Clamp( g.y() * s + t, 0.0f, max_level ) );
+                const kvs::UInt32 z = static_cast<kvs::UInt32>( kvs::Math::Clamp( g.z() * s + t, 0.0f, max_level ) );
+                *(dst++) = x | ( y << 10 ) | ( z << 20 ) | ( 3u << 30 );
+            }
+        }
+    }
+
+    return data;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Number of the voxels per block edge for the adaptive sampling.
+ */
+/*===========================================================================*/
+const size_t BlockSize = 8;
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the min. and max. values in each block.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  nblocks [in] number of the blocks
+ *  @return min. and max. values for each block
+ *
+ *  The block (bx,by,bz) covers the sampling points in [b*BlockSize,
+ *  (b+1)*BlockSize) in the voxel coordinate. The range includes one voxel
+ *  around the block, since the trilinear and cubic B-spline reconstructions
+ *  at the sampling points refer to the voxels in [b*BlockSize-1,
+ *  (b+1)*BlockSize+1].
+ */
+/*===========================================================================*/
+template <typename T>
+kvs::ValueArray<kvs::Real32> BlockRanges(
+    const kvs::StructuredVolumeObject* volume,
+    const kvs::Vec3u& nblocks )
+{
+    const T* src = static_cast<const T*>( volume->values().data() );
+    const kvs::Vec3u r = volume->resolution();
+    const size_t nx = r.x();
+    const size_t ny = r.y();
+    const size_t nz = r.z();
+    const size_t line_size = nx;
+    const size_t slice_size = nx * ny;
+    const long nslabs = static_cast<long>( nblocks.z() );
+
+    kvs::ValueArray<kvs::Real32> ranges( nblocks.x() * nblocks.y() * nblocks.z() * 2 );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long bz = 0; bz < nslabs; bz++ )
+    {
+        const size_t k0 = bz * BlockSize > 0 ? bz * BlockSize - 1 : 0;
+        const size_t k1 = kvs::Math::Min( ( bz + 1 ) * BlockSize + 1, nz - 1 );
+        for ( size_t by = 0; by < nblocks.y(); by++ )
+        {
+            const size_t j0 = by * BlockSize > 0 ? by * BlockSize - 1 : 0;
+            const size_t j1 = kvs::Math::Min( ( by + 1 ) * BlockSize + 1, ny - 1 );
+            for ( size_t bx = 0; bx < nblocks.x(); bx++ )
+            {
+                const size_t i0 = bx * BlockSize > 0 ? bx * BlockSize - 1 : 0;
+                const size_t i1 = kvs::Math::Min( ( bx + 1 ) * BlockSize + 1, nx - 1 );
+
+                T min_value = src[ i0 + j0 * line_size + k0 * slice_size ];
+                T max_value = min_value;
+                for ( size_t k = k0; k <= k1; k++ )
+                {
+                    for ( size_t j = j0; j <= j1; j++ )
+                    {
+                        const T* p = src + j * line_size + k * slice_size;
+                        for ( size_t i = i0; i <= i1; i++ )
+                        {
+                            min_value = kvs::Math::Min( min_value, p[i] );
+                            max_value = kvs::Math::Max( max_value, p[i] );
+                        }
+                    }
+                }
+
+                const size_t index = bx + by * nblocks.x() + bz * nblocks.x() * nblocks.y();
+                ranges[ 2 * index + 0 ] = static_cast<kvs::Real32>( min_value );
+                ranges[ 2 * index + 1 ] = static_cast<kvs::Real32>( max_value );
+            }
+        }
+    }
+
+    return ranges;
+}
+
 } // end of namespace
 
 
@@ -84,9 +292,19 @@ namespace glsl
  *  @param  tfunc [in] transfer function
  */
 /*===========================================================================*/
-void RayCastingRenderer::BufferObject::create(
-    const kvs::StructuredVolumeObject* volume,
-    const kvs::TransferFunction& tfunc )
+/**
+ *  @brief  Create a volume buffer object on GPU.
+ *  @param  volume [in] pointer to the volume object
+ *
+ *  The values are stored in the texture in their native precision, and the
+ *  range mapping to the transfer function is applied in the shader with the
+ *  uniform variables, so that the texture does not depend on the transfer
+ *  function. The 32-bit integer and floating-point values are stored as 32-bit
+ *  float values, or 16-bit unsigned normalized values over the min/max range
+ *  of the volume if the quantization is enabled.
+ */
+/*===========================================================================*/
+void RayCastingRenderer::BufferObject::create( const kvs::StructuredVolumeObject* volume )
 {
     const size_t width = volume->resolution().x();
     const size_t height = volume->resolution().y();
@@ -96,81 +314,79 @@ void RayCastingRenderer::BufferObject::create(
     GLenum data_type = 0;
     kvs::AnyValueArray data_value;
     const std::type_info& type = volume->values().typeInfo()->type();
+    const bool is_wide_type =
+        type == typeid( kvs::UInt32 ) ||
+        type == typeid( kvs::Int32 ) ||
+        type == typeid( kvs::Real32 ) ||
+        type == typeid( kvs::Real64 );
     if ( type == typeid( kvs::UInt8 ) )
     {
         data_format = GL_ALPHA8;
         data_type = GL_UNSIGNED_BYTE;
         data_value = volume->values();
+        m_min_range = 0.0f;
+        m_max_range = 255.0f;
+        m_min_value = 0.0f;
+        m_max_value = 255.0f;
     }
     else if ( type == typeid( kvs::UInt16 ) )
     {
         data_format = GL_ALPHA16;
         data_type = GL_UNSIGNED_SHORT;
         data_value = volume->values();
+        m_min_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt16>::Min() );
+        m_max_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt16>::Max() );
+        m_min_value = static_cast<kvs::Real32>( volume->minValue() );
+        m_max_value = static_cast<kvs::Real32>( volume->maxValue() );
     }
     else if ( type == typeid( kvs::Int8 ) )
     {
         data_format = GL_ALPHA8;
         data_type = GL_UNSIGNED_BYTE;
         data_value = ::SignedToUnsigned<kvs::UInt8,kvs::Int8>( volume );
+        m_min_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int8>::Min() );
+        m_max_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int8>::Max() );
+        m_min_value = -128.0f;
+        m_max_value = 127.0f;
     }
     else if ( type == typeid( kvs::Int16 ) )
     {
         data_format = GL_ALPHA16;
         data_type = GL_UNSIGNED_SHORT;
         data_value = ::SignedToUnsigned<kvs::UInt16,kvs::Int16>( volume );
+        m_min_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int16>::Min() );
+        m_max_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int16>::Max() );
+        m_min_value = static_cast<kvs::Real32>( volume->minValue() );
+        m_max_value = static_cast<kvs::Real32>( volume->maxValue() );
     }
-    else if ( type == typeid( kvs::UInt32 ) )
-    {
-        data_format = GL_ALPHA;
-        data_type = GL_FLOAT;
-        kvs::Real32 min_value = static_cast<kvs::Real32>( volume->minValue() );
-        kvs::Real32 max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        if ( tfunc.hasRange() )
-        {
-            min_value = tfunc.colorMap().minValue();
-            max_value = tfunc.colorMap().maxValue();
-        }
-        data_value = ::NormalizeValues<kvs::UInt32>( volume, min_value, max_value );
-    }
-    else if ( type == typeid( kvs::Int32 ) )
-    {
-        data_format = GL_ALPHA;
-        data_type = GL_FLOAT;
-        kvs::Real32 min_value = static_cast<kvs::Real32>( volume->minValue() );
-        kvs::Real32 max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        if ( tfunc.hasRange() )
-        {
-            min_value = tfunc.colorMap().minValue();
-            max_value = tfunc.colorMap().maxValue();
-        }
-        data_value = ::NormalizeValues<kvs::Int32>( volume, min_value, max_value );
-    }
-    else if ( type == typeid( kvs::Real32 ) )
+    else if ( is_wide_type && m_enable_quantization )
     {
-        data_format = GL_ALPHA;
-        data_type = GL_FLOAT;
-        kvs::Real32 min_value = static_cast<kvs::Real32>( volume->minValue() );
-        kvs::Real32 max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        if ( tfunc.hasRange() )
-        {
-            min_value = tfunc.colorMap().minValue();
-            max_value = tfunc.colorMap().maxValue();
-        }
-        data_value = ::NormalizeValues<kvs::Real32>( volume, min_value, max_value );
+        const kvs::Real64 min_value = volume->minValue();
+        const kvs::Real64 max_value = volume->maxValue();
+        data_format = GL_ALPHA16;
+        data_type = GL_UNSIGNED_SHORT;
+        if ( type == typeid( kvs::UInt32 ) ) { data_value = ::Quantize<kvs::UInt32>( volume, min_value, max_value ); }
+        else if ( type == typeid( kvs::Int32 ) ) { data_value = ::Quantize<kvs::Int32>( volume, min_value, max_value ); }
+        else if ( type == typeid( kvs::Real32 ) ) { data_value = ::Quantize<kvs::Real32>( volume, min_value, max_value ); }
+        else { data_value = ::Quantize<kvs::Real64>( volume, min_value, max_value ); }
+        m_min_range = static_cast<kvs::Real32>( min_value );
+        m_max_range = static_cast<kvs::Real32>( max_value );
+        m_min_value = static_cast<kvs::Real32>( min_value );
+        m_max_value = static_cast<kvs::Real32>( max_value );
     }
-    else if ( type == typeid( kvs::Real64 ) )
+    else if ( is_wide_type )
     {
-        data_format = GL_ALPHA;
+        // The values are read from the float texture as they are.
+        data_format = GL_ALPHA32F_ARB;
         data_type = GL_FLOAT;
-        kvs::Real32 min_value = static_cast<kvs::Real32>( volume->minValue() );
-        kvs::Real32 max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        if ( tfunc.hasRange() )
-        {
-            min_value = tfunc.colorMap().minValue();
-            max_value = tfunc.colorMap().maxValue();
-        }
-        data_value = ::NormalizeValues<kvs::Real64>( volume, min_value, max_value );
+        if ( type == typeid( kvs::UInt32 ) ) { data_value = ::ToReal32<kvs::UInt32>( volume ); }
+        else if ( type == typeid( kvs::Int32 ) ) { data_value = ::ToReal32<kvs::Int32>( volume ); }
+        else if ( type == typeid( kvs::Real32 ) ) { data_value = volume->values(); }
+        else { data_value = ::ToReal32<kvs::Real64>( volume ); }
+        m_min_range = 0.0f;
+        m_max_range = 1.0f;
+        m_min_value = static_cast<kvs::Real32>( volume->minValue() );
+        m_max_value = static_cast<kvs::Real32>( volume->maxValue() );
     }
     else
     {
@@ -185,6 +401,41 @@ void RayCastingRenderer::BufferObject::create(
     m_manager.setMagFilter( GL_LINEAR );
     m_manager.setMinFilter( GL_LINEAR );
     m_manager.create( width, height, depth, data_value.data() );
+
+    if ( m_enable_gradient ) { this->create_gradient_texture( volume ); }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the uniform variables for the volume range.
+ *  @param  shader [in] shader program
+ */
+/*===========================================================================*/
+void RayCastingRenderer::BufferObject::setupRange( kvs::ProgramObject& shader ) const
+{
+    kvs::ProgramObject::Binder bind( shader );
+    shader.setUniform( "volume.min_range", m_min_range );
+    shader.setUniform( "volume.max_range", m_max_range );
+    if ( m_enable_gradient ) { shader.setUniform( "gradient_scale", m_gradient_scale ); }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the uniform variables for the transfer function range.
+ *  @param  shader [in] shader program
+ *  @param  tfunc [in] transfer function
+ */
+/*===========================================================================*/
+void RayCastingRenderer::BufferObject::setupTransferFunctionRange(
+    kvs::ProgramObject& shader,
+    const kvs::TransferFunction& tfunc ) const
+{
+    const kvs::Real32 min_value = tfunc.hasRange() ? tfunc.colorMap().minValue() : m_min_value;
+    const kvs::Real32 max_value = tfunc.hasRange() ? tfunc.colorMap().maxValue() : m_max_value;
+
+    kvs::ProgramObject::Binder bind( shader );
+    shader.setUniform( "transfer_function.min_value", min_value );
+    shader.setUniform( "transfer_function.max_value", max_value );
 }
 
 /*===========================================================================*/
@@ -212,6 +463,47 @@ void RayCastingRenderer::BufferObject::draw()
     }
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Creates the precomputed gradient texture.
+ *  @param  volume [in] pointer to the volume object
+ *
+ *  The gradient is stored in the RGB10_A2 format (4 bytes per voxel), and
+ *  read with a single linear fetch instead of the six fetches of the central
+ *  difference in the shader.
+ */
+/*===========================================================================*/
+void RayCastingRenderer::BufferObject::create_gradient_texture( const kvs::StructuredVolumeObject* volume )
+{
+    kvs::ValueArray<kvs::UInt32> data;
+    const std::type_info& type = volume->values().typeInfo()->type();
+    if ( type == typeid( kvs::Int8 ) ) { data = ::PackedGradient<kvs::Int8>( volume, &m_gradient_scale ); }
+    else if ( type == typeid( kvs::UInt8 ) ) { data = ::PackedGradient<kvs::UInt8>( volume, &m_gradient_scale ); }
+    else if ( type == typeid( kvs::Int16 ) ) { data = ::PackedGradient<kvs::Int16>( volume, &m_gradient_scale ); }
+    else if ( type == typeid( kvs::UInt16 ) ) { data = ::PackedGradient<kvs::UInt16>( volume, &m_gradient_scale ); }
+    else if ( type == typeid( kvs::Int32 ) ) { data = ::PackedGradient<kvs::Int32>( volume, &m_gradient_scale ); }
+    else if ( type == typeid( kvs::UInt32 ) ) { data = ::PackedGradient<kvs::UInt32>( volume, &m_gradient_scale ); }
+    else if ( type == typeid( kvs::Real32 ) ) { data = ::PackedGradient<kvs::Real32>( volume, &m_gradient_scale ); }
+    else if ( type == typeid( kvs::Real64 ) ) { data = ::PackedGradient<kvs::Real64>( volume, &m_gradient_scale ); }
+    else
+    {
+        kvsMessageError( "Not supported data type '%s'.",
+                         volume->values().typeInfo()->typeName() );
+        return;
+    }
+
+    const size_t width = volume->resolution().x();
+    const size_t height = volume->resolution().y();
+    const size_t depth = volume->resolution().z();
+    m_gradient.setPixelFormat( GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV );
+    m_gradient.setWrapS( GL_CLAMP_TO_EDGE );
+    m_gradient.setWrapT( GL_CLAMP_TO_EDGE );
+    m_gradient.setWrapR( GL_CLAMP_TO_EDGE );
+    m_gradient.setMagFilter( GL_LINEAR );
+    m_gradient.setMinFilter( GL_LINEAR );
+    m_gradient.create( width, height, depth, data.data() );
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Create a bounding cube buffer object on GPU.
@@ -356,6 +648,10 @@ void RayCastingRenderer::RenderPass::create(
     frag.define("ENABLE_TEXTURE_RECTANGLE");
 #endif
     if ( m_enable_jittering ) { frag.define( "ENABLE_JITTERING" ); }
+    if ( m_enable_cubic_filter ) { frag.define( "ENABLE_CUBIC_BSPLINE_FILTER" ); }
+    if ( m_buffer_object.isGradientTextureEnabled() ) { frag.define( "ENABLE_GRADIENT_TEXTURE" ); }
+    if ( m_enable_adaptive_sampling ) { frag.define( "ENABLE_ADAPTIVE_SAMPLING" ); }
+    if ( m_enable_statistics ) { frag.define( "ENABLE_RAY_STATISTICS" ); }
 
     m_shader_program.build( vert, frag );
 }
@@ -382,6 +678,12 @@ void RayCastingRenderer::RenderPass::setup(
     shader.setUniform( "shading.S",  model.S );
     shader.setUniform( "sampling_step", m_step );
     shader.setUniform( "opaque", m_opaque );
+    if ( m_enable_adaptive_sampling )
+    {
+        shader.setUniform( "min_step_scale", m_min_step_scale );
+        shader.setUniform( "max_step_scale", m_max_step_scale );
+        shader.setUniform( "opacity_tolerance", m_opacity_tolerance );
+    }
 
     const kvs::Mat4 PM = kvs::OpenGL::ProjectionMatrix() * kvs::OpenGL::ModelViewMatrix();
     const kvs::Mat4 PM_inverse = PM.inverted();
@@ -544,6 +846,17 @@ void RayCastingRenderer::exec(
         this->update_buffer_object( volume );
     }
 
+    // The shader program and the framebuffer are rebuilt when the ray
+    // statistics are enabled or disabled after they were created.
+    if ( m_render_pass.isStatisticsEnabled() != m_statistics_framebuffer.isCreated() )
+    {
+        const size_t framebuffer_width = BaseClass::framebufferWidth();
+        const size_t framebuffer_height = BaseClass::framebufferHeight();
+        this->update_shader_program( BaseClass::shader(), BaseClass::isShadingEnabled() );
+        this->update_framebuffer( framebuffer_width, framebuffer_height );
+        this->update_buffer_object( volume );
+    }
+
     if ( !m_transfer_function_texture.isValid() )
     {
         const size_t width = BaseClass::transferFunction().resolution();
@@ -554,6 +867,11 @@ void RayCastingRenderer::exec(
         m_transfer_function_texture.setMinFilter( GL_LINEAR );
         m_transfer_function_texture.setPixelFormat( GL_RGBA32F_ARB, GL_RGBA, GL_FLOAT  );
         m_transfer_function_texture.create( width, table.data() );
+
+        // Only the range uniforms are updated for the new transfer function.
+        auto& shader = m_render_pass.shaderProgram();
+        m_volume_buffer.setupTransferFunctionRange( shader, BaseClass::transferFunction() );
+        if ( m_render_pass.isAdaptiveSamplingEnabled() ) { this->create_opacity_texture(); }
     }
 
     this->setup_shader_program( BaseClass::shader(), object, camera, light );
@@ -629,6 +947,8 @@ void RayCastingRenderer::create_shader_program(
     shader.setUniform( "jittering_texture", 4 );
     shader.setUniform( "depth_texture", 5 );
     shader.setUniform( "color_texture", 6 );
+    if ( m_volume_buffer.isGradientTextureEnabled() ) { shader.setUniform( "gradient_data", 7 ); }
+    if ( m_render_pass.isAdaptiveSamplingEnabled() ) { shader.setUniform( "opacity_volume", 8 ); }
 }
 
 /*===========================================================================*/
@@ -728,6 +1048,19 @@ void RayCastingRenderer::create_framebuffer( const size_t width, const size_t he
     m_entry_exit_framebuffer.attachColorTexture( m_exit_texture, 0 );
     m_entry_exit_framebuffer.attachColorTexture( m_entry_texture, 1 );
 
+    if ( m_render_pass.isStatisticsEnabled() )
+    {
+        m_statistics_texture.setWrapS( GL_CLAMP_TO_EDGE );
+        m_statistics_texture.setWrapT( GL_CLAMP_TO_EDGE );
+        m_statistics_texture.setMagFilter( GL_NEAREST );
+        m_statistics_texture.setMinFilter( GL_NEAREST );
+        m_statistics_texture.setPixelFormat( GL_RGBA32F_ARB, GL_RGBA, GL_FLOAT );
+        m_statistics_texture.create( width, height );
+
+        m_statistics_framebuffer.create();
+        m_statistics_framebuffer.attachColorTexture( m_statistics_texture, 0 );
+    }
+
     auto& shader = m_render_pass.shaderProgram();
     kvs::ProgramObject::Binder bind( shader );
     shader.setUniform( "width", static_cast<GLfloat>( width ) );
@@ -749,6 +1082,8 @@ void RayCastingRenderer::update_framebuffer( const size_t width, const size_t he
     m_entry_texture.release();
     m_exit_texture.release();
     m_entry_exit_framebuffer.release();
+    m_statistics_texture.release();
+    m_statistics_framebuffer.release();
     this->create_framebuffer( width, height );
 }
 
@@ -760,7 +1095,7 @@ void RayCastingRenderer::update_framebuffer( const size_t width, const size_t he
 /*===========================================================================*/
 void RayCastingRenderer::create_buffer_object( const kvs::StructuredVolumeObject* volume )
 {
-    m_volume_buffer.create( volume, BaseClass::transferFunction() );
+    m_volume_buffer.create( volume );
     m_bounding_cube_buffer.create( volume );
 
     // Set uniform variables.
@@ -768,76 +1103,25 @@ void RayCastingRenderer::create_buffer_object( const kvs::StructuredVolumeObject
     const kvs::Real32 max_ngrids = kvs::Math::Max( r.x(), r.y(), r.z() );
     const kvs::Vec3 ratio( r.x() / max_ngrids, r.y() / max_ngrids, r.z() / max_ngrids );
     const kvs::Vec3 reciprocal( 1.0f / r.x(), 1.0f / r.y(), 1.0f / r.z() );
-    kvs::Real32 min_range = 0.0f;
-    kvs::Real32 max_range = 0.0f;
-    kvs::Real32 min_value = BaseClass::transferFunction().colorMap().minValue();
-    kvs::Real32 max_value = BaseClass::transferFunction().colorMap().maxValue();
-    const std::type_info& type = volume->values().typeInfo()->type();
-    if ( type == typeid( kvs::UInt8 ) )
-    {
-        min_range = 0.0f;
-        max_range = 255.0f;
-        if ( !BaseClass::transferFunction().hasRange() )
-        {
-            min_value = 0.0f;
-            max_value = 255.0f;
-        }
-    }
-    else if ( type == typeid( kvs::Int8 ) )
-    {
-        min_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt8>::Min() );
-        max_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt8>::Max() );
-        if ( !BaseClass::transferFunction().hasRange() )
-        {
-            min_value = -128.0f;
-            max_value = 127.0f;
-        }
-    }
-    else if ( type == typeid( kvs::UInt16 ) )
-    {
-        min_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt16>::Min() );
-        max_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt16>::Max() );
-        if ( !BaseClass::transferFunction().hasRange() )
-        {
-            min_value = static_cast<kvs::Real32>( volume->minValue() );
-            max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        }
-    }
-    else if ( type == typeid( kvs::Int16 ) )
-    {
-        min_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int16>::Min() );
-        max_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int16>::Max() );
-        if ( !BaseClass::transferFunction().hasRange() )
-        {
-            min_value = static_cast<kvs::Real32>( volume->minValue() );
-            max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        }
-    }
-    else if ( type == typeid( kvs::UInt32 ) ||
-              type == typeid( kvs::Int32  ) ||
-              type == typeid( kvs::Real32 ) ||
-              type == typeid( kvs::Real64 ) )
-    {
-        min_range = 0.0f;
-        max_range = 1.0f;
-        min_value = 0.0f;
-        max_value = 1.0f;
-    }
-    else
-    {
-        kvsMessageError( "Not supported data type '%s'.",
-                         volume->values().typeInfo()->typeName() );
-    }
 
     auto& shader = m_render_pass.shaderProgram();
+    m_volume_buffer.setupRange( shader );
+    m_volume_buffer.setupTransferFunctionRange( shader, BaseClass::transferFunction() );
+
     kvs::ProgramObject::Binder bind( shader );
     shader.setUniform( "volume.resolution", r );
     shader.setUniform( "volume.resolution_ratio", ratio );
     shader.setUniform( "volume.resolution_reciprocal", reciprocal );
-    shader.setUniform( "volume.min_range", min_range );
-    shader.setUniform( "volume.max_range", max_range );
-    shader.setUniform( "transfer_function.min_value", min_value );
-    shader.setUniform( "transfer_function.max_value", max_value );
+
+    if ( m_render_pass.isAdaptiveSamplingEnabled() )
+    {
+        this->create_block_ranges( volume );
+        this->create_opacity_texture();
+
+        const kvs::Vec3 n = kvs::Vec3( m_nblocks ) * static_cast<float>( ::BlockSize );
+        shader.setUniform( "opacity_volume_scale", kvs::Vec3( 1.0f / n.x(), 1.0f / n.y(), 1.0f / n.z() ) );
+        shader.setUniform( "block_size", static_cast<float>( ::BlockSize ) );
+    }
 }
 
 /*===========================================================================*/
@@ -850,6 +1134,7 @@ void RayCastingRenderer::update_buffer_object( const kvs::StructuredVolumeObject
 {
     m_volume_buffer.release();
     m_bounding_cube_buffer.release();
+    m_opacity_texture.release();
     this->create_buffer_object( volume );
 }
 
@@ -885,8 +1170,151 @@ void RayCastingRenderer::draw_buffer_object( const kvs::StructuredVolumeObject*
         kvs::Texture::Binder unit5( m_jittering_texture, 4 );
         kvs::Texture::Binder unit6( m_depth_texture, 5 );
         kvs::Texture::Binder unit7( m_color_texture, 6 );
+
+        // The gradient texture and the opacity texture are created and
+        // declared in the shader only if the precomputed gradient and the
+        // adaptive sampling are enabled, respectively.
+        const bool enable_gradient = m_volume_buffer.isGradientTextureEnabled();
+        const bool enable_adaptive_sampling = m_render_pass.isAdaptiveSamplingEnabled();
+        if ( enable_gradient ) { kvs::Texture::Bind( m_volume_buffer.gradientTexture(), 7 ); }
+        if ( enable_adaptive_sampling ) { kvs::Texture::Bind( m_opacity_texture, 8 ); }
+        m_render_pass.draw( volume );
+        if ( enable_adaptive_sampling ) { kvs::Texture::Unbind( m_opacity_texture, 8 ); }
+        if ( enable_gradient ) { kvs::Texture::Unbind( m_volume_buffer.gradientTexture(), 7 ); }
+
+        if ( m_render_pass.isStatisticsEnabled() ) { this->count_ray_statistics( volume ); }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the min. and max. values in each block for adaptive sampling.
+ *  @param  volume [in] pointer to the volume object
+ */
+/*===========================================================================*/
+void RayCastingRenderer::create_block_ranges( const kvs::StructuredVolumeObject* volume )
+{
+    const kvs::Vec3u ncells = volume->resolution() - kvs::Vec3u::Constant(1);
+    m_nblocks = kvs::Vec3u(
+        kvs::Math::Max( ( ncells.x() + ::BlockSize - 1 ) / ::BlockSize, size_t(1) ),
+        kvs::Math::Max( ( ncells.y() + ::BlockSize - 1 ) / ::BlockSize, size_t(1) ),
+        kvs::Math::Max( ( ncells.z() + ::BlockSize - 1 ) / ::BlockSize, size_t(1) ) );
+
+    const std::type_info& type = volume->values().typeInfo()->type();
+    if ( type == typeid( kvs::Int8 ) ) { m_block_ranges = ::BlockRanges<kvs::Int8>( volume, m_nblocks ); }
+    else if ( type == typeid( kvs::UInt8 ) ) { m_block_ranges = ::BlockRanges<kvs::UInt8>( volume, m_nblocks ); }
+    else if ( type == typeid( kvs::Int16 ) ) { m_block_ranges = ::BlockRanges<kvs::Int16>( volume, m_nblocks ); }
+    else if ( type == typeid( kvs::UInt16 ) ) { m_block_ranges = ::BlockRanges<kvs::UInt16>( volume, m_nblocks ); }
+    else if ( type == typeid( kvs::Int32 ) ) { m_block_ranges = ::BlockRanges<kvs::Int32>( volume, m_nblocks ); }
+    else if ( type == typeid( kvs::UInt32 ) ) { m_block_ranges = ::BlockRanges<kvs::UInt32>( volume, m_nblocks ); }
+    else if ( type == typeid( kvs::Real32 ) ) { m_block_ranges = ::BlockRanges<kvs::Real32>( volume, m_nblocks ); }
+    else if ( type == typeid( kvs::Real64 ) ) { m_block_ranges = ::BlockRanges<kvs::Real64>( volume, m_nblocks ); }
+    else
+    {
+        kvsMessageError( "Not supported data type '%s'.",
+                         volume->values().typeInfo()->typeName() );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the max. opacity texture for adaptive sampling.
+ *
+ *  The max. opacity of the transfer function over the value range of each
+ *  block is stored, so that the texture is rebuilt without the volume data
+ *  when the transfer function is changed.
+ */
+/*===========================================================================*/
+void RayCastingRenderer::create_opacity_texture()
+{
+    const size_t nblocks = m_nblocks.x() * m_nblocks.y() * m_nblocks.z();
+    if ( m_block_ranges.size() != nblocks * 2 ) { return; }
+
+    const kvs::TransferFunction& tfunc = BaseClass::transferFunction();
+    const kvs::Real32 min_value = tfunc.hasRange() ? tfunc.colorMap().minValue() : m_volume_buffer.minValue();
+    const kvs::Real32 max_value = tfunc.hasRange() ? tfunc.colorMap().maxValue() : m_volume_buffer.maxValue();
+    const kvs::ValueArray<kvs::Real32> table = tfunc.table();
+    const long resolution = static_cast<long>( tfunc.resolution() );
+    const float scale = max_value > min_value ? resolution / ( max_value - min_value ) : 0.0f;
+
+    // The table is read with the linear interpolation, where the texel i is
+    // located at i + 0.5, so the texels adjacent to the range are included.
+    kvs::ValueArray<kvs::Real32> data( nblocks );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long index = 0; index < static_cast<long>( nblocks ); index++ )
+    {
+        const float lower = ( m_block_ranges[ 2 * index + 0 ] - min_value ) * scale - 0.5f;
+        const float upper = ( m_block_ranges[ 2 * index + 1 ] - min_value ) * scale - 0.5f;
+        const long i0 = kvs::Math::Clamp( static_cast<long>( std::floor( lower ) ), 0L, resolution - 1 );
+        const long i1 = kvs::Math::Clamp( static_cast<long>( std::ceil( upper ) ), 0L, resolution - 1 );
+
+        float max_opacity = 0.0f;
+        for ( long i = i0; i <= i1; i++ )
+        {
+            max_opacity = kvs::Math::Max( max_opacity, table[ 4 * i + 3 ] );
+        }
+        data[ index ] = max_opacity;
+    }
+
+    m_opacity_texture.release();
+    m_opacity_texture.setPixelFormat( GL_ALPHA32F_ARB, GL_ALPHA, GL_FLOAT );
+    m_opacity_texture.setWrapS( GL_CLAMP_TO_EDGE );
+    m_opacity_texture.setWrapT( GL_CLAMP_TO_EDGE );
+    m_opacity_texture.setWrapR( GL_CLAMP_TO_EDGE );
+    m_opacity_texture.setMagFilter( GL_NEAREST );
+    m_opacity_texture.setMinFilter( GL_NEAREST );
+    m_opacity_texture.create( m_nblocks.x(), m_nblocks.y(), m_nblocks.z(), data.data() );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Counts the samples and the early terminated rays.
+ *  @param  volume [in] pointer to the volume object
+ *
+ *  The rays are cast again into the statistics framebuffer, where the number
+ *  of the samples and the flags for the termination are written for each
+ *  pixel instead of the color, and the framebuffer is read back and reduced.
+ *  The textures are expected to be bound by draw_buffer_object.
+ */
+/*===========================================================================*/
+void RayCastingRenderer::count_ray_statistics( const kvs::StructuredVolumeObject* volume )
+{
+    const size_t width = m_statistics_texture.width();
+    const size_t height = m_statistics_texture.height();
+    kvs::ValueArray<kvs::Real32> pixels( width * height * 4 );
+    {
+        kvs::FrameBufferObject::GuardedBinder binder( m_statistics_framebuffer );
+        kvs::OpenGL::SetDrawBuffer( GL_COLOR_ATTACHMENT0_EXT );
+        kvs::OpenGL::SetClearColor( kvs::Vec4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+        kvs::OpenGL::Clear( GL_COLOR_BUFFER_BIT );
+        kvs::OpenGL::Disable( GL_BLEND );
+
+        auto& shader = m_render_pass.shaderProgram();
+        {
+            kvs::ProgramObject::Binder bind( shader );
+            shader.setUniform( "statistics_pass", 1 );
+        }
         m_render_pass.draw( volume );
+        {
+            kvs::ProgramObject::Binder bind( shader );
+            shader.setUniform( "statistics_pass", 0 );
+        }
+
+        kvs::OpenGL::SetReadBuffer( GL_COLOR_ATTACHMENT0_EXT );
+        kvs::OpenGL::ReadPixels( 0, 0, width, height, GL_RGBA, GL_FLOAT, pixels.data() );
+    }
+
+    RayStatistics statistics;
+    for ( size_t i = 0; i < width * height; i++ )
+    {
+        const kvs::Real32* p = pixels.data() + 4 * i;
+        if ( p[3] == 0.0f ) { continue; } // no ray
+        statistics.nrays++;
+        statistics.nsamples += static_cast<size_t>( p[0] );
+        if ( p[1] > 0.0f ) { statistics.nterminations++; }
+        if ( p[2] > 0.0f ) { statistics.nocclusions++; }
     }
+    m_ray_statistics = statistics;
 }
 
 } // end of namespace glsl
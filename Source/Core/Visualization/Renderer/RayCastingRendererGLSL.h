@@ -18,6 +18,7 @@
 #include <kvs/StructuredVolumeObject>
 #include <kvs/ProgramObject>
 #include <kvs/ShaderSource>
+#include <kvs/ValueArray>
 
 
 namespace kvs
@@ -44,18 +45,49 @@ public:
         Volume
     };
 
+    struct RayStatistics
+    {
+        size_t nrays = 0; ///< number of the rays through the volume
+        size_t nsamples = 0; ///< total number of the samples along the rays
+        size_t nterminations = 0; ///< number of the rays terminated by the opaque value
+        size_t nocclusions = 0; ///< number of the rays occluded by the geometries
+        float samplesPerRay() const { return nrays > 0 ? float( nsamples ) / nrays : 0.0f; }
+        float earlyTerminationRatio() const { return nrays > 0 ? float( nterminations ) / nrays : 0.0f; }
+    };
+
     class BufferObject
     {
     private:
         kvs::Texture3D m_manager{};
+        bool m_enable_quantization = false; ///< flag for quantizing 32/64-bit values to 16 bits
+        kvs::Real32 m_min_range = 0.0f; ///< value mapped to 0 of the texture
+        kvs::Real32 m_max_range = 1.0f; ///< value mapped to 1 of the texture
+        kvs::Real32 m_min_value = 0.0f; ///< min. value for the transfer function without range
+        kvs::Real32 m_max_value = 1.0f; ///< max. value for the transfer function without range
+        kvs::Texture3D m_gradient{}; ///< precomputed gradient texture
+        bool m_enable_gradient = false; ///< flag for precomputing the gradient texture
+        kvs::Real32 m_gradient_scale = 1.0f; ///< max. magnitude of the gradient
     public:
         BufferObject() = default;
         virtual ~BufferObject() { this->release(); }
         kvs::Texture3D& manager() { return m_manager; }
-        void release() { m_manager.release(); }
-        void create( const kvs::StructuredVolumeObject* volume,
-                     const kvs::TransferFunction& tfunc );
+        kvs::Texture3D& gradientTexture() { return m_gradient; }
+        bool isQuantizationEnabled() const { return m_enable_quantization; }
+        bool isGradientTextureEnabled() const { return m_enable_gradient; }
+        kvs::Real32 gradientScale() const { return m_gradient_scale; }
+        kvs::Real32 minRange() const { return m_min_range; }
+        kvs::Real32 maxRange() const { return m_max_range; }
+        kvs::Real32 minValue() const { return m_min_value; }
+        kvs::Real32 maxValue() const { return m_max_value; }
+        void setQuantizationEnabled( const bool enable = true ) { m_enable_quantization = enable; }
+        void setGradientTextureEnabled( const bool enable = true ) { m_enable_gradient = enable; }
+        void release() { m_manager.release(); m_gradient.release(); }
+        void create( const kvs::StructuredVolumeObject* volume );
+        void setupRange( kvs::ProgramObject& shader ) const;
+        void setupTransferFunctionRange( kvs::ProgramObject& shader, const kvs::TransferFunction& tfunc ) const;
         void draw();
+    private:
+        void create_gradient_texture( const kvs::StructuredVolumeObject* volume );
     };
 
     class BoundingBufferObject
@@ -79,6 +111,12 @@ public:
         std::string m_frag_shader_file = "RC_ray_caster.frag"; ///< fragment shader file
         kvs::ProgramObject m_shader_program{}; ///< shader program
         bool m_enable_jittering = false; ///< frag for stochastic jittering
+        bool m_enable_cubic_filter = false; ///< flag for cubic B-spline reconstruction
+        bool m_enable_adaptive_sampling = false; ///< flag for adaptive sampling
+        bool m_enable_statistics = false; ///< flag for counting the samples per ray
+        float m_min_step_scale = 0.5f; ///< min. ratio of the step to the sampling step
+        float m_max_step_scale = 4.0f; ///< max. ratio of the step to the sampling step
+        float m_opacity_tolerance = 0.1f; ///< max. opacity accumulated in a step
         float m_step = 0.5f; ///< sampling step
         float m_opaque = 1.0f; ///< opaque value for early ray termination
     public:
@@ -89,12 +127,23 @@ public:
         const std::string& fragmentShaderFile() const { return m_frag_shader_file; }
         kvs::ProgramObject& shaderProgram() { return m_shader_program; }
         bool isJitteringEnabled() const { return m_enable_jittering; }
+        bool isCubicFilterEnabled() const { return m_enable_cubic_filter; }
+        bool isAdaptiveSamplingEnabled() const { return m_enable_adaptive_sampling; }
+        bool isStatisticsEnabled() const { return m_enable_statistics; }
+        float minStepScale() const { return m_min_step_scale; }
+        float maxStepScale() const { return m_max_step_scale; }
+        float opacityTolerance() const { return m_opacity_tolerance; }
         float step() const { return m_step; }
         float opaque() const { return m_opaque; }
         void setVertexShaderFile( const std::string& file ) { m_vert_shader_file = file; }
         void setFragmentShaderFile( const std::string& file ) { m_frag_shader_file = file; }
         void setShaderFiles( const std::string& vert_file, const std::string& frag_file );
         void setJitteringEnabled( const bool enable = true ) { m_enable_jittering = enable; }
+        void setCubicFilterEnabled( const bool enable = true ) { m_enable_cubic_filter = enable; }
+        void setAdaptiveSamplingEnabled( const bool enable = true ) { m_enable_adaptive_sampling = enable; }
+        void setStatisticsEnabled( const bool enable = true ) { m_enable_statistics = enable; }
+        void setStepScaleRange( const float min_scale, const float max_scale ) { m_min_step_scale = min_scale; m_max_step_scale = max_scale; }
+        void setOpacityTolerance( const float tolerance ) { m_opacity_tolerance = tolerance; }
         void setStep( const float step ) { m_step = step; }
         void setOpaque( const float opaque ) { m_opaque = opaque; }
         virtual void release() { m_shader_program.release(); }
@@ -130,6 +179,16 @@ private:
     // Textures
     kvs::Texture1D m_transfer_function_texture; ///< transfer function texture
     kvs::Texture2D m_jittering_texture; ///< texture for stochastic jittering
+    kvs::Texture3D m_opacity_texture; ///< max. opacity in each block for adaptive sampling
+
+    // Block ranges for adaptive sampling
+    kvs::Vec3u m_nblocks{ 0, 0, 0 }; ///< number of the blocks
+    kvs::ValueArray<kvs::Real32> m_block_ranges{}; ///< min. and max. values in each block
+
+    // Ray statistics
+    kvs::FrameBufferObject m_statistics_framebuffer; ///< framebuffer object for the ray statistics
+    kvs::Texture2D m_statistics_texture; ///< texture for the ray statistics
+    RayStatistics m_ray_statistics{}; ///< ray statistics in the last frame
 
     // Framebuffer
     kvs::Texture2D m_color_texture; ///< texture for color buffer
@@ -161,7 +220,20 @@ public:
     void setSamplingStep( const float step ) { m_render_pass.setStep( step ); }
     void setOpaqueValue( const float opaque ) { m_render_pass.setOpaque( opaque ); }
     void enableJittering() { m_render_pass.setJitteringEnabled( true ); }
+    void enableQuantization() { m_volume_buffer.setQuantizationEnabled( true ); }
+    void disableQuantization() { m_volume_buffer.setQuantizationEnabled( false ); }
     void disableJittering() { m_render_pass.setJitteringEnabled( false ); }
+    void enableGradientTexture() { m_volume_buffer.setGradientTextureEnabled( true ); }
+    void disableGradientTexture() { m_volume_buffer.setGradientTextureEnabled( false ); }
+    void enableCubicFilter() { m_render_pass.setCubicFilterEnabled( true ); }
+    void disableCubicFilter() { m_render_pass.setCubicFilterEnabled( false ); }
+    void enableAdaptiveSampling() { m_render_pass.setAdaptiveSamplingEnabled( true ); }
+    void disableAdaptiveSampling() { m_render_pass.setAdaptiveSamplingEnabled( false ); }
+    void setStepScaleRange( const float min_scale, const float max_scale ) { m_render_pass.setStepScaleRange( min_scale, max_scale ); }
+    void setOpacityTolerance( const float tolerance ) { m_render_pass.setOpacityTolerance( tolerance ); }
+    void enableRayStatistics() { m_render_pass.setStatisticsEnabled( true ); }
+    void disableRayStatistics() { m_render_pass.setStatisticsEnabled( false ); }
+    const RayStatistics& rayStatistics() const { return m_ray_statistics; }
 
     const std::string& vertexShaderFile() const { return m_render_pass.vertexShaderFile(); }
     const std::string& fragmentShaderFile() const { return m_render_pass.fragmentShaderFile(); }
@@ -183,6 +255,10 @@ private:
     void create_buffer_object( const kvs::StructuredVolumeObject* volume );
     void update_buffer_object( const kvs::StructuredVolumeObject* volume );
     void draw_buffer_object( const kvs::StructuredVolumeObject* volume );
+
+    void create_block_ranges( const kvs::StructuredVolumeObject* volume );
+    void create_opacity_texture();
+    void count_ray_statistics( const kvs::StructuredVolumeObject* volume );
 };
 
 } // end of namespace glsl
@@ -41,6 +41,11 @@ void ScatterPlotMatrixRenderer::exec( kvs::ObjectBase* object, kvs::Camera* came
         const float Lx = float( content.width() - m_padding * ( M - 1 ) ) / M; // length for each x axis
         const float Ly = float( content.height() - m_padding * ( M - 1 ) ) / M; // length for each y axis
 
+        // The column buffers are shared by all the panels, and the points in
+        // each panel are drawn by a single draw call if available.
+        const bool instancing = kvs::TableBuffer::IsSupported();
+        if ( instancing ) { BaseClass::updateBuffers( table ); }
+
         for ( size_t j = 0; j < M; ++j )
         {
             for ( size_t i = 0; i < M; ++i )
@@ -59,9 +64,15 @@ void ScatterPlotMatrixRenderer::exec( kvs::ObjectBase* object, kvs::Camera* came
                 engine->beginFrame( screen()->width(), screen()->height(), dpr );
                 {
                     BaseClass::drawPolyline( rect, table, x_index, y_index );
-                    BaseClass::drawPoint( rect, table, x_index, y_index, false );
+                    if ( !instancing ) { BaseClass::drawPoint( rect, table, x_index, y_index, false ); }
                 }
                 engine->endFrame();
+
+                if ( instancing )
+                {
+                    if ( BaseClass::isHistogramModeEnabled() ) { BaseClass::drawHistogram( rect, dpr, x_index, y_index ); }
+                    else { BaseClass::drawInstancedPoint( rect, dpr, x_index, y_index, false ); }
+                }
             }
         }
     }
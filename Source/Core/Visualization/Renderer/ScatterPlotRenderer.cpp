@@ -12,6 +12,150 @@
 #include <kvs/RGBAColor>
 #include <kvs/TableObject>
 #include <kvs/IgnoreUnusedVariable>
+#include <kvs/ShaderSource>
+#include <kvs/Math>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Shaders for the points.
+ *
+ *  Each point is drawn as an instance of the quad, and the circle with the
+ *  edge is cut out in the fragment shader. The normalized values of the row
+ *  are given as the instanced vertex attributes, and the rows out of the range
+ *  are clipped away by referring to the packed inside-range flags.
+ */
+/*===========================================================================*/
+const std::string PointVertexShader =
+    "#version 120\n"
+    "#extension GL_EXT_gpu_shader4 : enable\n" +
+    kvs::TableBuffer::InsideRangeFunction() +
+    "attribute float x_value;\n"
+    "attribute float y_value;\n"
+    "attribute float color_value;\n"
+    "uniform sampler2D flag_texture;\n"
+    "uniform sampler1D color_map_texture;\n"
+    "uniform int flag_texture_width;\n"
+    "uniform float color_map_resolution;\n"
+    "uniform bool color_map_enabled;\n"
+    "uniform vec4 point_color;\n"
+    "uniform vec4 rect;\n"
+    "uniform float extent;\n"
+    "varying vec2 offset;\n"
+    "varying vec4 fill_color;\n"
+    "void main()\n"
+    "{\n"
+    "    if ( !InsideRange( flag_texture, flag_texture_width, gl_InstanceID ) )\n"
+    "    {\n"
+    "        gl_Position = vec4( 2.0, 2.0, 2.0, 1.0 );\n"
+    "        return;\n"
+    "    }\n"
+    "    vec2 corner = vec2( float( gl_VertexID % 2 ), float( gl_VertexID / 2 ) ) * 2.0 - 1.0;\n"
+    "    vec2 center = vec2( mix( rect.x, rect.z, x_value ), mix( rect.w, rect.y, y_value ) );\n"
+    "    offset = corner * extent;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4( center + offset, 0.0, 1.0 );\n"
+    "    fill_color = point_color;\n"
+    "    if ( color_map_enabled )\n"
+    "    {\n"
+    "        float s = ( color_value * ( color_map_resolution - 1.0 ) + 0.5 ) / color_map_resolution;\n"
+    "        fill_color.rgb = texture1D( color_map_texture, s ).rgb;\n"
+    "    }\n"
+    "}\n";
+
+const std::string PointFragmentShader(
+    "#version 120\n"
+    "varying vec2 offset;\n"
+    "varying vec4 fill_color;\n"
+    "uniform float radius;\n"
+    "uniform float edge_width;\n"
+    "uniform vec4 edge_color;\n"
+    "void main()\n"
+    "{\n"
+    "    float d = length( offset );\n"
+    "    float fill_alpha = fill_color.a * clamp( radius - d + 0.5, 0.0, 1.0 );\n"
+    "    float edge_alpha = edge_width > 0.0 ? edge_color.a * clamp( edge_width * 0.5 - abs( d - radius ) + 0.5, 0.0, 1.0 ) : 0.0;\n"
+    "    float alpha = edge_alpha + fill_alpha * ( 1.0 - edge_alpha );\n"
+    "    if ( alpha <= 0.0 ) { discard; }\n"
+    "    vec3 color = edge_color.rgb * edge_alpha + fill_color.rgb * fill_alpha * ( 1.0 - edge_alpha );\n"
+    "    gl_FragColor = vec4( color / alpha, alpha );\n"
+    "}\n"
+    );
+
+/*===========================================================================*/
+/**
+ *  @brief  Shaders for the binning of the points.
+ *
+ *  Each point is drawn to the pixel of the bin in the framebuffer whose size
+ *  is equal to the number of bins, and counted up by the additive blending.
+ */
+/*===========================================================================*/
+const std::string BinningVertexShader =
+    "#version 120\n"
+    "#extension GL_EXT_gpu_shader4 : enable\n" +
+    kvs::TableBuffer::InsideRangeFunction() +
+    "attribute float x_value;\n"
+    "attribute float y_value;\n"
+    "uniform sampler2D flag_texture;\n"
+    "uniform int flag_texture_width;\n"
+    "uniform float nbins;\n"
+    "void main()\n"
+    "{\n"
+    "    if ( !InsideRange( flag_texture, flag_texture_width, gl_InstanceID ) )\n"
+    "    {\n"
+    "        gl_Position = vec4( 2.0, 2.0, 2.0, 1.0 );\n"
+    "        return;\n"
+    "    }\n"
+    "    vec2 bin = min( floor( vec2( x_value, y_value ) * nbins ), vec2( nbins - 1.0 ) );\n"
+    "    gl_Position = vec4( ( bin + 0.5 ) / nbins * 2.0 - 1.0, 0.0, 1.0 );\n"
+    "}\n";
+
+const std::string BinningFragmentShader(
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = vec4( 1.0 );\n"
+    "}\n"
+    );
+
+/*===========================================================================*/
+/**
+ *  @brief  Shaders for the 2D histogram.
+ *
+ *  The count of each bin is mapped to the color map in the log scale.
+ */
+/*===========================================================================*/
+const std::string HistogramVertexShader(
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+    "}\n"
+    );
+
+const std::string HistogramFragmentShader(
+    "#version 120\n"
+    "#extension GL_EXT_gpu_shader4 : enable\n"
+    "uniform sampler2D histogram_texture;\n"
+    "uniform sampler1D color_map_texture;\n"
+    "uniform sampler2D max_count_texture;\n"
+    "uniform float color_map_resolution;\n"
+    "uniform float opacity;\n"
+    "void main()\n"
+    "{\n"
+    "    float count = texture2D( histogram_texture, gl_TexCoord[0].xy ).r;\n"
+    "    if ( count <= 0.0 ) { discard; }\n"
+    "    float max_count = texelFetch2D( max_count_texture, ivec2( 0, 0 ), 0 ).r;\n"
+    "    float t = log( 1.0 + count ) / log( 1.0 + max_count );\n"
+    "    float s = ( t * ( color_map_resolution - 1.0 ) + 0.5 ) / color_map_resolution;\n"
+    "    gl_FragColor = vec4( texture1D( color_map_texture, s ).rgb, opacity );\n"
+    "}\n"
+    );
+
+} // end of namespace
 
 
 namespace kvs
@@ -45,13 +189,23 @@ void ScatterPlotRenderer::exec( kvs::ObjectBase* object, kvs::Camera* camera, kv
         // Draw background.
         this->drawBackground( rect, dpr );
 
+        // The points are drawn by the instanced rendering if available.
+        const bool instancing = kvs::TableBuffer::IsSupported();
+        if ( instancing ) { this->updateBuffers( table ); }
+
         kvs::NanoVG* engine = m_painter.device()->renderEngine();
         engine->beginFrame( screen()->width(), screen()->height(), dpr );
         {
             this->drawPolyline( rect, table, 0, 1 );
-            this->drawPoint( rect, table, 0, 1, has_values );
+            if ( !instancing ) { this->drawPoint( rect, table, 0, 1, has_values ); }
         }
         engine->endFrame();
+
+        if ( instancing )
+        {
+            if ( m_enable_histogram_mode ) { this->drawHistogram( rect, dpr, 0, 1 ); }
+            else { this->drawInstancedPoint( rect, dpr, 0, 1, has_values ); }
+        }
     }
     m_painter.end();
 
@@ -211,4 +365,230 @@ void ScatterPlotRenderer::drawPoint(
     }
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Updates the buffers and the shaders for the instanced rendering.
+ *  @param  table [in] pointer to the table object
+ */
+/*===========================================================================*/
+void ScatterPlotRenderer::updateBuffers( const kvs::TableObject* table )
+{
+    if ( !m_point_shader.isCreated() )
+    {
+        const kvs::ShaderSource point_vert( ::PointVertexShader );
+        const kvs::ShaderSource point_frag( ::PointFragmentShader );
+        m_point_shader.build( point_vert, point_frag );
+
+        const kvs::ShaderSource binning_vert( ::BinningVertexShader );
+        const kvs::ShaderSource binning_frag( ::BinningFragmentShader );
+        m_binning_shader.build( binning_vert, binning_frag );
+
+        const kvs::ShaderSource histogram_vert( ::HistogramVertexShader );
+        const kvs::ShaderSource histogram_frag( ::HistogramFragmentShader );
+        m_histogram_shader.build( histogram_vert, histogram_frag );
+    }
+
+    m_table_buffer.update( table );
+
+    const size_t resolution = m_color_map.resolution();
+    if ( m_color_map_texture.width() != resolution )
+    {
+        m_color_map_texture.release();
+        m_color_map_texture.setWrapS( GL_CLAMP_TO_EDGE );
+        m_color_map_texture.setMagFilter( GL_LINEAR );
+        m_color_map_texture.setMinFilter( GL_LINEAR );
+        m_color_map_texture.setPixelFormat( GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE );
+        m_color_map_texture.create( resolution, m_color_map.table().data() );
+    }
+    else
+    {
+        kvs::Texture::GuardedBinder binder( m_color_map_texture );
+        m_color_map_texture.load( resolution, m_color_map.table().data() );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws the points with the instanced rendering.
+ *  @param  rect [in] plot region
+ *  @param  dpr [in] device pixel ratio
+ *  @param  x_index [in] column index for the x axis
+ *  @param  y_index [in] column index for the y axis
+ *  @param  has_values [in] if true, the points are colored by the third column
+ *
+ *  All the rows are drawn by a single draw call, in which the columns for the
+ *  axes are selected by the offsets in the column buffer.
+ */
+/*===========================================================================*/
+void ScatterPlotRenderer::drawInstancedPoint(
+    const kvs::Rectangle& rect,
+    const float dpr,
+    const size_t x_index,
+    const size_t y_index,
+    const bool has_values )
+{
+    const size_t nrows = m_table_buffer.numberOfRows();
+    if ( nrows == 0 ) { return; }
+
+    kvs::OpenGL::WithPushedAttrib attrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT );
+    kvs::OpenGL::Disable( GL_CULL_FACE );
+    kvs::OpenGL::Disable( GL_DEPTH_TEST );
+    kvs::OpenGL::Enable( GL_BLEND );
+    kvs::OpenGL::SetBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+    auto& shader = m_point_shader;
+    kvs::ProgramObject::Binder bind_shader( shader );
+    kvs::Texture::Binder bind_flag( m_table_buffer.flagTexture(), 0 );
+    kvs::Texture::Binder bind_color_map( m_color_map_texture, 1 );
+    kvs::VertexBufferObject::Binder bind_buffer( m_table_buffer.columnBuffer() );
+
+    const float radius = m_point_size * dpr;
+    const float edge_width = m_edge_width * dpr;
+    shader.setUniform( "flag_texture", 0 );
+    shader.setUniform( "color_map_texture", 1 );
+    shader.setUniform( "flag_texture_width", static_cast<GLint>( m_table_buffer.flagTexture().width() ) );
+    shader.setUniform( "color_map_resolution", static_cast<GLfloat>( m_color_map.resolution() ) );
+    shader.setUniform( "color_map_enabled", static_cast<GLint>( has_values ? 1 : 0 ) );
+    shader.setUniform( "point_color", kvs::RGBAColor( m_point_color, m_point_opacity ).toVec4() );
+    shader.setUniform( "rect", kvs::Vec4( rect.x0(), rect.y0(), rect.x1(), rect.y1() ) * dpr );
+    shader.setUniform( "extent", radius + edge_width * 0.5f + 1.0f );
+    shader.setUniform( "radius", radius );
+    shader.setUniform( "edge_width", edge_width );
+    shader.setUniform( "edge_color", kvs::RGBAColor( m_edge_color, m_edge_opacity ).toVec4() );
+
+    const GLint locations[3] = {
+        shader.attributeLocation( "x_value" ),
+        shader.attributeLocation( "y_value" ),
+        shader.attributeLocation( "color_value" ) };
+    const size_t columns[3] = { x_index, y_index, 2 };
+    for ( size_t i = 0; i < 3; i++ )
+    {
+        if ( locations[i] < 0 ) { continue; }
+        if ( i == 2 && !has_values ) { continue; }
+        kvs::OpenGL::EnableVertexAttribArray( locations[i] );
+        kvs::OpenGL::VertexAttribDivisor( locations[i], 1 );
+        m_table_buffer.setColumnPointer( locations[i], columns[i] );
+    }
+
+    kvs::OpenGL::DrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>( nrows ) );
+
+    for ( size_t i = 0; i < 3; i++ )
+    {
+        if ( locations[i] < 0 ) { continue; }
+        if ( i == 2 && !has_values ) { continue; }
+        kvs::OpenGL::VertexAttribDivisor( locations[i], 0 );
+        kvs::OpenGL::DisableVertexAttribArray( locations[i] );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws the 2D histogram of the points.
+ *  @param  rect [in] plot region
+ *  @param  dpr [in] device pixel ratio
+ *  @param  x_index [in] column index for the x axis
+ *  @param  y_index [in] column index for the y axis
+ *
+ *  The points are counted up in the bins on the GPU, and the bins are drawn
+ *  with the color map in the log scale normalized by the max. count, which is
+ *  also reduced on the GPU without reading the bins back.
+ */
+/*===========================================================================*/
+void ScatterPlotRenderer::drawHistogram(
+    const kvs::Rectangle& rect,
+    const float dpr,
+    const size_t x_index,
+    const size_t y_index )
+{
+    const size_t nrows = m_table_buffer.numberOfRows();
+    const size_t nbins = kvs::Math::Max( m_number_of_bins, size_t(1) );
+    if ( nrows == 0 ) { return; }
+
+    if ( m_histogram_texture.width() != nbins )
+    {
+        m_histogram_framebuffer.release();
+        m_histogram_texture.release();
+        m_histogram_texture.setWrapS( GL_CLAMP_TO_EDGE );
+        m_histogram_texture.setWrapT( GL_CLAMP_TO_EDGE );
+        m_histogram_texture.setMagFilter( GL_NEAREST );
+        m_histogram_texture.setMinFilter( GL_NEAREST );
+        m_histogram_texture.setPixelFormat( GL_R32F, GL_RED, GL_FLOAT );
+        m_histogram_texture.create( nbins, nbins );
+        m_histogram_framebuffer.create();
+        m_histogram_framebuffer.attachColorTexture( m_histogram_texture );
+    }
+
+    kvs::OpenGL::WithPushedAttrib attrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT | GL_POINT_BIT );
+    kvs::OpenGL::Disable( GL_CULL_FACE );
+    kvs::OpenGL::Disable( GL_DEPTH_TEST );
+    kvs::OpenGL::Enable( GL_BLEND );
+
+    // Count up the points in the bins.
+    const kvs::Vec4 viewport = kvs::OpenGL::Viewport();
+    {
+        kvs::FrameBufferObject::Binder bind_framebuffer( m_histogram_framebuffer );
+        kvs::OpenGL::SetViewport( 0, 0, nbins, nbins );
+        kvs::OpenGL::SetClearColor( kvs::Vec4::Zero() );
+        kvs::OpenGL::Clear( GL_COLOR_BUFFER_BIT );
+        kvs::OpenGL::SetBlendFunc( GL_ONE, GL_ONE );
+        kvs::OpenGL::Disable( GL_POINT_SMOOTH );
+        kvs::OpenGL::SetPointSize( 1.0f );
+
+        auto& shader = m_binning_shader;
+        kvs::ProgramObject::Binder bind_shader( shader );
+        kvs::Texture::Binder bind_flag( m_table_buffer.flagTexture(), 0 );
+        kvs::VertexBufferObject::Binder bind_buffer( m_table_buffer.columnBuffer() );
+        shader.setUniform( "flag_texture", 0 );
+        shader.setUniform( "flag_texture_width", static_cast<GLint>( m_table_buffer.flagTexture().width() ) );
+        shader.setUniform( "nbins", static_cast<GLfloat>( nbins ) );
+
+        const GLint locations[2] = {
+            shader.attributeLocation( "x_value" ),
+            shader.attributeLocation( "y_value" ) };
+        const size_t columns[2] = { x_index, y_index };
+        for ( size_t i = 0; i < 2; i++ )
+        {
+            kvs::OpenGL::EnableVertexAttribArray( locations[i] );
+            kvs::OpenGL::VertexAttribDivisor( locations[i], 1 );
+            m_table_buffer.setColumnPointer( locations[i], columns[i] );
+        }
+
+        kvs::OpenGL::DrawArraysInstanced( GL_POINTS, 0, 1, static_cast<GLsizei>( nrows ) );
+
+        for ( size_t i = 0; i < 2; i++ )
+        {
+            kvs::OpenGL::VertexAttribDivisor( locations[i], 0 );
+            kvs::OpenGL::DisableVertexAttribArray( locations[i] );
+        }
+    }
+    kvs::OpenGL::SetViewport( viewport );
+
+    // Reduce the bins to the max. count on the GPU.
+    m_max_count_buffer.reduce( m_histogram_texture );
+
+    // Draw the bins with the color map.
+    kvs::OpenGL::SetBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    auto& shader = m_histogram_shader;
+    kvs::ProgramObject::Binder bind_shader( shader );
+    kvs::Texture::Binder bind_histogram( m_histogram_texture, 0 );
+    kvs::Texture::Binder bind_color_map( m_color_map_texture, 1 );
+    kvs::Texture::Binder bind_max_count( m_max_count_buffer.resultTexture(), 2 );
+    shader.setUniform( "histogram_texture", 0 );
+    shader.setUniform( "color_map_texture", 1 );
+    shader.setUniform( "max_count_texture", 2 );
+    shader.setUniform( "color_map_resolution", static_cast<GLfloat>( m_color_map.resolution() ) );
+    shader.setUniform( "opacity", m_point_opacity );
+
+    const float x0 = rect.x0();
+    const float x1 = rect.x1();
+    const float y0 = rect.y0();
+    const float y1 = rect.y1();
+    kvs::OpenGL::Begin( GL_QUADS );
+    kvs::OpenGL::TexCoordVertex( kvs::Vec2( 0, 0 ), kvs::Vec2( x0, y1 ) * dpr );
+    kvs::OpenGL::TexCoordVertex( kvs::Vec2( 1, 0 ), kvs::Vec2( x1, y1 ) * dpr );
+    kvs::OpenGL::TexCoordVertex( kvs::Vec2( 1, 1 ), kvs::Vec2( x1, y0 ) * dpr );
+    kvs::OpenGL::TexCoordVertex( kvs::Vec2( 0, 1 ), kvs::Vec2( x0, y0 ) * dpr );
+    kvs::OpenGL::End();
+}
+
 } // end of namespace kvs
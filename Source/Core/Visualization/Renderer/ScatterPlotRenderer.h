@@ -14,6 +14,12 @@
 #include <kvs/Margins>
 #include <kvs/UIColor>
 #include <kvs/Deprecated>
+#include <kvs/TableBuffer>
+#include <kvs/ProgramObject>
+#include <kvs/Texture1D>
+#include <kvs/Texture2D>
+#include <kvs/FrameBufferObject>
+#include <kvs/MaxReductionBuffer>
 
 
 namespace kvs
@@ -58,9 +64,23 @@ private:
     kvs::RGBAColor m_background_color{ kvs::UIColor::Gray5() }; ///< background color
     bool m_background_visible = false; ///< visibility of the background
 
+    // 2D histogram
+    bool m_enable_histogram_mode = false; ///< flag for 2D histogram mode
+    size_t m_number_of_bins = 64; ///< number of bins in each direction
+
     kvs::ColorMap m_color_map{ 256 }; ///< color map
     kvs::Painter m_painter{}; ///< painter
 
+    // Resources for the instanced rendering
+    kvs::TableBuffer m_table_buffer{}; ///< buffers of the table
+    kvs::Texture1D m_color_map_texture{}; ///< color map texture
+    kvs::ProgramObject m_point_shader{}; ///< shader for the points
+    kvs::ProgramObject m_binning_shader{}; ///< shader for the binning of the points
+    kvs::ProgramObject m_histogram_shader{}; ///< shader for the 2D histogram
+    kvs::FrameBufferObject m_histogram_framebuffer{}; ///< framebuffer for the binning
+    kvs::Texture2D m_histogram_texture{}; ///< floating-point texture of the bins
+    kvs::MaxReductionBuffer m_max_count_buffer{}; ///< buffer for the max. count of the bins
+
 public:
     ScatterPlotRenderer() { m_color_map.create(); }
 
@@ -78,6 +98,10 @@ public:
     void setBackgroundColor( const kvs::RGBAColor color ) { m_background_color = color; }
     void setBackgroundVisible( const bool visible = true ) { m_background_visible = visible; }
     void setColorMap( const kvs::ColorMap& color_map ) { m_color_map = color_map; }
+    void setHistogramModeEnabled( const bool enable = true ) { m_enable_histogram_mode = enable; }
+    void enableHistogramMode() { this->setHistogramModeEnabled( true ); }
+    void disableHistogramMode() { this->setHistogramModeEnabled( false ); }
+    void setNumberOfBins( const size_t nbins ) { m_number_of_bins = nbins; }
 
     const kvs::Margins& margins() const { return m_margins; }
     const kvs::RGBColor& pointColor() const { return m_point_color; }
@@ -93,6 +117,8 @@ public:
     const kvs::RGBAColor& backgroundColor() const { return m_background_color; }
     bool isBackgroundVisible() const { return m_background_visible; }
     const kvs::ColorMap& colorMap() const { return m_color_map; }
+    bool isHistogramModeEnabled() const { return m_enable_histogram_mode; }
+    size_t numberOfBins() const { return m_number_of_bins; }
 
     void exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
 
@@ -101,6 +127,9 @@ protected:
     void drawBackground( const kvs::Rectangle& rect, const float dpr );
     void drawPolyline( const kvs::Rectangle& rect, kvs::TableObject* table, const size_t x_index, const size_t y_index );
     void drawPoint( const kvs::Rectangle& rect, kvs::TableObject* table, const size_t x_index, const size_t y_index, const bool has_values );
+    void updateBuffers( const kvs::TableObject* table );
+    void drawInstancedPoint( const kvs::Rectangle& rect, const float dpr, const size_t x_index, const size_t y_index, const bool has_values );
+    void drawHistogram( const kvs::Rectangle& rect, const float dpr, const size_t x_index, const size_t y_index );
 
 public:
     KVS_DEPRECATED( void setTopMargin( const int margin ) ) { m_margins.setTop( margin ); }
@@ -13,6 +13,7 @@
 #include <kvs/Assert>
 #include <kvs/Message>
 #include <kvs/Xorshift128>
+#include <kvs/ShaderSource>
 
 
 namespace
@@ -96,23 +97,130 @@ void StochasticPointRenderer::setOpacity( const kvs::UInt8 opacity )
     static_cast<Engine&>( engine() ).setOpacity( opacity );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Creates buffer object for the compressed points.
+ *  @param  point [in] pointer to the point object
+ *  @param  shader_program [in] shader program for the attribute locations
+ */
+/*===========================================================================*/
+void StochasticPointRenderer::Engine::CompressedBufferObject::create(
+    const kvs::PointObject* point,
+    const kvs::ProgramObject& shader_program )
+{
+    const auto& points = point->compressedPoints();
+
+    // The quantized coordinates are stored as the signed shorts so that they
+    // can be passed through the vertex array (gl_Vertex) without conversion.
+    m_manager.setVertexArray( points.coords(), 3 );
+
+    const auto normal_location = shader_program.attributeLocation( "packed_normal" );
+    if ( normal_location >= 0 )
+    {
+        m_manager.setVertexAttribArray( points.normals(), normal_location, 2, true );
+    }
+
+    const auto color_location = shader_program.attributeLocation( "color_index" );
+    if ( color_location >= 0 )
+    {
+        m_manager.setVertexAttribArray( points.colorIndices(), color_location, 1, true );
+    }
+
+    m_manager.create();
+
+    m_palette_texture.release();
+    m_palette_texture.setWrapS( GL_CLAMP_TO_EDGE );
+    m_palette_texture.setMagFilter( GL_NEAREST );
+    m_palette_texture.setMinFilter( GL_NEAREST );
+    m_palette_texture.setPixelFormat( GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE );
+    m_palette_texture.create( kvs::CompressedPointArray::PaletteSize, points.palette().data() );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Draws buffer object for the compressed points block by block.
+ *  @param  point [in] pointer to the point object
+ *  @param  shader_program [in] shader program bound for drawing
+ */
+/*===========================================================================*/
+void StochasticPointRenderer::Engine::CompressedBufferObject::draw(
+    const kvs::PointObject* point,
+    kvs::ProgramObject& shader_program )
+{
+    const auto& points = point->compressedPoints();
+    const size_t nblocks = points.numberOfBlocks();
+
+    kvs::Texture::Binder bind1( m_palette_texture, 1 );
+    kvs::VertexBufferObjectManager::Binder bind2( m_manager );
+    for ( size_t block = 0; block < nblocks; block++ )
+    {
+        const kvs::Vec3 min_coord = points.blockMinCoord( block );
+        const kvs::Vec3 max_coord = points.blockMaxCoord( block );
+        shader_program.setUniform( "block_min_coord", min_coord );
+        shader_program.setUniform( "block_extent", max_coord - min_coord );
+
+        const auto first = static_cast<GLint>( points.blockFirst( block ) );
+        const auto count = static_cast<GLsizei>( points.blockCount( block ) );
+        m_manager.drawArrays( GL_POINTS, first, count );
+    }
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Constructs a new RenderPass class.
  *  @param  buffer_object [in] buffer object
+ *  @param  compressed_buffer_object [in] buffer object for compressed points
  *  @param  parent [in] pointer to engin
  */
 /*===========================================================================*/
 StochasticPointRenderer::Engine::RenderPass::RenderPass(
     Engine::BufferObject& buffer_object,
+    Engine::CompressedBufferObject& compressed_buffer_object,
     RenderPass::Parent* parent ):
     BaseRenderPass( buffer_object ),
-    m_parent( parent )
+    m_parent( parent ),
+    m_compressed_buffer_object( compressed_buffer_object )
 {
     this->setVertexShaderFile( "SR_point.vert" );
     this->setFragmentShaderFile( "SR_point.frag" );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Builds shader program.
+ *  @param  model [in] shading model
+ *  @param  enable [in] if true, shading is enabled
+ */
+/*===========================================================================*/
+void StochasticPointRenderer::Engine::RenderPass::create(
+    const kvs::Shader::ShadingModel& model, const bool enable )
+{
+    kvs::ShaderSource vert( this->vertexShaderFile() );
+    kvs::ShaderSource frag( this->fragmentShaderFile() );
+    if ( enable )
+    {
+        switch ( model.type() )
+        {
+        case kvs::Shader::LambertShading: frag.define("ENABLE_LAMBERT_SHADING"); break;
+        case kvs::Shader::PhongShading: frag.define("ENABLE_PHONG_SHADING"); break;
+        case kvs::Shader::BlinnPhongShading: frag.define("ENABLE_BLINN_PHONG_SHADING"); break;
+        default: break; // NO SHADING
+        }
+
+        if ( model.two_side_lighting )
+        {
+            frag.define("ENABLE_TWO_SIDE_LIGHTING");
+        }
+    }
+
+    if ( m_enable_compression )
+    {
+        vert.define("ENABLE_COMPRESSED_POINTS");
+    }
+
+    this->shaderProgram().build( vert, frag );
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Setups render pass.
@@ -131,6 +239,10 @@ void StochasticPointRenderer::Engine::RenderPass::setup(
     shader_program.setUniform( "random_texture_size_inv", size_inv );
     shader_program.setUniform( "random_texture", 0 );
     shader_program.setUniform( "opacity", m_opacity / 255.0f );
+    if ( m_enable_compression )
+    {
+        shader_program.setUniform( "palette_texture", 1 );
+    }
 }
 
 /*===========================================================================*/
@@ -152,9 +264,17 @@ void StochasticPointRenderer::Engine::RenderPass::draw(
     kvs::ProgramObject::Binder bind2( shader_program );
     shader_program.setUniform( "random_offset", random_offset );
 
-    auto& buffer_object = this->bufferObject();
     kvs::Texture::Binder bind3( m_parent->randomTexture() );
-    buffer_object.draw( object );
+    if ( m_enable_compression )
+    {
+        const auto* point = kvs::PointObject::DownCast( object );
+        m_compressed_buffer_object.draw( point, shader_program );
+    }
+    else
+    {
+        auto& buffer_object = this->bufferObject();
+        buffer_object.draw( object );
+    }
 }
 
 /*===========================================================================*/
@@ -172,8 +292,17 @@ void StochasticPointRenderer::Engine::create(
     BaseClass::attachObject( object );
     BaseClass::createRandomTexture();
 
+    m_render_pass.setCompressionEnabled( point->isCompressed() );
     m_render_pass.create( BaseClass::shader(), BaseClass::isShadingEnabled() );
 
+    // The random indices for the compressed points are generated from the
+    // quantized coordinates in the vertex shader.
+    if ( point->isCompressed() )
+    {
+        m_compressed_buffer_object.create( point, m_render_pass.shaderProgram() );
+        return;
+    }
+
     const size_t nvertices = point->numberOfVertices();
     const auto indices = BaseClass::randomIndices( nvertices );
     auto location = m_render_pass.shaderProgram().attributeLocation( "random_index" );
@@ -8,6 +8,7 @@
 #include <kvs/Module>
 #include <kvs/ProgramObject>
 #include <kvs/VertexBufferObjectManager>
+#include <kvs/Texture1D>
 #include <kvs/PointRenderer>
 #include "StochasticRenderingEngine.h"
 #include "StochasticRendererBase.h"
@@ -55,16 +56,36 @@ public:
     using BaseClass = kvs::StochasticRenderingEngine;
     using BufferObject = kvs::glsl::PointRenderer::BufferObject;
 
+    class CompressedBufferObject
+    {
+    private:
+        kvs::VertexBufferObjectManager m_manager{}; ///< VBO manager
+        kvs::Texture1D m_palette_texture{}; ///< color palette texture
+    public:
+        CompressedBufferObject() = default;
+        virtual ~CompressedBufferObject() { this->release(); }
+        kvs::VertexBufferObjectManager& manager() { return m_manager; }
+        const kvs::Texture1D& paletteTexture() const { return m_palette_texture; }
+        void release() { m_manager.release(); m_palette_texture.release(); }
+        void create( const kvs::PointObject* point, const kvs::ProgramObject& shader_program );
+        void draw( const kvs::PointObject* point, kvs::ProgramObject& shader_program );
+    };
+
     class RenderPass : public kvs::glsl::PointRenderer::RenderPass
     {
         using BaseRenderPass = kvs::glsl::PointRenderer::RenderPass;
         using Parent = BaseClass;
     private:
         const Parent* m_parent; ///< reference to the engine
+        CompressedBufferObject& m_compressed_buffer_object; ///< buffer object for compressed points
         kvs::UInt8 m_opacity = 255; ///< point opacity
+        bool m_enable_compression = false; ///< flag for decoding compressed points
     public:
-        RenderPass( BufferObject& buffer_object, Parent* parent );
+        RenderPass( BufferObject& buffer_object, CompressedBufferObject& compressed_buffer_object, Parent* parent );
+        bool isCompressionEnabled() const { return m_enable_compression; }
         void setOpacity( const kvs::UInt8 opacity ) { m_opacity = opacity; }
+        void setCompressionEnabled( const bool enable = true ) { m_enable_compression = enable; }
+        void create( const kvs::Shader::ShadingModel& model, const bool enable );
         void setup( const kvs::Shader::ShadingModel& model );
         void draw( const kvs::ObjectBase* object );
     };
@@ -73,11 +94,17 @@ private:
     kvs::Vec2 m_depth_offset{ 0.0f, 0.0f }; ///< depth offset {factor, units}
     RenderPass m_render_pass; ///< render pass
     BufferObject m_buffer_object; ///< buffer object
+    CompressedBufferObject m_compressed_buffer_object; ///< buffer object for compressed points
 
 public:
-    Engine(): m_render_pass( m_buffer_object, this ) {}
+    Engine(): m_render_pass( m_buffer_object, m_compressed_buffer_object, this ) {}
     virtual ~Engine() { this->release(); }
-    void release() { m_render_pass.release(); m_buffer_object.release(); }
+    void release()
+    {
+        m_render_pass.release();
+        m_buffer_object.release();
+        m_compressed_buffer_object.release();
+    }
     void create( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
     void update( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
     void setup( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
@@ -9,6 +9,7 @@
 #include <kvs/Camera>
 #include <kvs/Light>
 #include <kvs/OpenGL>
+#include <kvs/ScreenBase>
 
 
 namespace kvs
@@ -129,6 +130,16 @@ void StochasticRendererBase::exec(
     // Render to the framebuffer.
     m_ensemble_buffer.draw();
 
+    // The frames drawn while the engine is not ready (e.g. the buffer objects
+    // are partially uploaded) are not accumulated, and the next frame is
+    // requested until the engine gets ready.
+    if ( !m_engine->isReady() )
+    {
+        m_ensemble_buffer.clear();
+        m_engine->resetRepetitions();
+        if ( this->screen() ) { this->screen()->redraw(); }
+    }
+
     kvs::OpenGL::Finish();
     stopTimer();
 }
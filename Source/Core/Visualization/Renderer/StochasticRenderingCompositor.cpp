@@ -14,6 +14,7 @@
 #include <kvs/Camera>
 #include <kvs/Light>
 #include <kvs/Background>
+#include <kvs/BufferUploadQueue>
 #include "StochasticRendererBase.h"
 #include "ParticleBasedRenderer.h"
 
@@ -38,6 +39,9 @@ void StochasticRenderingCompositor::draw()
         m_scene->updateGLLightParameters();
         m_scene->background()->apply();
 
+        // Upload the pending buffer objects within the budget per frame.
+        m_scene->uploadQueue()->process();
+
         if ( m_scene->objectManager()->hasObject() )
         {
             this->render_objects();
@@ -46,6 +50,9 @@ void StochasticRenderingCompositor::draw()
         {
             m_scene->updateGLModelingMatrix();
         }
+
+        // Request the next frame until all of the buffer objects are uploaded.
+        if ( m_scene->uploadQueue()->hasPendingRequests() ) { m_scene->screen()->redraw(); }
     }
 }
 
@@ -78,6 +85,24 @@ void StochasticRenderingCompositor::render_objects()
     } );
     this->lastRenderPass( m_ensemble_buffer );
 
+    // The frames drawn while any of the engines is not ready (e.g. the buffer
+    // objects are partially uploaded) are not accumulated, and the next frame
+    // is requested until all of the engines get ready.
+    bool is_ready = true;
+    this->for_each_object( [&] ( Object*, Renderer* renderer )
+    {
+        if ( !renderer->engine().isReady() ) { is_ready = false; }
+    } );
+    if ( !is_ready )
+    {
+        m_ensemble_buffer.clear();
+        this->for_each_object( [&] ( Object*, Renderer* renderer )
+        {
+            renderer->engine().resetRepetitions();
+        } );
+        m_scene->screen()->redraw();
+    }
+
     kvs::OpenGL::Finish();
     m_timer.stop();
 }
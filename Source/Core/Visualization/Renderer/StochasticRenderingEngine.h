@@ -66,6 +66,7 @@ public:
     virtual void update( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light ) = 0;
     virtual void setup( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light ) = 0;
     virtual void draw( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light ) = 0;
+    virtual bool isReady() const { return true; }
 
     const kvs::Shader::ShadingModel& shader() const { return *m_shader; }
     void resetRepetitions() { m_repetition_count = 0; }
@@ -24,6 +24,9 @@
 #include <kvs/TetrahedralCell>
 #include <kvs/ProjectedTetrahedraTable>
 #include <kvs/PreIntegrationTable2D>
+#include <kvs/OpenMP>
+#include <algorithm>
+#include <vector>
 
 
 namespace
@@ -192,6 +195,267 @@ kvs::ValueArray<kvs::Real32> VertexNormals(
     return kvs::ValueArray<kvs::Real32>();
 }
 
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the Morton code of the 3D index.
+ *  @param  x [in] index in x-axis (up to 10 bits)
+ *  @param  y [in] index in y-axis (up to 10 bits)
+ *  @param  z [in] index in z-axis (up to 10 bits)
+ *  @return Morton code
+ */
+/*===========================================================================*/
+inline kvs::UInt32 MortonCode( const kvs::UInt32 x, const kvs::UInt32 y, const kvs::UInt32 z )
+{
+    auto spread = [] ( kvs::UInt32 v )
+    {
+        v = ( v | ( v << 16 ) ) & 0x030000FF;
+        v = ( v | ( v <<  8 ) ) & 0x0300F00F;
+        v = ( v | ( v <<  4 ) ) & 0x030C30C3;
+        v = ( v | ( v <<  2 ) ) & 0x09249249;
+        return v;
+    };
+    return spread( x ) | ( spread( y ) << 1 ) | ( spread( z ) << 2 );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the cell indices sorted in the spatially coherent order.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  chunk_size [in] max. number of cells in a chunk
+ *  @return sorted cell indices
+ *
+ *  The cells are bucketed into a grid by their centers, and the buckets are
+ *  ordered along the Z-order curve by the counting sort. The grid is chosen
+ *  so that a chunk covers about eight buckets.
+ */
+/*===========================================================================*/
+kvs::ValueArray<kvs::UInt32> SortedCells(
+    const kvs::UnstructuredVolumeObject* volume,
+    const size_t chunk_size )
+{
+    const size_t nnodes = volume->numberOfNodes();
+    const size_t ncells = volume->numberOfCells();
+    const kvs::Real32* coords = volume->coords().data();
+    const kvs::UInt32* connections = volume->connections().data();
+
+    kvs::Vec3 min_coord( coords );
+    kvs::Vec3 max_coord( coords );
+    for ( size_t i = 1; i < nnodes; i++ )
+    {
+        for ( int j = 0; j < 3; j++ )
+        {
+            min_coord[j] = kvs::Math::Min( min_coord[j], coords[ 3 * i + j ] );
+            max_coord[j] = kvs::Math::Max( max_coord[j], coords[ 3 * i + j ] );
+        }
+    }
+
+    const size_t nchunks = ( ncells + chunk_size - 1 ) / chunk_size;
+    size_t level = 0;
+    while ( level < 7 && ( size_t(1) << ( 3 * level ) ) < nchunks * 8 ) { level++; }
+    const kvs::UInt32 resolution = 1u << level;
+
+    kvs::Vec3 scale( 0.0f, 0.0f, 0.0f );
+    for ( int j = 0; j < 3; j++ )
+    {
+        const float extent = max_coord[j] - min_coord[j];
+        if ( extent > 0.0f ) { scale[j] = resolution / extent; }
+    }
+
+    kvs::ValueArray<kvs::UInt32> keys( ncells );
+    KVS_OMP_PARALLEL_FOR( schedule(static) )
+    for ( long i = 0; i < static_cast<long>( ncells ); i++ )
+    {
+        kvs::Vec3 center( 0.0f, 0.0f, 0.0f );
+        for ( size_t j = 0; j < 4; j++ )
+        {
+            center += kvs::Vec3( coords + 3 * connections[ 4 * i + j ] );
+        }
+        center *= 0.25f;
+
+        kvs::UInt32 index[3];
+        for ( int j = 0; j < 3; j++ )
+        {
+            const auto p = static_cast<kvs::UInt32>( ( center[j] - min_coord[j] ) * scale[j] );
+            index[j] = kvs::Math::Min( p, resolution - 1 );
+        }
+        keys[i] = ::MortonCode( index[0], index[1], index[2] );
+    }
+
+    const size_t nbuckets = size_t(1) << ( 3 * level );
+    kvs::ValueArray<kvs::UInt32> offsets( nbuckets + 1 );
+    offsets.fill( 0 );
+    for ( size_t i = 0; i < ncells; i++ ) { offsets[ keys[i] + 1 ]++; }
+    for ( size_t i = 0; i < nbuckets; i++ ) { offsets[ i + 1 ] += offsets[i]; }
+
+    kvs::ValueArray<kvs::UInt32> cells( ncells );
+    for ( size_t i = 0; i < ncells; i++ )
+    {
+        cells[ offsets[ keys[i] ]++ ] = static_cast<kvs::UInt32>( i );
+    }
+
+    return cells;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Vertex arrays of a chunk with the local node indices.
+ */
+/*===========================================================================*/
+struct ChunkArrays
+{
+    kvs::ValueArray<kvs::UInt16> indices{}; ///< random indices
+    kvs::ValueArray<kvs::Real32> values{}; ///< normalized values
+    kvs::ValueArray<kvs::Real32> coords{}; ///< coordinates
+    kvs::ValueArray<kvs::Real32> normals{}; ///< normal vectors
+    kvs::ValueArray<kvs::UInt32> connections{}; ///< local connections
+    kvs::Vec3 min_coord{}; ///< min. coordinate
+    kvs::Vec3 max_coord{}; ///< max. coordinate
+    kvs::Real32 min_value = 0.0f; ///< min. normalized value
+    kvs::Real32 max_value = 0.0f; ///< max. normalized value
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the vertex arrays of the chunk.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  cells [in] indices of the cells in the chunk
+ *  @param  ncells [in] number of the cells in the chunk
+ *  @param  indices [in] random indices of the nodes
+ *  @param  values [in] normalized values of the nodes
+ *  @param  normals [in] normal vectors of the nodes
+ *  @return vertex arrays
+ */
+/*===========================================================================*/
+ChunkArrays CreateChunkArrays(
+    const kvs::UnstructuredVolumeObject* volume,
+    const kvs::UInt32* cells,
+    const size_t ncells,
+    const kvs::ValueArray<kvs::UInt16>& indices,
+    const kvs::ValueArray<kvs::Real32>& values,
+    const kvs::ValueArray<kvs::Real32>& normals )
+{
+    const kvs::Real32* coords = volume->coords().data();
+    const kvs::UInt32* connections = volume->connections().data();
+
+    // Nodes referred by the cells, which are shared with the adjacent chunks.
+    std::vector<kvs::UInt32> nodes( 4 * ncells );
+    for ( size_t i = 0; i < ncells; i++ )
+    {
+        for ( size_t j = 0; j < 4; j++ )
+        {
+            nodes[ 4 * i + j ] = connections[ 4 * cells[i] + j ];
+        }
+    }
+    std::sort( nodes.begin(), nodes.end() );
+    nodes.erase( std::unique( nodes.begin(), nodes.end() ), nodes.end() );
+
+    const size_t nnodes = nodes.size();
+    ChunkArrays arrays;
+    arrays.indices.allocate( nnodes * 2 );
+    arrays.values.allocate( nnodes );
+    arrays.coords.allocate( nnodes * 3 );
+    arrays.normals.allocate( nnodes * 3 );
+    arrays.min_coord = kvs::Vec3( coords + 3 * nodes[0] );
+    arrays.max_coord = arrays.min_coord;
+    arrays.min_value = values[ nodes[0] ];
+    arrays.max_value = values[ nodes[0] ];
+    for ( size_t i = 0; i < nnodes; i++ )
+    {
+        const kvs::UInt32 node = nodes[i];
+        arrays.indices[ 2 * i + 0 ] = indices[ 2 * node + 0 ];
+        arrays.indices[ 2 * i + 1 ] = indices[ 2 * node + 1 ];
+        arrays.values[i] = values[ node ];
+        arrays.min_value = kvs::Math::Min( arrays.min_value, values[ node ] );
+        arrays.max_value = kvs::Math::Max( arrays.max_value, values[ node ] );
+        for ( size_t j = 0; j < 3; j++ )
+        {
+            const kvs::Real32 x = coords[ 3 * node + j ];
+            arrays.coords[ 3 * i + j ] = x;
+            arrays.normals[ 3 * i + j ] = normals.empty() ? 0.0f : normals[ 3 * node + j ];
+            arrays.min_coord[j] = kvs::Math::Min( arrays.min_coord[j], x );
+            arrays.max_coord[j] = kvs::Math::Max( arrays.max_coord[j], x );
+        }
+    }
+
+    arrays.connections.allocate( 4 * ncells );
+    for ( size_t i = 0; i < ncells; i++ )
+    {
+        for ( size_t j = 0; j < 4; j++ )
+        {
+            const kvs::UInt32 node = connections[ 4 * cells[i] + j ];
+            const auto local = std::lower_bound( nodes.begin(), nodes.end(), node ) - nodes.begin();
+            arrays.connections[ 4 * i + j ] = static_cast<kvs::UInt32>( local );
+        }
+    }
+
+    return arrays;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the bounding box is outside the view frustum.
+ *  @param  PM [in] model-view-projection matrix
+ *  @param  min_coord [in] min. coordinate of the bounding box
+ *  @param  max_coord [in] max. coordinate of the bounding box
+ *  @return true if all the corners are outside one of the clip planes
+ */
+/*===========================================================================*/
+bool IsOutsideFrustum(
+    const kvs::Mat4& PM,
+    const kvs::Vec3& min_coord,
+    const kvs::Vec3& max_coord )
+{
+    // Number of the corners outside each of the six clip planes.
+    int outside[6] = { 0, 0, 0, 0, 0, 0 };
+    for ( int i = 0; i < 8; i++ )
+    {
+        const kvs::Vec4 p(
+            ( i & 1 ) ? max_coord.x() : min_coord.x(),
+            ( i & 2 ) ? max_coord.y() : min_coord.y(),
+            ( i & 4 ) ? max_coord.z() : min_coord.z(),
+            1.0f );
+        const kvs::Vec4 c = PM * p;
+        for ( int j = 0; j < 3; j++ )
+        {
+            if ( c[j] < -c.w() ) { outside[ 2 * j + 0 ]++; }
+            if ( c[j] > c.w() ) { outside[ 2 * j + 1 ]++; }
+        }
+    }
+
+    for ( int j = 0; j < 6; j++ ) { if ( outside[j] == 8 ) { return true; } }
+    return false;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the value range is mapped to zero opacity.
+ *  @param  opacities [in] opacity table of the transfer function
+ *  @param  min_value [in] min. normalized value
+ *  @param  max_value [in] max. normalized value
+ *  @return true if the opacities in the range are zero
+ */
+/*===========================================================================*/
+bool IsTransparent(
+    const kvs::ValueArray<kvs::Real32>& opacities,
+    const kvs::Real32 min_value,
+    const kvs::Real32 max_value )
+{
+    if ( opacities.empty() ) { return false; }
+
+    // The table entries around the range are included, since the transfer
+    // function texture is linearly interpolated.
+    const long last = static_cast<long>( opacities.size() ) - 1;
+    const long begin = kvs::Math::Clamp( static_cast<long>( std::floor( min_value * last ) ), 0L, last );
+    const long end = kvs::Math::Clamp( static_cast<long>( std::ceil( max_value * last ) ), 0L, last );
+    for ( long i = begin; i <= end; i++ )
+    {
+        if ( opacities[i] > 0.0f ) { return false; }
+    }
+
+    return true;
+}
+
 }
 
 
@@ -242,6 +506,28 @@ void StochasticTetrahedraRenderer::setEdgeFactor( const float factor )
     static_cast<Engine&>( engine() ).setEdgeFactor( factor );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets the max. number of cells in a chunk of the buffer objects.
+ *  @param  ncells [in] number of cells
+ */
+/*===========================================================================*/
+void StochasticTetrahedraRenderer::setChunkSize( const size_t ncells )
+{
+    static_cast<Engine&>( engine() ).setChunkSize( ncells );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the upload queue for the progressive upload of the chunks.
+ *  @param  queue [in] upload queue (e.g. kvs::Scene::uploadQueue())
+ */
+/*===========================================================================*/
+void StochasticTetrahedraRenderer::setUploadQueue( kvs::BufferUploadQueue* queue )
+{
+    static_cast<Engine&>( engine() ).setUploadQueue( queue );
+}
+
 const kvs::TransferFunction& StochasticTetrahedraRenderer::transferFunction() const
 {
     return static_cast<const Engine&>( engine() ).transferFunction();
@@ -252,6 +538,21 @@ float StochasticTetrahedraRenderer::samplingStep() const
     return static_cast<const Engine&>( engine() ).samplingStep();
 }
 
+size_t StochasticTetrahedraRenderer::chunkSize() const
+{
+    return static_cast<const Engine&>( engine() ).chunkSize();
+}
+
+size_t StochasticTetrahedraRenderer::numberOfChunks() const
+{
+    return static_cast<const Engine&>( engine() ).numberOfChunks();
+}
+
+size_t StochasticTetrahedraRenderer::numberOfDrawnChunks() const
+{
+    return static_cast<const Engine&>( engine() ).numberOfDrawnChunks();
+}
+
 void StochasticTetrahedraRenderer::setVertexShaderFile( const std::string& file )
 {
     static_cast<Engine&>( engine() ).setVertexShaderFile( file );
@@ -304,12 +605,11 @@ int StochasticTetrahedraRenderer::Engine::PreIntegrationBuffer::inverseTextureSi
 void StochasticTetrahedraRenderer::Engine::PreIntegrationBuffer::create(
     const kvs::TransferFunction& tfunc )
 {
-    kvs::PreIntegrationTable2D table;
-    table.setTransferFunction( tfunc );
-    table.create();
+    m_table.setTransferFunction( tfunc );
+    m_table.create();
 
-    auto T = table.T();
-    auto T_inv = table.inverseT( this->inverseTextureSize() );
+    auto T = m_table.T();
+    auto T_inv = m_table.inverseT( this->inverseTextureSize() );
     const auto resolution = T.size();
 
     m_T_max = T.back();
@@ -331,16 +631,39 @@ void StochasticTetrahedraRenderer::Engine::PreIntegrationBuffer::create(
     m_texture.setMagFilter( GL_LINEAR );
     m_texture.setMinFilter( GL_LINEAR );
     m_texture.setPixelFormat( GL_R32F, GL_RED, GL_FLOAT );
-    m_texture.create( resolution, resolution, table.table().data() );
+    m_texture.create( resolution, resolution, m_table.table().data() );
 }
 
 void StochasticTetrahedraRenderer::Engine::PreIntegrationBuffer::update(
     const kvs::TransferFunction& tfunc )
 {
-    m_texture.release();
-    m_T_texture.release();
-    m_T_inv_texture.release();
-    this->create( tfunc );
+    const auto resolution = tfunc.opacityMap().table().size();
+    if ( !m_texture.isCreated() || m_texture.width() != resolution )
+    {
+        this->release();
+        this->create( tfunc );
+        return;
+    }
+
+    // The table is rebuilt only in the band of the changed opacities, and the
+    // textures are reloaded without the reallocation.
+    if ( !m_table.update( tfunc ) ) { return; }
+
+    auto T = m_table.T();
+    auto T_inv = m_table.inverseT( this->inverseTextureSize() );
+    m_T_max = T.back();
+    {
+        kvs::Texture::Binder unit( m_T_texture );
+        m_T_texture.load( T.size(), T.data() );
+    }
+    {
+        kvs::Texture::Binder unit( m_T_inv_texture );
+        m_T_inv_texture.load( T_inv.size(), T_inv.data() );
+    }
+    {
+        kvs::Texture::Binder unit( m_texture );
+        m_texture.load( resolution, resolution, m_table.table().data() );
+    }
 }
 
 void StochasticTetrahedraRenderer::Engine::PreIntegrationBuffer::release()
@@ -370,9 +693,28 @@ void StochasticTetrahedraRenderer::Engine::DecompositionBuffer::create()
     m_texture.create( size, 1, table.data() );
 }
 
+void StochasticTetrahedraRenderer::Engine::BufferObject::release()
+{
+    for ( auto& chunk : m_chunks )
+    {
+        if ( chunk->request ) { chunk->request->cancel(); }
+    }
+    m_chunks.clear();
+    m_ndrawn_chunks = 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the buffer objects of the spatially coherent chunks.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  shader_program [in] shader program for the attribute locations
+ *  @param  queue [in] upload queue (if null, the chunks are uploaded immediately)
+ */
+/*===========================================================================*/
 void StochasticTetrahedraRenderer::Engine::BufferObject::create(
     const kvs::UnstructuredVolumeObject* volume,
-    const kvs::ProgramObject& shader_program )
+    const kvs::ProgramObject& shader_program,
+    kvs::BufferUploadQueue* queue )
 {
     if ( volume->cellType() != kvs::UnstructuredVolumeObject::Tetrahedra )
     {
@@ -386,24 +728,116 @@ void StochasticTetrahedraRenderer::Engine::BufferObject::create(
         return;
     }
 
+    this->release();
+
     const auto indices = ::RandomIndices( volume, m_engine->randomTextureSize() );
     const auto values = ::NormalizedValues( volume );
-    const auto coords = volume->coords();
     const auto normals = ::VertexNormals( volume );
-    m_manager.setVertexAttribArray( indices, shader_program.attributeLocation("random_index"), 2 );
-    m_manager.setVertexAttribArray( values, shader_program.attributeLocation("value"), 1 );
-    m_manager.setVertexArray( coords, 3 );
-    m_manager.setNormalArray( normals );
-    m_manager.setIndexArray( volume->connections() );
-    m_manager.create();
+    const auto chunk_size = kvs::Math::Max( m_chunk_size, size_t(1) );
+    const auto cells = ::SortedCells( volume, chunk_size );
+
+    const size_t ncells = volume->numberOfCells();
+    const size_t nchunks = ( ncells + chunk_size - 1 ) / chunk_size;
+    std::vector<::ChunkArrays> arrays( nchunks );
+    KVS_OMP_PARALLEL_FOR( schedule(dynamic) )
+    for ( long i = 0; i < static_cast<long>( nchunks ); i++ )
+    {
+        const size_t first = i * chunk_size;
+        const size_t count = kvs::Math::Min( chunk_size, ncells - first );
+        arrays[i] = ::CreateChunkArrays( volume, cells.data() + first, count, indices, values, normals );
+    }
+
+    const auto index_location = shader_program.attributeLocation("random_index");
+    const auto value_location = shader_program.attributeLocation("value");
+    for ( size_t i = 0; i < nchunks; i++ )
+    {
+        const auto& a = arrays[i];
+        std::unique_ptr<Chunk> chunk( new Chunk() );
+        chunk->min_coord = a.min_coord;
+        chunk->max_coord = a.max_coord;
+        chunk->min_value = a.min_value;
+        chunk->max_value = a.max_value;
+        chunk->ncells = a.connections.size() / 4;
+
+        auto& manager = chunk->manager;
+        manager.setVertexAttribArray( a.indices, index_location, 2 );
+        manager.setVertexAttribArray( a.values, value_location, 1 );
+        manager.setVertexArray( a.coords, 3 );
+        manager.setNormalArray( a.normals );
+        manager.setIndexArray( a.connections );
+        if ( queue )
+        {
+            // The arrays are kept in the request until the upload is completed.
+            chunk->request = std::make_shared<kvs::BufferUploadQueue::Request>( &manager );
+            chunk->request->hold( a.indices );
+            chunk->request->hold( a.values );
+            chunk->request->hold( a.coords );
+            chunk->request->hold( a.normals );
+            chunk->request->hold( a.connections );
+            queue->push( chunk->request );
+        }
+        else
+        {
+            manager.create();
+        }
+
+        m_chunks.push_back( std::move( chunk ) );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if all of the chunks are uploaded.
+ *  @return true if all of the chunks are uploaded
+ */
+/*===========================================================================*/
+bool StochasticTetrahedraRenderer::Engine::BufferObject::isUploaded() const
+{
+    for ( const auto& chunk : m_chunks )
+    {
+        if ( !chunk->isUploaded() ) { return false; }
+    }
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Culls the chunks outside the view frustum or fully transparent.
+ *  @param  PM [in] model-view-projection matrix
+ *  @param  tfunc [in] transfer function
+ */
+/*===========================================================================*/
+void StochasticTetrahedraRenderer::Engine::BufferObject::cull(
+    const kvs::Mat4& PM,
+    const kvs::TransferFunction& tfunc )
+{
+    const auto& opacities = tfunc.opacityMap().table();
+    for ( auto& chunk : m_chunks )
+    {
+        chunk->is_culled =
+            ::IsTransparent( opacities, chunk->min_value, chunk->max_value ) ||
+            ::IsOutsideFrustum( PM, chunk->min_coord, chunk->max_coord );
+    }
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Draws the uploaded chunks that are not culled.
+ *  @param  volume [in] pointer to the volume object
+ */
+/*===========================================================================*/
 void StochasticTetrahedraRenderer::Engine::BufferObject::draw(
     const kvs::UnstructuredVolumeObject* volume )
 {
-    const size_t ncells = volume->numberOfCells();
-    kvs::VertexBufferObjectManager::Binder bind( m_manager );
-    m_manager.drawElements( GL_LINES_ADJACENCY_EXT, 4 * ncells );
+    m_ndrawn_chunks = 0;
+    for ( auto& chunk : m_chunks )
+    {
+        if ( chunk->is_culled || !chunk->isUploaded() ) { continue; }
+
+        kvs::VertexBufferObjectManager::Binder bind( chunk->manager );
+        chunk->manager.drawElements( GL_LINES_ADJACENCY_EXT, 4 * chunk->ncells );
+        m_ndrawn_chunks++;
+    }
 }
 
 void StochasticTetrahedraRenderer::Engine::RenderPass::setShaderFiles(
@@ -559,9 +993,11 @@ void StochasticTetrahedraRenderer::Engine::setup(
     kvs::Light* light )
 {
     if ( m_transfer_function_changed ) { this->update_transfer_function_texture(); }
-
     m_render_pass.setup( BaseClass::shader() );
 
+    const kvs::Mat4 PM = kvs::OpenGL::ProjectionMatrix() * kvs::OpenGL::ModelViewMatrix();
+    m_buffer_object.cull( PM, m_transfer_function );
+
     auto& shader_program = m_render_pass.shaderProgram();
     shader_program.bind();
     shader_program.setUniform( "maxT", m_preintegration_buffer.Tmax() );
@@ -637,7 +1073,7 @@ void StochasticTetrahedraRenderer::Engine::create_shader_program()
 void StochasticTetrahedraRenderer::Engine::create_buffer_object(
     const kvs::UnstructuredVolumeObject* volume )
 {
-    m_buffer_object.create( volume, m_render_pass.shaderProgram() );
+    m_buffer_object.create( volume, m_render_pass.shaderProgram(), m_upload_queue );
 }
 
 /*===========================================================================*/
@@ -660,9 +1096,9 @@ void StochasticTetrahedraRenderer::Engine::create_transfer_function_texture()
 
 void StochasticTetrahedraRenderer::Engine::update_transfer_function_texture()
 {
-    m_transfer_function_buffer.release();
-    m_preintegration_buffer.release();
-    this->create_transfer_function_texture();
+    m_transfer_function_buffer.update( m_transfer_function );
+    m_preintegration_buffer.update( m_transfer_function );
+    m_transfer_function_changed = false;
 }
 
 /*===========================================================================*/
@@ -18,8 +18,13 @@
 #include <kvs/Texture2D>
 #include <kvs/ProgramObject>
 #include <kvs/VertexBufferObjectManager>
+#include <kvs/BufferUploadQueue>
+#include <kvs/PreIntegrationTable2D>
 #include <kvs/StochasticRenderingEngine>
 #include <kvs/StochasticRendererBase>
+#include <kvs/Matrix44>
+#include <memory>
+#include <vector>
 
 
 namespace kvs
@@ -45,8 +50,13 @@ public:
     void setTransferFunction( const kvs::TransferFunction& transfer_function );
     void setSamplingStep( const float sampling_step );
     void setEdgeFactor( const float factor );
+    void setChunkSize( const size_t ncells );
+    void setUploadQueue( kvs::BufferUploadQueue* queue );
     const kvs::TransferFunction& transferFunction() const;
     float samplingStep() const;
+    size_t chunkSize() const;
+    size_t numberOfChunks() const;
+    size_t numberOfDrawnChunks() const;
     void setVertexShaderFile( const std::string& file );
     void setGeometryShaderFile( const std::string& file );
     void setFragmentShaderFile( const std::string& file );
@@ -81,6 +91,7 @@ public:
         kvs::Texture1D m_T_texture{}; ///< T function for pre-integration
         kvs::Texture1D m_T_inv_texture{}; ///< inverse function of T for pre-integration
         kvs::Real32 m_T_max = 0.0f; ///< maximum value of T
+        kvs::PreIntegrationTable2D m_table{}; ///< pre-integration table
     public:
         PreIntegrationBuffer() = default;
         virtual ~PreIntegrationBuffer() { this->release(); }
@@ -107,16 +118,40 @@ public:
 
     class BufferObject
     {
+    public:
+        struct Chunk
+        {
+            kvs::VertexBufferObjectManager manager{}; ///< vertex buffer object
+            kvs::BufferUploadQueue::RequestPointer request{}; ///< upload request
+            kvs::Vec3 min_coord{}; ///< min. coordinate of the bounding box
+            kvs::Vec3 max_coord{}; ///< max. coordinate of the bounding box
+            kvs::Real32 min_value = 0.0f; ///< min. normalized value
+            kvs::Real32 max_value = 0.0f; ///< max. normalized value
+            size_t ncells = 0; ///< number of cells
+            bool is_culled = false; ///< true if the chunk is culled
+            bool isUploaded() const { return !request || request->isCompleted(); }
+        };
+
+    private:
         const kvs::StochasticRenderingEngine* m_engine; ///< pointer to the engine
-        kvs::VertexBufferObjectManager m_manager{}; ///< vertex buffer object
+        size_t m_chunk_size = 1024 * 1024; ///< max. number of cells in a chunk
+        size_t m_ndrawn_chunks = 0; ///< number of chunks drawn in the last draw
+        std::vector<std::unique_ptr<Chunk>> m_chunks{}; ///< spatially coherent chunks
     public:
         BufferObject( const kvs::StochasticRenderingEngine* engine ): m_engine( engine ) {}
         virtual ~BufferObject() { this->release(); }
-        kvs::VertexBufferObjectManager& manager() { return m_manager; }
-        void release() { m_manager.release(); }
+        size_t chunkSize() const { return m_chunk_size; }
+        size_t numberOfChunks() const { return m_chunks.size(); }
+        size_t numberOfDrawnChunks() const { return m_ndrawn_chunks; }
+        bool isUploaded() const;
+        const Chunk& chunk( const size_t index ) const { return *m_chunks[index]; }
+        void setChunkSize( const size_t ncells ) { m_chunk_size = ncells; }
+        void release();
         void create(
             const kvs::UnstructuredVolumeObject* volume,
-            const kvs::ProgramObject& shader_program );
+            const kvs::ProgramObject& shader_program,
+            kvs::BufferUploadQueue* queue = nullptr );
+        void cull( const kvs::Mat4& PM, const kvs::TransferFunction& tfunc );
         void draw( const kvs::UnstructuredVolumeObject* volume );
     };
 
@@ -167,6 +202,7 @@ private:
     BufferObject m_buffer_object{ this }; ///< buffer object
     RenderPass m_render_pass{ m_buffer_object }; ///< render pass
     kvs::Real32 m_edge_factor = 0.0f; ///< edge enhancement factor
+    kvs::BufferUploadQueue* m_upload_queue = nullptr; ///< upload queue (reference)
 
 public:
     Engine() = default;
@@ -176,8 +212,11 @@ public:
     void update( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
     void setup( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
     void draw( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
+    bool isReady() const { return m_buffer_object.isUploaded(); }
 
     void setEdgeFactor( const float factor ) { m_edge_factor = factor; }
+    void setChunkSize( const size_t ncells ) { m_buffer_object.setChunkSize( ncells ); }
+    void setUploadQueue( kvs::BufferUploadQueue* queue ) { m_upload_queue = queue; }
     void setSamplingStep( const float step ) { m_render_pass.setSamplingStep( step ); }
     void setTransferFunction( const kvs::TransferFunction& transfer_function )
     {
@@ -187,6 +226,9 @@ public:
 
     float samplingStep() const { return m_render_pass.samplingStep(); }
     const kvs::TransferFunction& transferFunction() const { return m_transfer_function; }
+    size_t chunkSize() const { return m_buffer_object.chunkSize(); }
+    size_t numberOfChunks() const { return m_buffer_object.numberOfChunks(); }
+    size_t numberOfDrawnChunks() const { return m_buffer_object.numberOfDrawnChunks(); }
 
     const std::string& vertexShaderFile() const { return m_render_pass.vertexShaderFile(); }
     const std::string& geometryShaderFile() const { return m_render_pass.geometryShaderFile(); }
@@ -69,6 +69,28 @@ void StochasticUniformGridRenderer::setSamplingStep( const float step )
     static_cast<Engine&>( engine() ).setSamplingStep( step );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a flag for the precomputed gradient texture.
+ *  @param  enable [in] if true, the gradient is read from the texture built on the CPU
+ */
+/*===========================================================================*/
+void StochasticUniformGridRenderer::setGradientTextureEnabled( const bool enable )
+{
+    static_cast<Engine&>( engine() ).setGradientTextureEnabled( enable );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a flag for the cubic B-spline reconstruction.
+ *  @param  enable [in] if true, the values are reconstructed with the cubic B-spline
+ */
+/*===========================================================================*/
+void StochasticUniformGridRenderer::setCubicFilterEnabled( const bool enable )
+{
+    static_cast<Engine&>( engine() ).setCubicFilterEnabled( enable );
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Sets a transfer function.
@@ -221,6 +243,10 @@ void StochasticUniformGridRenderer::Engine::setup(
         m_transfer_function_texture.setPixelFormat( GL_RGBA32F_ARB, GL_RGBA, GL_FLOAT  );
         m_transfer_function_texture.create( width, table.data() );
         m_transfer_function_changed = false;
+
+        // Only the range uniforms are updated for the new transfer function.
+        auto& shader = m_render_pass.shaderProgram();
+        m_volume_buffer.setupTransferFunctionRange( shader, m_transfer_function );
     }
 
     this->setup_shader_program( BaseClass::shader(), object, camera, light );
@@ -262,6 +288,7 @@ void StochasticUniformGridRenderer::Engine::create_shader_program(
     shader.setUniform( "entry_points", 2 );
     shader.setUniform( "transfer_function_data", 3 );
     shader.setUniform( "random_texture", 4 );
+    if ( m_volume_buffer.isGradientTextureEnabled() ) { shader.setUniform( "gradient_data", 5 ); }
 }
 
 /*===========================================================================*/
@@ -380,7 +407,7 @@ void StochasticUniformGridRenderer::Engine::update_framebuffer(
 void StochasticUniformGridRenderer::Engine::create_buffer_object(
     const kvs::StructuredVolumeObject* volume )
 {
-    m_volume_buffer.create( volume, this->transferFunction() );
+    m_volume_buffer.create( volume );
     m_bounding_cube_buffer.create( volume );
 
     // Set uniform variables.
@@ -388,76 +415,15 @@ void StochasticUniformGridRenderer::Engine::create_buffer_object(
     const kvs::Real32 max_ngrids = kvs::Math::Max( r.x(), r.y(), r.z() );
     const kvs::Vec3 ratio( r.x() / max_ngrids, r.y() / max_ngrids, r.z() / max_ngrids );
     const kvs::Vec3 reciprocal( 1.0f / r.x(), 1.0f / r.y(), 1.0f / r.z() );
-    kvs::Real32 min_range = 0.0f;
-    kvs::Real32 max_range = 0.0f;
-    kvs::Real32 min_value = this->transferFunction().colorMap().minValue();
-    kvs::Real32 max_value = this->transferFunction().colorMap().maxValue();
-    const std::type_info& type = volume->values().typeInfo()->type();
-    if ( type == typeid( kvs::UInt8 ) )
-    {
-        min_range = 0.0f;
-        max_range = 255.0f;
-        if ( !this->transferFunction().hasRange() )
-        {
-            min_value = 0.0f;
-            max_value = 255.0f;
-        }
-    }
-    else if ( type == typeid( kvs::Int8 ) )
-    {
-        min_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt8>::Min() );
-        max_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt8>::Max() );
-        if ( !this->transferFunction().hasRange() )
-        {
-            min_value = -128.0f;
-            max_value = 127.0f;
-        }
-    }
-    else if ( type == typeid( kvs::UInt16 ) )
-    {
-        min_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt16>::Min() );
-        max_range = static_cast<kvs::Real32>( kvs::Value<kvs::UInt16>::Max() );
-        if ( !this->transferFunction().hasRange() )
-        {
-            min_value = static_cast<kvs::Real32>( volume->minValue() );
-            max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        }
-    }
-    else if ( type == typeid( kvs::Int16 ) )
-    {
-        min_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int16>::Min() );
-        max_range = static_cast<kvs::Real32>( kvs::Value<kvs::Int16>::Max() );
-        if ( !this->transferFunction().hasRange() )
-        {
-            min_value = static_cast<kvs::Real32>( volume->minValue() );
-            max_value = static_cast<kvs::Real32>( volume->maxValue() );
-        }
-    }
-    else if ( type == typeid( kvs::UInt32 ) ||
-              type == typeid( kvs::Int32  ) ||
-              type == typeid( kvs::Real32 ) ||
-              type == typeid( kvs::Real64 ) )
-    {
-        min_range = 0.0f;
-        max_range = 1.0f;
-        min_value = 0.0f;
-        max_value = 1.0f;
-    }
-    else
-    {
-        kvsMessageError( "Not supported data type '%s'.",
-                         volume->values().typeInfo()->typeName() );
-    }
 
     auto& shader = m_render_pass.shaderProgram();
+    m_volume_buffer.setupRange( shader );
+    m_volume_buffer.setupTransferFunctionRange( shader, this->transferFunction() );
+
     kvs::ProgramObject::Binder bind( shader );
     shader.setUniform( "volume.resolution", r );
     shader.setUniform( "volume.resolution_ratio", ratio );
     shader.setUniform( "volume.resolution_reciprocal", reciprocal );
-    shader.setUniform( "volume.min_range", min_range );
-    shader.setUniform( "volume.max_range", max_range );
-    shader.setUniform( "transfer_function.min_value", min_value );
-    shader.setUniform( "transfer_function.max_value", max_value );
 }
 
 /*===========================================================================*/
@@ -495,7 +461,13 @@ void StochasticUniformGridRenderer::Engine::draw_buffer_object(
     kvs::Texture::Binder unit2( m_entry_texture, 2 );
     kvs::Texture::Binder unit3( m_transfer_function_texture, 3 );
     kvs::Texture::Binder unit4( BaseClass::randomTexture(), 4 );
+
+    // The gradient texture is created and declared in the shader only if the
+    // precomputed gradient is enabled.
+    const bool enable_gradient = m_volume_buffer.isGradientTextureEnabled();
+    if ( enable_gradient ) { kvs::Texture::Bind( m_volume_buffer.gradientTexture(), 5 ); }
     m_volume_buffer.draw();
+    if ( enable_gradient ) { kvs::Texture::Unbind( m_volume_buffer.gradientTexture(), 5 ); }
 }
 
 } // end of namespace kvs
@@ -39,6 +39,12 @@ public:
     StochasticUniformGridRenderer();
     void setEdgeFactor( const float factor );
     void setSamplingStep( const float step );
+    void setGradientTextureEnabled( const bool enable = true );
+    void setCubicFilterEnabled( const bool enable = true );
+    void enableGradientTexture() { this->setGradientTextureEnabled( true ); }
+    void disableGradientTexture() { this->setGradientTextureEnabled( false ); }
+    void enableCubicFilter() { this->setCubicFilterEnabled( true ); }
+    void disableCubicFilter() { this->setCubicFilterEnabled( false ); }
     void setTransferFunction( const kvs::TransferFunction& transfer_function );
     const kvs::TransferFunction& transferFunction() const;
     float samplingStep() const;
@@ -96,6 +102,8 @@ public:
 
     void setEdgeFactor( const float factor ) { m_edge_factor = factor; }
     void setSamplingStep( const float step ) { m_step = step; }
+    void setGradientTextureEnabled( const bool enable = true ) { m_volume_buffer.setGradientTextureEnabled( enable ); }
+    void setCubicFilterEnabled( const bool enable = true ) { m_render_pass.setCubicFilterEnabled( enable ); }
     void setTransferFunction( const kvs::TransferFunction& transfer_function )
     {
         m_transfer_function = transfer_function;
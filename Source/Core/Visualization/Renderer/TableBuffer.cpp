@@ -0,0 +1,210 @@
+/*****************************************************************************/
+/**
+ *  @file   TableBuffer.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#include "TableBuffer.h"
+#include <kvs/OpenMP>
+#include <kvs/Math>
+#include <kvs/ValueArray>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Max. width of the flag texture in texels.
+ */
+/*===========================================================================*/
+const size_t MaxFlagTextureWidth = 4096;
+
+/*===========================================================================*/
+/**
+ *  @brief  Functor to normalize the column values to 16-bit unsigned integers.
+ */
+/*===========================================================================*/
+struct Normalize
+{
+    size_t nrows;
+    kvs::Real64 min_value;
+    kvs::Real64 max_value;
+    kvs::UInt16* normalized_values;
+
+    template <typename T>
+    void operator ()( const T* values ) const
+    {
+        const kvs::Real64 range = max_value - min_value;
+        const kvs::Real64 scale = range > 0.0 ? 65535.0 / range : 0.0;
+        const long n = static_cast<long>( nrows );
+        KVS_OMP_PARALLEL_FOR( schedule(static) )
+        for ( long i = 0; i < n; i++ )
+        {
+            const kvs::Real64 t = ( static_cast<kvs::Real64>( values[i] ) - min_value ) * scale;
+            // NaN is mapped to zero.
+            normalized_values[i] = !( t > 0.0 ) ? 0 : t >= 65535.0 ? 65535 : static_cast<kvs::UInt16>( t + 0.5 );
+        }
+    }
+};
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the instanced rendering is available (OpenGL 3.3 or later).
+ *  @return true if glDrawArraysInstanced and glVertexAttribDivisor are available
+ */
+/*===========================================================================*/
+bool TableBuffer::IsSupported()
+{
+#if defined( GL_VERSION_3_3 )
+    static const bool supported = std::atof( kvs::OpenGL::Version().c_str() ) >= 3.3;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the GLSL function to test the inside-range flag of the row.
+ *  @return shader code of 'bool InsideRange( sampler2D, int, int )'
+ *
+ *  The flags are packed in the MSB-first order as in kvs::BitArray. The code
+ *  requires GL_EXT_gpu_shader4 for the integer operations and texelFetch2D.
+ */
+/*===========================================================================*/
+std::string TableBuffer::InsideRangeFunction()
+{
+    return
+        "bool InsideRange( sampler2D flag_texture, int flag_texture_width, int row )\n"
+        "{\n"
+        "    int index = row / 8;\n"
+        "    ivec2 texel = ivec2( index % flag_texture_width, index / flag_texture_width );\n"
+        "    int flags = int( texelFetch2D( flag_texture, texel, 0 ).r * 255.0 + 0.5 );\n"
+        "    return ( ( flags >> ( 7 - row % 8 ) ) & 1 ) != 0;\n"
+        "}\n";
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Updates the buffers if the table is changed.
+ *  @param  table [in] pointer to the table object
+ */
+/*===========================================================================*/
+void TableBuffer::update( const kvs::TableObject* table )
+{
+    this->update_columns( table );
+    this->update_flags( table );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the buffers.
+ */
+/*===========================================================================*/
+void TableBuffer::release()
+{
+    m_column_buffer.release();
+    m_flag_texture.release();
+    m_flags.release();
+    m_min_values.clear();
+    m_max_values.clear();
+    m_table = nullptr;
+    m_nrows = 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the column as the vertex attribute of the bound column buffer.
+ *  @param  location [in] location of the vertex attribute
+ *  @param  column_index [in] column index
+ */
+/*===========================================================================*/
+void TableBuffer::setColumnPointer( const GLint location, const size_t column_index ) const
+{
+    if ( location < 0 ) { return; }
+    const size_t offset = column_index * m_nrows * sizeof( kvs::UInt16 );
+    kvs::OpenGL::VertexAttribPointer( location, 1, GL_UNSIGNED_SHORT, GL_TRUE, 0, (const GLvoid*)( offset ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Uploads the normalized values of the columns if the table is changed.
+ *  @param  table [in] pointer to the table object
+ */
+/*===========================================================================*/
+void TableBuffer::update_columns( const kvs::TableObject* table )
+{
+    const size_t nrows = table->numberOfRows();
+    const size_t ncolumns = table->numberOfColumns();
+    const size_t size = nrows * ncolumns * sizeof( kvs::UInt16 );
+    if ( m_table == table &&
+         m_column_buffer.size() == size &&
+         m_min_values == table->minValues() &&
+         m_max_values == table->maxValues() ) { return; }
+
+    kvs::ValueArray<kvs::UInt16> values( nrows * ncolumns );
+    for ( size_t j = 0; j < ncolumns; j++ )
+    {
+        ::Normalize normalize = {
+            nrows, table->minValue(j), table->maxValue(j), values.data() + j * nrows };
+        table->visitColumn( j, normalize );
+    }
+
+    m_column_buffer.release();
+    m_column_buffer.setUsage( GL_STATIC_DRAW );
+    m_column_buffer.create( size, values.data() );
+
+    m_table = table;
+    m_nrows = nrows;
+    m_min_values = table->minValues();
+    m_max_values = table->maxValues();
+    m_flags.release();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Uploads the inside-range flags if the flags are changed.
+ *  @param  table [in] pointer to the table object
+ */
+/*===========================================================================*/
+void TableBuffer::update_flags( const kvs::TableObject* table )
+{
+    const auto& flags = table->insideRangeFlags();
+    const size_t nbytes = flags.byteSize();
+    if ( m_flags.size() == flags.size() &&
+         std::memcmp( m_flags.data(), flags.data(), nbytes ) == 0 ) { return; }
+
+    const size_t max_width = static_cast<size_t>( kvs::OpenGL::Integer( GL_MAX_TEXTURE_SIZE ) );
+    const size_t width = kvs::Math::Max( size_t(1), kvs::Math::Min( ::MaxFlagTextureWidth, max_width, nbytes ) );
+    const size_t height = kvs::Math::Max( size_t(1), ( nbytes + width - 1 ) / width );
+    if ( m_flag_texture.width() != width || m_flag_texture.height() != height )
+    {
+        m_flag_texture.release();
+        m_flag_texture.setWrapS( GL_CLAMP_TO_EDGE );
+        m_flag_texture.setWrapT( GL_CLAMP_TO_EDGE );
+        m_flag_texture.setMagFilter( GL_NEAREST );
+        m_flag_texture.setMinFilter( GL_NEAREST );
+        m_flag_texture.setPixelFormat( GL_R8, GL_RED, GL_UNSIGNED_BYTE );
+        m_flag_texture.create( width, height );
+    }
+
+    // The last row of the texture is partially loaded.
+    kvs::Texture::GuardedBinder binder( m_flag_texture );
+    const size_t nfull_rows = nbytes / width;
+    if ( nfull_rows > 0 ) { m_flag_texture.load( width, nfull_rows, flags.data() ); }
+    const size_t remainder = nbytes - nfull_rows * width;
+    if ( remainder > 0 ) { m_flag_texture.load( remainder, 1, flags.data() + nfull_rows * width, 0, nfull_rows ); }
+
+    m_flags = flags.clone();
+}
+
+} // end of namespace kvs
@@ -0,0 +1,63 @@
+/*****************************************************************************/
+/**
+ *  @file   TableBuffer.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <string>
+#include <kvs/TableObject>
+#include <kvs/BitArray>
+#include <kvs/VertexBufferObject>
+#include <kvs/Texture2D>
+#include <kvs/Noncopyable>
+#include <kvs/OpenGL>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  GPU buffers of the table object for the instanced rendering.
+ *
+ *  The column values normalized by the min. and max. values are stored as
+ *  16-bit unsigned integers column by column in a vertex buffer object, so
+ *  that any column can be referred to as an instanced vertex attribute. The
+ *  inside-range flags are stored as the packed bits in a 8-bit texture, so
+ *  that brushing the table does not need to re-upload the columns.
+ */
+/*===========================================================================*/
+class TableBuffer : public kvs::Noncopyable
+{
+private:
+    const kvs::TableObject* m_table = nullptr; ///< pointer to the loaded table (reference)
+    kvs::TableObject::Values m_min_values{}; ///< min. values used for the normalization
+    kvs::TableObject::Values m_max_values{}; ///< max. values used for the normalization
+    kvs::BitArray m_flags{}; ///< inside-range flags loaded to the flag texture
+    size_t m_nrows = 0; ///< number of rows
+    kvs::VertexBufferObject m_column_buffer{}; ///< normalized values of the columns
+    kvs::Texture2D m_flag_texture{}; ///< packed inside-range flags of the rows
+
+public:
+    static bool IsSupported();
+    static std::string InsideRangeFunction();
+
+public:
+    TableBuffer() = default;
+    virtual ~TableBuffer() { this->release(); }
+
+    size_t numberOfRows() const { return m_nrows; }
+    const kvs::VertexBufferObject& columnBuffer() const { return m_column_buffer; }
+    const kvs::Texture2D& flagTexture() const { return m_flag_texture; }
+
+    void update( const kvs::TableObject* table );
+    void release();
+    void setColumnPointer( const GLint location, const size_t column_index ) const;
+
+private:
+    void update_columns( const kvs::TableObject* table );
+    void update_flags( const kvs::TableObject* table );
+};
+
+} // end of namespace kvs
@@ -0,0 +1,188 @@
+/*****************************************************************************/
+/**
+ *  @file   WeightedBlendedBuffer.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#include "WeightedBlendedBuffer.h"
+#include <kvs/OpenGL>
+
+
+namespace
+{
+
+inline void Draw()
+{
+    kvs::OpenGL::WithPushedMatrix p1( GL_MODELVIEW );
+    p1.loadIdentity();
+    {
+        kvs::OpenGL::WithPushedMatrix p2( GL_PROJECTION );
+        p2.loadIdentity();
+        {
+            kvs::OpenGL::SetOrtho( 0, 1, 0, 1, -1, 1 );
+            kvs::OpenGL::Begin( GL_QUADS );
+            kvs::OpenGL::TexCoordVertex( kvs::Vec2( 0, 0 ), kvs::Vec2( 0, 0 ) );
+            kvs::OpenGL::TexCoordVertex( kvs::Vec2( 1, 0 ), kvs::Vec2( 1, 0 ) );
+            kvs::OpenGL::TexCoordVertex( kvs::Vec2( 1, 1 ), kvs::Vec2( 1, 1 ) );
+            kvs::OpenGL::TexCoordVertex( kvs::Vec2( 0, 1 ), kvs::Vec2( 0, 1 ) );
+            kvs::OpenGL::End();
+        }
+    }
+}
+
+inline void SetupTexture( kvs::Texture2D& texture )
+{
+    texture.setWrapS( GL_CLAMP_TO_EDGE );
+    texture.setWrapT( GL_CLAMP_TO_EDGE );
+    texture.setMagFilter( GL_NEAREST );
+    texture.setMinFilter( GL_NEAREST );
+}
+
+}
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the framebuffer.
+ *  @param  width [in] framebuffer width
+ *  @param  height [in] framebuffer height
+ */
+/*===========================================================================*/
+void WeightedBlendedBuffer::create( const size_t width, const size_t height )
+{
+    this->release();
+    m_width = width;
+    m_height = height;
+
+    // The accumulated values can exceed the range of the half float, since
+    // the weight is up to 3e3 for the fragments close to the viewer.
+    ::SetupTexture( m_accum_texture );
+    m_accum_texture.setPixelFormat( GL_RGBA32F_ARB, GL_RGBA, GL_FLOAT );
+    m_accum_texture.create( width, height );
+
+    ::SetupTexture( m_weight_texture );
+    m_weight_texture.setPixelFormat( GL_R32F, GL_RED, GL_FLOAT );
+    m_weight_texture.create( width, height );
+
+    ::SetupTexture( m_depth_texture );
+    m_depth_texture.setPixelFormat( GL_DEPTH_COMPONENT, GL_DEPTH_COMPONENT, GL_FLOAT );
+    m_depth_texture.create( width, height );
+
+    m_framebuffer.create();
+    m_framebuffer.attachColorTexture( m_accum_texture, 0 );
+    m_framebuffer.attachColorTexture( m_weight_texture, 1 );
+    m_framebuffer.attachDepthTexture( m_depth_texture );
+
+    const std::string vert(
+        "void main()"
+        "{"
+        "    gl_TexCoord[0] = gl_Vertex;"
+        "    gl_Position = vec4( gl_Vertex.xy * 2.0 - 1.0, 0.0, 1.0 );"
+        "}"
+        );
+
+    const std::string frag(
+        "uniform sampler2D accum_buffer;"
+        "uniform sampler2D weight_buffer;"
+        "void main()"
+        "{"
+        "    vec2 p = gl_TexCoord[0].xy;"
+        "    vec4 accum = texture2D( accum_buffer, p );"
+        "    float revealage = accum.a;"
+        "    if ( revealage >= 1.0 ) { discard; }"
+        "    float weight = texture2D( weight_buffer, p ).r;"
+        "    vec3 color = accum.rgb / max( weight, 1.0e-5 );"
+        "    gl_FragColor = vec4( color, 1.0 - revealage );"
+        "}"
+        );
+
+    m_composite_shader.build( vert, frag );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the buffer resources.
+ */
+/*===========================================================================*/
+void WeightedBlendedBuffer::release()
+{
+    m_accum_texture.release();
+    m_weight_texture.release();
+    m_depth_texture.release();
+    m_framebuffer.release();
+    m_composite_shader.release();
+    m_width = 0;
+    m_height = 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Binds the buffer for accumulating the transparent fragments.
+ *
+ *  The depth buffer of the current framebuffer is copied to the buffer, and
+ *  the depth test without depth writing and the blending for the weighted
+ *  sum and the product of the transmittances are enabled until unbind().
+ */
+/*===========================================================================*/
+void WeightedBlendedBuffer::bind()
+{
+    {
+        kvs::Texture::Binder unit( m_depth_texture );
+        m_depth_texture.loadFromFrameBuffer( 0, 0, m_width, m_height );
+    }
+
+    kvs::OpenGL::PushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_ENABLE_BIT );
+    m_framebuffer.bind();
+
+    const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    kvs::OpenGL::SetDrawBuffers( 2, buffers );
+
+    // The weight buffer has only red component, so that both of the buffers
+    // can be cleared by (0,0,0,1), where the revealage is initialized to 1.
+    kvs::OpenGL::SetClearColor( kvs::Vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+    kvs::OpenGL::Clear( GL_COLOR_BUFFER_BIT );
+
+    // RGB: sum of C*a*w, A: product of (1-a) for the accumulation buffer, and
+    // R: sum of a*w for the weight buffer.
+    kvs::OpenGL::Enable( GL_DEPTH_TEST );
+    kvs::OpenGL::SetDepthMask( GL_FALSE );
+    kvs::OpenGL::Enable( GL_BLEND );
+    kvs::OpenGL::SetBlendFuncSeparate( GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Unbinds the buffer.
+ */
+/*===========================================================================*/
+void WeightedBlendedBuffer::unbind()
+{
+    m_framebuffer.unbind();
+    kvs::OpenGL::PopAttrib();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Composites the accumulated fragments over the current framebuffer.
+ */
+/*===========================================================================*/
+void WeightedBlendedBuffer::draw()
+{
+    kvs::OpenGL::WithPushedAttrib p( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_ENABLE_BIT );
+    kvs::OpenGL::Disable( GL_DEPTH_TEST );
+    kvs::OpenGL::Disable( GL_LIGHTING );
+    kvs::OpenGL::SetDepthMask( GL_FALSE );
+    kvs::OpenGL::Enable( GL_BLEND );
+    kvs::OpenGL::SetBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+    kvs::Texture::Binder tex0( m_accum_texture, 0 );
+    kvs::Texture::Binder tex1( m_weight_texture, 1 );
+    kvs::ProgramObject::Binder shader( m_composite_shader );
+    m_composite_shader.setUniform( "accum_buffer", 0 );
+    m_composite_shader.setUniform( "weight_buffer", 1 );
+    ::Draw();
+}
+
+} // end of namespace kvs
@@ -0,0 +1,57 @@
+/*****************************************************************************/
+/**
+ *  @file   WeightedBlendedBuffer.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#pragma once
+#include <kvs/Texture2D>
+#include <kvs/FrameBufferObject>
+#include <kvs/ProgramObject>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Buffer class for the weighted blended order-independent transparency.
+ *
+ *  The transparent fragments are accumulated in a single geometry pass into
+ *  the accumulation buffer (RGB: sum of the weighted premultiplied colors, A:
+ *  revealage, i.e. product of the transmittances) and the weight buffer (sum
+ *  of the weighted opacities), and then composited over the current
+ *  framebuffer. The depth buffer of the current framebuffer is copied before
+ *  the accumulation, so that the transparent fragments are occluded by the
+ *  opaque geometries and the volumes already drawn.
+ */
+/*===========================================================================*/
+class WeightedBlendedBuffer
+{
+private:
+    size_t m_width = 0; ///< framebuffer width
+    size_t m_height = 0; ///< framebuffer height
+    kvs::Texture2D m_accum_texture{}; ///< accumulation buffer
+    kvs::Texture2D m_weight_texture{}; ///< weight buffer
+    kvs::Texture2D m_depth_texture{}; ///< depth buffer
+    kvs::FrameBufferObject m_framebuffer{}; ///< framebuffer for the accumulation
+    kvs::ProgramObject m_composite_shader{}; ///< shader for the composition
+
+public:
+    WeightedBlendedBuffer() = default;
+    virtual ~WeightedBlendedBuffer() { this->release(); }
+
+    size_t width() const { return m_width; }
+    size_t height() const { return m_height; }
+    bool isCreated() const { return m_framebuffer.isCreated(); }
+    const kvs::Texture2D& accumTexture() const { return m_accum_texture; }
+    const kvs::Texture2D& weightTexture() const { return m_weight_texture; }
+
+    void create( const size_t width, const size_t height );
+    void release();
+    void bind();
+    void unbind();
+    void draw();
+};
+
+} // end of namespace kvs
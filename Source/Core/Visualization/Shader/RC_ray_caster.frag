@@ -11,6 +11,10 @@
 #include "qualifire.h"
 #include "texture.h"
 
+#if defined( ENABLE_LAMBERT_SHADING ) || defined( ENABLE_PHONG_SHADING ) || defined( ENABLE_BLINN_PHONG_SHADING )
+#define ENABLE_SHADING
+#endif
+
 
 // Input parameters.
 FragIn vec3 position_ndc;
@@ -25,10 +29,25 @@ uniform vec3 light_position; // light position in the object coordinate
 uniform vec3 camera_position; // camera position in the object coordinate
 uniform VolumeParameter volume; // volume parameter
 uniform sampler3D volume_data; // volume data
+#if defined( ENABLE_GRADIENT_TEXTURE )
+uniform sampler3D gradient_data; // precomputed gradient data
+uniform float gradient_scale; // max. magnitude of the gradient
+#endif
 uniform ShadingParameter shading; // shading parameter
 uniform TransferFunctionParameter transfer_function; // transfer function
 uniform sampler1D transfer_function_data; // 1D transfer function data
 uniform sampler2D jittering_texture; // texture for jittering
+#if defined( ENABLE_ADAPTIVE_SAMPLING )
+uniform sampler3D opacity_volume; // max. opacity in each block
+uniform vec3 opacity_volume_scale; // reciprocal number of the voxels covered by the opacity volume
+uniform float block_size; // number of the voxels per block edge
+uniform float min_step_scale; // min. ratio of the step to the sampling step
+uniform float max_step_scale; // max. ratio of the step to the sampling step
+uniform float opacity_tolerance; // max. opacity accumulated in a step
+#endif
+#if defined( ENABLE_RAY_STATISTICS )
+uniform bool statistics_pass; // if true, the ray statistics are output instead of the color
+#endif
 uniform float width; // screen width
 uniform float height; // screen height
 uniform sampler2D depth_texture; // depth texture for depth buffer
@@ -89,6 +108,73 @@ vec3 NDC2Obj( const in vec3 ndc )
     return temp.xyz / temp.w;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns a value of the volume data.
+ *  @param  volume_index [in] volume index
+ *  @return value in [0,1] of the texture
+ */
+/*===========================================================================*/
+float VolumeValue( in vec3 volume_index )
+{
+#if defined( ENABLE_CUBIC_BSPLINE_FILTER )
+    return CubicBSpline3D( volume_data, volume_index, volume.resolution, volume.resolution_reciprocal ).w;
+#else
+    return LookupTexture3D( volume_data, volume_index ).w;
+#endif
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a gradient vector of the volume data.
+ *  @param  volume_index [in] volume index
+ *  @return gradient vector in object coordinate
+ */
+/*===========================================================================*/
+vec3 Gradient( in vec3 volume_index )
+{
+#if defined( ENABLE_GRADIENT_TEXTURE )
+    return VolumeGradientTexture( gradient_data, volume_index, gradient_scale );
+#else
+    return VolumeGradient( volume_data, volume_index, volume.resolution_reciprocal );
+#endif
+}
+
+#if defined( ENABLE_ADAPTIVE_SAMPLING )
+/*===========================================================================*/
+/**
+ *  @brief  Returns the ratio of the step length to the sampling step.
+ *  @param  position [in] sampling point in the voxel coordinate
+ *  @param  direction [in] ray direction scaled by the sampling step
+ *  @return step scale
+ *
+ *  The step is chosen so that the opacity accumulated over the step does not
+ *  exceed the tolerance for the max. opacity in the block. The step is not
+ *  extended beyond the block boundary, so that the next block is not skipped.
+ */
+/*===========================================================================*/
+float StepScale( in vec3 position, in vec3 direction )
+{
+    float a = LookupTexture3D( opacity_volume, position * opacity_volume_scale ).a;
+
+    float k = max_step_scale;
+    if ( a >= 1.0 ) { k = min_step_scale; }
+    else if ( a > 0.0 )
+    {
+        // 1 - (1 - a)^k = tolerance
+        k = clamp( log( 1.0 - opacity_tolerance ) / log( 1.0 - a ), min_step_scale, max_step_scale );
+    }
+
+    // Distance to the block boundary in the number of the sampling steps.
+    vec3 b = floor( position / block_size ) * block_size;
+    vec3 e = mix( position - b, b + vec3( block_size ) - position, step( 0.0, direction ) );
+    vec3 t = e / max( abs( direction ), vec3( 1.0e-6 ) );
+    float t_exit = min( min( t.x, t.y ), t.z );
+
+    return min( k, max( t_exit, 1.0 ) );
+}
+#endif
+
 /*===========================================================================*/
 /**
  *  @brief  Main function of fragment shader.
@@ -129,6 +215,9 @@ void main()
     float dt = sampling_step;
     int nsteps = int( floor( segment / dt ) );
 #endif
+#if defined( ENABLE_ADAPTIVE_SAMPLING )
+    nsteps = int( ceil( float( nsteps ) / min_step_scale ) );
+#endif
 
     // Ray direction.
     vec3 direction = dt * normalize( exit_point - entry_point );
@@ -146,8 +235,20 @@ void main()
     float depth = 1.0;
     float w = 0.0;
     float dd = dt / segment;
-    for ( int i = 0; i < nsteps; i++, w += dd )
+    float step_scale = 1.0;
+#if defined( ENABLE_RAY_STATISTICS )
+    float nsamples = 0.0;
+    float terminated = 0.0;
+    float occluded = 0.0;
+#endif
+    for ( int i = 0; i < nsteps; i++ )
     {
+#if defined( ENABLE_ADAPTIVE_SAMPLING )
+        if ( w >= 1.0 ) { break; }
+#endif
+#if defined( ENABLE_RAY_STATISTICS )
+        nsamples += 1.0;
+#endif
         // Get the scalar value from the 3D texture.
         // NOTE: The volume index which is a index to access the volume data
         // represented as 3D texture can be calculate as follows:
@@ -158,8 +259,8 @@ void main()
         //
         // where, I: volume index, P: sampling point, R: volume resolution.
         vec3 volume_index = vec3( ( position + vec3(0.5) ) / volume.resolution );
-        vec4 value = LookupTexture3D( volume_data, volume_index );
-        float scalar = mix( volume.min_range, volume.max_range, value.w );
+        float value = VolumeValue( volume_index );
+        float scalar = mix( volume.min_range, volume.max_range, value );
 
         // Get the source color from the transfer function.
         float tfunc_index = ( scalar - transfer_function.min_value ) * tfunc_scale;
@@ -169,16 +270,24 @@ void main()
         c.a = 1.0 - pow( 1.0 - c.a, dT );
 #endif
 
+#if defined( ENABLE_ADAPTIVE_SAMPLING )
+        // Opacity correction for the step length.
+        step_scale = StepScale( position, direction );
+        c.a = 1.0 - pow( 1.0 - c.a, step_scale );
+#endif
+
         float d = RayDepth( w, entry_depth, exit_depth );
         if ( c.a != 0.0 )
         {
-            // Get the normal vector in object coordinate.
-            vec3 offset_index = vec3( volume.resolution_reciprocal );
-            vec3 normal = VolumeGradient( volume_data, volume_index, offset_index );
+#if defined( ENABLE_SHADING )
+            // Get the normal vector in object coordinate. The gradient is
+            // not needed without shading.
+            vec3 normal = Gradient( volume_index );
 
             // Light vector (L) and normal vector (N) in camera coordinate.
             vec3 L = normalize( light_position - position );
             vec3 N = normalize( gl_NormalMatrix * normal );
+#endif
 
 #if   defined( ENABLE_LAMBERT_SHADING )
             c.rgb = ShadingLambert( shading, c.rgb, L, N );
@@ -204,6 +313,9 @@ void main()
             if ( color.a > opaque )
             {
                 color.a = 1.0;
+#if defined( ENABLE_RAY_STATISTICS )
+                terminated = 1.0;
+#endif
                 break; // break
             }
         }
@@ -215,11 +327,26 @@ void main()
             color.rgb += ( 1.0 - color.a ) * color0.rgb;
             color.a = 1.0;
             depth = d;
+#if defined( ENABLE_RAY_STATISTICS )
+            occluded = 1.0;
+#endif
             break;
         }
 
-        position += direction;
+        position += step_scale * direction;
+        w += step_scale * dd;
+    }
+
+#if defined( ENABLE_RAY_STATISTICS )
+    // Number of the samples, flags for the early ray termination and the
+    // occlusion by the geometries for each ray.
+    if ( statistics_pass )
+    {
+        gl_FragColor = vec4( nsamples, terminated, occluded, 1.0 );
+        gl_FragDepth = depth;
+        return;
     }
+#endif
 
     gl_FragColor = color;
     gl_FragDepth = depth;
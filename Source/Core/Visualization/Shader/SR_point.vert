@@ -6,10 +6,16 @@
 /*****************************************************************************/
 #version 120
 #include "qualifire.h"
+#include "texture.h"
 
 
 // Input parameter from OpenGL.
+#if defined( ENABLE_COMPRESSED_POINTS )
+VertIn vec2 packed_normal; // octahedral-encoded normal vector in [0,1]
+VertIn float color_index; // index to the color palette in [0,1]
+#else
 VertIn vec2 random_index; // index for accessing to the random texture
+#endif
 
 // Output parameters to fragment shader.
 VertOut vec3 position; // vertex position in camera coordinate
@@ -21,6 +27,31 @@ uniform mat4 ModelViewMatrix; // model-view matrix
 uniform mat4 ModelViewProjectionMatrix; // model-view projection matrix
 uniform mat3 NormalMatrix; // normal matrix
 
+#if defined( ENABLE_COMPRESSED_POINTS )
+uniform vec3 block_min_coord; // min. coordinate of the block
+uniform vec3 block_extent; // extent of the bounding box of the block
+uniform sampler1D palette_texture; // color palette
+uniform float random_texture_size_inv; // reciprocal value of the random texture size
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the normal vector decoded by the octahedral mapping.
+ *  @param  e [in] encoded normal vector in [0,1]
+ *  @return normal vector
+ */
+/*===========================================================================*/
+vec3 DecodeNormal( in vec2 e )
+{
+    vec2 f = e * 2.0 - 1.0;
+    vec3 n = vec3( f, 1.0 - abs( f.x ) - abs( f.y ) );
+    float t = max( -n.z, 0.0 );
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize( n );
+}
+#endif
+
 
 /*===========================================================================*/
 /**
@@ -29,10 +60,26 @@ uniform mat3 NormalMatrix; // normal matrix
 /*===========================================================================*/
 void main()
 {
+#if defined( ENABLE_COMPRESSED_POINTS )
+    // The quantized coordinate is given as the signed short in gl_Vertex.
+    vec3 q = gl_Vertex.xyz + 32768.0;
+    vec4 vertex = vec4( block_min_coord + q / 65535.0 * block_extent, 1.0 );
+
+    gl_Position = ModelViewProjectionMatrix * vertex;
+    gl_FrontColor = vec4( LookupTexture1D( palette_texture, ( color_index * 255.0 + 0.5 ) / 256.0 ).rgb, 1.0 );
+
+    position = ( ModelViewMatrix * vertex ).xyz;
+    normal = NormalMatrix * DecodeNormal( packed_normal );
+
+    // Hash of the quantized coordinate instead of the per-vertex random index.
+    float size = 1.0 / random_texture_size_inv;
+    index = floor( mod( vec2( dot( q, vec3( 1.0, 7.0, 13.0 ) ), dot( q, vec3( 11.0, 3.0, 5.0 ) ) ), size ) );
+#else
     gl_Position = ModelViewProjectionMatrix * gl_Vertex;
     gl_FrontColor = gl_Color;
 
     position = ( ModelViewMatrix * gl_Vertex ).xyz;
     normal = NormalMatrix * gl_Normal;
     index = random_index;
+#endif
 }
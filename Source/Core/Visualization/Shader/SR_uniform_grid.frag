@@ -11,6 +11,10 @@
 #include "qualifire.h"
 #include "texture.h"
 
+#if defined( ENABLE_LAMBERT_SHADING ) || defined( ENABLE_PHONG_SHADING ) || defined( ENABLE_BLINN_PHONG_SHADING )
+#define ENABLE_SHADING
+#endif
+
 
 // Input parameters.
 FragIn vec3 position_ndc;
@@ -23,6 +27,10 @@ uniform vec3 light_position; // light position in the object coordinate
 uniform vec3 camera_position; // camera position in the object coordinate
 uniform VolumeParameter volume; // volume parameter
 uniform sampler3D volume_data; // volume data
+#if defined( ENABLE_GRADIENT_TEXTURE )
+uniform sampler3D gradient_data; // precomputed gradient data
+uniform float gradient_scale; // max. magnitude of the gradient
+#endif
 uniform ShadingParameter shading; // shading parameter
 uniform TransferFunctionParameter transfer_function; // transfer function
 uniform sampler1D transfer_function_data; // 1D transfer function data
@@ -100,6 +108,38 @@ vec3 NDC2Obj( const in vec3 ndc )
     return temp.xyz / temp.w;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns a value of the volume data.
+ *  @param  volume_index [in] volume index
+ *  @return value in [0,1] of the texture
+ */
+/*===========================================================================*/
+float VolumeValue( in vec3 volume_index )
+{
+#if defined( ENABLE_CUBIC_BSPLINE_FILTER )
+    return CubicBSpline3D( volume_data, volume_index, volume.resolution, volume.resolution_reciprocal ).w;
+#else
+    return LookupTexture3D( volume_data, volume_index ).w;
+#endif
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a gradient vector of the volume data.
+ *  @param  volume_index [in] volume index
+ *  @return gradient vector in object coordinate
+ */
+/*===========================================================================*/
+vec3 Gradient( in vec3 volume_index )
+{
+#if defined( ENABLE_GRADIENT_TEXTURE )
+    return VolumeGradientTexture( gradient_data, volume_index, gradient_scale );
+#else
+    return VolumeGradient( volume_data, volume_index, volume.resolution_reciprocal );
+#endif
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Main function of fragment shader.
@@ -162,8 +202,8 @@ void main()
         //
         // where, I: volume index, P: sampling point, R: volume resolution.
         vec3 volume_index = vec3( ( position + vec3(0.5) ) / volume.resolution );
-        vec4 value = LookupTexture3D( volume_data, volume_index );
-        float scalar = mix( volume.min_range, volume.max_range, value.w );
+        float value = VolumeValue( volume_index );
+        float scalar = mix( volume.min_range, volume.max_range, value );
 
         // Get the source color from the transfer function.
         float tfunc_index = ( scalar - transfer_function.min_value ) * tfunc_scale;
@@ -172,14 +212,10 @@ void main()
 #if defined( ENABLE_ALPHA_CORRECTION )
         c.a = 1.0 - pow( 1.0 - c.a, dT );
 #endif
-        // Get the normal vector in object coordinate.
-        vec3 offset_index = vec3( volume.resolution_reciprocal );
-        vec3 normal = VolumeGradient( volume_data, volume_index, offset_index );
-
         // Edge enhancement
         if ( edge_factor > 0.0 )
         {
-            vec3 n = normalize( normal );
+            vec3 n = normalize( Gradient( volume_index ) );
             if ( length( n ) > 0.0 )
             {
                 vec3 v = normalize( -direction );
@@ -194,9 +230,15 @@ void main()
         accum_alpha += ( 1.0 - accum_alpha ) * c.a;
         if ( R <= accum_alpha )
         {
+#if defined( ENABLE_SHADING )
+            // Get the normal vector in object coordinate only at the sampling
+            // point to be drawn.
+            vec3 normal = Gradient( volume_index );
+
             // Light vector (L) and normal vector (N) in camera coordinate.
             vec3 L = normalize( light_position - position );
             vec3 N = normalize( gl_NormalMatrix * normal );
+#endif
 
 #if   defined( ENABLE_LAMBERT_SHADING )
             c.rgb = ShadingLambert( shading, c.rgb, L, N );
@@ -0,0 +1,64 @@
+/*****************************************************************************/
+/**
+ *  @file   batch.vert
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+#version 120
+#include "qualifire.h"
+
+// Input parameters.
+attribute float object_index; // index of the object in the batch
+
+// Output parameters to fragment shader.
+VertOut vec3 position;
+VertOut vec3 normal;
+
+// Uniform variables (OpenGL variables).
+uniform mat4 ModelViewMatrix; // model-view matrix
+uniform mat4 ModelViewProjectionMatrix; // model-view projection matrix
+uniform mat3 NormalMatrix; // normal matrix
+
+// Uniform variables.
+uniform sampler2D xform_texture; // modeling matrices (4 texels per object)
+uniform vec2 xform_texture_size; // width and height of the xform texture
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the modeling matrix of the object.
+ *  @param  index [in] index of the object
+ *  @return modeling matrix
+ */
+/*===========================================================================*/
+mat4 ObjectXform( in float index )
+{
+    float objects_per_row = xform_texture_size.x / 4.0;
+    float row = floor( index / objects_per_row );
+    float col = ( index - row * objects_per_row ) * 4.0;
+    float v = ( row + 0.5 ) / xform_texture_size.y;
+    float du = 1.0 / xform_texture_size.x;
+    float u = ( col + 0.5 ) * du;
+    return mat4(
+        texture2DLod( xform_texture, vec2( u, v ), 0.0 ),
+        texture2DLod( xform_texture, vec2( u + du, v ), 0.0 ),
+        texture2DLod( xform_texture, vec2( u + 2.0 * du, v ), 0.0 ),
+        texture2DLod( xform_texture, vec2( u + 3.0 * du, v ), 0.0 ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function of vertex shader.
+ */
+/*===========================================================================*/
+void main()
+{
+    mat4 X = ObjectXform( object_index );
+    vec4 vertex = X * gl_Vertex;
+
+    gl_Position = ModelViewProjectionMatrix * vertex;
+    gl_FrontColor = gl_Color;
+
+    position = ( ModelViewMatrix * vertex ).xyz;
+    normal = NormalMatrix * ( mat3( X[0].xyz, X[1].xyz, X[2].xyz ) * gl_Normal );
+}
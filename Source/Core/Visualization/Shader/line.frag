@@ -7,6 +7,9 @@
 #version 120
 #include "shading.h"
 #include "qualifire.h"
+#if defined( ENABLE_WEIGHTED_BLENDED_OIT )
+#include "oit.h"
+#endif
 
 // Input parameters from vertex shader.
 FragIn vec3 position;
@@ -19,6 +22,9 @@ uniform ShadingParameter shading;
 uniform float line_width;
 uniform float outline_width;
 uniform vec3 outline_color;
+#if defined( ENABLE_WEIGHTED_BLENDED_OIT )
+uniform float opacity; // opacity of the line
+#endif
 
 
 /*===========================================================================*/
@@ -35,8 +41,12 @@ void main()
         if ( distance( gl_FragCoord.xy, center ) >= center_line_width )
         {
             // The opacity value is set to 0.9 for diminishing aliasing.
+#if defined( ENABLE_WEIGHTED_BLENDED_OIT )
+            WeightedBlendedOutput( outline_color, opacity );
+#else
             float opacity = 0.9;
             gl_FragColor = vec4( outline_color, opacity );
+#endif
             return;
         }
     }
@@ -66,5 +76,9 @@ void main()
     vec3 shaded_color = ShadingNone( shading, color );
 #endif
 
+#if defined( ENABLE_WEIGHTED_BLENDED_OIT )
+    WeightedBlendedOutput( shaded_color, opacity );
+#else
     gl_FragColor = vec4( shaded_color, 1.0 );
+#endif
 }
@@ -0,0 +1,23 @@
+/*****************************************************************************/
+/**
+ *  @file   oit.h
+ *  @author Naohisa Sakamoto
+ */
+/*****************************************************************************/
+
+// Weight function for the weighted blended OIT (McGuire and Bavoil, 2013),
+// which decreases with the depth in [0,1].
+float WeightedBlendedWeight( in float alpha )
+{
+    float d = 1.0 - gl_FragCoord.z;
+    return( alpha * clamp( 3.0e3 * d * d * d, 1.0e-2, 3.0e3 ) );
+}
+
+// Outputs the fragment to the accumulation buffer (0) and the weight buffer
+// (1) of kvs::WeightedBlendedBuffer.
+void WeightedBlendedOutput( in vec3 color, in float alpha )
+{
+    float w = WeightedBlendedWeight( alpha );
+    gl_FragData[0] = vec4( color * alpha * w, alpha );
+    gl_FragData[1] = vec4( alpha * w );
+}
@@ -7,6 +7,9 @@
 #version 120
 #include "shading.h"
 #include "qualifire.h"
+#if defined( ENABLE_WEIGHTED_BLENDED_OIT )
+#include "oit.h"
+#endif
 
 // Input parameters from vertex shader.
 FragIn vec3 position;
@@ -14,6 +17,9 @@ FragIn vec3 normal;
 
 // Uniform parameters.
 uniform ShadingParameter shading;
+#if defined( ENABLE_WEIGHTED_BLENDED_OIT )
+uniform bool opaque_pass; // true: opaque fragments, false: transparent fragments
+#endif
 
 
 /*===========================================================================*/
@@ -49,5 +55,20 @@ void main()
     vec3 shaded_color = ShadingNone( shading, color );
 #endif
 
+#if defined( ENABLE_WEIGHTED_BLENDED_OIT )
+    // The opaque fragments are drawn to the framebuffer with the depth, and
+    // the transparent ones are accumulated in the weighted blended buffer.
+    if ( opaque_pass )
+    {
+        if ( alpha < 1.0 ) { discard; }
+        gl_FragData[0] = vec4( shaded_color, 1.0 );
+    }
+    else
+    {
+        if ( alpha >= 1.0 ) { discard; }
+        WeightedBlendedOutput( shaded_color, alpha );
+    }
+#else
     gl_FragColor = vec4( shaded_color, alpha );
+#endif
 }
@@ -60,3 +60,66 @@ vec3 VolumeGradient8( in sampler3D v, in vec3 p, in vec3 o )
 
     return mix( g0, mix( mix0, mix1, 0.5 ), 0.75 );
 }
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns gradient vector read from the precomputed gradient texture.
+ *  @param  g [in] gradient texture (RGB: signed-mapped gradient divided by scale)
+ *  @param  p [in] sampling point
+ *  @param  scale [in] max. magnitude of the gradient
+ *  @return gradient vector, whose length is the magnitude in the value unit
+ */
+/*===========================================================================*/
+vec3 VolumeGradientTexture( in sampler3D g, in vec3 p, in float scale )
+{
+    return ( texture3D( g, p ).rgb * 2.0 - 1.0 ) * scale;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns value reconstructed with the cubic B-spline filter.
+ *  @param  v [in] volume data (linear filtering)
+ *  @param  p [in] sampling point
+ *  @param  r [in] volume resolution
+ *  @param  o [in] reciprocal number of the volume resolution
+ *  @return reconstructed value
+ *
+ *  The 4x4x4 weighted sum is evaluated with eight trilinear fetches by moving
+ *  the sampling points between the texels in proportion to the weights
+ *  (Sigg and Hadwiger, GPU Gems 2, Chapter 20).
+ */
+/*===========================================================================*/
+vec4 CubicBSpline3D( in sampler3D v, in vec3 p, in vec3 r, in vec3 o )
+{
+    vec3 x = p * r - vec3( 0.5 );
+    vec3 index = floor( x );
+    vec3 f = x - index;
+    vec3 f1 = vec3( 1.0 ) - f;
+
+    // B-spline weights and the offsets for the linear fetches.
+    vec3 w0 = f1 * f1 * f1 / 6.0;
+    vec3 w1 = 2.0 / 3.0 - 0.5 * f * f * ( 2.0 - f );
+    vec3 w3 = f * f * f / 6.0;
+    vec3 g0 = w0 + w1;
+    vec3 g1 = vec3( 1.0 ) - g0;
+    vec3 h0 = ( index - vec3( 0.5 ) + w1 / g0 ) * o;
+    vec3 h1 = ( index + vec3( 1.5 ) + w3 / g1 ) * o;
+
+    vec4 v000 = texture3D( v, vec3( h0.x, h0.y, h0.z ) );
+    vec4 v100 = texture3D( v, vec3( h1.x, h0.y, h0.z ) );
+    vec4 v010 = texture3D( v, vec3( h0.x, h1.y, h0.z ) );
+    vec4 v110 = texture3D( v, vec3( h1.x, h1.y, h0.z ) );
+    vec4 v001 = texture3D( v, vec3( h0.x, h0.y, h1.z ) );
+    vec4 v101 = texture3D( v, vec3( h1.x, h0.y, h1.z ) );
+    vec4 v011 = texture3D( v, vec3( h0.x, h1.y, h1.z ) );
+    vec4 v111 = texture3D( v, vec3( h1.x, h1.y, h1.z ) );
+
+    vec4 v00 = mix( v100, v000, g0.x );
+    vec4 v10 = mix( v110, v010, g0.x );
+    vec4 v01 = mix( v101, v001, g0.x );
+    vec4 v11 = mix( v111, v011, g0.x );
+    vec4 v0 = mix( v10, v00, g0.y );
+    vec4 v1 = mix( v11, v01, g0.y );
+
+    return mix( v1, v0, g0.z );
+}
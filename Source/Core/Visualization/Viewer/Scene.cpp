@@ -14,6 +14,7 @@
 #include <kvs/ObjectManager>
 #include <kvs/RendererManager>
 #include <kvs/IDManager>
+#include <kvs/BufferUploadQueue>
 #include <kvs/ObjectBase>
 #include <kvs/RendererBase>
 #include <kvs/VisualizationPipeline>
@@ -72,7 +73,8 @@ Scene::Scene( kvs::ScreenBase* screen ):
     m_background( new kvs::Background( kvs::UIColor::Background() ) ),
     m_object_manager( new kvs::ObjectManager() ),
     m_renderer_manager( new kvs::RendererManager() ),
-    m_id_manager( new kvs::IDManager() )
+    m_id_manager( new kvs::IDManager() ),
+    m_upload_queue( new kvs::BufferUploadQueue() )
 {
 }
 
@@ -90,6 +92,7 @@ Scene::~Scene()
     if ( m_object_manager ) { delete m_object_manager; }
     if ( m_renderer_manager ) { delete m_renderer_manager; }
     if ( m_id_manager ) { delete m_id_manager; }
+    if ( m_upload_queue ) { delete m_upload_queue; }
 }
 
 /*===========================================================================*/
@@ -689,6 +692,10 @@ void Scene::setEnabledCollisionDetection( bool enable )
 /*==========================================================================*/
 void Scene::initializeFunction()
 {
+    // Discard the tracked GL bindings, which could be changed by the window
+    // system or user code outside of KVS.
+    kvs::OpenGL::InvalidateStateTracker();
+
     // Set the lighting parameters.
     m_light->on();
 
@@ -703,6 +710,10 @@ void Scene::initializeFunction()
 /*==========================================================================*/
 void Scene::paintFunction()
 {
+    // Discard the tracked GL bindings, which could be changed by the window
+    // system or user code outside of KVS.
+    kvs::OpenGL::InvalidateStateTracker();
+
     this->updateGLProjectionMatrix();
     this->updateGLViewingMatrix();
     this->updateGLLightParameters();
@@ -710,6 +721,9 @@ void Scene::paintFunction()
     // Set the background color or image.
     m_background->apply();
 
+    // Upload the pending buffer objects within the budget per frame.
+    m_upload_queue->process();
+
     // Rendering the resistered object by using the corresponding renderer.
     if ( m_object_manager->hasObject() )
     {
@@ -732,6 +746,10 @@ void Scene::paintFunction()
     {
         this->updateGLModelingMatrix();
     }
+
+    // Request the next frame until all of the buffer objects, including the
+    // ones pushed by the renderers in this frame, are uploaded.
+    if ( m_upload_queue->hasPendingRequests() ) { m_screen->redraw(); }
 }
 
 /*==========================================================================*/
@@ -744,6 +762,10 @@ void Scene::paintFunction()
 /*==========================================================================*/
 void Scene::resizeFunction( int width, int height, float dpr )
 {
+    // Discard the tracked GL bindings, which could be changed by the window
+    // system or user code outside of KVS.
+    kvs::OpenGL::InvalidateStateTracker();
+
     // Update the window size for camera.
     m_camera->setWindowSize( width, height );
 
@@ -22,6 +22,7 @@ class RendererManager;
 class IDManager;
 class ObjectBase;
 class RendererBase;
+class BufferUploadQueue;
 
 /*===========================================================================*/
 /**
@@ -48,6 +49,7 @@ private:
     kvs::ObjectManager* m_object_manager = nullptr; ///< object manager
     kvs::RendererManager* m_renderer_manager = nullptr; ///< renderer manager
     kvs::IDManager* m_id_manager = nullptr; ///< ID manager ( object_id, renderer_id )
+    kvs::BufferUploadQueue* m_upload_queue = nullptr; ///< upload queue of the buffer objects
     ControlTarget m_target = ControlTarget::TargetObject; ///< control target
     bool m_enable_object_operation = true;  ///< flag for object operation
     bool m_enable_collision_detection = false; ///< flag for collision detection
@@ -108,6 +110,7 @@ public:
     kvs::ObjectManager* objectManager() { return m_object_manager; }
     kvs::RendererManager* rendererManager() { return m_renderer_manager; }
     kvs::IDManager* IDManager() { return m_id_manager; }
+    kvs::BufferUploadQueue* uploadQueue() { return m_upload_queue; }
     ControlTarget& controlTarget() { return m_target; }
 
     const kvs::Camera* camera() const { return m_camera; }